@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! benchmarkCompare.cpp
+//! This file contains a tool that compares the trtexec timing and layer profile exports of a baseline run and of
+//! a candidate run, reports the statistically significant changes, and fails past configurable thresholds.
+//! It only reads files and does not need TensorRT or a GPU, so it can gate upgrades on any CI machine.
+//! It can be run with the following command line:
+//! Command: ./benchmark_compare --baselineTimes=<file> --candidateTimes=<file> [--baselineProfile=<file>
+//!          --candidateProfile=<file>] [--threshold=T] [--method=mannwhitney|bootstrap]
+//!
+
+#include "compareStats.h"
+#include "exportReader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace benchmarkCompare;
+
+namespace
+{
+
+//! Exit codes, so that CI scripts can tell a regression from a broken invocation.
+constexpr int kEXIT_PASS = 0;
+constexpr int kEXIT_REGRESSION = 1;
+constexpr int kEXIT_ERROR = 2;
+
+//!
+//! \brief The CompareOptions structure groups the command line options of the tool.
+//!
+struct CompareOptions
+{
+    std::string baselineTimes;
+    std::string candidateTimes;
+    std::string baselineProfile;
+    std::string candidateProfile;
+    double percentile{50};      //!< Percentile of the samples that is compared
+    double threshold{5};        //!< Relative change in % past which a significant slowdown of a run metric fails
+    double layerThreshold{0};   //!< Same for layers; 0 reports layers without failing on them
+    double minShare{1};         //!< Layers below this % of the baseline layer time never fail
+    double alpha{0.01};         //!< Significance level
+    bool bootstrap{false};      //!< Use bootstrap confidence intervals instead of the Mann-Whitney test
+    int resamples{2000};        //!< Bootstrap resamples
+    int seed{1};                //!< Seed of the bootstrap generator
+    int top{10};                //!< Number of layer regressions and improvements printed
+};
+
+enum class Verdict
+{
+    kUNCHANGED,
+    kREGRESSION,
+    kIMPROVEMENT
+};
+
+//!
+//! \brief The Comparison structure holds the comparison of one metric between the two runs.
+//!
+struct Comparison
+{
+    std::string name;
+    size_t baselineCount{0};
+    size_t candidateCount{0};
+    double baseline{0};  //!< The compared percentile of the baseline, in ms
+    double candidate{0}; //!< The compared percentile of the candidate, in ms
+    double change{0};    //!< candidate / baseline - 1
+    double pValue{1};    //!< Mann-Whitney p-value, unused with bootstrap
+    Interval interval;   //!< Bootstrap confidence interval of change, unused with Mann-Whitney
+    bool significant{false};
+    Verdict verdict{Verdict::kUNCHANGED};
+};
+
+Comparison compare(const std::string& name, std::vector<double> baseline, std::vector<double> candidate,
+    double threshold, const CompareOptions& options)
+{
+    Comparison c;
+    c.name = name;
+    c.baselineCount = baseline.size();
+    c.candidateCount = candidate.size();
+    if (options.bootstrap)
+    {
+        c.interval = bootstrapRelativeChange(baseline, candidate, options.percentile, 1 - options.alpha,
+            options.resamples, static_cast<uint32_t>(options.seed));
+        c.significant = c.interval.low > 0 || c.interval.high < 0;
+    }
+    else
+    {
+        c.pValue = mannWhitneyPValue(baseline, candidate);
+        c.significant = c.pValue < options.alpha;
+    }
+    c.baseline = percentile(baseline, options.percentile);
+    c.candidate = percentile(candidate, options.percentile);
+    c.change = c.baseline > 0 ? c.candidate / c.baseline - 1 : 0;
+    if (c.significant && c.change * 100 > threshold)
+    {
+        c.verdict = Verdict::kREGRESSION;
+    }
+    else if (c.significant && c.change * 100 < -threshold)
+    {
+        c.verdict = Verdict::kIMPROVEMENT;
+    }
+    return c;
+}
+
+void printHeader(std::ostream& os, int nameWidth, const CompareOptions& options)
+{
+    os << std::left << std::setw(nameWidth) << "Metric" << std::right << std::setw(10) << "Baseline" << std::setw(12)
+       << "Candidate" << std::setw(10) << "Change" << std::setw(24)
+       << (options.bootstrap ? std::to_string(static_cast<int>(100 * (1 - options.alpha))) + "% interval"
+                             : std::string("p-value"))
+       << "  Verdict" << std::endl;
+}
+
+void printComparison(std::ostream& os, int nameWidth, const Comparison& c, const CompareOptions& options)
+{
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+    os << std::left << std::setw(nameWidth) << c.name << std::right << std::fixed << std::setprecision(4)
+       << std::setw(10) << c.baseline << std::setw(12) << c.candidate << std::showpos << std::setprecision(1)
+       << std::setw(9) << c.change * 100 << "%";
+    if (options.bootstrap)
+    {
+        std::ostringstream interval;
+        interval << std::fixed << std::showpos << std::setprecision(1) << "[" << c.interval.low * 100 << "%, "
+                 << c.interval.high * 100 << "%]";
+        os << std::setw(24) << interval.str();
+    }
+    else
+    {
+        os << std::noshowpos << std::scientific << std::setprecision(2) << std::setw(24) << c.pValue;
+    }
+    os.flags(flags);
+    os.precision(precision);
+    os << "  "
+       << (c.verdict == Verdict::kREGRESSION ? "REGRESSION"
+                                             : c.verdict == Verdict::kIMPROVEMENT ? "improvement"
+                                                                                  : c.significant ? "within threshold"
+                                                                                                  : "no significant change")
+       << std::endl;
+}
+
+//! Compares the host latency and GPU time distributions, and returns the number of regressions.
+int compareTimes(const CompareOptions& options)
+{
+    const TimesRun baseline = readTimes(options.baselineTimes);
+    const TimesRun candidate = readTimes(options.candidateTimes);
+    std::cout << "Inferences: " << baseline.latencies.size() << " in the baseline, " << candidate.latencies.size()
+              << " in the candidate, comparing p" << options.percentile << " in ms" << std::endl;
+    const std::vector<Comparison> comparisons{
+        compare("Host latency", baseline.latencies, candidate.latencies, options.threshold, options),
+        compare("GPU time", baseline.gpuTimes, candidate.gpuTimes, options.threshold, options)};
+
+    const int nameWidth = 24;
+    printHeader(std::cout, nameWidth, options);
+    int regressions = 0;
+    for (const auto& c : comparisons)
+    {
+        printComparison(std::cout, nameWidth, c, options);
+        regressions += c.verdict == Verdict::kREGRESSION;
+    }
+    return regressions;
+}
+
+//! Aligns the layers of the two profiles by name, compares them, and returns the number of failing regressions.
+int compareProfiles(const CompareOptions& options)
+{
+    const ProfileRun baseline = readProfile(options.baselineProfile);
+    const ProfileRun candidate = readProfile(options.candidateProfile);
+
+    std::map<std::string, size_t> candidateIndices;
+    for (size_t l = 0; l < candidate.layers.size(); ++l)
+    {
+        candidateIndices[candidate.layers[l]] = l;
+    }
+    double baselineTotal{0};
+    for (const auto& times : baseline.times)
+    {
+        baselineTotal += std::accumulate(times.begin(), times.end(), 0.0);
+    }
+
+    // Layers are reported whatever the layer threshold, so a threshold of 0 still ranks them.
+    const double reportThreshold = std::max(0.0, options.layerThreshold);
+    std::vector<Comparison> layers;
+    std::vector<bool> gating;
+    std::vector<std::string> removed;
+    for (size_t l = 0; l < baseline.layers.size(); ++l)
+    {
+        const auto match = candidateIndices.find(baseline.layers[l]);
+        if (match == candidateIndices.end())
+        {
+            removed.push_back(baseline.layers[l]);
+            continue;
+        }
+        layers.push_back(compare(baseline.layers[l], baseline.times[l], candidate.times[match->second],
+            reportThreshold, options));
+        const double share = baselineTotal > 0
+            ? std::accumulate(baseline.times[l].begin(), baseline.times[l].end(), 0.0) * 100 / baselineTotal
+            : 0;
+        gating.push_back(options.layerThreshold > 0 && share >= options.minShare);
+        candidateIndices.erase(match);
+    }
+
+    std::cout << "Layers: " << baseline.layers.size() << " in the baseline, " << candidate.layers.size()
+              << " in the candidate, " << layers.size() << " matched by name" << std::endl;
+    int nameWidth = 24;
+    for (const auto& c : layers)
+    {
+        nameWidth = std::max(nameWidth, static_cast<int>(c.name.size()) + 1);
+    }
+    printHeader(std::cout, nameWidth, options);
+    const Comparison total = compare("Total layer time", baseline.inferenceTotals, candidate.inferenceTotals,
+        options.threshold, options);
+    printComparison(std::cout, nameWidth, total, options);
+    int failures = total.verdict == Verdict::kREGRESSION;
+
+    // Rank by the change in time rather than in ratio, so that small layers do not crowd out the costly ones.
+    std::vector<size_t> order(layers.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&layers](size_t a, size_t b) {
+        return layers[a].candidate - layers[a].baseline > layers[b].candidate - layers[b].baseline;
+    });
+    auto printTop = [&](const char* title, Verdict verdict, bool slowestFirst) {
+        std::cout << title << std::endl;
+        int printed = 0;
+        for (size_t i = 0; i < order.size() && printed < options.top; ++i)
+        {
+            const size_t l = order[slowestFirst ? i : order.size() - 1 - i];
+            if (layers[l].verdict == verdict)
+            {
+                printComparison(std::cout, nameWidth, layers[l], options);
+                ++printed;
+            }
+        }
+        if (printed == 0)
+        {
+            std::cout << "  (none)" << std::endl;
+        }
+    };
+    printTop("Top layer regressions:", Verdict::kREGRESSION, true);
+    printTop("Top layer improvements:", Verdict::kIMPROVEMENT, false);
+
+    for (size_t l = 0; l < layers.size(); ++l)
+    {
+        failures += gating[l] && layers[l].verdict == Verdict::kREGRESSION;
+    }
+    for (const auto& name : removed)
+    {
+        std::cout << "Only in the baseline: " << name << std::endl;
+    }
+    for (const auto& name : candidate.layers)
+    {
+        if (candidateIndices.count(name))
+        {
+            std::cout << "Only in the candidate: " << name << std::endl;
+        }
+    }
+    return failures;
+}
+
+void printUsage()
+{
+    std::cout << "Usage: ./benchmark_compare [options]" << std::endl
+              << "Compares trtexec --exportTimes and --exportProfile files of a baseline and a candidate run."
+              << std::endl
+              << "  --baselineTimes=<file>       Timing export of the baseline run" << std::endl
+              << "  --candidateTimes=<file>      Timing export of the candidate run" << std::endl
+              << "  --baselineProfile=<file>     Layer profile export of the baseline run" << std::endl
+              << "  --candidateProfile=<file>    Layer profile export of the candidate run" << std::endl
+              << "  --percentile=P               Percentile of the samples that is compared (default = 50)"
+              << std::endl
+              << "  --threshold=T                Fail if the host latency, GPU time or total layer time is "
+                 "significantly slower by more than T% (default = 5)"
+              << std::endl
+              << "  --layerThreshold=T           Also fail if a layer is significantly slower by more than T% "
+                 "(default = 0, layers do not fail)"
+              << std::endl
+              << "  --minShare=S                 Layers below S% of the baseline layer time never fail "
+                 "(default = 1)"
+              << std::endl
+              << "  --alpha=A                    Significance level (default = 0.01)" << std::endl
+              << "  --method=mannwhitney|bootstrap  Significance test (default = mannwhitney)" << std::endl
+              << "  --resamples=N                Bootstrap resamples (default = 2000)" << std::endl
+              << "  --seed=N                     Seed of the bootstrap resampling (default = 1)" << std::endl
+              << "  --top=N                      Number of layer regressions and improvements printed "
+                 "(default = 10)"
+              << std::endl
+              << "  --help, -h                   Display help information" << std::endl
+              << "Exit status: 0 without failing regression, 1 with, 2 on invalid arguments or files."
+              << std::endl;
+}
+
+//! Returns the value of an argument of the form --name=value, or nullptr if arg is not one.
+const char* optionValue(const char* arg, const char* name)
+{
+    const size_t n = std::strlen(name);
+    const bool match = arg[0] == '-' && arg[1] == '-' && !std::strncmp(arg + 2, name, n) && arg[n + 2] == '=';
+    return match ? arg + n + 3 : nullptr;
+}
+
+//! Parses the arguments; returns false and sets help if help was requested.
+bool parseOptions(int argc, char** argv, CompareOptions& options, bool& help)
+{
+    const std::map<std::string, std::string*> files{{"baselineTimes", &options.baselineTimes},
+        {"candidateTimes", &options.candidateTimes}, {"baselineProfile", &options.baselineProfile},
+        {"candidateProfile", &options.candidateProfile}};
+    const std::map<std::string, double*> numbers{{"percentile", &options.percentile},
+        {"threshold", &options.threshold}, {"layerThreshold", &options.layerThreshold},
+        {"minShare", &options.minShare}, {"alpha", &options.alpha}};
+    const std::map<std::string, int*> counts{
+        {"resamples", &options.resamples}, {"seed", &options.seed}, {"top", &options.top}};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        if (!std::strcmp(arg, "--help") || !std::strcmp(arg, "-h"))
+        {
+            help = true;
+            return false;
+        }
+        bool known = false;
+        for (const auto& f : files)
+        {
+            if (const char* value = optionValue(arg, f.first.c_str()))
+            {
+                *f.second = value;
+                known = true;
+            }
+        }
+        try
+        {
+            for (const auto& n : numbers)
+            {
+                if (const char* value = optionValue(arg, n.first.c_str()))
+                {
+                    *n.second = std::stod(value);
+                    known = true;
+                }
+            }
+            for (const auto& c : counts)
+            {
+                if (const char* value = optionValue(arg, c.first.c_str()))
+                {
+                    *c.second = std::stoi(value);
+                    known = true;
+                }
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "Invalid value in " << arg << std::endl;
+            return false;
+        }
+        if (const char* value = optionValue(arg, "method"))
+        {
+            if (std::strcmp(value, "mannwhitney") && std::strcmp(value, "bootstrap"))
+            {
+                std::cerr << "Unknown method " << value << std::endl;
+                return false;
+            }
+            options.bootstrap = !std::strcmp(value, "bootstrap");
+            known = true;
+        }
+        if (!known)
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (options.baselineTimes.empty() != options.candidateTimes.empty()
+        || options.baselineProfile.empty() != options.candidateProfile.empty())
+    {
+        std::cerr << "Please provide both the baseline and the candidate file of each export" << std::endl;
+        return false;
+    }
+    if (options.baselineTimes.empty() && options.baselineProfile.empty())
+    {
+        std::cerr << "Please provide timing or layer profile exports to compare" << std::endl;
+        return false;
+    }
+    if (options.percentile < 0 || options.percentile > 100 || options.alpha <= 0 || options.alpha >= 1
+        || options.threshold < 0 || options.resamples < 1 || options.top < 0)
+    {
+        std::cerr << "Please provide 0 <= percentile <= 100, 0 < alpha < 1, threshold >= 0 and positive counts"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    CompareOptions options;
+    bool help{false};
+    if (!parseOptions(argc, argv, options, help))
+    {
+        printUsage();
+        return help ? kEXIT_PASS : kEXIT_ERROR;
+    }
+
+    int failures = 0;
+    try
+    {
+        if (!options.baselineTimes.empty())
+        {
+            failures += compareTimes(options);
+        }
+        if (!options.baselineProfile.empty())
+        {
+            failures += compareProfiles(options);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return kEXIT_ERROR;
+    }
+
+    if (failures)
+    {
+        std::cout << "FAILED: " << failures << " significant regression(s) past the thresholds" << std::endl;
+        return kEXIT_REGRESSION;
+    }
+    std::cout << "PASSED: no significant regression past the thresholds" << std::endl;
+    return kEXIT_PASS;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_COMPARE_STATS_H
+#define TENSORRT_COMPARE_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace benchmarkCompare
+{
+
+//!
+//! \brief Returns the percentile of samples by nearest rank, 0 <= percentage <= 100. samples is reordered.
+//!
+inline double percentile(std::vector<double>& samples, double percentage)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+    const size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(percentage / 100 * samples.size())));
+    std::nth_element(samples.begin(), samples.begin() + (rank - 1), samples.end());
+    return samples[rank - 1];
+}
+
+//!
+//! \brief Returns the two-sided p-value of the Mann-Whitney U test that a and b come from the same distribution.
+//!
+//! \details Uses the normal approximation with tie and continuity corrections, which is accurate from about
+//!          20 samples per side. The test assumes independent samples; consecutive inferences are not quite
+//!          independent, so small p-values should be read with a margin.
+//!
+inline double mannWhitneyPValue(const std::vector<double>& a, const std::vector<double>& b)
+{
+    const double n1 = static_cast<double>(a.size());
+    const double n2 = static_cast<double>(b.size());
+    if (a.empty() || b.empty())
+    {
+        return 1;
+    }
+    std::vector<std::pair<double, int>> all;
+    all.reserve(a.size() + b.size());
+    for (const double v : a)
+    {
+        all.emplace_back(v, 0);
+    }
+    for (const double v : b)
+    {
+        all.emplace_back(v, 1);
+    }
+    std::sort(all.begin(), all.end());
+
+    // Ties share the average of their ranks.
+    double rankSumA{0};
+    double tieTerm{0};
+    for (size_t i = 0; i < all.size();)
+    {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+        {
+            ++j;
+        }
+        const double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; ++k)
+        {
+            rankSumA += all[k].second == 0 ? rank : 0;
+        }
+        const double t = static_cast<double>(j - i);
+        tieTerm += t * t * t - t;
+        i = j;
+    }
+
+    const double n = n1 + n2;
+    const double u = rankSumA - n1 * (n1 + 1) / 2;
+    const double mean = n1 * n2 / 2;
+    const double variance = n1 * n2 / 12 * ((n + 1) - tieTerm / (n * (n - 1)));
+    if (variance <= 0)
+    {
+        return 1;
+    }
+    const double z = std::max(0.0, std::abs(u - mean) - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+//!
+//! \brief The Interval structure is a confidence interval.
+//!
+struct Interval
+{
+    double low{0};
+    double high{0};
+};
+
+//!
+//! \brief Returns the percentile bootstrap confidence interval of the relative change of a percentile of the
+//!        samples, statistic(candidate) / statistic(baseline) - 1.
+//!
+//! \details Both sides are resampled with replacement resamples times from a generator seeded with seed, so the
+//!          result is reproducible. Each resample costs a selection over both sides.
+//!
+inline Interval bootstrapRelativeChange(const std::vector<double>& baseline, const std::vector<double>& candidate,
+    double percentage, double confidence, int resamples, uint32_t seed)
+{
+    Interval interval;
+    if (baseline.empty() || candidate.empty() || resamples < 1)
+    {
+        return interval;
+    }
+    std::mt19937 generator(seed);
+    auto resample = [&generator](const std::vector<double>& samples, std::vector<double>& out) {
+        std::uniform_int_distribution<size_t> index(0, samples.size() - 1);
+        out.resize(samples.size());
+        for (auto& v : out)
+        {
+            v = samples[index(generator)];
+        }
+    };
+
+    std::vector<double> changes;
+    changes.reserve(resamples);
+    std::vector<double> a;
+    std::vector<double> b;
+    for (int r = 0; r < resamples; ++r)
+    {
+        resample(baseline, a);
+        resample(candidate, b);
+        const double reference = percentile(a, percentage);
+        if (reference > 0)
+        {
+            changes.push_back(percentile(b, percentage) / reference - 1);
+        }
+    }
+    if (changes.empty())
+    {
+        return interval;
+    }
+    const double tail = (1 - confidence) / 2 * 100;
+    interval.low = percentile(changes, tail);
+    interval.high = percentile(changes, 100 - tail);
+    return interval;
+}
+
+} // namespace benchmarkCompare
+
+#endif // TENSORRT_COMPARE_STATS_H
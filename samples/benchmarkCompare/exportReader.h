@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_EXPORT_READER_H
+#define TENSORRT_EXPORT_READER_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace benchmarkCompare
+{
+
+//!
+//! \brief The JsonValue structure is a parsed JSON value.
+//!
+struct JsonValue
+{
+    enum class Type
+    {
+        kNULL,
+        kBOOL,
+        kNUMBER,
+        kSTRING,
+        kARRAY,
+        kOBJECT
+    };
+
+    Type type{Type::kNULL};
+    double number{0};
+    std::string text;                              //!< The value of a string
+    std::vector<JsonValue> elements;               //!< The elements of an array
+    std::map<std::string, JsonValue> members;      //!< The members of an object
+
+    //!
+    //! \brief Returns the member named key, or nullptr if this is not an object or has no such member.
+    //!
+    const JsonValue* find(const std::string& key) const
+    {
+        const auto member = members.find(key);
+        return type == Type::kOBJECT && member != members.end() ? &member->second : nullptr;
+    }
+};
+
+//!
+//! \brief The JsonParser class parses a complete JSON document. Errors throw std::runtime_error with the offset.
+//!
+class JsonParser
+{
+public:
+    explicit JsonParser(const std::string& text)
+        : mText(text)
+    {
+    }
+
+    JsonValue parse()
+    {
+        JsonValue value = parseValue();
+        skipSpaces();
+        if (mPos != mText.size())
+        {
+            fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    JsonValue parseValue()
+    {
+        skipSpaces();
+        if (mPos >= mText.size())
+        {
+            fail("unexpected end");
+        }
+        JsonValue value;
+        const char c = mText[mPos];
+        if (c == '{')
+        {
+            value.type = JsonValue::Type::kOBJECT;
+            ++mPos;
+            if (!consume('}'))
+            {
+                do
+                {
+                    skipSpaces();
+                    const std::string key = parseString();
+                    expect(':');
+                    value.members[key] = parseValue();
+                } while (consume(','));
+                expect('}');
+            }
+        }
+        else if (c == '[')
+        {
+            value.type = JsonValue::Type::kARRAY;
+            ++mPos;
+            if (!consume(']'))
+            {
+                do
+                {
+                    value.elements.push_back(parseValue());
+                } while (consume(','));
+                expect(']');
+            }
+        }
+        else if (c == '"')
+        {
+            value.type = JsonValue::Type::kSTRING;
+            value.text = parseString();
+        }
+        else if (mText.compare(mPos, 4, "true") == 0 || mText.compare(mPos, 5, "false") == 0)
+        {
+            value.type = JsonValue::Type::kBOOL;
+            value.number = c == 't';
+            mPos += c == 't' ? 4 : 5;
+        }
+        else if (mText.compare(mPos, 4, "null") == 0)
+        {
+            mPos += 4;
+        }
+        else
+        {
+            const char* begin = mText.c_str() + mPos;
+            char* end = nullptr;
+            value.type = JsonValue::Type::kNUMBER;
+            value.number = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                fail("invalid value");
+            }
+            mPos += end - begin;
+        }
+        return value;
+    }
+
+    std::string parseString()
+    {
+        if (mPos >= mText.size() || mText[mPos] != '"')
+        {
+            fail("expected a string");
+        }
+        std::string text;
+        for (++mPos; mPos < mText.size() && mText[mPos] != '"'; ++mPos)
+        {
+            char c = mText[mPos];
+            if (c == '\\' && ++mPos < mText.size())
+            {
+                c = mText[mPos];
+                switch (c)
+                {
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u':
+                {
+                    // The exporters only escape control characters; surrogate pairs are not combined.
+                    const unsigned long code = std::strtoul(mText.substr(mPos + 1, 4).c_str(), nullptr, 16);
+                    mPos += 4;
+                    appendUtf8(text, code);
+                    continue;
+                }
+                default: break; // '"', '\\' and '/' stand for themselves
+                }
+            }
+            text.push_back(c);
+        }
+        if (mPos >= mText.size())
+        {
+            fail("unterminated string");
+        }
+        ++mPos;
+        return text;
+    }
+
+    static void appendUtf8(std::string& text, unsigned long code)
+    {
+        if (code < 0x80)
+        {
+            text.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800)
+        {
+            text.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            text.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            text.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            text.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    void skipSpaces()
+    {
+        while (mPos < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPos])))
+        {
+            ++mPos;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skipSpaces();
+        if (mPos < mText.size() && mText[mPos] == c)
+        {
+            ++mPos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    void fail(const std::string& message) const
+    {
+        throw std::runtime_error("JSON " + message + " at offset " + std::to_string(mPos));
+    }
+
+    const std::string& mText;
+    size_t mPos{0};
+};
+
+//!
+//! \brief Splits one line of a CSV file into fields, undoing the quoting of fields with commas or quotes.
+//!
+inline std::vector<std::string> splitCsvLine(const std::string& line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted{false};
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+        const char c = line[i];
+        if (quoted)
+        {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+            {
+                fields.back().push_back('"');
+                ++i;
+            }
+            else if (c == '"')
+            {
+                quoted = false;
+            }
+            else
+            {
+                fields.back().push_back(c);
+            }
+        }
+        else if (c == '"')
+        {
+            quoted = true;
+        }
+        else if (c == ',')
+        {
+            fields.emplace_back();
+        }
+        else if (c != '\r')
+        {
+            fields.back().push_back(c);
+        }
+    }
+    return fields;
+}
+
+//!
+//! \brief The TimesRun structure holds the per inference timings of a trtexec --exportTimes file.
+//!
+struct TimesRun
+{
+    std::vector<double> latencies; //!< Host latencies in milliseconds, in file order
+    std::vector<double> gpuTimes;  //!< GPU times in milliseconds, in file order
+};
+
+//!
+//! \brief The ProfileRun structure holds the per invocation layer times of a trtexec --exportProfile file.
+//!
+struct ProfileRun
+{
+    std::vector<std::string> layers;         //!< Layer names in the order of their first invocation
+    std::vector<std::vector<double>> times;  //!< Invocation times of every layer in milliseconds
+    std::vector<double> inferenceTotals;     //!< Sum of the layer times of every inference
+};
+
+inline std::string readFile(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Cannot open " + fileName);
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+inline bool isCsvFile(const std::string& fileName)
+{
+    return fileName.size() >= 4 && fileName.compare(fileName.size() - 4, 4, ".csv") == 0;
+}
+
+//!
+//! \brief Returns the index of every required column in a CSV header, in the order of names.
+//!
+inline std::vector<size_t> findColumns(
+    const std::vector<std::string>& header, const std::vector<std::string>& names, const std::string& fileName)
+{
+    std::vector<size_t> columns;
+    for (const auto& name : names)
+    {
+        const auto column = std::find(header.begin(), header.end(), name);
+        if (column == header.end())
+        {
+            throw std::runtime_error(fileName + " has no " + name + " column");
+        }
+        columns.push_back(column - header.begin());
+    }
+    return columns;
+}
+
+//!
+//! \brief Reads a trtexec --exportTimes file, in JSON or in CSV if its name ends in .csv.
+//!
+inline TimesRun readTimes(const std::string& fileName)
+{
+    TimesRun run;
+    const std::string text = readFile(fileName);
+    if (isCsvFile(fileName))
+    {
+        std::istringstream lines(text);
+        std::string line;
+        std::getline(lines, line);
+        const auto columns = findColumns(splitCsvLine(line), {"latencyMs", "gpuMs"}, fileName);
+        while (std::getline(lines, line))
+        {
+            const auto fields = splitCsvLine(line);
+            if (fields.size() > std::max(columns[0], columns[1]))
+            {
+                run.latencies.push_back(std::atof(fields[columns[0]].c_str()));
+                run.gpuTimes.push_back(std::atof(fields[columns[1]].c_str()));
+            }
+        }
+        return run;
+    }
+    const JsonValue root = JsonParser(text).parse();
+    if (root.type != JsonValue::Type::kARRAY)
+    {
+        throw std::runtime_error(fileName + " is not an array of inference timings");
+    }
+    for (const auto& inference : root.elements)
+    {
+        const JsonValue* latency = inference.find("latencyMs");
+        const JsonValue* gpu = inference.find("gpuMs");
+        if (!latency || !gpu)
+        {
+            throw std::runtime_error(fileName + " has an inference without latencyMs or gpuMs");
+        }
+        run.latencies.push_back(latency->number);
+        run.gpuTimes.push_back(gpu->number);
+    }
+    return run;
+}
+
+//!
+//! \brief Reads a trtexec --exportProfile file, in JSON or in CSV if its name ends in .csv.
+//!
+inline ProfileRun readProfile(const std::string& fileName)
+{
+    ProfileRun run;
+    std::map<std::string, size_t> indices;
+    auto add = [&run, &indices](int64_t inference, const std::string& layer, double time) {
+        auto index = indices.find(layer);
+        if (index == indices.end())
+        {
+            index = indices.emplace(layer, run.layers.size()).first;
+            run.layers.push_back(layer);
+            run.times.emplace_back();
+        }
+        run.times[index->second].push_back(time);
+        if (inference >= 0)
+        {
+            if (static_cast<size_t>(inference) >= run.inferenceTotals.size())
+            {
+                run.inferenceTotals.resize(inference + 1, 0.0);
+            }
+            run.inferenceTotals[inference] += time;
+        }
+    };
+
+    const std::string text = readFile(fileName);
+    if (isCsvFile(fileName))
+    {
+        std::istringstream lines(text);
+        std::string line;
+        std::getline(lines, line);
+        const auto columns = findColumns(splitCsvLine(line), {"inference", "layer", "timeMs"}, fileName);
+        while (std::getline(lines, line))
+        {
+            const auto fields = splitCsvLine(line);
+            if (fields.size() > *std::max_element(columns.begin(), columns.end()))
+            {
+                add(std::atoll(fields[columns[0]].c_str()), fields[columns[1]],
+                    std::atof(fields[columns[2]].c_str()));
+            }
+        }
+        return run;
+    }
+    const JsonValue root = JsonParser(text).parse();
+    const JsonValue* invocations = root.find("invocations");
+    if (!invocations || invocations->type != JsonValue::Type::kARRAY)
+    {
+        throw std::runtime_error(fileName + " has no invocations array");
+    }
+    for (const auto& invocation : invocations->elements)
+    {
+        const JsonValue* inference = invocation.find("inference");
+        const JsonValue* layer = invocation.find("layer");
+        const JsonValue* time = invocation.find("timeMs");
+        if (!inference || !layer || !time)
+        {
+            throw std::runtime_error(fileName + " has an invocation without inference, layer or timeMs");
+        }
+        add(static_cast<int64_t>(inference->number), layer->text, time->number);
+    }
+    return run;
+}
+
+} // namespace benchmarkCompare
+
+#endif // TENSORRT_EXPORT_READER_H
@@ -0,0 +1,195 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! bufferLayoutTest.cpp
+//! This file contains the unit test of planBufferLayout() of bufferLayout.h, which packs the buffers of all bindings
+//! into the arena of a BufferManager. It checks the layouts of typical and degenerate bindings, and the invariants of
+//! random ones. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./buffer_layout_test
+//!
+
+#include "bufferLayout.h"
+#include "unitTest.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+//!
+//! \brief Checks what a BufferManager relies on: aligned offsets, inputs and outputs each contiguous in binding order,
+//!        no overlap, and an arena ending at the end of the last output.
+//!
+void checkInvariants(UnitTest& test, const std::vector<size_t>& nbBytes, const std::vector<bool>& isInput,
+    const BufferLayout& layout, size_t alignment)
+{
+    UNIT_EXPECT(test, layout.offsets.size() == nbBytes.size());
+    UNIT_EXPECT(test, layout.inputBegin == 0);
+    UNIT_EXPECT(test, layout.inputBegin <= layout.inputEnd);
+    UNIT_EXPECT(test, layout.inputEnd <= layout.outputBegin);
+    UNIT_EXPECT(test, layout.outputBegin <= layout.outputEnd);
+    UNIT_EXPECT(test, layout.totalBytes == layout.outputEnd);
+    UNIT_EXPECT(test, layout.outputBegin % alignment == 0);
+    for (const bool inputs : {true, false})
+    {
+        size_t end = inputs ? layout.inputBegin : layout.outputBegin;
+        for (size_t i = 0; i < nbBytes.size(); ++i)
+        {
+            if (isInput[i] != inputs)
+            {
+                continue;
+            }
+            UNIT_EXPECT(test, layout.offsets[i] % alignment == 0);
+            // Each binding follows the previous one of its group, after at most the padding to the alignment.
+            UNIT_EXPECT(test, layout.offsets[i] >= end && layout.offsets[i] < end + alignment);
+            end = layout.offsets[i] + nbBytes[i];
+        }
+        UNIT_EXPECT(test, end == (inputs ? layout.inputEnd : layout.outputEnd));
+    }
+}
+
+void testLayouts(UnitTest& test)
+{
+    test.setCase("no bindings");
+    BufferLayout layout = planBufferLayout({}, {});
+    UNIT_EXPECT(test, layout.offsets.empty());
+    UNIT_EXPECT(test, layout.totalBytes == 0);
+
+    test.setCase("interleaved inputs and outputs");
+    const std::vector<size_t> nbBytes{100, 4000, 256, 1};
+    const std::vector<bool> isInput{false, true, true, false};
+    layout = planBufferLayout(nbBytes, isInput);
+    checkInvariants(test, nbBytes, isInput, layout, kARENA_ALIGNMENT);
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{4352, 0, 4096, 4608}));
+    UNIT_EXPECT(test, layout.inputEnd == 4352);
+    UNIT_EXPECT(test, layout.outputBegin == 4352);
+    UNIT_EXPECT(test, layout.totalBytes == 4609);
+
+    test.setCase("inputs only");
+    layout = planBufferLayout({10, 20}, {true, true});
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{0, 256}));
+    UNIT_EXPECT(test, layout.inputEnd == 276);
+    UNIT_EXPECT(test, layout.outputBegin == 512 && layout.outputEnd == 512);
+    UNIT_EXPECT(test, layout.totalBytes == 512);
+
+    test.setCase("outputs only");
+    layout = planBufferLayout({10, 20}, {false, false});
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{0, 256}));
+    UNIT_EXPECT(test, layout.inputEnd == 0 && layout.outputBegin == 0);
+    UNIT_EXPECT(test, layout.totalBytes == 276);
+
+    test.setCase("custom alignment");
+    layout = planBufferLayout({3, 5, 7}, {true, false, true}, 1);
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{0, 10, 3}));
+    UNIT_EXPECT(test, layout.totalBytes == 15);
+}
+
+void testEmptyBindings(UnitTest& test)
+{
+    test.setCase("empty bindings");
+    // Bindings of zero bytes make an empty arena, which a BufferManager does not allocate.
+    BufferLayout layout = planBufferLayout({0, 0, 0}, {true, false, false});
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{0, 0, 0}));
+    UNIT_EXPECT(test, layout.inputEnd == 0 && layout.outputEnd == 0);
+    UNIT_EXPECT(test, layout.totalBytes == 0);
+
+    test.setCase("empty binding among others");
+    const std::vector<size_t> nbBytes{0, 64, 0, 32};
+    const std::vector<bool> isInput{true, true, false, false};
+    layout = planBufferLayout(nbBytes, isInput);
+    checkInvariants(test, nbBytes, isInput, layout, kARENA_ALIGNMENT);
+    // An empty binding takes no space, but still starts aligned.
+    UNIT_EXPECT(test, (layout.offsets == std::vector<size_t>{0, 0, 256, 256}));
+    UNIT_EXPECT(test, layout.totalBytes == 288);
+}
+
+void testRandomLayouts(UnitTest& test)
+{
+    test.setCase("random bindings");
+    std::mt19937 generator(2019);
+    std::uniform_int_distribution<int> count(1, 12);
+    std::uniform_int_distribution<size_t> bytes(0, 5000);
+    std::bernoulli_distribution input(0.4);
+    for (const size_t alignment : {size_t{1}, size_t{8}, kARENA_ALIGNMENT})
+    {
+        for (int run = 0; run < 200; ++run)
+        {
+            std::vector<size_t> nbBytes(count(generator));
+            std::vector<bool> isInput(nbBytes.size());
+            size_t sum = 0;
+            for (size_t i = 0; i < nbBytes.size(); ++i)
+            {
+                nbBytes[i] = bytes(generator);
+                isInput[i] = input(generator);
+                sum += nbBytes[i];
+            }
+            const BufferLayout layout = planBufferLayout(nbBytes, isInput, alignment);
+            checkInvariants(test, nbBytes, isInput, layout, alignment);
+            // The padding is less than one alignment per binding.
+            UNIT_EXPECT(test, layout.totalBytes >= sum && layout.totalBytes < sum + nbBytes.size() * alignment);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    UnitTest test("TensorRT.buffer_layout_test", argc, argv);
+    testLayouts(test);
+    testEmptyBindings(test);
+    testRandomLayouts(test);
+    return test.report();
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! bufferPoolBenchmark.cpp
+//! This file contains a CPU benchmark that churns host buffers from several threads, once with plain malloc
+//! and once through the size class buffer pool, and compares their throughput.
+//! It can be run with the following command line:
+//! Command: ./buffer_pool_benchmark [--threads=N] [--iterations=N] [--live=N] [--minSize=N] [--maxSize=N]
+//!
+
+#include "buffers.h"
+#include "getOptions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.buffer_pool_benchmark";
+
+//! Granularity at which buffers are touched, so that page faults are part of the cost of an allocation.
+constexpr size_t kPAGE_SIZE = 4096;
+
+//!
+//! \brief The BenchmarkOptions structure groups the command line options of the benchmark.
+//!
+struct BenchmarkOptions
+{
+    int threads{4};           //!< Number of threads churning buffers
+    int iterations{100000};   //!< Buffers replaced by each thread
+    int live{16};             //!< Buffers kept alive by each thread
+    size_t minSize{1 << 10};  //!< Smallest buffer size in bytes
+    size_t maxSize{4 << 20};  //!< Largest buffer size in bytes
+    bool touch{true};         //!< Write one byte per page of every buffer
+};
+
+//!
+//! \brief Replaces random buffers of a set of live buffers with new ones of random sizes from several threads,
+//!        and returns the number of buffers created per second.
+//!
+//! \details Sizes are log-uniform between minSize and maxSize. The sequence of sizes only depends on the thread
+//!          index, so every buffer type sees the same requests.
+//!
+template <typename TBuffer>
+double churn(const BenchmarkOptions& options)
+{
+    auto worker = [&options](int thread) {
+        std::mt19937 generator(thread + 1);
+        std::uniform_real_distribution<double> logSize(std::log(options.minSize), std::log(options.maxSize));
+        std::uniform_int_distribution<int> slot(0, options.live - 1);
+        std::vector<TBuffer> buffers(options.live);
+        for (int i = 0; i < options.iterations; ++i)
+        {
+            TBuffer& buffer = buffers[slot(generator)];
+            buffer = TBuffer(static_cast<size_t>(std::exp(logSize(generator))), nvinfer1::DataType::kINT8);
+            if (options.touch)
+            {
+                char* data = static_cast<char*>(buffer.data());
+                for (size_t offset = 0; offset < buffer.nbBytes(); offset += kPAGE_SIZE)
+                {
+                    data[offset] = static_cast<char>(i);
+                }
+            }
+        }
+    };
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t)
+    {
+        threads.emplace_back(worker, t);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return static_cast<double>(options.threads) * options.iterations / elapsed.count();
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./buffer_pool_benchmark [options]" << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    const std::vector<TRTOption> optionList = {
+        {0, "threads", true, "Number of threads churning buffers (default = 4)"},
+        {0, "iterations", true, "Number of buffers created by each thread (default = 100000)"},
+        {0, "live", true, "Number of buffers kept alive by each thread (default = 16)"},
+        {0, "minSize", true, "Smallest buffer size in bytes (default = 1024)"},
+        {0, "maxSize", true, "Largest buffer size in bytes (default = 4194304)"},
+        {0, "noTouch", false, "Do not write to the buffers, only allocate them"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kTHREADS, kITERATIONS, kLIVE, kMIN_SIZE, kMAX_SIZE, kNO_TOUCH, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    try
+    {
+        if (parsed.values[kTHREADS].first)
+        {
+            options.threads = std::stoi(value(kTHREADS));
+        }
+        if (parsed.values[kITERATIONS].first)
+        {
+            options.iterations = std::stoi(value(kITERATIONS));
+        }
+        if (parsed.values[kLIVE].first)
+        {
+            options.live = std::stoi(value(kLIVE));
+        }
+        if (parsed.values[kMIN_SIZE].first)
+        {
+            options.minSize = std::stoull(value(kMIN_SIZE));
+        }
+        if (parsed.values[kMAX_SIZE].first)
+        {
+            options.maxSize = std::stoull(value(kMAX_SIZE));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+    options.touch = !parsed.values[kNO_TOUCH].first;
+
+    if (options.threads < 1 || options.iterations < 1 || options.live < 1 || options.minSize < 1
+        || options.maxSize < options.minSize)
+    {
+        gLogError << "Please provide positive counts and 1 <= minSize <= maxSize" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    gLogInfo << options.threads << " threads, " << options.iterations << " buffers each, " << options.live
+             << " live buffers per thread, sizes " << options.minSize << " to " << options.maxSize << " bytes"
+             << std::endl;
+    const double mallocRate = churn<samplesCommon::HostBuffer>(options);
+    gLogInfo << "malloc: " << mallocRate << " buffers/s" << std::endl;
+    const double pooledRate = churn<samplesCommon::PooledHostBuffer>(options);
+    gLogInfo << "pooled: " << pooledRate << " buffers/s (" << pooledRate / mallocRate << "x)" << std::endl;
+    samplesCommon::BufferPool<samplesCommon::HostAllocator, samplesCommon::HostFree>::instance().printStats(
+        gLogInfo, "Host");
+    samplesCommon::trimBufferPools();
+
+    return gLogger.reportPass(toolTest);
+}
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! calibrateRanges.cpp
+//! This file contains a tool that computes per tensor dynamic ranges on the CPU from dumped activation tensors,
+//! and writes them in the tensor:range format read by sampleINT8API.
+//! It can be run with the following command line:
+//! Command: ./calibrate_ranges [--manifest=<file>] [<tensor>=<dump file>...] --output=<file> [--method=entropy]
+//!
+
+#include "calibrationCache.h"
+#include "common.h"
+#include "getOptions.h"
+#include "logger.h"
+#include "rangeCalibration.h"
+#include "rangeCheckpoint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.calibrate_ranges";
+
+//! Number of values parsed from a dump before they are added to the histogram.
+constexpr size_t kCHUNK_SIZE = 1 << 16;
+
+enum class RangeMethod
+{
+    kENTROPY,    //!< Minimize the KL divergence of the quantized distribution
+    kPERCENTILE, //!< Clip a fixed fraction of the values
+    kMAX         //!< Keep every value
+};
+
+//!
+//! \brief The RangeOptions structure groups the command line options of the tool.
+//!
+struct RangeOptions
+{
+    std::vector<std::pair<std::string, std::string>> dumps; //!< Tensor name and dump file pairs
+    std::string output;                                      //!< Dynamic range file to write
+    RangeMethod method{RangeMethod::kENTROPY};               //!< How ranges are derived from histograms
+    double percentile{99.99};                                //!< Percentile used by RangeMethod::kPERCENTILE
+    int bins{4096};                                          //!< Number of histogram bins
+    int threads{0};                                          //!< Number of threads, 0 for hardware threads
+    std::string checkpoint;                                  //!< File of the periodic checkpoints, if any
+    int checkpointInterval{64};                              //!< Number of dumps between checkpoints
+};
+
+//!
+//! \brief Adds every value of a dump to a histogram, a chunk at a time.
+//!
+//! \details Files ending in .bin or .raw hold raw float32 values. Other files are text dumps as written by
+//!          BufferManager::dumpBuffer() or the DumpTensorPlugin of sampleNMT: header lines starting with '[' or
+//!          "Batch size" are skipped, every other token is a value.
+//!
+bool addDump(const std::string& fileName, samplesCommon::StreamingHistogram& histogram)
+{
+    std::vector<float> chunk;
+    chunk.reserve(kCHUNK_SIZE);
+    auto flush = [&]() {
+        histogram.add(chunk.data(), chunk.size());
+        chunk.clear();
+    };
+
+    const std::string extension = fileName.substr(fileName.find_last_of('.') + 1);
+    if (extension == "bin" || extension == "raw")
+    {
+        std::ifstream file(fileName, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        chunk.resize(kCHUNK_SIZE);
+        while (file.read(reinterpret_cast<char*>(chunk.data()), kCHUNK_SIZE * sizeof(float)) || file.gcount())
+        {
+            chunk.resize(file.gcount() / sizeof(float));
+            flush();
+            chunk.resize(kCHUNK_SIZE);
+        }
+        return true;
+    }
+
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '[' || line.compare(0, 10, "Batch size") == 0)
+        {
+            continue;
+        }
+        const char* cursor = line.c_str();
+        char* end = nullptr;
+        for (float value = std::strtof(cursor, &end); end != cursor; value = std::strtof(cursor, &end))
+        {
+            chunk.push_back(value);
+            cursor = end;
+            if (chunk.size() == kCHUNK_SIZE)
+            {
+                flush();
+            }
+        }
+    }
+    flush();
+    return true;
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./calibrate_ranges [--manifest=<file>] [<tensor>=<dump file>...] --output=<file> [options]"
+              << std::endl;
+    std::cout << "Each dump holds values of one tensor; a tensor may have several dumps, e.g. one per batch." << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, RangeOptions& options)
+{
+    const std::vector<TRTOption> optionList = {
+        {0, "manifest", true, "File with one \"<tensor> <dump file>\" line per dump"},
+        {0, "output", true, "Dynamic range file to write, in the tensor:range format of sampleINT8API"},
+        {0, "method", true, "entropy, percentile or max (default = entropy)"},
+        {0, "percentile", true, "Percentile of the absolute values kept by --method=percentile (default = 99.99)"},
+        {0, "bins", true, "Number of histogram bins (default = 4096)"},
+        {0, "threads", true, "Number of threads (default = number of hardware threads)"},
+        {0, "checkpoint", true, "Checkpoint progress to this file, and resume from it if it was left by the same run"},
+        {0, "checkpointInterval", true, "Number of dumps between checkpoints (default = 64)"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kMANIFEST, kOUTPUT, kMETHOD, kPERCENTILE, kBINS, kTHREADS, kCHECKPOINT, kCHECKPOINT_INTERVAL, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    for (const auto& arg : parsed.positionalArgs)
+    {
+        const size_t separator = arg.rfind('=');
+        if (separator == std::string::npos || separator == 0)
+        {
+            gLogError << "Expected <tensor>=<dump file>, got " << arg << std::endl;
+            return false;
+        }
+        options.dumps.emplace_back(arg.substr(0, separator), arg.substr(separator + 1));
+    }
+    if (parsed.values[kMANIFEST].first)
+    {
+        std::ifstream manifest(value(kMANIFEST));
+        if (!manifest)
+        {
+            gLogError << "Could not open " << value(kMANIFEST) << std::endl;
+            return false;
+        }
+        std::string line;
+        while (std::getline(manifest, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            const size_t separator = line.find_last_of(" \t");
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            if (separator == std::string::npos || separator == 0)
+            {
+                gLogError << "Expected \"<tensor> <dump file>\", got " << line << std::endl;
+                return false;
+            }
+            options.dumps.emplace_back(line.substr(0, line.find_last_not_of(" \t", separator) + 1), line.substr(separator + 1));
+        }
+    }
+
+    try
+    {
+        if (parsed.values[kOUTPUT].first)
+        {
+            options.output = value(kOUTPUT);
+        }
+        if (parsed.values[kMETHOD].first)
+        {
+            const std::string method = value(kMETHOD);
+            if (method == "entropy")
+            {
+                options.method = RangeMethod::kENTROPY;
+            }
+            else if (method == "percentile")
+            {
+                options.method = RangeMethod::kPERCENTILE;
+            }
+            else if (method == "max")
+            {
+                options.method = RangeMethod::kMAX;
+            }
+            else
+            {
+                gLogError << "Invalid method " << method << std::endl;
+                return false;
+            }
+        }
+        if (parsed.values[kPERCENTILE].first)
+        {
+            options.percentile = std::stod(value(kPERCENTILE));
+        }
+        if (parsed.values[kBINS].first)
+        {
+            options.bins = std::stoi(value(kBINS));
+        }
+        if (parsed.values[kTHREADS].first)
+        {
+            options.threads = std::stoi(value(kTHREADS));
+        }
+        if (parsed.values[kCHECKPOINT].first)
+        {
+            options.checkpoint = value(kCHECKPOINT);
+        }
+        if (parsed.values[kCHECKPOINT_INTERVAL].first)
+        {
+            options.checkpointInterval = std::max(1, std::stoi(value(kCHECKPOINT_INTERVAL)));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (options.output.empty() || options.dumps.empty())
+    {
+        gLogError << "Please provide --output and at least one dump" << std::endl;
+        printHelpInfo(optionList);
+        return false;
+    }
+    if (options.bins < 256 || options.bins % 2)
+    {
+        gLogError << "--bins must be even and at least 256" << std::endl;
+        return false;
+    }
+    if (options.threads <= 0)
+    {
+        options.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    RangeOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    // One histogram per tensor; dumps are parsed in parallel into private histograms that are merged in.
+    std::vector<std::pair<std::string, std::string>> sources;
+    for (const auto& dump : options.dumps)
+    {
+        sources.emplace_back(dump.first, samplesCommon::fileIdentity(dump.second));
+    }
+    samplesCommon::CheckpointedHistograms histograms(
+        sources, options.bins, options.checkpoint, options.checkpointInterval);
+    if (histograms.resume())
+    {
+        gLogInfo << "Resuming from " << options.checkpoint << " after " << histograms.getSourcesDone() << " of "
+                 << histograms.getNbSources() << " dumps" << std::endl;
+    }
+
+    // Without a checkpoint file, all dumps form a single round.
+    std::atomic<bool> ok{true};
+    while (!histograms.isDone())
+    {
+        const int roundBegin = histograms.getSourcesDone();
+        samplesCommon::parallelFor(histograms.getRoundEnd() - roundBegin, options.threads, [&](int d) {
+            const int i = roundBegin + d;
+            samplesCommon::StreamingHistogram histogram(options.bins);
+            if (!addDump(options.dumps[i].second, histogram))
+            {
+                gLogError << "Could not read " << options.dumps[i].second << std::endl;
+                ok = false;
+                return;
+            }
+            histograms.add(i, histogram);
+        });
+        if (!ok)
+        {
+            return gLogger.reportFail(toolTest);
+        }
+        if (!histograms.endRound())
+        {
+            gLogWarning << "Could not write checkpoint " << options.checkpoint << std::endl;
+        }
+    }
+
+    std::vector<const std::string*> names;
+    std::vector<const samplesCommon::StreamingHistogram*> tensorHistograms;
+    for (const auto& tensor : histograms.getHistograms())
+    {
+        names.push_back(&tensor.first);
+        tensorHistograms.push_back(&tensor.second);
+    }
+    std::vector<float> ranges(names.size());
+    samplesCommon::parallelFor(static_cast<int>(names.size()), options.threads, [&](int i) {
+        const samplesCommon::StreamingHistogram& histogram = *tensorHistograms[i];
+        switch (options.method)
+        {
+        case RangeMethod::kENTROPY: ranges[i] = samplesCommon::entropyThreshold(histogram); break;
+        case RangeMethod::kPERCENTILE: ranges[i] = samplesCommon::percentileThreshold(histogram, options.percentile); break;
+        case RangeMethod::kMAX: ranges[i] = histogram.getMax(); break;
+        }
+    });
+
+    std::ofstream output(options.output);
+    if (!output)
+    {
+        gLogError << "Could not open " << options.output << std::endl;
+        return gLogger.reportFail(toolTest);
+    }
+    output << std::setprecision(9);
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        const samplesCommon::StreamingHistogram& histogram = *tensorHistograms[i];
+        if (ranges[i] <= 0.0F)
+        {
+            gLogWarning << "Skipping tensor " << *names[i] << ": all of its " << histogram.getCount()
+                        << " values are zero" << std::endl;
+            continue;
+        }
+        gLogInfo << "Tensor: " << *names[i] << ". Values: " << histogram.getCount() << ", max: " << histogram.getMax()
+                 << ", dynamic range: " << ranges[i] << std::endl;
+        output << *names[i] << ":" << ranges[i] << std::endl;
+    }
+    if (!output)
+    {
+        return gLogger.reportFail(toolTest);
+    }
+    histograms.removeCheckpoint();
+    return gLogger.reportPass(toolTest);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! calibrationCacheTest.cpp
+//! This file contains the unit test of CalibrationCacheStore of calibrationCache.h: tables read back as written,
+//! an index that keeps the latest entry of every key, builds writing tables and index entries concurrently without
+//! losing any, and failures of the index reported apart from those of the tables. It needs neither TensorRT nor a
+//! GPU.
+//! It can be run with the following command line:
+//! Command: ./calibration_cache_test
+//!
+
+#include "calibrationCache.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using samplesCommon::CalibrationCacheStore;
+
+namespace
+{
+
+const std::string kDIRECTORY = "calibration_cache_test_store";
+
+std::string makeKey(int writer, int table)
+{
+    return "key" + std::to_string(writer) + "_" + std::to_string(table);
+}
+
+//! Removes the tables of the keys and the index of a store, then its directory.
+void removeStore(const CalibrationCacheStore& store, const std::vector<std::string>& keys)
+{
+    for (const auto& key : keys)
+    {
+        std::remove(store.getPath(key).c_str());
+    }
+    std::remove(store.getIndexPath().c_str());
+    std::remove(store.getDirectory().c_str());
+}
+
+void testRoundTrip(samplesCommon::UnitTest& test)
+{
+    test.setCase("round trip");
+    const CalibrationCacheStore store(kDIRECTORY + "/nested");
+    std::vector<char> cache;
+    UNIT_EXPECT(test, !store.read("missing", cache));
+    const std::string table = "TRT-6015-EntropyCalibration2\ndata: 3c010a14\n";
+    UNIT_EXPECT(test, store.write("a", table.data(), table.size()));
+    UNIT_EXPECT(test, store.read("a", cache));
+    UNIT_EXPECT(test, std::string(cache.begin(), cache.end()) == table);
+    // A table written again replaces the previous one.
+    UNIT_EXPECT(test, store.write("a", "new", 3));
+    UNIT_EXPECT(test, store.read("a", cache) && std::string(cache.begin(), cache.end()) == "new");
+    removeStore(store, {"a"});
+    std::remove(kDIRECTORY.c_str());
+}
+
+void testIndex(samplesCommon::UnitTest& test)
+{
+    test.setCase("index");
+    const CalibrationCacheStore store(kDIRECTORY);
+    UNIT_EXPECT(test, store.write("a", "1", 1));
+    UNIT_EXPECT(test, store.readIndex().empty());
+    UNIT_EXPECT(test, store.addToIndex("a", "mnist"));
+    UNIT_EXPECT(test, store.addToIndex("b", "ssd two words"));
+    UNIT_EXPECT(test, store.addToIndex("a", "mnist again"));
+    UNIT_EXPECT(test, store.addToIndex("c", "multi\nline"));
+    // Every key once, with its latest description, in the order the keys were last written.
+    const std::vector<std::pair<std::string, std::string>> expected{
+        {"b", "ssd two words"}, {"a", "mnist again"}, {"c", "multi line"}};
+    UNIT_EXPECT(test, store.readIndex() == expected);
+    removeStore(store, {"a"});
+}
+
+void testConcurrentWriters(samplesCommon::UnitTest& test)
+{
+    test.setCase("concurrent writers");
+    // Builds running at once each store their tables and record them; no entry of the index may be lost.
+    const int nbWriters = 8;
+    const int nbTables = 50;
+    const CalibrationCacheStore store(kDIRECTORY);
+    std::vector<int> tablesWritten(nbWriters, 0);
+    std::vector<int> entriesWritten(nbWriters, 0);
+    std::vector<std::thread> writers;
+    for (int w = 0; w < nbWriters; ++w)
+    {
+        writers.emplace_back([&, w]() {
+            // Each writer has a store of its own, as separate processes would.
+            const CalibrationCacheStore own(kDIRECTORY);
+            for (int t = 0; t < nbTables; ++t)
+            {
+                const std::string key = makeKey(w, t);
+                tablesWritten[w] += own.write(key, key.data(), key.size());
+                entriesWritten[w] += own.addToIndex(key, "writer " + std::to_string(w));
+            }
+        });
+    }
+    for (auto& w : writers)
+    {
+        w.join();
+    }
+
+    std::vector<std::string> keys;
+    for (int w = 0; w < nbWriters; ++w)
+    {
+        UNIT_EXPECT(test, tablesWritten[w] == nbTables);
+        UNIT_EXPECT(test, entriesWritten[w] == nbTables);
+        for (int t = 0; t < nbTables; ++t)
+        {
+            keys.push_back(makeKey(w, t));
+            std::vector<char> cache;
+            UNIT_EXPECT(test, store.read(keys.back(), cache) && std::string(cache.begin(), cache.end()) == keys.back());
+        }
+    }
+    std::set<std::string> indexed;
+    for (const auto& entry : store.readIndex())
+    {
+        indexed.insert(entry.first);
+    }
+    UNIT_EXPECT(test, indexed == std::set<std::string>(keys.begin(), keys.end()));
+    removeStore(store, keys);
+}
+
+void testFailures(samplesCommon::UnitTest& test)
+{
+    test.setCase("index failure");
+    // An index that cannot be written does not make the table fail.
+    const CalibrationCacheStore store(kDIRECTORY);
+    UNIT_EXPECT(test, store.write("a", "1", 1));
+    UNIT_EXPECT(test, mkdir(store.getIndexPath().c_str(), 0755) == 0);
+    UNIT_EXPECT(test, !store.addToIndex("a", "mnist"));
+    std::vector<char> cache;
+    UNIT_EXPECT(test, store.read("a", cache));
+    rmdir(store.getIndexPath().c_str());
+    removeStore(store, {"a"});
+
+    test.setCase("table failure");
+    // A directory that cannot be created fails the table.
+    {
+        std::ofstream file(kDIRECTORY);
+    }
+    const CalibrationCacheStore blocked(kDIRECTORY + "/store");
+    UNIT_EXPECT(test, !blocked.write("a", "1", 1));
+    std::remove(kDIRECTORY.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.calibration_cache_test", argc, argv);
+    testRoundTrip(test);
+    testIndex(test);
+    testConcurrentWriters(test);
+    testFailures(test);
+    return test.report();
+}
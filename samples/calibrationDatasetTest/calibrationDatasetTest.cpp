@@ -0,0 +1,315 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! calibrationDatasetTest.cpp
+//! This file contains the unit test of the calibration dataset files of calibrationDataset.h: images and labels
+//! written by CalibrationDatasetWriter in float, half and uint8 are read back by DatasetBatchStream, the payload is
+//! aligned, and truncated or corrupted files are rejected by readDatasetHeader. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./calibration_dataset_test
+//!
+
+#include "BatchStream.h"
+#include "calibrationDataset.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+const std::string kDATASET = "calibration_dataset_test.dataset";
+constexpr int kCHANNELS = 2;
+constexpr int kHEIGHT = 3;
+constexpr int kWIDTH = 5;
+constexpr int kVOLUME = kCHANNELS * kHEIGHT * kWIDTH;
+
+//! Returns count images whose values are exact in half precision and in uint8 with scale 1/4 and bias -8.
+std::vector<float> makeImages(int count)
+{
+    std::vector<float> images(count * kVOLUME);
+    for (size_t e = 0; e < images.size(); ++e)
+    {
+        images[e] = static_cast<float>(e % 64) / 4.0F - 8.0F;
+    }
+    return images;
+}
+
+std::vector<float> makeLabels(int count)
+{
+    std::vector<float> labels(count);
+    for (int i = 0; i < count; ++i)
+    {
+        labels[i] = static_cast<float>(i % 10);
+    }
+    return labels;
+}
+
+//! Writes a dataset of count images in two ranges, the second one first.
+bool writeDataset(DatasetType type, int count, bool hasLabels, float scale = 1.0F, const std::vector<float>& bias = {})
+{
+    const std::vector<float> images = makeImages(count);
+    const std::vector<float> labels = makeLabels(count);
+    const CalibrationDatasetWriter writer(kDATASET, type, kCHANNELS, kHEIGHT, kWIDTH, count, hasLabels, scale, bias);
+    const int half = count / 2;
+    return writer.good()
+        && writer.writeImages(half, count - half, images.data() + half * kVOLUME, labels.data() + half)
+        && writer.writeImages(0, half, images.data(), labels.data());
+}
+
+std::vector<uint8_t> readFile(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int64_t readIndexEntry(const std::vector<uint8_t>& file, const CalibrationDatasetHeader& header, int64_t image)
+{
+    int64_t offset;
+    std::memcpy(&offset, file.data() + header.indexOffset + image * sizeof(int64_t), sizeof(offset));
+    return offset;
+}
+
+//! Reads the whole dataset in batches of batchSize and checks the images against images within tolerance.
+void checkStream(samplesCommon::UnitTest& test, int count, bool hasLabels, const std::vector<float>& images,
+    float tolerance)
+{
+    const int batchSize = 3;
+    DatasetBatchStream stream(batchSize, 100, kDATASET, {"./"});
+    UNIT_EXPECT(test, stream.getImageCount() == count);
+    const nvinfer1::Dims dims = stream.getDims();
+    UNIT_EXPECT(test, dims.nbDims == 4 && dims.d[0] == batchSize && dims.d[1] == kCHANNELS && dims.d[2] == kHEIGHT
+            && dims.d[3] == kWIDTH);
+
+    const std::vector<float> labels = makeLabels(count);
+    int batches = 0;
+    while (stream.next())
+    {
+        const float* batch = stream.getBatch();
+        const float* batchLabels = stream.getLabels();
+        for (int e = 0; e < batchSize * kVOLUME; ++e)
+        {
+            UNIT_EXPECT_NEAR(test, batch[e], images[batches * batchSize * kVOLUME + e], tolerance);
+        }
+        for (int i = 0; i < batchSize; ++i)
+        {
+            UNIT_EXPECT(test, batchLabels[i] == (hasLabels ? labels[batches * batchSize + i] : 0.0F));
+        }
+        ++batches;
+    }
+    // The last partial batch is dropped.
+    UNIT_EXPECT(test, batches == count / batchSize);
+    UNIT_EXPECT(test, stream.getBatchesRead() == batches);
+
+    // reset(b) starts at batch b.
+    stream.reset(1);
+    UNIT_EXPECT(test, stream.next());
+    UNIT_EXPECT_NEAR(test, stream.getBatch()[0], images[batchSize * kVOLUME], tolerance);
+}
+
+void testFloat(samplesCommon::UnitTest& test)
+{
+    test.setCase("float");
+    const int count = 8;
+    UNIT_EXPECT(test, writeDataset(DatasetType::kFLOAT, count, true));
+    checkStream(test, count, true, makeImages(count), 0.0F);
+
+    // Float batches are read in place from the mapping, so they inherit the alignment of the payload.
+    DatasetBatchStream stream(2, 1, kDATASET, {"./"});
+    UNIT_EXPECT(test, stream.next());
+    UNIT_EXPECT(test, reinterpret_cast<uintptr_t>(stream.getBatch()) % kDATASET_PAYLOAD_ALIGNMENT == 0);
+    UNIT_EXPECT(test, !stream.next());
+    std::remove(kDATASET.c_str());
+}
+
+void testHalf(samplesCommon::UnitTest& test)
+{
+    test.setCase("half");
+    const int count = 7;
+    UNIT_EXPECT(test, writeDataset(DatasetType::kHALF, count, false));
+    checkStream(test, count, false, makeImages(count), 0.0F);
+
+    // Values that half precision cannot hold are rounded to within its precision.
+    std::vector<float> images(count * kVOLUME);
+    for (size_t e = 0; e < images.size(); ++e)
+    {
+        images[e] = 0.1F * static_cast<float>(e) + 0.01F;
+    }
+    {
+        const CalibrationDatasetWriter writer(kDATASET, DatasetType::kHALF, kCHANNELS, kHEIGHT, kWIDTH, count, false);
+        UNIT_EXPECT(test, writer.writeImages(0, count, images.data(), nullptr));
+    }
+    DatasetBatchStream stream(count, 1, kDATASET, {"./"});
+    UNIT_EXPECT(test, stream.next());
+    for (size_t e = 0; e < images.size(); ++e)
+    {
+        UNIT_EXPECT_NEAR(test, stream.getBatch()[e], images[e], images[e] / 1024.0F);
+    }
+    std::remove(kDATASET.c_str());
+}
+
+void testUint8(samplesCommon::UnitTest& test)
+{
+    test.setCase("uint8");
+    const int count = 9;
+    UNIT_EXPECT(test, writeDataset(DatasetType::kUINT8, count, true, 0.25F, {-8.0F}));
+    checkStream(test, count, true, makeImages(count), 0.0F);
+
+    // Each channel has its own bias, and values outside the range of the bytes are clamped.
+    std::vector<float> images(kVOLUME);
+    for (int c = 0; c < kCHANNELS; ++c)
+    {
+        for (int j = 0; j < kHEIGHT * kWIDTH; ++j)
+        {
+            images[c * kHEIGHT * kWIDTH + j] = 100.0F * c + j;
+        }
+    }
+    images[0] = -1.0F;
+    images[kVOLUME - 1] = 1000.0F;
+    {
+        const CalibrationDatasetWriter writer(
+            kDATASET, DatasetType::kUINT8, kCHANNELS, kHEIGHT, kWIDTH, 1, false, 1.0F, {0.0F, 100.0F});
+        UNIT_EXPECT(test, writer.writeImages(0, 1, images.data(), nullptr));
+        UNIT_EXPECT(test, !writer.writeImages(1, 1, images.data(), nullptr));
+    }
+    DatasetBatchStream stream(1, 1, kDATASET, {"./"});
+    UNIT_EXPECT(test, stream.next());
+    const float* batch = stream.getBatch();
+    UNIT_EXPECT(test, batch[0] == 0.0F);
+    UNIT_EXPECT(test, batch[kVOLUME - 1] == 355.0F);
+    for (int e = 1; e < kVOLUME - 1; ++e)
+    {
+        UNIT_EXPECT(test, batch[e] == images[e]);
+    }
+    std::remove(kDATASET.c_str());
+}
+
+void testAlignment(samplesCommon::UnitTest& test)
+{
+    test.setCase("alignment");
+    // The payload starts on an aligned offset after the index and the labels, whatever their sizes.
+    for (const DatasetType type : {DatasetType::kFLOAT, DatasetType::kHALF, DatasetType::kUINT8})
+    {
+        for (int count = 1; count <= 20; ++count)
+        {
+            for (const bool hasLabels : {false, true})
+            {
+                UNIT_EXPECT(test, writeDataset(type, count, hasLabels));
+                const std::vector<uint8_t> file = readFile(kDATASET);
+                CalibrationDatasetHeader header;
+                UNIT_EXPECT(test, readDatasetHeader(file.data(), file.size(), header));
+                const int64_t payload = readIndexEntry(file, header, 0);
+                const int64_t tablesEnd = hasLabels ? header.labelsOffset + count * static_cast<int64_t>(sizeof(float))
+                                                    : header.indexOffset + (count + 1) * sizeof(int64_t);
+                UNIT_EXPECT(test, payload % kDATASET_PAYLOAD_ALIGNMENT == 0);
+                UNIT_EXPECT(test, payload >= tablesEnd && payload < tablesEnd + kDATASET_PAYLOAD_ALIGNMENT);
+                UNIT_EXPECT(test, readIndexEntry(file, header, count) == static_cast<int64_t>(file.size()));
+            }
+        }
+    }
+    std::remove(kDATASET.c_str());
+}
+
+void testInvalidFiles(samplesCommon::UnitTest& test)
+{
+    test.setCase("invalid files");
+    const int count = 4;
+    UNIT_EXPECT(test, writeDataset(DatasetType::kHALF, count, true));
+    const std::vector<uint8_t> file = readFile(kDATASET);
+    std::remove(kDATASET.c_str());
+    CalibrationDatasetHeader header;
+    UNIT_EXPECT(test, readDatasetHeader(file.data(), file.size(), header));
+    UNIT_EXPECT(test, !readDatasetHeader(nullptr, 0, header));
+
+    // Every truncation is rejected, down to an empty file.
+    bool rejected = true;
+    for (size_t size = 0; size < file.size(); ++size)
+    {
+        rejected &= !readDatasetHeader(file.data(), size, header);
+    }
+    UNIT_EXPECT(test, rejected);
+
+    auto corrupted = [&](size_t offset, uint8_t value) {
+        std::vector<uint8_t> copy(file);
+        copy[offset] = value;
+        return !readDatasetHeader(copy.data(), copy.size(), header);
+    };
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, magic), 'X'));
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, version), kDATASET_VERSION + 1));
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, type), 3));
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, channels), 0));
+    // An image count beyond what the file holds.
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, count), count + 1));
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, count) + 7, 0x40));
+    // Labels and index entries pointing outside the file or at images that are not back to back.
+    UNIT_EXPECT(test, corrupted(offsetof(CalibrationDatasetHeader, labelsOffset) + 4, 1));
+    UNIT_EXPECT(test, corrupted(sizeof(CalibrationDatasetHeader) + 2 * sizeof(int64_t), 0x7F));
+    UNIT_EXPECT(test, corrupted(sizeof(CalibrationDatasetHeader) + count * sizeof(int64_t) + 1, 0x7F));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.calibration_dataset_test", argc, argv);
+    testFloat(test);
+    testHalf(test);
+    testUint8(test);
+    testAlignment(test);
+    testInvalidFiles(test);
+    return test.report();
+}
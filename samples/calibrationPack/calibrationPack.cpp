@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! calibrationPack.cpp
+//! This file contains a tool that packs calibration data into a single-file calibration dataset
+//! (see common/calibrationDataset.h), which DatasetBatchStream reads.
+//! It can be run with the following command lines:
+//! Command: ./calibration_pack --batches=<path prefix> --output=<file> [--type=float|half|uint8]
+//! Command: ./calibration_pack --list=<list file> --dims=C,H,W --output=<file> [--type=float|half|uint8]
+//! Command: ./calibration_pack --idx=<IDX image file> [--labels=<IDX label file>] --output=<file> [--type=...]
+//!
+
+#include "calibrationDataset.h"
+#include "common.h"
+#include "getOptions.h"
+#include "logger.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.calibration_pack";
+
+//! Number of list file images decoded and written by one task.
+constexpr int kIMAGES_PER_TASK = 32;
+
+//!
+//! \brief The PackOptions structure groups the command line options of the tool.
+//!
+struct PackOptions
+{
+    std::string batches;                  //!< Path prefix of the <prefix>N<suffix> batch files
+    std::string suffix{".batch"};         //!< Suffix of the batch files
+    std::string list;                     //!< List file of PPM image names, without extension
+    std::string dir;                      //!< Directory of the PPM images, by default the one of the list file
+    int dims[3]{0, 0, 0};                 //!< C, H, W of the PPM images
+    std::vector<float> mean{127.5F};      //!< Subtracted from PPM pixels, per channel or for all channels
+    float scale{2.0F / 255.0F};           //!< Applied to PPM pixels after the mean is subtracted
+    bool bgr{false};                      //!< Store PPM channels in BGR order
+    std::string idx;                      //!< IDX image file, e.g. the MNIST train-images-idx3-ubyte
+    std::string labels;                   //!< IDX label file matching the IDX image file
+    std::string output;                   //!< Dataset file to write
+    samplesCommon::DatasetType type{samplesCommon::DatasetType::kFLOAT}; //!< Payload type
+    int threads{0};                       //!< Number of threads, 0 for the number of hardware threads
+};
+
+std::vector<float> splitFloats(const std::string& value)
+{
+    std::vector<float> values;
+    std::istringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        values.push_back(std::stof(item));
+    }
+    return values;
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./calibration_pack (--batches=<path prefix> | --list=<list file> --dims=C,H,W | "
+                 "--idx=<IDX image file>) --output=<file> [options]"
+              << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, PackOptions& options)
+{
+    const std::vector<TRTOption> optionList = {
+        {0, "batches", true, "Path prefix of the <prefix>N.batch files to pack, e.g. data/ssd/batches/batch_calibration"},
+        {0, "suffix", true, "Suffix of the batch files (default = .batch)"},
+        {0, "list", true, "List file of PPM image names without extension, one per line"},
+        {0, "dir", true, "Directory of the PPM images (default = directory of the list file)"},
+        {0, "dims", true, "C,H,W of the PPM images"},
+        {0, "mean", true, "Mean subtracted from PPM pixels, one value or one per channel (default = 127.5)"},
+        {0, "scale", true, "Scale applied to PPM pixels after subtracting the mean (default = 2/255)"},
+        {0, "bgr", false, "Store PPM images in BGR channel order"},
+        {0, "idx", true, "IDX image file to pack, normalized to pixel / 255 as MNISTBatchStream does"},
+        {0, "labels", true, "IDX label file stored as the labels of the --idx images"},
+        {0, "output", true, "Dataset file to write"},
+        {0, "type", true, "Payload type: float, half or uint8 (default = float)"},
+        {0, "threads", true, "Number of threads (default = number of hardware threads)"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kBATCHES, kSUFFIX, kLIST, kDIR, kDIMS, kMEAN, kSCALE, kBGR, kIDX, kLABELS, kOUTPUT, kTYPE, kTHREADS, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    try
+    {
+        if (parsed.values[kBATCHES].first)
+        {
+            options.batches = value(kBATCHES);
+        }
+        if (parsed.values[kSUFFIX].first)
+        {
+            options.suffix = value(kSUFFIX);
+        }
+        if (parsed.values[kLIST].first)
+        {
+            options.list = value(kLIST);
+        }
+        if (parsed.values[kDIR].first)
+        {
+            options.dir = value(kDIR);
+        }
+        if (parsed.values[kDIMS].first)
+        {
+            const std::vector<float> dims = splitFloats(value(kDIMS));
+            if (dims.size() != 3)
+            {
+                gLogError << "--dims expects C,H,W" << std::endl;
+                return false;
+            }
+            std::copy(dims.begin(), dims.end(), options.dims);
+        }
+        if (parsed.values[kMEAN].first)
+        {
+            options.mean = splitFloats(value(kMEAN));
+        }
+        if (parsed.values[kSCALE].first)
+        {
+            options.scale = std::stof(value(kSCALE));
+        }
+        options.bgr = parsed.values[kBGR].first > 0;
+        if (parsed.values[kIDX].first)
+        {
+            options.idx = value(kIDX);
+        }
+        if (parsed.values[kLABELS].first)
+        {
+            options.labels = value(kLABELS);
+        }
+        if (parsed.values[kOUTPUT].first)
+        {
+            options.output = value(kOUTPUT);
+        }
+        if (parsed.values[kTYPE].first)
+        {
+            const std::string type = value(kTYPE);
+            if (type == "float")
+            {
+                options.type = samplesCommon::DatasetType::kFLOAT;
+            }
+            else if (type == "half")
+            {
+                options.type = samplesCommon::DatasetType::kHALF;
+            }
+            else if (type == "uint8")
+            {
+                options.type = samplesCommon::DatasetType::kUINT8;
+            }
+            else
+            {
+                gLogError << "Invalid payload type " << type << std::endl;
+                return false;
+            }
+        }
+        if (parsed.values[kTHREADS].first)
+        {
+            options.threads = std::stoi(value(kTHREADS));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+
+    const int nbInputs = !options.batches.empty() + !options.list.empty() + !options.idx.empty();
+    if (options.output.empty() || nbInputs != 1)
+    {
+        gLogError << "Please provide --output and exactly one of --batches, --list or --idx" << std::endl;
+        printHelpInfo(optionList);
+        return false;
+    }
+    if (!options.list.empty() && (options.dims[0] != 3 || options.dims[1] <= 0 || options.dims[2] <= 0))
+    {
+        gLogError << "--list requires --dims=3,H,W" << std::endl;
+        return false;
+    }
+    if (options.threads <= 0)
+    {
+        options.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+//!
+//! \brief Packs <prefix>N<suffix> batch files. Each file is mapped and written by its own task.
+//!
+bool packBatchFiles(const PackOptions& options)
+{
+    std::vector<std::string> fileNames;
+    for (int i = 0;; ++i)
+    {
+        std::string fileName = options.batches + std::to_string(i) + options.suffix;
+        if (!std::ifstream(fileName).is_open())
+        {
+            break;
+        }
+        fileNames.emplace_back(std::move(fileName));
+    }
+    if (fileNames.empty())
+    {
+        gLogError << "Could not find " << options.batches << "0" << options.suffix << std::endl;
+        return false;
+    }
+
+    // Read the headers first to place the images of every file in the dataset.
+    const int nbFiles = static_cast<int>(fileNames.size());
+    std::vector<int64_t> firstImage(nbFiles + 1, 0);
+    int dims[4]{0, 0, 0, 0};
+    bool hasLabels = true;
+    for (int i = 0; i < nbFiles; ++i)
+    {
+        int d[4];
+        std::ifstream file(fileNames[i], std::ios::binary | std::ios::ate);
+        const int64_t size = file.tellg();
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(d), sizeof(d)) || d[0] <= 0 || d[1] <= 0 || d[2] <= 0 || d[3] <= 0
+            || (i > 0 && !std::equal(d + 1, d + 4, dims + 1)))
+        {
+            gLogError << "Invalid or mismatching batch file header in " << fileNames[i] << std::endl;
+            return false;
+        }
+        std::copy(d, d + 4, dims);
+        const int64_t dataSize = sizeof(d) + static_cast<int64_t>(d[0]) * d[1] * d[2] * d[3] * sizeof(float);
+        if (size < dataSize)
+        {
+            gLogError << "Truncated batch file " << fileNames[i] << std::endl;
+            return false;
+        }
+        hasLabels = hasLabels && size >= dataSize + static_cast<int64_t>(d[0] * sizeof(float));
+        firstImage[i + 1] = firstImage[i] + d[0];
+    }
+    const int64_t imageSize = static_cast<int64_t>(dims[1]) * dims[2] * dims[3];
+
+    // uint8 payloads are quantized over the range of the whole set.
+    float scale = 1.0F;
+    std::vector<float> bias{0.0F};
+    std::atomic<bool> ok{true};
+    if (options.type == samplesCommon::DatasetType::kUINT8)
+    {
+        std::vector<float> minimum(nbFiles, std::numeric_limits<float>::max());
+        std::vector<float> maximum(nbFiles, std::numeric_limits<float>::lowest());
+        samplesCommon::parallelFor(nbFiles, options.threads, [&](int i) {
+            samplesCommon::MappedFile file(fileNames[i]);
+            if (!file.isOpen())
+            {
+                ok = false;
+                return;
+            }
+            const float* data = reinterpret_cast<const float*>(file.data() + 4 * sizeof(int));
+            const auto range = std::minmax_element(data, data + (firstImage[i + 1] - firstImage[i]) * imageSize);
+            minimum[i] = *range.first;
+            maximum[i] = *range.second;
+        });
+        const float low = *std::min_element(minimum.begin(), minimum.end());
+        const float high = *std::max_element(maximum.begin(), maximum.end());
+        scale = high > low ? (high - low) / 255.0F : 1.0F;
+        bias[0] = low;
+    }
+
+    const samplesCommon::CalibrationDatasetWriter writer(
+        options.output, options.type, dims[1], dims[2], dims[3], firstImage[nbFiles], hasLabels, scale, bias);
+    if (!ok || !writer.good())
+    {
+        gLogError << "Could not create " << options.output << std::endl;
+        return false;
+    }
+
+    samplesCommon::parallelFor(nbFiles, options.threads, [&](int i) {
+        samplesCommon::MappedFile file(fileNames[i]);
+        const int64_t count = firstImage[i + 1] - firstImage[i];
+        const float* data = file.isOpen() ? reinterpret_cast<const float*>(file.data() + 4 * sizeof(int)) : nullptr;
+        if (!data || !writer.writeImages(firstImage[i], count, data, hasLabels ? data + count * imageSize : nullptr))
+        {
+            ok = false;
+        }
+    });
+    if (!ok)
+    {
+        gLogError << "Could not write " << options.output << std::endl;
+        return false;
+    }
+
+    gLogInfo << "Packed " << firstImage[nbFiles] << " images of " << dims[1] << "x" << dims[2] << "x" << dims[3]
+             << " from " << nbFiles << " batch files into " << options.output << std::endl;
+    return true;
+}
+
+//!
+//! \brief Packs the PPM images of a list file, normalized to (pixel - mean) * scale. Chunks of images are decoded
+//!        and written by independent tasks.
+//!
+bool packListFile(const PackOptions& options)
+{
+    std::ifstream list(options.list);
+    if (!list)
+    {
+        gLogError << "Could not open " << options.list << std::endl;
+        return false;
+    }
+    std::string dir = options.dir;
+    if (dir.empty())
+    {
+        const size_t slash = options.list.find_last_of('/');
+        dir = slash == std::string::npos ? "." : options.list.substr(0, slash);
+    }
+    std::vector<std::string> fileNames;
+    std::string name;
+    while (std::getline(list, name))
+    {
+        if (!name.empty() && name.back() == '\r')
+        {
+            name.pop_back();
+        }
+        if (!name.empty())
+        {
+            fileNames.emplace_back(dir + "/" + name + ".ppm");
+        }
+    }
+
+    const int c = options.dims[0];
+    const int h = options.dims[1];
+    const int w = options.dims[2];
+    std::vector<float> mean(c);
+    for (int ch = 0; ch < c; ++ch)
+    {
+        mean[ch] = options.mean[std::min<size_t>(ch, options.mean.size() - 1)];
+    }
+    // (pixel - mean) * scale == scale * pixel + bias, so uint8 payloads store the pixels themselves.
+    std::vector<float> bias(c);
+    for (int ch = 0; ch < c; ++ch)
+    {
+        bias[ch] = -mean[ch] * options.scale;
+    }
+
+    const int64_t count = fileNames.size();
+    const samplesCommon::CalibrationDatasetWriter writer(
+        options.output, options.type, c, h, w, count, false, options.scale, bias);
+    if (!writer.good())
+    {
+        gLogError << "Could not create " << options.output << std::endl;
+        return false;
+    }
+
+    const int volChl = h * w;
+    const int nbTasks = static_cast<int>((count + kIMAGES_PER_TASK - 1) / kIMAGES_PER_TASK);
+    std::atomic<bool> ok{true};
+    samplesCommon::parallelFor(nbTasks, options.threads, [&](int task) {
+        const int64_t first = static_cast<int64_t>(task) * kIMAGES_PER_TASK;
+        const int64_t chunk = std::min<int64_t>(kIMAGES_PER_TASK, count - first);
+        std::vector<float> images(chunk * c * volChl);
+        std::vector<uint8_t> pixels;
+        for (int64_t i = 0; i < chunk; ++i)
+        {
+            if (!samplesCommon::readPPMFile(fileNames[first + i], c, h, w, pixels))
+            {
+                gLogError << "Could not read a " << w << "x" << h << " PPM image from " << fileNames[first + i]
+                          << std::endl;
+                ok = false;
+                return;
+            }
+            float* image = images.data() + i * c * volChl;
+            for (int ch = 0; ch < c; ++ch)
+            {
+                const int source = options.bgr ? c - 1 - ch : ch;
+                for (int j = 0; j < volChl; ++j)
+                {
+                    image[ch * volChl + j] = (float(pixels[j * c + source]) - mean[ch]) * options.scale;
+                }
+            }
+        }
+        if (!writer.writeImages(first, chunk, images.data(), nullptr))
+        {
+            ok = false;
+        }
+    });
+    if (!ok)
+    {
+        return false;
+    }
+
+    gLogInfo << "Packed " << count << " images of " << c << "x" << h << "x" << w << " from " << options.list
+             << " into " << options.output << std::endl;
+    return true;
+}
+
+//!
+//! \brief Reads the big endian header value at index i of an IDX file.
+//!
+int readIdxHeader(const samplesCommon::MappedFile& file, int i)
+{
+    int value;
+    std::memcpy(&value, file.data() + i * sizeof(int), sizeof(int));
+    return samplesCommon::swapEndianness(value);
+}
+
+//!
+//! \brief Packs the images of an IDX image file, and optionally the labels of an IDX label file, normalized to
+//!        pixel / 255. uint8 payloads store the pixels themselves.
+//!
+bool packIdxFile(const PackOptions& options)
+{
+    constexpr int kIDX_IMAGES_MAGIC = 2051;
+    constexpr int kIDX_LABELS_MAGIC = 2049;
+    constexpr size_t kIDX_IMAGES_OFFSET = 4 * sizeof(int);
+    constexpr size_t kIDX_LABELS_OFFSET = 2 * sizeof(int);
+
+    samplesCommon::MappedFile images(options.idx);
+    if (!images.isOpen() || images.size() < kIDX_IMAGES_OFFSET || readIdxHeader(images, 0) != kIDX_IMAGES_MAGIC)
+    {
+        gLogError << "Could not read IDX image file " << options.idx << std::endl;
+        return false;
+    }
+    const int64_t count = readIdxHeader(images, 1);
+    const int h = readIdxHeader(images, 2);
+    const int w = readIdxHeader(images, 3);
+    const int64_t volImg = static_cast<int64_t>(h) * w;
+    if (count <= 0 || h <= 0 || w <= 0 || images.size() < kIDX_IMAGES_OFFSET + count * volImg)
+    {
+        gLogError << "Truncated IDX image file " << options.idx << std::endl;
+        return false;
+    }
+
+    samplesCommon::MappedFile labels;
+    if (!options.labels.empty()
+        && (!labels.open(options.labels) || labels.size() < kIDX_LABELS_OFFSET
+            || readIdxHeader(labels, 0) != kIDX_LABELS_MAGIC || readIdxHeader(labels, 1) != count
+            || labels.size() < kIDX_LABELS_OFFSET + count))
+    {
+        gLogError << "Could not read " << count << " labels from IDX label file " << options.labels << std::endl;
+        return false;
+    }
+    const bool hasLabels = labels.isOpen();
+
+    const samplesCommon::CalibrationDatasetWriter writer(
+        options.output, options.type, 1, h, w, count, hasLabels, 1.0F / 255.0F, {0.0F});
+    if (!writer.good())
+    {
+        gLogError << "Could not create " << options.output << std::endl;
+        return false;
+    }
+
+    const uint8_t* pixels = images.data() + kIDX_IMAGES_OFFSET;
+    const uint8_t* rawLabels = hasLabels ? labels.data() + kIDX_LABELS_OFFSET : nullptr;
+    const int nbTasks = static_cast<int>((count + kIMAGES_PER_TASK - 1) / kIMAGES_PER_TASK);
+    std::atomic<bool> ok{true};
+    samplesCommon::parallelFor(nbTasks, options.threads, [&](int task) {
+        const int64_t first = static_cast<int64_t>(task) * kIMAGES_PER_TASK;
+        const int64_t chunk = std::min<int64_t>(kIMAGES_PER_TASK, count - first);
+        std::vector<float> data(chunk * volImg);
+        std::transform(pixels + first * volImg, pixels + (first + chunk) * volImg, data.begin(),
+            [](uint8_t pixel) { return static_cast<float>(pixel) / 255.0F; });
+        std::vector<float> chunkLabels;
+        if (hasLabels)
+        {
+            chunkLabels.assign(rawLabels + first, rawLabels + first + chunk);
+        }
+        if (!writer.writeImages(first, chunk, data.data(), hasLabels ? chunkLabels.data() : nullptr))
+        {
+            ok = false;
+        }
+    });
+    if (!ok)
+    {
+        gLogError << "Could not write " << options.output << std::endl;
+        return false;
+    }
+
+    gLogInfo << "Packed " << count << " images of 1x" << h << "x" << w << " from " << options.idx << " into "
+             << options.output << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    PackOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    bool packed = false;
+    if (!options.batches.empty())
+    {
+        packed = packBatchFiles(options);
+    }
+    else if (!options.list.empty())
+    {
+        packed = packListFile(options);
+    }
+    else
+    {
+        packed = packIdxFile(options);
+    }
+    return packed ? gLogger.reportPass(toolTest) : gLogger.reportFail(toolTest);
+}
@@ -17,9 +17,13 @@
 #define BATCH_STREAM_H
 
 #include "NvInfer.h"
+#include "calibrationDataset.h"
 #include "common.h"
+#include "mappedFile.h"
 #include <algorithm>
 #include <assert.h>
+#include <fstream>
+#include <memory>
 #include <stdio.h>
 #include <vector>
 
@@ -37,6 +41,13 @@ public:
     virtual nvinfer1::Dims getImageDims() const = 0;
 };
 
+//!
+//! \brief  The MNISTBatchStream class streams batches out of the MNIST IDX image and label files.
+//!
+//! \details Both files are memory-mapped and kept in their raw uint8 form. A batch is only converted to
+//!          normalized floats when getBatch() or getLabels() asks for it, into buffers owned by the stream
+//!          that are reused for every batch. Copies of the stream share the mappings.
+//!
 class MNISTBatchStream : public IBatchStream
 {
 public:
@@ -48,6 +59,8 @@ public:
     {
         readDataFile(locateFile(dataFile, directories));
         readLabelsFile(locateFile(labelsFile, directories));
+        mBatch.resize(mBatchSize * samplesCommon::volume(mDims));
+        mLabels.resize(mBatchSize);
     }
 
     void reset(int firstBatch) override
@@ -72,12 +85,34 @@ public:
 
     float* getBatch() override
     {
-        return mData.data() + (mBatchCount * mBatchSize * samplesCommon::volume(mDims));
+        if (mBatchConverted != mBatchCount)
+        {
+            // The MNIST data is made up of unsigned bytes, so we need to cast to float and normalize.
+            const int imageSize = samplesCommon::volume(mDims);
+            const uint8_t* raw = mDataFile->data() + kIMAGES_OFFSET;
+            const int64_t first = static_cast<int64_t>(mBatchCount) * mBatchSize * imageSize;
+            const int64_t count = clampedCount(first, mBatch.size(), mNumImages * static_cast<int64_t>(imageSize));
+            std::transform(raw + first, raw + first + count, mBatch.begin(),
+                [](uint8_t val) { return static_cast<float>(val) / 255.f; });
+            std::fill(mBatch.begin() + count, mBatch.end(), 0.f);
+            mBatchConverted = mBatchCount;
+        }
+        return mBatch.data();
     }
 
     float* getLabels() override
     {
-        return mLabels.data() + (mBatchCount * mBatchSize);
+        if (mLabelsConverted != mBatchCount)
+        {
+            const uint8_t* raw = mLabelsFile->data() + kLABELS_OFFSET;
+            const int64_t first = static_cast<int64_t>(mBatchCount) * mBatchSize;
+            const int64_t count = clampedCount(first, mLabels.size(), mNumLabels);
+            std::transform(
+                raw + first, raw + first + count, mLabels.begin(), [](uint8_t val) { return static_cast<float>(val); });
+            std::fill(mLabels.begin() + count, mLabels.end(), 0.f);
+            mLabelsConverted = mBatchCount;
+        }
+        return mLabels.data();
     }
 
     int getBatchesRead() const override
@@ -101,59 +136,70 @@ public:
     }
 
 private:
+    static constexpr size_t kIMAGES_OFFSET = 4 * sizeof(int); //!< Size of the IDX image file header
+    static constexpr size_t kLABELS_OFFSET = 2 * sizeof(int); //!< Size of the IDX label file header
+
+    //! Reads the big endian header value at index i.
+    static int readHeader(const samplesCommon::MappedFile& file, int i)
+    {
+        int value;
+        std::memcpy(&value, file.data() + i * sizeof(int), sizeof(int));
+        // All values in the MNIST files are big endian.
+        return samplesCommon::swapEndianness(value);
+    }
+
+    //! Returns how many of the size elements starting at first exist among total elements.
+    static int64_t clampedCount(int64_t first, size_t size, int64_t total)
+    {
+        return std::max<int64_t>(0, std::min<int64_t>(static_cast<int64_t>(size), total - first));
+    }
+
     void readDataFile(const std::string& dataFilePath)
     {
-        std::ifstream file{dataFilePath.c_str(), std::ios::binary};
+        mDataFile = std::make_shared<samplesCommon::MappedFile>(dataFilePath);
+        assert(mDataFile->size() >= kIMAGES_OFFSET && "Could not map the MNIST image set");
 
-        int magicNumber, numImages, imageH, imageW;
-        file.read(reinterpret_cast<char*>(&magicNumber), sizeof(magicNumber));
-        // All values in the MNIST files are big endian.
-        magicNumber = samplesCommon::swapEndianness(magicNumber);
+        int magicNumber = readHeader(*mDataFile, 0);
         assert(magicNumber == 2051 && "Magic Number does not match the expected value for an MNIST image set");
 
         // Read number of images and dimensions
-        file.read(reinterpret_cast<char*>(&numImages), sizeof(numImages));
-        file.read(reinterpret_cast<char*>(&imageH), sizeof(imageH));
-        file.read(reinterpret_cast<char*>(&imageW), sizeof(imageW));
-
-        numImages = samplesCommon::swapEndianness(numImages);
-        imageH = samplesCommon::swapEndianness(imageH);
-        imageW = samplesCommon::swapEndianness(imageW);
-
-        // The MNIST data is made up of unsigned bytes, so we need to cast to float and normalize.
-        int numElements = numImages * imageH * imageW;
-        std::vector<uint8_t> rawData(numElements);
-        file.read(reinterpret_cast<char*>(rawData.data()), numElements * sizeof(uint8_t));
-        mData.resize(numElements);
-        std::transform(
-            rawData.begin(), rawData.end(), mData.begin(), [](uint8_t val) { return static_cast<float>(val) / 255.f; });
+        const int numImages = readHeader(*mDataFile, 1);
+        const int imageH = readHeader(*mDataFile, 2);
+        const int imageW = readHeader(*mDataFile, 3);
+        assert(imageH == mDims.d[1] && imageW == mDims.d[2]);
+        assert(mDataFile->size() >= kIMAGES_OFFSET + static_cast<size_t>(numImages) * imageH * imageW);
+        mNumImages = numImages;
+        (void) magicNumber;
+        (void) imageH;
+        (void) imageW;
     }
 
     void readLabelsFile(const std::string& labelsFilePath)
     {
-        std::ifstream file{labelsFilePath.c_str(), std::ios::binary};
-        int magicNumber, numImages;
-        file.read(reinterpret_cast<char*>(&magicNumber), sizeof(magicNumber));
-        // All values in the MNIST files are big endian.
-        magicNumber = samplesCommon::swapEndianness(magicNumber);
-        assert(magicNumber == 2049 && "Magic Number does not match the expected value for an MNIST labels file");
+        mLabelsFile = std::make_shared<samplesCommon::MappedFile>(labelsFilePath);
+        assert(mLabelsFile->size() >= kLABELS_OFFSET && "Could not map the MNIST labels file");
 
-        file.read(reinterpret_cast<char*>(&numImages), sizeof(numImages));
-        numImages = samplesCommon::swapEndianness(numImages);
+        int magicNumber = readHeader(*mLabelsFile, 0);
+        assert(magicNumber == 2049 && "Magic Number does not match the expected value for an MNIST labels file");
 
-        std::vector<uint8_t> rawLabels(numImages);
-        file.read(reinterpret_cast<char*>(rawLabels.data()), numImages * sizeof(uint8_t));
-        mLabels.resize(numImages);
-        std::transform(
-            rawLabels.begin(), rawLabels.end(), mLabels.begin(), [](uint8_t val) { return static_cast<float>(val); });
+        const int numImages = readHeader(*mLabelsFile, 1);
+        assert(mLabelsFile->size() >= kLABELS_OFFSET + static_cast<size_t>(numImages));
+        mNumLabels = numImages;
+        (void) magicNumber;
     }
 
     int mBatchSize{0};
     int mBatchCount{0}; //!< The batch that will be read on the next invocation of next()
     int mMaxBatches{0};
     Dims mDims{};
-    std::vector<float> mData{};
-    std::vector<float> mLabels{};
+    int64_t mNumImages{0};
+    int64_t mNumLabels{0};
+    std::shared_ptr<samplesCommon::MappedFile> mDataFile{};   //!< Raw IDX images
+    std::shared_ptr<samplesCommon::MappedFile> mLabelsFile{}; //!< Raw IDX labels
+    std::vector<float> mBatch{};                               //!< Normalized images of batch mBatchConverted
+    std::vector<float> mLabels{};                              //!< Labels of batch mLabelsConverted
+    int mBatchConverted{-1};
+    int mLabelsConverted{-1};
 };
 
 class BatchStream : public IBatchStream
@@ -194,13 +240,35 @@ public:
     }
 
     // This constructor expects that the dimensions include the batch dimension.
-    BatchStream(int maxBatches, nvinfer1::Dims dims, std::string listFile, std::vector<std::string> directories)
+    // The list file holds one PPM image name per line, without the extension. Images must be of size
+    // dims.d[2] x dims.d[3]; they are normalized to scale * pixel - bias and decoded on nbThreads threads
+    // (0 selects the number of hardware threads).
+    BatchStream(int maxBatches, nvinfer1::Dims dims, std::string listFile, std::vector<std::string> directories,
+        float scale = 2.0F / 255.0F, float bias = 1.0F, int nbThreads = 0)
         : mBatchSize(dims.d[0])
         , mMaxBatches(maxBatches)
         , mDims(dims)
         , mListFile(listFile)
         , mDataDir(directories)
+        , mScale(scale)
+        , mBias(bias)
+        , mNbThreads(nbThreads > 0 ? nbThreads : std::max(1U, std::thread::hardware_concurrency()))
     {
+        // Index the list file once rather than rereading it for every batch.
+        std::ifstream file(locateFile(mListFile, mDataDir));
+        std::string name;
+        while (std::getline(file, name))
+        {
+            if (!name.empty() && name.back() == '\r')
+            {
+                name.pop_back();
+            }
+            if (!name.empty())
+            {
+                mImageNames.emplace_back(name + ".ppm");
+            }
+        }
+
         mImageSize = mDims.d[1] * mDims.d[2] * mDims.d[3];
         mBatch.resize(mBatchSize * mImageSize, 0);
         mLabels.resize(mBatchSize, 0);
@@ -291,6 +359,14 @@ public:
         return Dims3{mDims.d[1], mDims.d[2], mDims.d[3]};
     }
 
+    //!
+    //! \brief Returns the PPM image names read from the list file, empty when reading batch files.
+    //!
+    const std::vector<std::string>& getImageNames() const
+    {
+        return mImageNames;
+    }
+
 private:
     float* getFileBatch()
     {
@@ -323,75 +399,443 @@ private:
         }
         else
         {
-            std::vector<std::string> fNames;
-            std::ifstream file(locateFile(mListFile, mDataDir), std::ios::binary);
-            if (!file)
+            const size_t firstImage = static_cast<size_t>(mFileCount) * mBatchSize;
+            if (firstImage + mBatchSize > mImageNames.size())
             {
                 return false;
             }
 
             gLogInfo << "Batch #" << mFileCount << std::endl;
-            file.seekg(((mBatchCount * mBatchSize)) * 7);
+            std::vector<std::string> fNames(mBatchSize);
+            for (int i = 0; i < mBatchSize; i++)
+            {
+                fNames[i] = locateFile(mImageNames[firstImage + i], mDataDir);
+                gLogInfo << "Calibrating with file " << mImageNames[firstImage + i] << std::endl;
+            }
+            mFileCount++;
 
-            for (int i = 1; i <= mBatchSize; i++)
+            // Decode and normalize each image straight into its slot of the file batch.
+            const int imageC = mDims.d[1];
+            const int imageH = mDims.d[2];
+            const int imageW = mDims.d[3];
+            const int volChl = imageH * imageW;
+            std::atomic<bool> decoded{true};
+            samplesCommon::parallelFor(mBatchSize, mNbThreads, [&](int i) {
+                std::vector<uint8_t> pixels;
+                if (!samplesCommon::readPPMFile(fNames[i], imageC, imageH, imageW, pixels))
+                {
+                    decoded = false;
+                    return;
+                }
+                float* image = getFileBatch() + static_cast<size_t>(i) * mImageSize;
+                for (int c = 0; c < imageC; ++c)
+                {
+                    for (int j = 0; j < volChl; ++j)
+                    {
+                        image[c * volChl + j] = mScale * float(pixels[j * imageC + c]) - mBias;
+                    }
+                }
+            });
+            if (!decoded)
             {
-                std::string sName;
-                std::getline(file, sName);
-                sName = sName + ".ppm";
-                gLogInfo << "Calibrating with file " << sName << std::endl;
-                fNames.emplace_back(sName);
+                gLogError << "Could not read a " << imageW << "x" << imageH << " PPM image of batch #"
+                          << mFileCount - 1 << std::endl;
+                return false;
             }
+        }
 
-            mFileCount++;
+        mFileBatchPos = 0;
+        return true;
+    }
 
-            const int imageC = 3;
-            const int imageH = 300;
-            const int imageW = 300;
-            std::vector<samplesCommon::PPM<imageC, imageH, imageW>> ppms(fNames.size());
-            for (uint32_t i = 0; i < fNames.size(); ++i)
+    int mBatchSize{0};
+    int mMaxBatches{0};
+    int mBatchCount{0};
+    int mFileCount{0};
+    int mFileBatchPos{0};
+    int mImageSize{0};
+    std::vector<float> mBatch;             //!< Data for the batch
+    std::vector<float> mLabels;            //!< Labels for the batch
+    std::vector<float> mFileBatch;         //!< List of image files
+    std::vector<float> mFileLabels;        //!< List of label files
+    std::string mPrefix;                   //!< Batch file name prefix
+    std::string mSuffix;                   //!< Batch file name suffix
+    nvinfer1::Dims mDims;                  //!< Input dimensions
+    std::string mListFile;                 //!< File name of the list of image names
+    std::vector<std::string> mDataDir;     //!< Directories where the files can be found
+    std::vector<std::string> mImageNames;  //!< Image file names read from the list file
+    float mScale{2.0F / 255.0F};           //!< Scale applied to list file pixels
+    float mBias{1.0F};                     //!< Bias subtracted from scaled list file pixels
+    int mNbThreads{1};                     //!< Number of threads decoding list file images
+};
+
+//!
+//! \brief  The MappedBatchStream class streams batches out of memory-mapped <prefix>N<suffix> batch files.
+//!
+//! \details It reads the same files as BatchStream, but every file is mapped once on first use instead of being
+//!          read and copied on every pass. If a requested batch lies within a single file, getBatch() and
+//!          getLabels() point straight into the mapping; batches that straddle two files are gathered with a
+//!          single copy into a stream-owned buffer. Copies of the stream share the mappings.
+//!
+class MappedBatchStream : public IBatchStream
+{
+public:
+    MappedBatchStream(
+        int batchSize, int maxBatches, std::string prefix, std::string suffix, std::vector<std::string> directories)
+        : mBatchSize(batchSize)
+        , mMaxBatches(maxBatches)
+    {
+        // Only the first file is searched for; the others are expected to lie in the same directory.
+        const std::string firstFile = locateFile(prefix + std::string("0") + suffix, directories);
+        const std::string pathPrefix = firstFile.substr(0, firstFile.size() - suffix.size() - 1);
+        for (int i = 0;; ++i)
+        {
+            std::string fileName = pathPrefix + std::to_string(i) + suffix;
+            if (!std::ifstream(fileName).is_open())
             {
-                readPPMFile(locateFile(fNames[i], mDataDir), ppms[i]);
+                break;
             }
+            mFileNames.emplace_back(std::move(fileName));
+        }
+        mFiles = std::make_shared<std::vector<samplesCommon::MappedFile>>(mFileNames.size());
+
+        const int* d = reinterpret_cast<const int*>(mapFile(0));
+        mDims.nbDims = 4;  // The number of dimensions.
+        mDims.d[0] = d[0]; // Batch Size
+        mDims.d[1] = d[1]; // Channels
+        mDims.d[2] = d[2]; // Height
+        mDims.d[3] = d[3]; // Width
+        assert(mDims.d[0] > 0 && mDims.d[1] > 0 && mDims.d[2] > 0 && mDims.d[3] > 0);
 
-            std::vector<float> data(samplesCommon::volume(mDims));
-            const float scale = 2.0 / 255.0;
-            const float bias = 1.0;
-            long int volChl = mDims.d[2] * mDims.d[3];
+        mImageSize = mDims.d[1] * mDims.d[2] * mDims.d[3];
+        mTotalImages = static_cast<int64_t>(mFileNames.size()) * mDims.d[0];
+        mBatch.resize(mBatchSize * mImageSize, 0);
+        mLabels.resize(mBatchSize, 0);
+        reset(0);
+    }
+
+    MappedBatchStream(int batchSize, int maxBatches, std::string prefix, std::vector<std::string> directories)
+        : MappedBatchStream(batchSize, maxBatches, prefix, ".batch", directories)
+    {
+    }
 
-            // Normalize input data
-            for (int i = 0, volImg = mDims.d[1] * mDims.d[2] * mDims.d[3]; i < mBatchSize; ++i)
+    void reset(int firstBatch) override
+    {
+        mBatchCount = 0;
+        mImagePos = 0;
+        mBatchFile = -1;
+        skip(firstBatch);
+    }
+
+    bool next() override
+    {
+        if (mBatchCount == mMaxBatches || mImagePos + mBatchSize > mTotalImages)
+        {
+            return false;
+        }
+
+        const int fileBatchSize = mDims.d[0];
+        const int firstFile = static_cast<int>(mImagePos / fileBatchSize);
+        const int firstPos = static_cast<int>(mImagePos % fileBatchSize);
+        if (firstPos + mBatchSize <= fileBatchSize)
+        {
+            // The whole batch lives in one file, so it can be handed out without copying.
+            mapFile(firstFile);
+            mBatchFile = firstFile;
+            mBatchFilePos = firstPos;
+        }
+        else
+        {
+            mBatchFile = -1;
+            for (int csize = 0, batchPos = 0; batchPos < mBatchSize; batchPos += csize)
             {
-                for (int c = 0; c < mDims.d[1]; ++c)
+                const int64_t image = mImagePos + batchPos;
+                const int file = static_cast<int>(image / fileBatchSize);
+                const int pos = static_cast<int>(image % fileBatchSize);
+                mapFile(file);
+                csize = std::min(mBatchSize - batchPos, fileBatchSize - pos);
+                std::copy_n(getFileBatch(file) + pos * mImageSize, csize * mImageSize, mBatch.data() + batchPos * mImageSize);
+                const float* labels = getFileLabels(file);
+                if (labels)
                 {
-                    for (int j = 0; j < volChl; ++j)
-                    {
-                        data[i * volImg + c * volChl + j] = scale * float(ppms[i].buffer[j * mDims.d[1] + c]) - bias;
-                    }
+                    std::copy_n(labels + pos, csize, mLabels.data() + batchPos);
+                }
+                else
+                {
+                    std::fill_n(mLabels.data() + batchPos, csize, 0.0f);
                 }
             }
+        }
+
+        mImagePos += mBatchSize;
+        mBatchCount++;
+        prefetch(mImagePos);
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mImagePos += static_cast<int64_t>(skipCount) * mBatchSize;
+    }
 
-            std::copy_n(data.data(), mDims.d[0] * mImageSize, getFileBatch());
+    float* getBatch() override
+    {
+        return mBatchFile < 0 ? mBatch.data() : getFileBatch(mBatchFile) + mBatchFilePos * mImageSize;
+    }
+
+    float* getLabels() override
+    {
+        if (mBatchFile < 0)
+        {
+            return mLabels.data();
+        }
+        float* labels = getFileLabels(mBatchFile);
+        if (!labels)
+        {
+            std::fill(mLabels.begin(), mLabels.end(), 0.0f);
+            return mLabels.data();
         }
+        return labels + mBatchFilePos;
+    }
 
-        mFileBatchPos = 0;
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mDims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return Dims3{mDims.d[1], mDims.d[2], mDims.d[3]};
+    }
+
+    //!
+    //! \brief Returns the paths of the batch files the stream reads from.
+    //!
+    const std::vector<std::string>& getFileNames() const
+    {
+        return mFileNames;
+    }
+
+private:
+    static constexpr size_t kHEADER_SIZE = 4 * sizeof(int);
+
+    //! Maps the file on first use and returns the start of the mapping.
+    uint8_t* mapFile(int file)
+    {
+        samplesCommon::MappedFile& mapping = (*mFiles)[file];
+        if (!mapping.isOpen())
+        {
+            bool mapped = mapping.open(mFileNames[file]);
+            assert(mapped && mapping.size() >= kHEADER_SIZE);
+            const int* d = reinterpret_cast<const int*>(mapping.data());
+            assert(file == 0 || (mDims.d[0] == d[0] && mDims.d[1] == d[1] && mDims.d[2] == d[2] && mDims.d[3] == d[3]));
+            (void) mapped;
+            (void) d;
+        }
+        return mapping.data();
+    }
+
+    float* getFileBatch(int file)
+    {
+        return reinterpret_cast<float*>((*mFiles)[file].data() + kHEADER_SIZE);
+    }
+
+    //! Returns nullptr if the file does not carry labels.
+    float* getFileLabels(int file)
+    {
+        const size_t dataSize = kHEADER_SIZE + static_cast<size_t>(mDims.d[0]) * mImageSize * sizeof(float);
+        if ((*mFiles)[file].size() < dataSize + mDims.d[0] * sizeof(float))
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<float*>((*mFiles)[file].data() + dataSize);
+    }
+
+    //! Asks the kernel to start reading the batch starting at imagePos in the background.
+    void prefetch(int64_t imagePos)
+    {
+        const int fileBatchSize = mDims.d[0];
+        for (int64_t image = imagePos, end = std::min(imagePos + mBatchSize, mTotalImages); image < end;)
+        {
+            const int file = static_cast<int>(image / fileBatchSize);
+            const int pos = static_cast<int>(image % fileBatchSize);
+            const int count = static_cast<int>(std::min<int64_t>(end - image, fileBatchSize - pos));
+            mapFile(file);
+            (*mFiles)[file].prefetch(kHEADER_SIZE + static_cast<size_t>(pos) * mImageSize * sizeof(float),
+                static_cast<size_t>(count) * mImageSize * sizeof(float));
+            image += count;
+        }
+    }
+
+    int mBatchSize{0};
+    int mMaxBatches{0};
+    int mBatchCount{0};
+    int mImageSize{0};
+    int64_t mImagePos{0};     //!< Index of the first image of the next batch, counted over all files
+    int64_t mTotalImages{0};  //!< Number of images in all batch files
+    int mBatchFile{-1};       //!< File holding the current batch, or -1 if it was gathered into mBatch
+    int mBatchFilePos{0};     //!< Position of the current batch in mBatchFile
+    nvinfer1::Dims mDims;     //!< Input dimensions, the batch dimension is the one of the files
+    std::vector<float> mBatch;                                     //!< Gathered data for batches spanning files
+    std::vector<float> mLabels;                                    //!< Gathered labels for batches spanning files
+    std::vector<std::string> mFileNames;                           //!< Paths of all batch files
+    std::shared_ptr<std::vector<samplesCommon::MappedFile>> mFiles; //!< Mappings, shared between copies
+};
+
+//!
+//! \brief  The DatasetBatchStream class streams batches out of a single-file calibration dataset.
+//!
+//! \details The dataset (see calibrationDataset.h) is opened and mapped once, whatever its size. Batches are
+//!          consecutive runs of images located through the index of the file, so reset() and skip() are O(1).
+//!          Float payloads are handed out without copying; half and uint8 payloads are converted into a
+//!          stream-owned buffer. Copies of the stream share the mapping.
+//!
+class DatasetBatchStream : public IBatchStream
+{
+public:
+    DatasetBatchStream(int batchSize, int maxBatches, std::string fileName, std::vector<std::string> directories)
+        : mBatchSize(batchSize)
+        , mMaxBatches(maxBatches)
+        , mFile(std::make_shared<samplesCommon::MappedFile>())
+    {
+        std::memset(&mHeader, 0, sizeof(mHeader));
+        const std::string path = locateFile(fileName, directories);
+        const bool mapped
+            = mFile->open(path) && samplesCommon::readDatasetHeader(mFile->data(), mFile->size(), mHeader);
+        if (!mapped)
+        {
+            gLogError << "Could not read calibration dataset " << path << std::endl;
+            assert(mapped);
+            mHeader.count = 0;
+        }
+
+        mDims.nbDims = 4;
+        mDims.d[0] = mBatchSize;
+        mDims.d[1] = mHeader.channels;
+        mDims.d[2] = mHeader.height;
+        mDims.d[3] = mHeader.width;
+        mImageSize = mDims.d[1] * mDims.d[2] * mDims.d[3];
+        if (mHeader.type != static_cast<int32_t>(samplesCommon::DatasetType::kFLOAT))
+        {
+            mBatch.resize(mBatchSize * mImageSize, 0);
+        }
+        mLabels.resize(mBatchSize, 0);
+        reset(0);
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = 0;
+        mImagePos = 0;
+        skip(firstBatch);
+    }
+
+    bool next() override
+    {
+        if (mBatchCount == mMaxBatches || mImagePos + mBatchSize > mHeader.count)
+        {
+            return false;
+        }
+
+        const uint8_t* payload = mFile->data() + imageOffset(mImagePos);
+        if (mBatch.empty())
+        {
+            mBatchData = reinterpret_cast<float*>(const_cast<uint8_t*>(payload));
+        }
+        else
+        {
+            samplesCommon::decodeDatasetImages(mHeader, payload, mBatchSize, mBatch.data());
+            mBatchData = mBatch.data();
+        }
+        if (mHeader.hasLabels)
+        {
+            std::memcpy(mLabels.data(), mFile->data() + mHeader.labelsOffset + mImagePos * sizeof(float),
+                mBatchSize * sizeof(float));
+        }
+
+        mImagePos += mBatchSize;
+        mBatchCount++;
+        if (mImagePos + mBatchSize <= mHeader.count)
+        {
+            const int64_t begin = imageOffset(mImagePos);
+            mFile->prefetch(begin, imageOffset(mImagePos + mBatchSize) - begin);
+        }
         return true;
     }
 
+    void skip(int skipCount) override
+    {
+        mImagePos += static_cast<int64_t>(skipCount) * mBatchSize;
+    }
+
+    float* getBatch() override
+    {
+        return mBatchData;
+    }
+
+    float* getLabels() override
+    {
+        return mLabels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mDims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return Dims3{mDims.d[1], mDims.d[2], mDims.d[3]};
+    }
+
+    //!
+    //! \brief Returns the number of images in the dataset.
+    //!
+    int64_t getImageCount() const
+    {
+        return mHeader.count;
+    }
+
+private:
+    //! Returns the offset of an image in the file; image count is the end of the payload.
+    int64_t imageOffset(int64_t image) const
+    {
+        int64_t offset;
+        std::memcpy(&offset, mFile->data() + mHeader.indexOffset + image * sizeof(int64_t), sizeof(offset));
+        return offset;
+    }
+
     int mBatchSize{0};
     int mMaxBatches{0};
     int mBatchCount{0};
-    int mFileCount{0};
-    int mFileBatchPos{0};
     int mImageSize{0};
-    std::vector<float> mBatch;         //!< Data for the batch
-    std::vector<float> mLabels;        //!< Labels for the batch
-    std::vector<float> mFileBatch;     //!< List of image files
-    std::vector<float> mFileLabels;    //!< List of label files
-    std::string mPrefix;               //!< Batch file name prefix
-    std::string mSuffix;               //!< Batch file name suffix
-    nvinfer1::Dims mDims;              //!< Input dimensions
-    std::string mListFile;             //!< File name of the list of image names
-    std::vector<std::string> mDataDir; //!< Directories where the files can be found
+    int64_t mImagePos{0};                           //!< Index of the first image of the next batch
+    samplesCommon::CalibrationDatasetHeader mHeader; //!< Header of the dataset file
+    nvinfer1::Dims mDims;                           //!< Input dimensions
+    float* mBatchData{nullptr};                     //!< Data of the current batch
+    std::vector<float> mBatch;                      //!< Converted batch, unused for float payloads
+    std::vector<float> mLabels;                     //!< Labels for the batch
+    std::shared_ptr<samplesCommon::MappedFile> mFile; //!< Mapping of the dataset, shared between copies
 };
 
 #endif
@@ -19,21 +19,28 @@
 
 #include "BatchStream.h"
 #include "NvInfer.h"
+#include "calibrationCache.h"
 
 //! \class EntropyCalibratorImpl
 //!
 //! \brief Implements common functionality for Entropy calibrators.
 //!
+//! If a cache key is given, the calibration table is kept in a CalibrationCacheStore under that key.
+//! Otherwise it is read from and written to "CalibrationTable" + networkName in the working directory.
+//!
 template <typename TBatchStream>
 class EntropyCalibratorImpl
 {
 public:
     EntropyCalibratorImpl(
-        TBatchStream stream, int firstBatch, std::string networkName, const char* inputBlobName, bool readCache = true)
+        TBatchStream stream, int firstBatch, std::string networkName, const char* inputBlobName, bool readCache = true,
+        std::string cacheKey = "", std::string cacheDirectory = "")
         : mStream{stream}
         , mCalibrationTableName("CalibrationTable" + networkName)
         , mInputBlobName(inputBlobName)
         , mReadCache(readCache)
+        , mCacheKey(cacheKey)
+        , mCacheStore(cacheDirectory)
     {
         nvinfer1::Dims imageDims = mStream.getImageDims();
         mInputCount = samplesCommon::volume(imageDims) * mStream.getBatchSize();
@@ -63,6 +70,15 @@ public:
     const void* readCalibrationCache(size_t& length)
     {
         mCalibrationCache.clear();
+        if (!mCacheKey.empty())
+        {
+            if (mReadCache && mCacheStore.read(mCacheKey, mCalibrationCache))
+            {
+                gLogInfo << "Using calibration table " << mCacheStore.getPath(mCacheKey) << std::endl;
+            }
+            length = mCalibrationCache.size();
+            return length ? mCalibrationCache.data() : nullptr;
+        }
         std::ifstream input(mCalibrationTableName, std::ios::binary);
         input >> std::noskipws;
         if (mReadCache && input.good())
@@ -75,6 +91,18 @@ public:
 
     void writeCalibrationCache(const void* cache, size_t length)
     {
+        if (!mCacheKey.empty())
+        {
+            if (!mCacheStore.write(mCacheKey, cache, length))
+            {
+                gLogWarning << "Could not store calibration table in " << mCacheStore.getDirectory() << std::endl;
+            }
+            else if (!mCacheStore.addToIndex(mCacheKey, mCalibrationTableName))
+            {
+                gLogWarning << "Could not record calibration table in " << mCacheStore.getIndexPath() << std::endl;
+            }
+            return;
+        }
         std::ofstream output(mCalibrationTableName, std::ios::binary);
         output.write(reinterpret_cast<const char*>(cache), length);
     }
@@ -85,6 +113,8 @@ private:
     std::string mCalibrationTableName;
     const char* mInputBlobName;
     bool mReadCache{true};
+    std::string mCacheKey;
+    samplesCommon::CalibrationCacheStore mCacheStore;
     void* mDeviceInput{nullptr};
     std::vector<char> mCalibrationCache;
 };
@@ -93,14 +123,20 @@ private:
 //!
 //! \brief Implements Entropy calibrator 2.
 //!  CalibrationAlgoType is kENTROPY_CALIBRATION_2.
+//!  networkKey, if given, comes from samplesCommon::networkCacheKey(); the batch size and the
+//!  algorithm are added to it to form the key of the table in the cache store.
 //!
 template <typename TBatchStream>
 class Int8EntropyCalibrator2 : public IInt8EntropyCalibrator2
 {
 public:
-    Int8EntropyCalibrator2(
-        TBatchStream stream, int firstBatch, const char* networkName, const char* inputBlobName, bool readCache = true)
-        : mImpl(stream, firstBatch, networkName, inputBlobName, readCache)
+    Int8EntropyCalibrator2(TBatchStream stream, int firstBatch, const char* networkName, const char* inputBlobName,
+        bool readCache = true, const std::string& networkKey = "", const std::string& cacheDirectory = "")
+        : mImpl(stream, firstBatch, networkName, inputBlobName, readCache,
+            networkKey.empty() ? networkKey
+                               : samplesCommon::calibrationCacheKey(networkKey, stream.getBatchSize(),
+                                   CalibrationAlgoType::kENTROPY_CALIBRATION_2),
+            cacheDirectory)
     {
     }
 
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PREFETCHING_BATCH_STREAM_H
+#define PREFETCHING_BATCH_STREAM_H
+
+#include "BatchStream.h"
+#include "NvInfer.h"
+#include "common.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//!
+//! \brief  The PrefetchingBatchStream class reads batches of another stream ahead of time on a background thread.
+//!
+//! \details While the caller works on batch N, batches N+1..N+depth are loaded by calling next() on the wrapped
+//!          stream and are copied into a ring of preallocated buffers. The background thread is only started by
+//!          the first call to next(), so reset() and skip() issued before that are forwarded unchanged. Later,
+//!          reset() restarts the wrapped stream and skip() first consumes batches that were already prefetched.
+//!          The stream can be copied only while its background thread is not running, which is the case until
+//!          next() is first called.
+//!
+template <typename TBatchStream>
+class PrefetchingBatchStream : public IBatchStream
+{
+public:
+    PrefetchingBatchStream(TBatchStream stream, int depth = 2)
+        : mStream(stream)
+        , mDepth(std::max(depth, 1))
+    {
+        allocateSlots();
+    }
+
+    PrefetchingBatchStream(const PrefetchingBatchStream& other)
+        : mStream(other.mStream)
+        , mDepth(other.mDepth)
+    {
+        allocateSlots();
+    }
+
+    ~PrefetchingBatchStream()
+    {
+        stop();
+    }
+
+    void reset(int firstBatch) override
+    {
+        stop();
+        releaseAll();
+        mStream.reset(firstBatch);
+        mBatchCount = 0;
+    }
+
+    bool next() override
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mStarted)
+        {
+            mStarted = true;
+            mWorker = std::thread(&PrefetchingBatchStream::prefetch, this);
+        }
+        if (mCurrent >= 0)
+        {
+            mFree.push_back(mCurrent);
+            mCurrent = -1;
+            mCondition.notify_all();
+        }
+        mCondition.wait(lock, [this] { return !mReady.empty() || mEnd; });
+        if (mReady.empty())
+        {
+            return false;
+        }
+        mCurrent = mReady.front();
+        mReady.pop_front();
+        ++mBatchCount;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        stop();
+        while (skipCount > 0 && !mReady.empty())
+        {
+            mFree.push_back(mReady.front());
+            mReady.pop_front();
+            --skipCount;
+        }
+        if (skipCount > 0)
+        {
+            mStream.skip(skipCount);
+        }
+    }
+
+    float* getBatch() override
+    {
+        return mCurrent < 0 ? nullptr : mSlots[mCurrent].batch.data();
+    }
+
+    float* getLabels() override
+    {
+        return mCurrent < 0 ? nullptr : mSlots[mCurrent].labels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mDims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return mImageDims;
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<float> batch;
+        std::vector<float> labels;
+    };
+
+    void allocateSlots()
+    {
+        // Cache the shape so that the accessors do not touch the wrapped stream while the worker uses it.
+        mBatchSize = mStream.getBatchSize();
+        mDims = mStream.getDims();
+        mImageDims = mStream.getImageDims();
+        const size_t batchVolume = static_cast<size_t>(mBatchSize) * samplesCommon::volume(mImageDims);
+
+        // One slot more than the prefetch depth is needed for the batch the caller is currently using.
+        mSlots.resize(mDepth + 1);
+        for (int i = 0; i <= mDepth; ++i)
+        {
+            mSlots[i].batch.resize(batchVolume);
+            mSlots[i].labels.resize(mBatchSize);
+            mFree.push_back(i);
+        }
+    }
+
+    //! Body of the background thread.
+    void prefetch()
+    {
+        for (;;)
+        {
+            int slot{-1};
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return mStop || !mFree.empty(); });
+                if (mStop)
+                {
+                    return;
+                }
+                slot = mFree.front();
+                mFree.pop_front();
+            }
+
+            const bool loaded = mStream.next();
+            if (loaded)
+            {
+                std::copy_n(mStream.getBatch(), mSlots[slot].batch.size(), mSlots[slot].batch.data());
+                std::copy_n(mStream.getLabels(), mSlots[slot].labels.size(), mSlots[slot].labels.data());
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (loaded)
+            {
+                mReady.push_back(slot);
+            }
+            else
+            {
+                mFree.push_front(slot);
+                mEnd = true;
+            }
+            mCondition.notify_all();
+            if (!loaded)
+            {
+                return;
+            }
+        }
+    }
+
+    //! Stops and joins the background thread; prefetched batches are kept.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        if (mWorker.joinable())
+        {
+            mWorker.join();
+        }
+        mStop = false;
+        mStarted = false;
+        mEnd = false;
+    }
+
+    //! Returns every slot to the free list.
+    void releaseAll()
+    {
+        mReady.clear();
+        mFree.clear();
+        mCurrent = -1;
+        for (int i = 0; i <= mDepth; ++i)
+        {
+            mFree.push_back(i);
+        }
+    }
+
+    TBatchStream mStream;
+    int mDepth{2};
+    int mBatchSize{0};
+    int mBatchCount{0};
+    nvinfer1::Dims mDims;
+    nvinfer1::Dims mImageDims;
+
+    std::vector<Slot> mSlots;  //!< Ring of preallocated batch buffers
+    std::deque<int> mFree;     //!< Slots that the worker may fill
+    std::deque<int> mReady;    //!< Filled slots in stream order
+    int mCurrent{-1};          //!< Slot handed out by the last call to next()
+    bool mStarted{false};      //!< The worker has been started since the last stop()
+    bool mStop{false};         //!< Request for the worker to exit
+    bool mEnd{false};          //!< The wrapped stream has no more batches
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mWorker;
+};
+
+#endif // PREFETCHING_BATCH_STREAM_H
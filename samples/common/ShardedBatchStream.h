@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SHARDED_BATCH_STREAM_H
+#define SHARDED_BATCH_STREAM_H
+
+#include "BatchStream.h"
+#include "NvInfer.h"
+#include "logger.h"
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//!
+//! \brief How the batches of a range are dealt out to the shards.
+//!
+enum class ShardMode
+{
+    kCONTIGUOUS, //!< Each shard reads one consecutive block of batches
+    kSTRIDED     //!< Shard i reads batches i, i + shardCount, i + 2 * shardCount, ...
+};
+
+inline ShardMode parseShardMode(const std::string& mode)
+{
+    if (mode == "contiguous")
+    {
+        return ShardMode::kCONTIGUOUS;
+    }
+    if (mode == "strided")
+    {
+        return ShardMode::kSTRIDED;
+    }
+    throw std::invalid_argument("Invalid shard mode " + mode);
+}
+
+//!
+//! \brief  The ShardedBatchStream class exposes the part of another stream that belongs to one shard.
+//!
+//! \details The global batches [firstBatch, firstBatch + nbBatches) of the wrapped stream are split into
+//!          shardCount disjoint shards, so that independent processes can each work on one of them.
+//!          Batch positions seen through reset() and skip() are local to the shard. The wrapped stream is
+//!          repositioned with reset() and skip(), so it must be able to reach the whole range: its maximum
+//!          batch count must not stop it before firstBatch + nbBatches.
+//!
+template <typename TBatchStream>
+class ShardedBatchStream : public IBatchStream
+{
+public:
+    ShardedBatchStream(TBatchStream stream, int firstBatch, int nbBatches, int shardIndex, int shardCount,
+        ShardMode mode = ShardMode::kCONTIGUOUS)
+        : mStream(stream)
+        , mFirstBatch(firstBatch)
+        , mShardIndex(shardIndex)
+        , mShardCount(shardCount)
+        , mMode(mode)
+    {
+        assert(shardCount > 0 && shardIndex >= 0 && shardIndex < shardCount);
+        if (mMode == ShardMode::kCONTIGUOUS)
+        {
+            // The first nbBatches % shardCount shards take one extra batch.
+            const int base = nbBatches / shardCount;
+            const int remainder = nbBatches % shardCount;
+            mShardBatches = base + (shardIndex < remainder ? 1 : 0);
+            mShardStart = shardIndex * base + std::min(shardIndex, remainder);
+        }
+        else
+        {
+            mShardBatches = shardIndex < nbBatches ? (nbBatches - shardIndex + shardCount - 1) / shardCount : 0;
+            mShardStart = shardIndex;
+        }
+        reset(0);
+    }
+
+    void reset(int firstBatch) override
+    {
+        mLocalBatch = firstBatch;
+        mStreamBatch = globalBatch(firstBatch);
+        mStream.reset(mStreamBatch);
+        mBatchCount = 0;
+    }
+
+    bool next() override
+    {
+        if (mLocalBatch >= mShardBatches)
+        {
+            return false;
+        }
+        const int target = globalBatch(mLocalBatch);
+        if (target > mStreamBatch)
+        {
+            mStream.skip(target - mStreamBatch);
+        }
+        if (!mStream.next())
+        {
+            return false;
+        }
+        mStreamBatch = target + 1;
+        ++mLocalBatch;
+        ++mBatchCount;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        // The wrapped stream catches up on the next call to next().
+        mLocalBatch += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return mStream.getBatch();
+    }
+
+    float* getLabels() override
+    {
+        return mStream.getLabels();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mStream.getBatchSize();
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return mStream.getDims();
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return mStream.getImageDims();
+    }
+
+    //!
+    //! \brief Returns the number of batches that belong to this shard.
+    //!
+    int getShardBatches() const
+    {
+        return mShardBatches;
+    }
+
+private:
+    //! Maps a batch of this shard to a batch of the wrapped stream.
+    int globalBatch(int localBatch) const
+    {
+        return mFirstBatch
+            + (mMode == ShardMode::kCONTIGUOUS ? mShardStart + localBatch : mShardStart + localBatch * mShardCount);
+    }
+
+    TBatchStream mStream;
+    int mFirstBatch{0};
+    int mShardIndex{0};
+    int mShardCount{1};
+    ShardMode mMode{ShardMode::kCONTIGUOUS};
+    int mShardStart{0};   //!< Offset of the first batch of the shard in the range
+    int mShardBatches{0}; //!< Number of batches in the shard
+    int mLocalBatch{0};   //!< Shard batch read by the next call to next()
+    int mStreamBatch{0};  //!< Global batch the wrapped stream reads on its next call to next()
+    int mBatchCount{0};
+};
+
+//!
+//! \brief The ScoreCounters structure holds the raw counts behind a score.
+//!
+//! \details Counters of the shards of a run add up to the counters of the whole run.
+//!
+struct ScoreCounters
+{
+    int top1{0};   //!< Number of images classified correctly
+    int top5{0};   //!< Number of images with the correct class among the 5 best
+    int images{0}; //!< Number of images scored
+
+    ScoreCounters& operator+=(const ScoreCounters& other)
+    {
+        top1 += other.top1;
+        top5 += other.top5;
+        images += other.images;
+        return *this;
+    }
+
+    std::pair<float, float> score() const
+    {
+        return images ? std::make_pair(float(top1) / float(images), float(top5) / float(images))
+                      : std::make_pair(0.0f, 0.0f);
+    }
+};
+
+//!
+//! \brief Writes the score counters of each data type, one "<type> <top1> <top5> <images>" line per type
+//!
+inline bool writeScoreFile(const std::string& fileName, const std::vector<std::string>& dataTypeNames,
+    const std::vector<ScoreCounters>& counters)
+{
+    std::ofstream file(fileName);
+    if (!file)
+    {
+        gLogError << "Could not open score file " << fileName << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < dataTypeNames.size(); i++)
+    {
+        file << dataTypeNames[i] << " " << counters[i].top1 << " " << counters[i].top5 << " " << counters[i].images
+             << std::endl;
+    }
+    return static_cast<bool>(file);
+}
+
+//!
+//! \brief Adds the score counters found in a file written by writeScoreFile() to the counters of each data type
+//!
+inline bool mergeScoreFile(const std::string& fileName, const std::vector<std::string>& dataTypeNames,
+    std::vector<ScoreCounters>& counters)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        gLogError << "Could not open score file " << fileName << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream record(line);
+        std::string name;
+        ScoreCounters shard;
+        if (!(record >> name))
+        {
+            continue;
+        }
+        auto type = std::find(dataTypeNames.begin(), dataTypeNames.end(), name);
+        if (type == dataTypeNames.end() || !(record >> shard.top1 >> shard.top5 >> shard.images))
+        {
+            gLogError << "Malformed line in score file " << fileName << ": " << line << std::endl;
+            return false;
+        }
+        counters[type - dataTypeNames.begin()] += shard;
+    }
+    return true;
+}
+
+#endif // SHARDED_BATCH_STREAM_H
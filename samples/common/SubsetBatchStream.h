@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SUBSET_BATCH_STREAM_H
+#define SUBSET_BATCH_STREAM_H
+
+#include "BatchStream.h"
+#include "NvInfer.h"
+#include "common.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Returns the number of features computeImageFeatures() extracts from a CHW image.
+//!
+inline int imageFeatureSize(const nvinfer1::Dims& imageDims, int grid)
+{
+    return imageDims.d[0] * (grid * grid + 2);
+}
+
+//!
+//! \brief Computes cheap features of a CHW image: for every channel, the mean of each cell of a grid x grid
+//!        partition of the image, the standard deviation, and the largest absolute value.
+//!
+//! \details The cell means describe the content of the image at a low resolution, and the last two features
+//!          describe the spread of its values, which is what calibration ranges depend on.
+//!
+inline void computeImageFeatures(const float* image, const nvinfer1::Dims& imageDims, int grid, float* features)
+{
+    const int c = imageDims.d[0];
+    const int h = imageDims.d[1];
+    const int w = imageDims.d[2];
+    for (int ch = 0; ch < c; ++ch)
+    {
+        const float* plane = image + static_cast<int64_t>(ch) * h * w;
+        float* cells = features + ch * (grid * grid + 2);
+        std::fill(cells, cells + grid * grid, 0.0F);
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        float maxAbs = 0.0F;
+        for (int y = 0; y < h; ++y)
+        {
+            float* row = cells + (y * grid / h) * grid;
+            for (int x = 0; x < w; ++x)
+            {
+                const float value = plane[y * w + x];
+                row[x * grid / w] += value;
+                sum += value;
+                sumSquares += static_cast<double>(value) * value;
+                maxAbs = std::max(maxAbs, std::fabs(value));
+            }
+        }
+        for (int cell = 0; cell < grid * grid; ++cell)
+        {
+            // Cells are as even as integer division allows.
+            const int cellH = ((cell / grid + 1) * h + grid - 1) / grid - ((cell / grid) * h + grid - 1) / grid;
+            const int cellW = ((cell % grid + 1) * w + grid - 1) / grid - ((cell % grid) * w + grid - 1) / grid;
+            cells[cell] = cellH > 0 && cellW > 0 ? cells[cell] / (cellH * cellW) : 0.0F;
+        }
+        const double mean = sum / (h * w);
+        cells[grid * grid] = static_cast<float>(std::sqrt(std::max(0.0, sumSquares / (h * w) - mean * mean)));
+        cells[grid * grid + 1] = maxAbs;
+    }
+}
+
+//!
+//! \brief Chooses k of the points with k-means++ seeding and returns their indices in the order they were chosen.
+//!
+//! \details The first point is drawn uniformly, and every following one with a probability proportional to
+//!          its squared distance to the closest point already chosen, so the choice spreads over the clusters
+//!          of the data instead of following their density. The result only depends on the points, k and seed.
+//!
+inline std::vector<int64_t> kMeansPlusPlusSeeds(
+    const std::vector<float>& points, int dim, int k, int nbThreads, uint32_t seed = 1)
+{
+    const int64_t nbPoints = static_cast<int64_t>(points.size()) / dim;
+    k = static_cast<int>(std::min<int64_t>(k, nbPoints));
+    std::vector<int64_t> chosen;
+    if (k <= 0)
+    {
+        return chosen;
+    }
+    std::mt19937 generator(seed);
+    std::vector<double> distances(nbPoints, std::numeric_limits<double>::max());
+    chosen.push_back(std::uniform_int_distribution<int64_t>(0, nbPoints - 1)(generator));
+
+    constexpr int64_t kCHUNK = 4096;
+    const int nbChunks = static_cast<int>((nbPoints + kCHUNK - 1) / kCHUNK);
+    while (static_cast<int>(chosen.size()) < k)
+    {
+        const float* center = points.data() + chosen.back() * dim;
+        parallelFor(nbChunks, nbThreads, [&](int chunk) {
+            const int64_t end = std::min(nbPoints, (chunk + 1) * kCHUNK);
+            for (int64_t p = chunk * kCHUNK; p < end; ++p)
+            {
+                const float* point = points.data() + p * dim;
+                double distance = 0.0;
+                for (int d = 0; d < dim; ++d)
+                {
+                    const double delta = point[d] - center[d];
+                    distance += delta * delta;
+                }
+                distances[p] = std::min(distances[p], distance);
+            }
+        });
+
+        const double total = std::accumulate(distances.begin(), distances.end(), 0.0);
+        if (total <= 0.0)
+        {
+            // Every point duplicates a chosen one.
+            break;
+        }
+        double target = std::uniform_real_distribution<double>(0.0, total)(generator);
+        int64_t next = -1;
+        for (int64_t p = 0; p < nbPoints; ++p)
+        {
+            if (distances[p] > 0.0)
+            {
+                // Rounding may leave target above 0 after the last point; then the last candidate is kept.
+                next = p;
+                target -= distances[p];
+                if (target < 0.0)
+                {
+                    break;
+                }
+            }
+        }
+        chosen.push_back(next);
+    }
+    return chosen;
+}
+
+//!
+//! \brief Scans the first nbBatches batches of a stream once and chooses nbImages diverse images for calibration.
+//!
+//! \details Features of every image are standardized per dimension, so that no feature dominates the distances
+//!          because of its scale, before k-means++ seeding picks the images. The returned indices are sorted
+//!          and count images in stream order: index i is image i % batchSize of the batch that the (i / batchSize
+//!          + 1)th call to next() after reset(0) returns.
+//!
+template <typename TBatchStream>
+std::vector<int64_t> selectDiverseImages(
+    TBatchStream stream, int nbBatches, int nbImages, int grid = 4, int nbThreads = 0)
+{
+    if (nbThreads <= 0)
+    {
+        nbThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    const nvinfer1::Dims imageDims = stream.getImageDims();
+    const int imageSize = volume(imageDims);
+    const int batchSize = stream.getBatchSize();
+    const int dim = imageFeatureSize(imageDims, grid);
+
+    std::vector<float> features;
+    stream.reset(0);
+    for (int b = 0; b < nbBatches && stream.next(); ++b)
+    {
+        const float* batch = stream.getBatch();
+        features.resize(features.size() + static_cast<size_t>(batchSize) * dim);
+        float* batchFeatures = features.data() + features.size() - static_cast<size_t>(batchSize) * dim;
+        parallelFor(batchSize, nbThreads, [&](int i) {
+            computeImageFeatures(
+                batch + static_cast<int64_t>(i) * imageSize, imageDims, grid, batchFeatures + static_cast<int64_t>(i) * dim);
+        });
+    }
+
+    const int64_t nbPoints = static_cast<int64_t>(features.size()) / dim;
+    for (int d = 0; d < dim; ++d)
+    {
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        for (int64_t p = 0; p < nbPoints; ++p)
+        {
+            sum += features[p * dim + d];
+            sumSquares += static_cast<double>(features[p * dim + d]) * features[p * dim + d];
+        }
+        const double mean = nbPoints ? sum / nbPoints : 0.0;
+        const double deviation = nbPoints ? std::sqrt(std::max(0.0, sumSquares / nbPoints - mean * mean)) : 0.0;
+        for (int64_t p = 0; p < nbPoints; ++p)
+        {
+            float& feature = features[p * dim + d];
+            feature = deviation > 0.0 ? static_cast<float>((feature - mean) / deviation) : 0.0F;
+        }
+    }
+
+    std::vector<int64_t> images = kMeansPlusPlusSeeds(features, dim, nbImages, nbThreads);
+    std::sort(images.begin(), images.end());
+    return images;
+}
+
+//!
+//! \brief Writes a list of image indices, one per line.
+//!
+inline bool writeSubsetList(const std::string& fileName, const std::vector<int64_t>& images)
+{
+    std::ofstream file(fileName);
+    for (const auto image : images)
+    {
+        file << image << std::endl;
+    }
+    return static_cast<bool>(file);
+}
+
+//!
+//! \brief Reads a list of image indices written by writeSubsetList(). Returns false if it is missing or empty.
+//!
+inline bool readSubsetList(const std::string& fileName, std::vector<int64_t>& images)
+{
+    images.clear();
+    std::ifstream file(fileName);
+    for (int64_t image; file >> image;)
+    {
+        images.push_back(image);
+    }
+    return !images.empty();
+}
+
+} // namespace samplesCommon
+
+//!
+//! \brief  The SubsetBatchStream class replays a list of images of another stream as batches.
+//!
+//! \details Images are indexed in the order of the wrapped stream, as by samplesCommon::selectDiverseImages().
+//!          Each output batch gathers batchSize images of the list; a last incomplete batch is dropped, so that
+//!          calibration never sees padding. The wrapped stream is repositioned with reset() and next(), and its
+//!          batches are only read once when the list is sorted.
+//!
+template <typename TBatchStream>
+class SubsetBatchStream : public IBatchStream
+{
+public:
+    SubsetBatchStream(TBatchStream stream, std::vector<int64_t> images, int batchSize)
+        : mStream(stream)
+        , mImages(std::move(images))
+        , mBatchSize(batchSize)
+        , mImageSize(samplesCommon::volume(mStream.getImageDims()))
+    {
+        assert(batchSize > 0);
+        mBatch.resize(static_cast<size_t>(mBatchSize) * mImageSize);
+        mLabels.resize(mBatchSize);
+        reset(0);
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = firstBatch;
+        mBatchesRead = 0;
+    }
+
+    bool next() override
+    {
+        if (mBatchCount >= getNbBatches())
+        {
+            return false;
+        }
+        const int streamBatchSize = mStream.getBatchSize();
+        for (int i = 0; i < mBatchSize; ++i)
+        {
+            const int64_t image = mImages[static_cast<size_t>(mBatchCount) * mBatchSize + i];
+            const int streamBatch = static_cast<int>(image / streamBatchSize);
+            const int offset = static_cast<int>(image % streamBatchSize);
+            if (streamBatch != mStreamBatch)
+            {
+                mStream.reset(streamBatch);
+                if (!mStream.next())
+                {
+                    return false;
+                }
+                mStreamBatch = streamBatch;
+            }
+            std::copy_n(mStream.getBatch() + static_cast<int64_t>(offset) * mImageSize, mImageSize,
+                mBatch.begin() + static_cast<int64_t>(i) * mImageSize);
+            mLabels[i] = mStream.getLabels()[offset];
+        }
+        ++mBatchCount;
+        ++mBatchesRead;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mBatchCount += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return mBatch.data();
+    }
+
+    float* getLabels() override
+    {
+        return mLabels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchesRead;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        nvinfer1::Dims dims = mStream.getDims();
+        if (dims.nbDims == 4)
+        {
+            dims.d[0] = mBatchSize;
+        }
+        return dims;
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return mStream.getImageDims();
+    }
+
+    //!
+    //! \brief Returns the number of complete batches in the list.
+    //!
+    int getNbBatches() const
+    {
+        return static_cast<int>(mImages.size() / mBatchSize);
+    }
+
+private:
+    TBatchStream mStream;
+    std::vector<int64_t> mImages; //!< Images to replay, indexed in the order of mStream
+    int mBatchSize{0};
+    int mImageSize{0};
+    int mBatchCount{0};   //!< Batch of the list read by the next call to next()
+    int mBatchesRead{0};
+    int mStreamBatch{-1}; //!< Batch of mStream currently loaded, -1 if none
+    std::vector<float> mBatch;
+    std::vector<float> mLabels;
+};
+
+#endif // SUBSET_BATCH_STREAM_H
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_BUFFER_LAYOUT_H
+#define TENSORRT_BUFFER_LAYOUT_H
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//! Alignment of the binding buffers packed into an arena, that of cudaMalloc.
+constexpr size_t kARENA_ALIGNMENT = 256;
+
+//!
+//! \brief  The BufferLayout structure describes how the buffers of all bindings are packed into one arena.
+//!
+//! \details Inputs come first and outputs last, each group in binding order, so that all inputs, and all
+//!          outputs, can be copied with a single memcpy. An arena of zero bytes is not allocated, so its
+//!          bindings have no address.
+//!
+struct BufferLayout
+{
+    std::vector<size_t> offsets; //!< Offset of every binding in the arena, a multiple of the alignment
+    size_t inputBegin{0};        //!< Offset of the first input
+    size_t inputEnd{0};          //!< End of the last input
+    size_t outputBegin{0};       //!< Offset of the first output
+    size_t outputEnd{0};         //!< End of the last output
+    size_t totalBytes{0};        //!< Size of the arena
+};
+
+//!
+//! \brief Computes the arena layout of bindings of the given sizes in bytes.
+//!
+inline BufferLayout planBufferLayout(
+    const std::vector<size_t>& nbBytes, const std::vector<bool>& isInput, size_t alignment = kARENA_ALIGNMENT)
+{
+    assert(nbBytes.size() == isInput.size() && alignment > 0);
+    BufferLayout layout;
+    layout.offsets.resize(nbBytes.size());
+    size_t offset = 0;
+    for (const bool inputs : {true, false})
+    {
+        size_t& begin = inputs ? layout.inputBegin : layout.outputBegin;
+        size_t& end = inputs ? layout.inputEnd : layout.outputEnd;
+        begin = end = offset;
+        for (size_t i = 0; i < nbBytes.size(); ++i)
+        {
+            if (isInput[i] == inputs)
+            {
+                layout.offsets[i] = offset;
+                end = offset + nbBytes[i];
+                offset = (end + alignment - 1) / alignment * alignment;
+            }
+        }
+    }
+    layout.totalBytes = layout.outputEnd;
+    return layout;
+}
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_BUFFER_LAYOUT_H
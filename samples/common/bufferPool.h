@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_BUFFER_POOL_H
+#define TENSORRT_BUFFER_POOL_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The BufferPoolStats structure is a snapshot of the counters of a BufferPool.
+//!
+struct BufferPoolStats
+{
+    size_t bytesInUse{0};        //!< Bytes of the blocks handed out and not released yet
+    size_t peakBytesInUse{0};    //!< High-water mark of bytesInUse
+    size_t bytesReserved{0};     //!< Bytes obtained from the underlying allocator and not returned to it
+    size_t peakBytesReserved{0}; //!< High-water mark of bytesReserved
+    uint64_t allocations{0};     //!< Number of calls to allocate()
+    uint64_t threadCacheHits{0}; //!< Allocations served by the cache of the calling thread
+    uint64_t freeListHits{0};    //!< Allocations served by the global free lists
+};
+
+//!
+//! \brief  The BufferPool class recycles the blocks of an underlying allocator by power-of-two size classes.
+//!
+//! \details A request is rounded up to the next power of two, at least 256 bytes, and served in order from
+//!          a small cache owned by the calling thread, which needs no lock, from a global free list of its
+//!          size class, and finally from the underlying allocator. Released blocks of up to 16 MiB go back to
+//!          the cache of the releasing thread until it is full; other blocks go to the global lists. Blocks are
+//!          only returned to the underlying allocator by trim(), or when an allocation fails, so the memory held
+//!          by the pool stays at the high-water mark of the program. The pool is destroyed with the other
+//!          statics, possibly after the runtime behind the underlying allocator, so its destructor returns
+//!          nothing: call trim() before exit to give the blocks back. Requests above the largest size class
+//!          bypass the pool. Because FreeFunc only receives a pointer, the size of each block is recorded in a
+//!          map split into independently locked shards. There is one pool per pair of functors, see instance().
+//!
+template <typename AllocFunc, typename FreeFunc>
+class BufferPool
+{
+public:
+    static constexpr int kMIN_CLASS_BITS = 8;                          //!< Smallest class: 256 bytes
+    static constexpr int kNB_CLASSES = 32;                             //!< Largest class: 1 TiB
+    static constexpr size_t kTHREAD_CACHE_BLOCKS = 4;                  //!< Blocks of each class cached per thread
+    static constexpr size_t kTHREAD_CACHE_MAX_BYTES = size_t(1) << 24; //!< Larger blocks skip the thread caches
+
+    static BufferPool& instance()
+    {
+        static BufferPool pool;
+        return pool;
+    }
+
+    //!
+    //! \brief Allocates a block of at least size bytes. Returns false if the underlying allocator fails.
+    //!
+    bool allocate(void** ptr, size_t size)
+    {
+        ++mAllocations;
+        const int sizeClass = classOf(size);
+        if (sizeClass < 0)
+        {
+            return allocateBlock(ptr, size);
+        }
+        const size_t bytes = classBytes(sizeClass);
+
+        std::vector<void*>& cached = threadCache().blocks[sizeClass];
+        if (!cached.empty())
+        {
+            *ptr = cached.back();
+            cached.pop_back();
+            ++mThreadCacheHits;
+            addInUse(bytes);
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mFreeLists[sizeClass].mutex);
+            std::vector<void*>& blocks = mFreeLists[sizeClass].blocks;
+            if (!blocks.empty())
+            {
+                *ptr = blocks.back();
+                blocks.pop_back();
+                ++mFreeListHits;
+                addInUse(bytes);
+                return true;
+            }
+        }
+        if (allocateBlock(ptr, bytes))
+        {
+            return true;
+        }
+        // The free lists of the other classes may hold enough memory.
+        trim();
+        return allocateBlock(ptr, bytes);
+    }
+
+    //!
+    //! \brief Releases a block returned by allocate(). It must work with nullptr input.
+    //!
+    void release(void* ptr)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        const size_t bytes = blockBytes(ptr);
+        mBytesInUse -= bytes;
+        const int sizeClass = classOf(bytes);
+        if (sizeClass < 0)
+        {
+            freeBlock(ptr, bytes);
+            return;
+        }
+        std::vector<void*>& cached = threadCache().blocks[sizeClass];
+        if (bytes <= kTHREAD_CACHE_MAX_BYTES && cached.size() < kTHREAD_CACHE_BLOCKS)
+        {
+            cached.push_back(ptr);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mFreeLists[sizeClass].mutex);
+        mFreeLists[sizeClass].blocks.push_back(ptr);
+    }
+
+    //!
+    //! \brief Returns the blocks of the global free lists and of the cache of the calling thread to the underlying
+    //!        allocator. Blocks cached by other threads are kept.
+    //!
+    void trim()
+    {
+        threadCache().flush();
+        for (int c = 0; c < kNB_CLASSES; ++c)
+        {
+            std::vector<void*> blocks;
+            {
+                std::lock_guard<std::mutex> lock(mFreeLists[c].mutex);
+                blocks.swap(mFreeLists[c].blocks);
+            }
+            for (void* block : blocks)
+            {
+                freeBlock(block, classBytes(c));
+            }
+        }
+    }
+
+    BufferPoolStats getStats() const
+    {
+        BufferPoolStats stats;
+        stats.bytesInUse = mBytesInUse;
+        stats.peakBytesInUse = mPeakBytesInUse;
+        stats.bytesReserved = mBytesReserved;
+        stats.peakBytesReserved = mPeakBytesReserved;
+        stats.allocations = mAllocations;
+        stats.threadCacheHits = mThreadCacheHits;
+        stats.freeListHits = mFreeListHits;
+        return stats;
+    }
+
+    //!
+    //! \brief Prints the high-water marks and hit rates of the pool.
+    //!
+    void printStats(std::ostream& os, const std::string& name) const
+    {
+        const BufferPoolStats stats = getStats();
+        const double toMiB = 1.0 / (1 << 20);
+        const double hits = stats.allocations ? 100.0 / stats.allocations : 0.0;
+        os << name << " pool: in use " << stats.bytesInUse * toMiB << " MiB (peak " << stats.peakBytesInUse * toMiB
+           << " MiB), reserved " << stats.bytesReserved * toMiB << " MiB (peak " << stats.peakBytesReserved * toMiB
+           << " MiB), " << stats.allocations << " allocations, " << stats.threadCacheHits * hits
+           << "% from thread caches, " << stats.freeListHits * hits << "% from free lists" << std::endl;
+    }
+
+private:
+    static constexpr int kNB_SHARDS = 64;
+
+    //! Blocks cached by one thread, handed to the global free lists when the thread exits.
+    struct ThreadCache
+    {
+        std::array<std::vector<void*>, kNB_CLASSES> blocks;
+
+        ~ThreadCache()
+        {
+            flush();
+        }
+
+        //! Moves the cached blocks to the global free lists.
+        void flush()
+        {
+            BufferPool& pool = instance();
+            for (int c = 0; c < kNB_CLASSES; ++c)
+            {
+                std::lock_guard<std::mutex> lock(pool.mFreeLists[c].mutex);
+                pool.mFreeLists[c].blocks.insert(pool.mFreeLists[c].blocks.end(), blocks[c].begin(), blocks[c].end());
+                blocks[c].clear();
+            }
+        }
+    };
+
+    struct FreeList
+    {
+        std::mutex mutex;
+        std::vector<void*> blocks;
+    };
+
+    //! Part of the map from the blocks obtained from the underlying allocator to their sizes.
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<void*, size_t> sizes;
+    };
+
+    BufferPool() = default;
+
+    static ThreadCache& threadCache()
+    {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    //! Returns the size class of a request, or -1 if it is too large to be pooled.
+    static int classOf(size_t size)
+    {
+        int bits = kMIN_CLASS_BITS;
+        while (bits < kMIN_CLASS_BITS + kNB_CLASSES && (size_t(1) << bits) < size)
+        {
+            ++bits;
+        }
+        return bits < kMIN_CLASS_BITS + kNB_CLASSES ? bits - kMIN_CLASS_BITS : -1;
+    }
+
+    static size_t classBytes(int sizeClass)
+    {
+        return size_t(1) << (sizeClass + kMIN_CLASS_BITS);
+    }
+
+    Shard& shardOf(void* ptr)
+    {
+        return mShards[(reinterpret_cast<uintptr_t>(ptr) >> kMIN_CLASS_BITS) % kNB_SHARDS];
+    }
+
+    size_t blockBytes(void* ptr)
+    {
+        Shard& shard = shardOf(ptr);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.sizes.at(ptr);
+    }
+
+    //! Gets a block from the underlying allocator.
+    bool allocateBlock(void** ptr, size_t bytes)
+    {
+        if (!mAllocFn(ptr, bytes))
+        {
+            return false;
+        }
+        {
+            Shard& shard = shardOf(*ptr);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.sizes[*ptr] = bytes;
+        }
+        updatePeak(mPeakBytesReserved, mBytesReserved += bytes);
+        addInUse(bytes);
+        return true;
+    }
+
+    //! Returns a block to the underlying allocator.
+    void freeBlock(void* ptr, size_t bytes)
+    {
+        {
+            Shard& shard = shardOf(ptr);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.sizes.erase(ptr);
+        }
+        mFreeFn(ptr);
+        mBytesReserved -= bytes;
+    }
+
+    void addInUse(size_t bytes)
+    {
+        updatePeak(mPeakBytesInUse, mBytesInUse += bytes);
+    }
+
+    static void updatePeak(std::atomic<size_t>& peak, size_t value)
+    {
+        size_t current = peak;
+        while (value > current && !peak.compare_exchange_weak(current, value))
+        {
+        }
+    }
+
+    AllocFunc mAllocFn;
+    FreeFunc mFreeFn;
+    std::array<FreeList, kNB_CLASSES> mFreeLists;
+    std::array<Shard, kNB_SHARDS> mShards;
+    std::atomic<size_t> mBytesInUse{0};
+    std::atomic<size_t> mPeakBytesInUse{0};
+    std::atomic<size_t> mBytesReserved{0};
+    std::atomic<size_t> mPeakBytesReserved{0};
+    std::atomic<uint64_t> mAllocations{0};
+    std::atomic<uint64_t> mThreadCacheHits{0};
+    std::atomic<uint64_t> mFreeListHits{0};
+};
+
+//!
+//! \brief AllocFunc for GenericBuffer that allocates from the BufferPool of AllocFunc and FreeFunc.
+//!
+template <typename AllocFunc, typename FreeFunc>
+class PooledAllocator
+{
+public:
+    bool operator()(void** ptr, size_t size) const
+    {
+        return BufferPool<AllocFunc, FreeFunc>::instance().allocate(ptr, size);
+    }
+};
+
+//!
+//! \brief FreeFunc for GenericBuffer that releases to the BufferPool of AllocFunc and FreeFunc.
+//!
+template <typename AllocFunc, typename FreeFunc>
+class PooledFree
+{
+public:
+    void operator()(void* ptr) const
+    {
+        BufferPool<AllocFunc, FreeFunc>::instance().release(ptr);
+    }
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_BUFFER_POOL_H
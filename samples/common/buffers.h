@@ -51,15 +51,23 @@
 #define TENSORRT_BUFFERS_H
 
 #include "NvInfer.h"
+#include "bufferLayout.h"
+#include "bufferPool.h"
 #include "half.h"
+#include "hostStagingMemory.h"
 #include "common.h"
+#include "npyFile.h"
 #include <cuda_runtime_api.h>
+#include <array>
 #include <cassert>
+#include <cctype>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <new>
 
@@ -239,6 +247,80 @@ public:
 using DeviceBuffer = GenericBuffer<DeviceAllocator, DeviceFree>;
 using HostBuffer = GenericBuffer<HostAllocator, HostFree>;
 
+//! Buffers that recycle their memory through the BufferPool of their allocator, see bufferPool.h.
+using PooledDeviceBuffer
+    = GenericBuffer<PooledAllocator<DeviceAllocator, DeviceFree>, PooledFree<DeviceAllocator, DeviceFree>>;
+using PooledHostBuffer = GenericBuffer<PooledAllocator<HostAllocator, HostFree>, PooledFree<HostAllocator, HostFree>>;
+
+//!
+//! \brief Prints the high-water marks of the host and device buffer pools.
+//!
+inline void printBufferPoolStats(std::ostream& os)
+{
+    BufferPool<HostAllocator, HostFree>::instance().printStats(os, "Host");
+    BufferPool<DeviceAllocator, DeviceFree>::instance().printStats(os, "Device");
+}
+
+//!
+//! \brief Returns the free blocks of the host and device buffer pools. Call it before exit, while the CUDA runtime
+//!        is still up, since the pools do not free their blocks when they are destroyed.
+//!
+inline void trimBufferPools()
+{
+    BufferPool<HostAllocator, HostFree>::instance().trim();
+    BufferPool<DeviceAllocator, DeviceFree>::instance().trim();
+}
+
+//!
+//! \brief  The CudaHostMemoryAllocator class allocates pageable memory with malloc and page-locked memory with
+//!         cudaHostAlloc.
+//!
+class CudaHostMemoryAllocator : public IHostMemoryAllocator
+{
+public:
+    void* allocate(size_t size, HostMemoryType type) override
+    {
+        if (type == HostMemoryType::kPAGEABLE)
+        {
+            return malloc(size);
+        }
+        void* ptr{nullptr};
+        const unsigned int flags
+            = type == HostMemoryType::kWRITE_COMBINED ? cudaHostAllocWriteCombined : cudaHostAllocDefault;
+        return cudaHostAlloc(&ptr, size, flags) == cudaSuccess ? ptr : nullptr;
+    }
+
+    void free(void* ptr, HostMemoryType type) override
+    {
+        if (type == HostMemoryType::kPAGEABLE)
+        {
+            ::free(ptr);
+        }
+        else
+        {
+            cudaFreeHost(ptr);
+        }
+    }
+};
+
+//!
+//! \brief Creates a HostStagingMemory of the given policy that allocates with CudaHostMemoryAllocator.
+//!
+inline std::shared_ptr<HostStagingMemory> createHostStagingMemory(HostMemoryType policy = HostMemoryType::kPINNED)
+{
+    return std::make_shared<HostStagingMemory>(policy, std::make_shared<CudaHostMemoryAllocator>());
+}
+
+//!
+//! \brief How a BufferManager allocates the buffers of the bindings.
+//!
+enum class BufferAllocation
+{
+    kPER_BINDING, //!< One host and one device allocation per binding
+    kARENA,       //!< One host and one device allocation shared by all bindings, see planBufferLayout()
+    kPOOLED       //!< One host and one device block per binding, recycled through the buffer pools
+};
+
 //!
 //! \brief  The ManagedBuffer class groups together a pair of corresponding device and host buffers.
 //!
@@ -249,6 +331,16 @@ public:
     HostBuffer hostBuffer;
 };
 
+//!
+//! \brief  The PooledManagedBuffer class groups together a pair of corresponding pooled device and host buffers.
+//!
+class PooledManagedBuffer
+{
+public:
+    PooledDeviceBuffer deviceBuffer;
+    PooledHostBuffer hostBuffer;
+};
+
 //!
 //! \brief  The BufferManager class handles host and device buffer allocation and deallocation.
 //!
@@ -265,11 +357,28 @@ public:
     //!
     //! \brief Create a BufferManager for handling buffer interactions with engine.
     //!
-    BufferManager(std::shared_ptr<nvinfer1::ICudaEngine> engine, const int& batchSize, const nvinfer1::IExecutionContext* context = nullptr)
+    //! \details With BufferAllocation::kARENA, the buffers of all bindings are carved out of a single host and a
+    //!          single device allocation, and inputs and outputs are each copied with one memcpy. With
+    //!          BufferAllocation::kPOOLED, buffers come from the buffer pools, so managers that are created and
+    //!          destroyed repeatedly reuse the same memory. Buffers are accessed the same way in all modes.
+    //!
+    //!          Host buffers are allocated with malloc, unless hostMemory is given: they are then allocated by
+    //!          hostMemory according to its policy, for example in pinned memory so that asynchronous copies
+    //!          overlap with compute. In arena mode, inputs and outputs then get one host allocation each, so
+    //!          that they can use different types of memory.
+    //!
+    BufferManager(std::shared_ptr<nvinfer1::ICudaEngine> engine, const int& batchSize,
+        const nvinfer1::IExecutionContext* context = nullptr,
+        BufferAllocation allocation = BufferAllocation::kPER_BINDING,
+        std::shared_ptr<HostStagingMemory> hostMemory = nullptr)
         : mEngine(engine)
         , mBatchSize(batchSize)
+        , mAllocation(allocation)
+        , mHostMemory(hostMemory)
     {
-        // Create host and device buffers
+        // Size the host and device buffers
+        std::vector<size_t> nbBytes;
+        std::vector<bool> isInput;
         for (int i = 0; i < mEngine->getNbBindings(); i++)
         {
             auto dims = context ? context->getBindingDimensions(i) : mEngine->getBindingDimensions(i);
@@ -283,11 +392,66 @@ public:
                 vol *= scalarsPerVec;
             }
             vol *= samplesCommon::volume(dims);
-            std::unique_ptr<ManagedBuffer> manBuf{new ManagedBuffer()};
-            manBuf->deviceBuffer = DeviceBuffer(vol, type);
-            manBuf->hostBuffer = HostBuffer(vol, type);
-            mDeviceBindings.emplace_back(manBuf->deviceBuffer.data());
-            mManagedBuffers.emplace_back(std::move(manBuf));
+            mShapes.push_back(bindingShape(i, dims, context ? 0 : mBatchSize));
+            nbBytes.push_back(vol * samplesCommon::getElementSize(type));
+            isInput.push_back(mEngine->bindingIsInput(i));
+            if (mAllocation == BufferAllocation::kPER_BINDING)
+            {
+                std::unique_ptr<ManagedBuffer> manBuf{new ManagedBuffer()};
+                manBuf->deviceBuffer = DeviceBuffer(vol, type);
+                if (!mHostMemory)
+                {
+                    manBuf->hostBuffer = HostBuffer(vol, type);
+                }
+                mDeviceBindings.emplace_back(manBuf->deviceBuffer.data());
+                mHostBuffers.emplace_back(
+                    mHostMemory ? allocateHost(nbBytes.back(), isInput.back()) : manBuf->hostBuffer.data());
+                mManagedBuffers.emplace_back(std::move(manBuf));
+            }
+            else if (mAllocation == BufferAllocation::kPOOLED)
+            {
+                std::unique_ptr<PooledManagedBuffer> manBuf{new PooledManagedBuffer()};
+                manBuf->deviceBuffer = PooledDeviceBuffer(vol, type);
+                if (!mHostMemory)
+                {
+                    manBuf->hostBuffer = PooledHostBuffer(vol, type);
+                }
+                mDeviceBindings.emplace_back(manBuf->deviceBuffer.data());
+                mHostBuffers.emplace_back(
+                    mHostMemory ? allocateHost(nbBytes.back(), isInput.back()) : manBuf->hostBuffer.data());
+                mPooledBuffers.emplace_back(std::move(manBuf));
+            }
+        }
+        mBufferSizes = nbBytes;
+
+        if (mAllocation == BufferAllocation::kARENA)
+        {
+            mLayout = planBufferLayout(nbBytes, isInput);
+            // An empty arena is not allocated, and its null base must not be offset, so the bindings are left null.
+            if (mLayout.totalBytes == 0)
+            {
+                mDeviceBindings.assign(nbBytes.size(), nullptr);
+                mHostBuffers.assign(nbBytes.size(), nullptr);
+                return;
+            }
+            mArena.deviceBuffer = DeviceBuffer(mLayout.totalBytes, nvinfer1::DataType::kINT8);
+            if (!mHostMemory)
+            {
+                mArena.hostBuffer = HostBuffer(mLayout.totalBytes, nvinfer1::DataType::kINT8);
+            }
+            char* hostBase = static_cast<char*>(mArena.hostBuffer.data());
+            mArenaHostInputs = mHostMemory
+                ? static_cast<char*>(allocateHost(mLayout.inputEnd - mLayout.inputBegin, true))
+                : hostBase + mLayout.inputBegin;
+            mArenaHostOutputs = mHostMemory
+                ? static_cast<char*>(allocateHost(mLayout.outputEnd - mLayout.outputBegin, false))
+                : hostBase + mLayout.outputBegin;
+            for (size_t i = 0; i < nbBytes.size(); ++i)
+            {
+                mDeviceBindings.emplace_back(static_cast<char*>(mArena.deviceBuffer.data()) + mLayout.offsets[i]);
+                mHostBuffers.emplace_back(isInput[i] ? mArenaHostInputs + (mLayout.offsets[i] - mLayout.inputBegin)
+                                                     : mArenaHostOutputs + (mLayout.offsets[i] - mLayout.outputBegin));
+            }
         }
     }
 
@@ -323,7 +487,7 @@ public:
         int index = mEngine->getBindingIndex(tensorName.c_str());
         if (index == -1)
             return kINVALID_SIZE_VALUE;
-        return mManagedBuffers[index]->hostBuffer.nbBytes();
+        return mBufferSizes[index];
     }
 
     //!
@@ -338,8 +502,8 @@ public:
             os << "Invalid tensor name" << std::endl;
             return;
         }
-        void* buf = mManagedBuffers[index]->hostBuffer.data();
-        size_t bufSize = mManagedBuffers[index]->hostBuffer.nbBytes();
+        void* buf = mHostBuffers[index];
+        size_t bufSize = mBufferSizes[index];
         nvinfer1::Dims bufDims = mEngine->getBindingDimensions(index);
         size_t rowCount = static_cast<size_t>(bufDims.nbDims >= 1 ? bufDims.d[bufDims.nbDims - 1] : mBatchSize);
 
@@ -356,6 +520,68 @@ public:
         }
     }
 
+    //!
+    //! \brief Writes the host buffer of tensorName to a .npy file, with the data type of the binding.
+    //!
+    //! \details The shape is the layout of the buffer in memory: the batch size comes first unless the manager
+    //!          was created with an execution context, and for vectorized formats the vectorized dimension is
+    //!          divided into vectors, which become the last dimension. For example, a CHW4 binding of dimensions
+    //!          (C, H, W) is written as (N, ceil(C / 4), H, W, 4).
+    //!
+    //! \return False if no such tensor can be found or the file cannot be written.
+    //!
+    bool dumpNpy(const std::string& tensorName, const std::string& fileName) const
+    {
+        int index = mEngine->getBindingIndex(tensorName.c_str());
+        if (index == -1)
+            return false;
+        return writeNpy(fileName, npyDescr(mEngine->getBindingDataType(index)), mShapes[index], mHostBuffers[index],
+            mBufferSizes[index]);
+    }
+
+    //!
+    //! \brief Reads a .npy file written by dumpNpy(), or by numpy, into the host buffer of tensorName.
+    //!
+    //! \details The file must hold elements of the data type of the binding in C order, as many as the buffer.
+    //!          Its shape may differ from the one dumpNpy() writes, so that arrays can be loaded without a reshape.
+    //!
+    //! \return False if no such tensor can be found or the file does not match the buffer.
+    //!
+    bool loadNpy(const std::string& tensorName, const std::string& fileName)
+    {
+        int index = mEngine->getBindingIndex(tensorName.c_str());
+        if (index == -1)
+            return false;
+        std::vector<int64_t> shape;
+        return readNpy(
+            fileName, npyDescr(mEngine->getBindingDataType(index)), mHostBuffers[index], mBufferSizes[index], shape);
+    }
+
+    //!
+    //! \brief Writes the host buffers of all outputs with dumpNpy(), each to prefix followed by the name of the
+    //!        tensor and ".npy". Characters of the name that are not letters, digits, '-' or '.' become '_'.
+    //!        Call copyOutputToHost() first to dump the outputs of the last inference.
+    //!
+    //! \return False if any output cannot be written.
+    //!
+    bool dumpOutputsNpy(const std::string& prefix) const
+    {
+        bool success = true;
+        for (int i = 0; i < mEngine->getNbBindings(); i++)
+        {
+            if (mEngine->bindingIsInput(i))
+                continue;
+            std::string name = mEngine->getBindingName(i);
+            for (auto& c : name)
+            {
+                if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '.')
+                    c = '_';
+            }
+            success = dumpNpy(mEngine->getBindingName(i), prefix + name + ".npy") && success;
+        }
+        return success;
+    }
+
     //!
     //! \brief Templated print function that dumps buffers of arbitrary type to std::ostream.
     //!        rowCount parameter controls how many elements are on each line.
@@ -408,25 +634,63 @@ public:
     ~BufferManager() = default;
 
 private:
+    //! Returns the shape of the buffer of a binding of dimensions dims, in memory order, see dumpNpy().
+    std::vector<int64_t> bindingShape(int index, const nvinfer1::Dims& dims, int batchSize) const
+    {
+        std::vector<int64_t> shape;
+        if (batchSize > 0)
+            shape.push_back(batchSize);
+        shape.insert(shape.end(), dims.d, dims.d + dims.nbDims);
+        if (-1 != mEngine->getBindingVectorizedDim(index))
+            shape.push_back(mEngine->getBindingComponentsPerElement(index));
+        return shape;
+    }
+
+    //! Allocates a host buffer from mHostMemory, which this manager then owns.
+    void* allocateHost(size_t size, bool isInput)
+    {
+        std::unique_ptr<void, HostStagingDeleter> buffer(
+            mHostMemory->allocate(size, isInput), HostStagingDeleter{mHostMemory});
+        if (!buffer)
+        {
+            throw std::bad_alloc();
+        }
+        mHostStagingBuffers.emplace_back(std::move(buffer));
+        return mHostStagingBuffers.back().get();
+    }
 
     void* getBuffer(const bool isHost, const std::string& tensorName) const
     {
         int index = mEngine->getBindingIndex(tensorName.c_str());
         if (index == -1)
             return nullptr;
-        return (isHost ? mManagedBuffers[index]->hostBuffer.data() : mManagedBuffers[index]->deviceBuffer.data());
+        return (isHost ? mHostBuffers[index] : mDeviceBindings[index]);
     }
 
     void memcpyBuffers(const bool copyInput, const bool deviceToHost, const bool async, const cudaStream_t& stream = 0)
     {
+        const cudaMemcpyKind memcpyType = deviceToHost ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
+        if (mAllocation == BufferAllocation::kARENA)
+        {
+            // The inputs, or the outputs, are contiguous in the arena, alignment padding included.
+            const size_t begin = copyInput ? mLayout.inputBegin : mLayout.outputBegin;
+            const size_t byteSize = (copyInput ? mLayout.inputEnd : mLayout.outputEnd) - begin;
+            if (byteSize == 0)
+                return;
+            char* host = copyInput ? mArenaHostInputs : mArenaHostOutputs;
+            char* device = static_cast<char*>(mArena.deviceBuffer.data()) + begin;
+            if (async)
+                CHECK(cudaMemcpyAsync(deviceToHost ? host : device, deviceToHost ? device : host, byteSize, memcpyType, stream));
+            else
+                CHECK(cudaMemcpy(deviceToHost ? host : device, deviceToHost ? device : host, byteSize, memcpyType));
+            return;
+        }
+
         for (int i = 0; i < mEngine->getNbBindings(); i++)
         {
-            void* dstPtr
-                = deviceToHost ? mManagedBuffers[i]->hostBuffer.data() : mManagedBuffers[i]->deviceBuffer.data();
-            const void* srcPtr
-                = deviceToHost ? mManagedBuffers[i]->deviceBuffer.data() : mManagedBuffers[i]->hostBuffer.data();
-            const size_t byteSize = mManagedBuffers[i]->hostBuffer.nbBytes();
-            const cudaMemcpyKind memcpyType = deviceToHost ? cudaMemcpyDeviceToHost : cudaMemcpyHostToDevice;
+            void* dstPtr = deviceToHost ? mHostBuffers[i] : mDeviceBindings[i];
+            const void* srcPtr = deviceToHost ? mDeviceBindings[i] : mHostBuffers[i];
+            const size_t byteSize = mBufferSizes[i];
             if ((copyInput && mEngine->bindingIsInput(i)) || (!copyInput && !mEngine->bindingIsInput(i)))
             {
                 if (async)
@@ -439,8 +703,19 @@ private:
 
     std::shared_ptr<nvinfer1::ICudaEngine> mEngine;              //!< The pointer to the engine
     int mBatchSize;                                              //!< The batch size
-    std::vector<std::unique_ptr<ManagedBuffer>> mManagedBuffers; //!< The vector of pointers to managed buffers
+    BufferAllocation mAllocation;                                //!< How the buffers are allocated
+    std::vector<std::unique_ptr<ManagedBuffer>> mManagedBuffers; //!< The vector of pointers to managed buffers, one per binding with kPER_BINDING
+    std::vector<std::unique_ptr<PooledManagedBuffer>> mPooledBuffers; //!< The pooled buffers, one per binding with kPOOLED
+    ManagedBuffer mArena;                                        //!< The buffers shared by all bindings with kARENA
+    BufferLayout mLayout;                                        //!< The layout of mArena
+    char* mArenaHostInputs{nullptr};                             //!< The host buffer of the inputs with kARENA
+    char* mArenaHostOutputs{nullptr};                            //!< The host buffer of the outputs with kARENA
+    std::shared_ptr<HostStagingMemory> mHostMemory;              //!< The allocator of the host buffers, if not malloc
+    std::vector<std::unique_ptr<void, HostStagingDeleter>> mHostStagingBuffers; //!< The buffers of mHostMemory
     std::vector<void*> mDeviceBindings;                          //!< The vector of device buffers needed for engine execution
+    std::vector<void*> mHostBuffers;                             //!< The vector of host buffers, one per binding
+    std::vector<size_t> mBufferSizes;                            //!< The size in bytes of the buffers of each binding
+    std::vector<std::vector<int64_t>> mShapes;                   //!< The shape of the buffers of each binding, see dumpNpy()
 };
 
 } // namespace samplesCommon
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_CALIBRATION_CACHE_H
+#define TENSORRT_CALIBRATION_CACHE_H
+
+#include "NvInfer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief  The CacheKeyHasher class accumulates a 64-bit FNV-1a hash of the values added to it.
+//!
+class CacheKeyHasher
+{
+public:
+    CacheKeyHasher& add(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            mHash = (mHash ^ bytes[i]) * 1099511628211ULL;
+        }
+        return *this;
+    }
+
+    CacheKeyHasher& add(const std::string& value)
+    {
+        // Hash the length too, so that consecutive strings cannot run into each other.
+        add(static_cast<int64_t>(value.size()));
+        return add(value.data(), value.size());
+    }
+
+    CacheKeyHasher& add(const char* value)
+    {
+        return add(std::string(value ? value : ""));
+    }
+
+    CacheKeyHasher& add(int64_t value)
+    {
+        return add(&value, sizeof(value));
+    }
+
+    CacheKeyHasher& add(const nvinfer1::Dims& dims)
+    {
+        add(static_cast<int64_t>(dims.nbDims));
+        for (int i = 0; i < dims.nbDims; ++i)
+        {
+            add(static_cast<int64_t>(dims.d[i]));
+        }
+        return *this;
+    }
+
+    CacheKeyHasher& add(const nvinfer1::Weights& weights)
+    {
+        add(static_cast<int64_t>(weights.type));
+        add(weights.count);
+        if (weights.values && weights.count > 0)
+        {
+            const size_t elementSize = weights.type == nvinfer1::DataType::kFLOAT
+                ? 4
+                : weights.type == nvinfer1::DataType::kHALF ? 2 : weights.type == nvinfer1::DataType::kINT32 ? 4 : 1;
+            add(weights.values, static_cast<size_t>(weights.count) * elementSize);
+        }
+        return *this;
+    }
+
+    //! Returns the hash as 16 hexadecimal digits.
+    std::string str() const
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(mHash));
+        return hex;
+    }
+
+private:
+    uint64_t mHash{14695981039346656037ULL};
+};
+
+//!
+//! \brief Returns "path size mtime" for a file, or just the path if it cannot be found. A dataset that is
+//!        rewritten or replaced gets a new identity.
+//!
+inline std::string fileIdentity(const std::string& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return path;
+    }
+    return path + " " + std::to_string(static_cast<long long>(st.st_size)) + " "
+        + std::to_string(static_cast<long long>(st.st_mtime));
+}
+
+//!
+//! \brief Returns the key of a network and calibration dataset.
+//!
+//! \details The network is hashed layer by layer: names, types, tensor names, shapes and types, and the
+//!          weights of the layers that own them. datasetIdentity should change whenever the calibration
+//!          data does, see fileIdentity().
+//!
+inline std::string networkCacheKey(const nvinfer1::INetworkDefinition& network, const std::string& datasetIdentity)
+{
+    CacheKeyHasher hasher;
+    auto addTensor = [&hasher](const nvinfer1::ITensor* tensor) {
+        hasher.add(tensor ? tensor->getName() : "");
+        if (tensor)
+        {
+            hasher.add(tensor->getDimensions()).add(static_cast<int64_t>(tensor->getType()));
+        }
+    };
+
+    for (int i = 0; i < network.getNbInputs(); ++i)
+    {
+        addTensor(network.getInput(i));
+    }
+    for (int l = 0; l < network.getNbLayers(); ++l)
+    {
+        nvinfer1::ILayer* layer = network.getLayer(l);
+        hasher.add(layer->getName()).add(static_cast<int64_t>(layer->getType()));
+        for (int i = 0; i < layer->getNbInputs(); ++i)
+        {
+            addTensor(layer->getInput(i));
+        }
+        for (int o = 0; o < layer->getNbOutputs(); ++o)
+        {
+            addTensor(layer->getOutput(o));
+        }
+
+        // Retrained weights change the activation ranges even if the topology is the same.
+        switch (layer->getType())
+        {
+        case nvinfer1::LayerType::kCONVOLUTION:
+        {
+            auto conv = static_cast<nvinfer1::IConvolutionLayer*>(layer);
+            hasher.add(conv->getKernelWeights()).add(conv->getBiasWeights());
+            break;
+        }
+        case nvinfer1::LayerType::kDECONVOLUTION:
+        {
+            auto deconv = static_cast<nvinfer1::IDeconvolutionLayer*>(layer);
+            hasher.add(deconv->getKernelWeights()).add(deconv->getBiasWeights());
+            break;
+        }
+        case nvinfer1::LayerType::kFULLY_CONNECTED:
+        {
+            auto fc = static_cast<nvinfer1::IFullyConnectedLayer*>(layer);
+            hasher.add(fc->getKernelWeights()).add(fc->getBiasWeights());
+            break;
+        }
+        case nvinfer1::LayerType::kSCALE:
+        {
+            auto scale = static_cast<nvinfer1::IScaleLayer*>(layer);
+            hasher.add(scale->getShift()).add(scale->getScale()).add(scale->getPower());
+            break;
+        }
+        case nvinfer1::LayerType::kCONSTANT:
+            hasher.add(static_cast<nvinfer1::IConstantLayer*>(layer)->getWeights());
+            break;
+        default: break;
+        }
+    }
+    for (int i = 0; i < network.getNbOutputs(); ++i)
+    {
+        addTensor(network.getOutput(i));
+    }
+    hasher.add(datasetIdentity);
+    return hasher.str();
+}
+
+//!
+//! \brief Returns the key of a calibration table: the network key, refined by the calibration batch size and algorithm.
+//!
+inline std::string calibrationCacheKey(
+    const std::string& networkKey, int batchSize, nvinfer1::CalibrationAlgoType algorithm)
+{
+    return CacheKeyHasher().add(networkKey).add(static_cast<int64_t>(batchSize)).add(static_cast<int64_t>(algorithm)).str();
+}
+
+//!
+//! \brief Writes a file under a unique temporary name and renames it over path, so that readers see either the
+//!        old or the new content in full.
+//!
+inline bool writeFileAtomically(const std::string& path, const std::string& content)
+{
+#ifdef _MSC_VER
+    const long long pid = _getpid();
+#else
+    const long long pid = getpid();
+#endif
+    const std::string temporary = path + ".tmp" + std::to_string(pid) + "_"
+        + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream output(temporary, std::ios::binary);
+        output.write(content.data(), content.size());
+        if (!output)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+#ifdef _MSC_VER
+    // rename() does not replace an existing file on Windows.
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+//!
+//! \brief  The CalibrationCacheStore class keeps calibration tables in a directory, one file per key.
+//!
+//! \details Tables are written to a temporary file and renamed into place, so a reader never sees a partial
+//!          table even if several builds run at once. The directory also holds index.txt, which lists the key
+//!          and a description of every table. The index is only ever appended to, one line per table written,
+//!          under an exclusive lock where the platform has one, so concurrent builds cannot drop each other's
+//!          entries; readIndex() keeps the last entry of every key. The directory is, in order of preference, the
+//!          one given to the constructor, $TRT_CALIBRATION_CACHE_DIR, or a per-user cache directory.
+//!
+class CalibrationCacheStore
+{
+public:
+    explicit CalibrationCacheStore(const std::string& directory = "")
+        : mDirectory(directory.empty() ? defaultDirectory() : directory)
+    {
+    }
+
+    const std::string& getDirectory() const
+    {
+        return mDirectory;
+    }
+
+    std::string getPath(const std::string& key) const
+    {
+        return mDirectory + "/" + key + ".calib";
+    }
+
+    //!
+    //! \brief Reads the table of a key. Returns false if there is none.
+    //!
+    bool read(const std::string& key, std::vector<char>& cache) const
+    {
+        cache.clear();
+        std::ifstream input(getPath(key), std::ios::binary);
+        if (!input)
+        {
+            return false;
+        }
+        cache.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        return !cache.empty();
+    }
+
+    //!
+    //! \brief Atomically stores the table of a key. Returns false if the table could not be stored.
+    //!
+    bool write(const std::string& key, const void* cache, size_t length) const
+    {
+        if (!createDirectories(mDirectory))
+        {
+            return false;
+        }
+        return writeFileAtomically(getPath(key), std::string(static_cast<const char*>(cache), length));
+    }
+
+    std::string getIndexPath() const
+    {
+        return mDirectory + "/index.txt";
+    }
+
+    //!
+    //! \brief Records a description of the table of a key in the index. Returns false if the index could not be
+    //!        written; the table itself is not affected.
+    //!
+    bool addToIndex(const std::string& key, const std::string& description) const
+    {
+        std::string line = key + " " + description;
+        std::replace(line.begin(), line.end(), '\n', ' ');
+        line += '\n';
+        // A single write to a file opened for appending, so that entries of concurrent writers do not interleave.
+#ifdef _MSC_VER
+        const int fd
+            = _open(getIndexPath().c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd < 0)
+        {
+            return false;
+        }
+        const bool written
+            = _write(fd, line.data(), static_cast<unsigned>(line.size())) == static_cast<int>(line.size());
+        return _close(fd) == 0 && written;
+#else
+        const int fd = open(getIndexPath().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        // The lock, released by close(), serializes the appends where O_APPEND alone is not atomic, as on NFS.
+        const bool written
+            = flock(fd, LOCK_EX) == 0 && ::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+        return close(fd) == 0 && written;
+#endif
+    }
+
+    //!
+    //! \brief Returns the key and description of every table in the index, each key once with its latest
+    //!        description, in the order the keys were last written.
+    //!
+    std::vector<std::pair<std::string, std::string>> readIndex() const
+    {
+        std::vector<std::pair<std::string, std::string>> entries;
+        std::ifstream index(getIndexPath());
+        std::string line;
+        while (std::getline(index, line))
+        {
+            const size_t space = line.find(' ');
+            if (line.empty() || space == 0)
+            {
+                continue;
+            }
+            const std::string key = line.substr(0, space);
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                              [&key](const std::pair<std::string, std::string>& e) { return e.first == key; }),
+                entries.end());
+            entries.emplace_back(key, space == std::string::npos ? "" : line.substr(space + 1));
+        }
+        return entries;
+    }
+
+    //!
+    //! \brief Returns $TRT_CALIBRATION_CACHE_DIR, or an empty string if it is not set.
+    //!
+    static std::string environmentDirectory()
+    {
+        const char* dir = std::getenv("TRT_CALIBRATION_CACHE_DIR");
+        return dir ? dir : "";
+    }
+
+    static std::string defaultDirectory()
+    {
+        const std::string dir = environmentDirectory();
+        if (!dir.empty())
+        {
+            return dir;
+        }
+#ifdef _MSC_VER
+        const char* home = std::getenv("LOCALAPPDATA");
+#else
+        const char* home = std::getenv("HOME");
+#endif
+        return home && *home ? std::string(home) + "/.cache/tensorrt/calibration" : "calibration_cache";
+    }
+
+private:
+    static bool createDirectories(const std::string& path)
+    {
+        for (size_t pos = path.find('/', 1);; pos = path.find('/', pos + 1))
+        {
+            const std::string dir = path.substr(0, pos);
+#ifdef _MSC_VER
+            _mkdir(dir.c_str());
+#else
+            mkdir(dir.c_str(), 0755);
+#endif
+            if (pos == std::string::npos)
+            {
+                break;
+            }
+        }
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFDIR);
+    }
+
+    std::string mDirectory;
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_CALIBRATION_CACHE_H
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_CALIBRATION_DATASET_H
+#define TENSORRT_CALIBRATION_DATASET_H
+
+#include "half.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! A calibration dataset packs a whole calibration set into a single file:
+//!
+//!     header | index: count + 1 int64 payload offsets | labels: count floats (optional) | padding | payload
+//!
+//! The payload holds the images back to back in CHW order and in the element type of the header. Image i
+//! occupies the bytes [index[i], index[i + 1]), so any run of consecutive images, and hence any batch, is
+//! read with a single seek. All values are little-endian.
+//!
+
+//! Element type of the payload.
+enum class DatasetType : int32_t
+{
+    kFLOAT = 0, //!< 32-bit floats, stored as they are fed to the network
+    kHALF = 1,  //!< IEEE half precision floats
+    kUINT8 = 2  //!< 8-bit values q dequantized to scale * q + bias[c]
+};
+
+constexpr int32_t kDATASET_VERSION = 1;
+constexpr int kDATASET_MAX_CHANNELS = 4;     //!< Channels with their own uint8 bias; others use bias[0]
+constexpr int64_t kDATASET_PAYLOAD_ALIGNMENT = 64;
+
+struct CalibrationDatasetHeader
+{
+    char magic[8];          //!< "TRTCALDS"
+    int32_t version;        //!< kDATASET_VERSION
+    int32_t type;           //!< DatasetType of the payload
+    int32_t channels;       //!< Image dimensions
+    int32_t height;
+    int32_t width;
+    int32_t hasLabels;      //!< Non zero if the file holds one label per image
+    int64_t count;          //!< Number of images
+    int64_t indexOffset;    //!< Offset of the index of payload offsets
+    int64_t labelsOffset;   //!< Offset of the labels, 0 if there are none
+    float scale;            //!< Dequantization scale of uint8 payloads
+    float bias[kDATASET_MAX_CHANNELS]; //!< Per channel dequantization bias of uint8 payloads
+    int32_t reserved;
+};
+
+static_assert(sizeof(CalibrationDatasetHeader) == 80, "Unexpected calibration dataset header layout");
+
+inline size_t datasetTypeSize(DatasetType type)
+{
+    switch (type)
+    {
+    case DatasetType::kFLOAT: return sizeof(float);
+    case DatasetType::kHALF: return sizeof(half_float::half);
+    case DatasetType::kUINT8: return sizeof(uint8_t);
+    }
+    return 0;
+}
+
+//!
+//! \brief Checks the magic, version and type of a header. Returns false if the file is not a dataset.
+//!
+inline bool isValidDatasetHeader(const CalibrationDatasetHeader& header)
+{
+    return std::memcmp(header.magic, "TRTCALDS", sizeof(header.magic)) == 0 && header.version == kDATASET_VERSION
+        && header.type >= static_cast<int32_t>(DatasetType::kFLOAT)
+        && header.type <= static_cast<int32_t>(DatasetType::kUINT8) && header.channels > 0 && header.height > 0
+        && header.width > 0 && header.count >= 0;
+}
+
+//!
+//! \brief Checks that the size bytes at data hold a whole dataset and copies its header to header: a valid header,
+//!        then an index, labels and payload that lie within the file, with the images back to back.
+//!
+inline bool readDatasetHeader(const uint8_t* data, size_t size, CalibrationDatasetHeader& header)
+{
+    if (!data || size < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    const int64_t fileSize = static_cast<int64_t>(size);
+    const int64_t entrySize = static_cast<int64_t>(sizeof(int64_t));
+    if (!isValidDatasetHeader(header) || header.count >= fileSize / entrySize
+        || header.indexOffset < static_cast<int64_t>(sizeof(header)) || header.indexOffset > fileSize)
+    {
+        return false;
+    }
+    const int64_t indexEnd = header.indexOffset + (header.count + 1) * entrySize;
+    if (indexEnd > fileSize)
+    {
+        return false;
+    }
+    if (header.hasLabels
+        && (header.labelsOffset < indexEnd
+            || header.labelsOffset + header.count * static_cast<int64_t>(sizeof(float)) > fileSize))
+    {
+        return false;
+    }
+
+    const int64_t imageBytes = static_cast<int64_t>(header.channels) * header.height * header.width
+        * datasetTypeSize(static_cast<DatasetType>(header.type));
+    int64_t first;
+    std::memcpy(&first, data + header.indexOffset, sizeof(first));
+    if (first < indexEnd || first > fileSize || header.count > (fileSize - first) / imageBytes)
+    {
+        return false;
+    }
+    for (int64_t i = 1; i <= header.count; ++i)
+    {
+        int64_t offset;
+        std::memcpy(&offset, data + header.indexOffset + i * entrySize, sizeof(offset));
+        if (offset != first + i * imageBytes)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//!
+//! \brief Converts count images of the payload to floats.
+//!
+inline void decodeDatasetImages(
+    const CalibrationDatasetHeader& header, const uint8_t* payload, int64_t count, float* images)
+{
+    const int64_t volChl = static_cast<int64_t>(header.height) * header.width;
+    const int64_t elements = count * header.channels * volChl;
+    switch (static_cast<DatasetType>(header.type))
+    {
+    case DatasetType::kFLOAT: std::memcpy(images, payload, elements * sizeof(float)); break;
+    case DatasetType::kHALF:
+    {
+        const half_float::half* values = reinterpret_cast<const half_float::half*>(payload);
+        std::copy_n(values, elements, images);
+        break;
+    }
+    case DatasetType::kUINT8:
+        for (int64_t i = 0, e = 0; i < count; ++i)
+        {
+            for (int c = 0; c < header.channels; ++c)
+            {
+                const float bias = header.bias[c < kDATASET_MAX_CHANNELS ? c : 0];
+                for (int64_t j = 0; j < volChl; ++j, ++e)
+                {
+                    images[e] = header.scale * float(payload[e]) + bias;
+                }
+            }
+        }
+        break;
+    }
+}
+
+//!
+//! \brief  The CalibrationDatasetWriter class creates a dataset file whose images can be written in any order.
+//!
+//! \details The constructor writes the header, the index and room for the labels and the payload. Each call to
+//!          writeImages() then fills a disjoint range of images through its own file handle, so several threads
+//!          may write at the same time as long as their ranges do not overlap.
+//!
+class CalibrationDatasetWriter
+{
+public:
+    //!
+    //! \brief Creates the file. For uint8 payloads, scale and bias define the dequantization; channels beyond
+    //!        kDATASET_MAX_CHANNELS share bias[0].
+    //!
+    CalibrationDatasetWriter(const std::string& fileName, DatasetType type, int channels, int height, int width,
+        int64_t count, bool hasLabels, float scale = 1.0F, const std::vector<float>& bias = {})
+        : mFileName(fileName)
+    {
+        std::memset(&mHeader, 0, sizeof(mHeader));
+        std::memcpy(mHeader.magic, "TRTCALDS", sizeof(mHeader.magic));
+        mHeader.version = kDATASET_VERSION;
+        mHeader.type = static_cast<int32_t>(type);
+        mHeader.channels = channels;
+        mHeader.height = height;
+        mHeader.width = width;
+        mHeader.hasLabels = hasLabels ? 1 : 0;
+        mHeader.count = count;
+        mHeader.scale = scale;
+        for (int c = 0; c < kDATASET_MAX_CHANNELS; ++c)
+        {
+            mHeader.bias[c] = bias.empty() ? 0.0F : bias[std::min<size_t>(c, bias.size() - 1)];
+        }
+
+        mImageBytes = static_cast<int64_t>(channels) * height * width * datasetTypeSize(type);
+        mHeader.indexOffset = sizeof(CalibrationDatasetHeader);
+        int64_t end = mHeader.indexOffset + (count + 1) * static_cast<int64_t>(sizeof(int64_t));
+        if (hasLabels)
+        {
+            mHeader.labelsOffset = end;
+            end += count * static_cast<int64_t>(sizeof(float));
+        }
+        mPayloadOffset = (end + kDATASET_PAYLOAD_ALIGNMENT - 1) / kDATASET_PAYLOAD_ALIGNMENT * kDATASET_PAYLOAD_ALIGNMENT;
+
+        std::vector<int64_t> index(count + 1);
+        for (int64_t i = 0; i <= count; ++i)
+        {
+            index[i] = mPayloadOffset + i * mImageBytes;
+        }
+
+        std::ofstream file(mFileName, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&mHeader), sizeof(mHeader));
+        file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(int64_t));
+        // Extend the file to its final size so that writers can seek anywhere in it.
+        const int64_t fileSize = index.back();
+        if (fileSize > static_cast<int64_t>(file.tellp()))
+        {
+            file.seekp(fileSize - 1);
+            file.put(0);
+        }
+        mGood = static_cast<bool>(file);
+    }
+
+    //!
+    //! \brief Returns false if the file could not be created.
+    //!
+    bool good() const
+    {
+        return mGood;
+    }
+
+    //!
+    //! \brief Encodes and writes count images starting at image first. labels may be null if the dataset has none.
+    //!
+    bool writeImages(int64_t first, int64_t count, const float* images, const float* labels) const
+    {
+        if (first < 0 || first + count > mHeader.count)
+        {
+            return false;
+        }
+        std::vector<char> payload(count * mImageBytes);
+        encode(images, count, payload.data());
+
+        std::fstream file(mFileName, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(mPayloadOffset + first * mImageBytes);
+        file.write(payload.data(), payload.size());
+        if (mHeader.hasLabels && labels)
+        {
+            file.seekp(mHeader.labelsOffset + first * static_cast<int64_t>(sizeof(float)));
+            file.write(reinterpret_cast<const char*>(labels), count * sizeof(float));
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    void encode(const float* images, int64_t count, char* payload) const
+    {
+        const int64_t volChl = static_cast<int64_t>(mHeader.height) * mHeader.width;
+        const int64_t elements = count * mHeader.channels * volChl;
+        switch (static_cast<DatasetType>(mHeader.type))
+        {
+        case DatasetType::kFLOAT: std::memcpy(payload, images, elements * sizeof(float)); break;
+        case DatasetType::kHALF:
+        {
+            half_float::half* values = reinterpret_cast<half_float::half*>(payload);
+            for (int64_t e = 0; e < elements; ++e)
+            {
+                values[e] = half_float::half(images[e]);
+            }
+            break;
+        }
+        case DatasetType::kUINT8:
+        {
+            uint8_t* values = reinterpret_cast<uint8_t*>(payload);
+            for (int64_t i = 0, e = 0; i < count; ++i)
+            {
+                for (int c = 0; c < mHeader.channels; ++c)
+                {
+                    const float bias = mHeader.bias[c < kDATASET_MAX_CHANNELS ? c : 0];
+                    for (int64_t j = 0; j < volChl; ++j, ++e)
+                    {
+                        const float q = std::round((images[e] - bias) / mHeader.scale);
+                        values[e] = static_cast<uint8_t>(std::min(std::max(q, 0.0F), 255.0F));
+                    }
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    std::string mFileName;
+    CalibrationDatasetHeader mHeader;
+    int64_t mImageBytes{0};
+    int64_t mPayloadOffset{0};
+    bool mGood{false};
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_CALIBRATION_DATASET_H
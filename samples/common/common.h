@@ -64,6 +64,7 @@
 #include "NvInferPlugin.h"
 #include "logger.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cmath>
@@ -80,6 +81,7 @@
 #include <ratio>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -671,6 +673,32 @@ inline void readPPMFile(const std::string& filename, samplesCommon::PPM<C, H, W>
     infile.read(reinterpret_cast<char*>(ppm.buffer), ppm.w * ppm.h * 3);
 }
 
+//!
+//! \brief Reads a binary PPM image whose size is only known at runtime.
+//!
+//! \return false if the file cannot be read or its size differs from c x h x w.
+//!          On success, buffer holds the interleaved pixels.
+//!
+inline bool readPPMFile(const std::string& filename, int c, int h, int w, std::vector<uint8_t>& buffer)
+{
+    std::ifstream infile(filename, std::ifstream::binary);
+    if (!infile.is_open())
+    {
+        return false;
+    }
+    std::string magic;
+    int fileW, fileH, max;
+    infile >> magic >> fileW >> fileH >> max;
+    infile.seekg(1, infile.cur);
+    if (fileW != w || fileH != h || c != 3)
+    {
+        return false;
+    }
+    buffer.resize(static_cast<size_t>(c) * h * w);
+    infile.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    return static_cast<bool>(infile);
+}
+
 template <int C, int H, int W>
 inline void writePPMFileWithBBox(const std::string& filename, PPM<C, H, W>& ppm, const BBox& bbox)
 {
@@ -786,6 +814,44 @@ inline std::vector<std::string> splitString(std::string str, char delimiter = ',
     return splitVect;
 }
 
+//!
+//! \brief Calls func(i) for every i in [0, count) on up to nbThreads threads, including the calling one.
+//!
+//! \details Indices are handed out dynamically, so items of uneven cost are balanced between threads.
+//!          The function returns once all calls have completed.
+//!
+template <typename Func>
+inline void parallelFor(int count, int nbThreads, Func func)
+{
+    nbThreads = std::max(1, std::min(nbThreads, count));
+    if (nbThreads == 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<int> nextIndex{0};
+    auto worker = [&]() {
+        for (int i = nextIndex++; i < count; i = nextIndex++)
+        {
+            func(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
 // Return m rounded up to nearest multiple of n
 inline int roundUp(int m, int n)
 {
@@ -154,7 +154,7 @@ TRTParsedArgs parseArgs(int argc, const char* const* argv, const std::vector<TRT
         }
 
         // If only 1 hyphen, char after is the flag.
-        TRTOption opt;
+        TRTOption opt{};
         std::string value;
         if (argStr[1] != '-')
         {
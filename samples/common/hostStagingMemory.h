@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_HOST_STAGING_MEMORY_H
+#define TENSORRT_HOST_STAGING_MEMORY_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The types of host memory a BufferManager can stage copies in.
+//!
+enum class HostMemoryType
+{
+    kPAGEABLE,      //!< malloc; the driver copies it through an internal pinned buffer, so copies do not overlap
+    kPINNED,        //!< Page-locked memory, copied by DMA, so asynchronous copies overlap with compute
+    kWRITE_COMBINED //!< Page-locked and write-combined: faster to copy to the device, very slow for the host to read
+};
+
+//!
+//! \brief Interface of the allocators of host memory, so that the policy and accounting of HostStagingMemory
+//!        can be exercised without CUDA.
+//!
+class IHostMemoryAllocator
+{
+public:
+    //! Returns nullptr if the memory cannot be allocated.
+    virtual void* allocate(size_t size, HostMemoryType type) = 0;
+    virtual void free(void* ptr, HostMemoryType type) = 0;
+    virtual ~IHostMemoryAllocator() = default;
+};
+
+//!
+//! \brief The HostMemoryStats structure reports the memory allocated by a HostStagingMemory, indexed by
+//!        HostMemoryType.
+//!
+struct HostMemoryStats
+{
+    std::array<size_t, 3> bytes{};       //!< Bytes currently allocated
+    std::array<size_t, 3> peakBytes{};   //!< High-water marks of bytes
+    std::array<size_t, 3> allocations{}; //!< Number of allocations
+    size_t fallbacks{0};                 //!< Page-locked allocations that fell back to pageable memory
+};
+
+//!
+//! \brief  The HostStagingMemory class allocates the host buffers of bindings according to a policy, and
+//!         accounts for them.
+//!
+//! \details The policy is the type of memory used for inputs. Write-combined memory is only used for inputs,
+//!          which the host writes but does not read; outputs then use pinned memory. Page-locked memory is a
+//!          limited resource, so when it cannot be allocated the buffer falls back to pageable memory. A
+//!          HostStagingMemory can be shared by several BufferManager instances to account for all of them.
+//!          createHostStagingMemory() of buffers.h creates one that allocates with CUDA.
+//!
+class HostStagingMemory
+{
+public:
+    HostStagingMemory(HostMemoryType policy, std::shared_ptr<IHostMemoryAllocator> allocator)
+        : mPolicy(policy)
+        , mAllocator(std::move(allocator))
+    {
+        assert(mAllocator);
+    }
+
+    HostMemoryType getPolicy() const
+    {
+        return mPolicy;
+    }
+
+    //!
+    //! \brief Returns the type of memory the policy assigns to an input or output buffer.
+    //!
+    HostMemoryType getType(bool isInput) const
+    {
+        return mPolicy == HostMemoryType::kWRITE_COMBINED && !isInput ? HostMemoryType::kPINNED : mPolicy;
+    }
+
+    //!
+    //! \brief Allocates a buffer. Returns nullptr if not even pageable memory can be allocated.
+    //!
+    void* allocate(size_t size, bool isInput)
+    {
+        // Zero sized bindings still get a distinct address.
+        size = std::max<size_t>(size, 1);
+        HostMemoryType type = getType(isInput);
+        void* ptr = mAllocator->allocate(size, type);
+        const bool fallback = !ptr && type != HostMemoryType::kPAGEABLE;
+        if (fallback)
+        {
+            type = HostMemoryType::kPAGEABLE;
+            ptr = mAllocator->allocate(size, type);
+        }
+        if (!ptr)
+        {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        mBlocks[ptr] = std::make_pair(type, size);
+        const int t = static_cast<int>(type);
+        mStats.bytes[t] += size;
+        mStats.peakBytes[t] = std::max(mStats.peakBytes[t], mStats.bytes[t]);
+        ++mStats.allocations[t];
+        mStats.fallbacks += fallback;
+        return ptr;
+    }
+
+    //!
+    //! \brief Frees a buffer returned by allocate(). It must work with nullptr input.
+    //!
+    void free(void* ptr)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+        std::pair<HostMemoryType, size_t> block;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = mBlocks.find(ptr);
+            assert(found != mBlocks.end() && "Freeing memory not allocated by this HostStagingMemory");
+            block = found->second;
+            mBlocks.erase(found);
+            mStats.bytes[static_cast<int>(block.first)] -= block.second;
+        }
+        mAllocator->free(ptr, block.first);
+    }
+
+    HostMemoryStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+private:
+    HostMemoryType mPolicy;
+    std::shared_ptr<IHostMemoryAllocator> mAllocator;
+    mutable std::mutex mMutex;
+    std::unordered_map<void*, std::pair<HostMemoryType, size_t>> mBlocks; //!< Type and size of live buffers
+    HostMemoryStats mStats;
+};
+
+//! Deleter of the buffers allocated by a HostStagingMemory, which it keeps alive.
+struct HostStagingDeleter
+{
+    std::shared_ptr<HostStagingMemory> memory;
+
+    void operator()(void* ptr) const
+    {
+        memory->free(ptr);
+    }
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_HOST_STAGING_MEMORY_H
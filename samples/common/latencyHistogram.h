@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_LATENCY_HISTOGRAM_H
+#define TENSORRT_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The LatencySummary structure holds the statistics of a LatencyHistogram, in milliseconds.
+//!
+struct LatencySummary
+{
+    uint64_t count{0};
+    double min{0};
+    double max{0};
+    double mean{0};
+    double stddev{0};
+    double p50{0};
+    double p90{0};
+    double p95{0};
+    double p99{0};
+    double p999{0};
+    double throughput{0}; //!< Latencies recorded per second of walltime, 0 if no walltime was given
+};
+
+//!
+//! \brief  The LatencyHistogram class records latencies into log-linear buckets, in the manner of HdrHistogram.
+//!
+//! \details Latencies are stored as integer nanoseconds. Values below 256 ns have a bucket each; above, every
+//!          power of two is split into 128 buckets of equal width, so a percentile is reported with a relative
+//!          error of at most 1/256 (0.4%) whatever its magnitude. Values are clamped to about 18 minutes. Recording
+//!          is a handful of integer operations and never allocates. Count, minimum, maximum, mean and standard
+//!          deviation are exact. Histograms filled by different threads can be merged, and the merged percentiles
+//!          are those of the union of the values.
+//!
+class LatencyHistogram
+{
+public:
+    static constexpr int kSUB_BUCKET_BITS = 7;                   //!< log2 of the buckets per power of two
+    static constexpr int kMAX_VALUE_BITS = 40;                   //!< Values are below 2^40 ns
+    static constexpr uint64_t kSUB_BUCKETS = uint64_t(1) << kSUB_BUCKET_BITS;
+    static constexpr int kNB_BUCKETS = (kMAX_VALUE_BITS - kSUB_BUCKET_BITS + 1) * kSUB_BUCKETS;
+
+    LatencyHistogram()
+        : mCounts(kNB_BUCKETS, 0)
+    {
+    }
+
+    //!
+    //! \brief Records a latency in milliseconds. Negative latencies count as 0.
+    //!
+    void record(double ms)
+    {
+        const double ns = std::min(std::max(ms * 1e6, 0.0), static_cast<double>((uint64_t(1) << kMAX_VALUE_BITS) - 1));
+        const uint64_t value = static_cast<uint64_t>(ns + 0.5);
+        ++mCounts[bucketOf(value)];
+        if (mCount == 0 || ms < mMin)
+        {
+            mMin = ms;
+        }
+        if (mCount == 0 || ms > mMax)
+        {
+            mMax = ms;
+        }
+        ++mCount;
+        mSum += ms;
+        mSumSquares += ms * ms;
+    }
+
+    //!
+    //! \brief Adds the latencies of another histogram to this one.
+    //!
+    void merge(const LatencyHistogram& other)
+    {
+        if (other.mCount == 0)
+        {
+            return;
+        }
+        for (int b = 0; b < kNB_BUCKETS; ++b)
+        {
+            mCounts[b] += other.mCounts[b];
+        }
+        mMin = mCount ? std::min(mMin, other.mMin) : other.mMin;
+        mMax = mCount ? std::max(mMax, other.mMax) : other.mMax;
+        mCount += other.mCount;
+        mSum += other.mSum;
+        mSumSquares += other.mSumSquares;
+    }
+
+    void reset()
+    {
+        std::fill(mCounts.begin(), mCounts.end(), 0);
+        mCount = 0;
+        mMin = mMax = mSum = mSumSquares = 0;
+    }
+
+    uint64_t count() const
+    {
+        return mCount;
+    }
+
+    //!
+    //! \brief Returns the latency below or at which percentage percent of the latencies lie (0 <= percentage
+    //!        <= 100), by nearest rank: 0 gives the minimum and 100 the maximum.
+    //!
+    double percentile(double percentage) const
+    {
+        double value{0};
+        percentiles(&percentage, &value, 1);
+        return value;
+    }
+
+    //!
+    //! \brief Computes all the statistics in one pass over the buckets.
+    //!
+    //! \param walltime The time over which the latencies were recorded, in milliseconds, to compute the throughput.
+    //!
+    LatencySummary summarize(double walltime = 0) const
+    {
+        LatencySummary summary;
+        summary.count = mCount;
+        if (mCount == 0)
+        {
+            return summary;
+        }
+        summary.min = mMin;
+        summary.max = mMax;
+        summary.mean = mSum / mCount;
+        summary.stddev = std::sqrt(std::max(0.0, mSumSquares / mCount - summary.mean * summary.mean));
+        const double percentages[] = {50, 90, 95, 99, 99.9};
+        double values[5];
+        percentiles(percentages, values, 5);
+        summary.p50 = values[0];
+        summary.p90 = values[1];
+        summary.p95 = values[2];
+        summary.p99 = values[3];
+        summary.p999 = values[4];
+        summary.throughput = walltime > 0 ? mCount * 1000.0 / walltime : 0;
+        return summary;
+    }
+
+private:
+    //! Returns the bucket of a value in nanoseconds.
+    static int bucketOf(uint64_t value)
+    {
+        if (value < 2 * kSUB_BUCKETS)
+        {
+            return static_cast<int>(value);
+        }
+        const int shift = highestBit(value) - kSUB_BUCKET_BITS;
+        return static_cast<int>((shift + 1) * kSUB_BUCKETS + (value >> shift) - kSUB_BUCKETS);
+    }
+
+    //! Returns the middle of a bucket in nanoseconds; buckets of width 1 hold a single value.
+    static double bucketValue(int bucket)
+    {
+        if (bucket < static_cast<int>(2 * kSUB_BUCKETS))
+        {
+            return bucket;
+        }
+        const int shift = bucket / static_cast<int>(kSUB_BUCKETS) - 1;
+        const uint64_t low = (kSUB_BUCKETS + bucket % kSUB_BUCKETS) << shift;
+        return low + ((uint64_t(1) << shift) - 1) / 2.0;
+    }
+
+    static int highestBit(uint64_t value)
+    {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    //! Computes the percentiles of nb increasing percentages in one pass over the buckets.
+    void percentiles(const double* percentages, double* values, int nb) const
+    {
+        uint64_t cumulated = 0;
+        int b = 0;
+        for (int i = 0; i < nb; ++i)
+        {
+            if (mCount == 0)
+            {
+                values[i] = 0;
+                continue;
+            }
+            // Nearest rank, from 1 to mCount
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentages[i] / 100 * mCount)));
+            while (b < kNB_BUCKETS && cumulated + mCounts[b] < rank)
+            {
+                cumulated += mCounts[b++];
+            }
+            // The exact extremes are known, and no bucket value should leave their range.
+            const double value = std::min(mMax, std::max(mMin, bucketValue(std::min(b, kNB_BUCKETS - 1)) * 1e-6));
+            values[i] = rank == 1 ? mMin : rank >= mCount ? mMax : value;
+        }
+    }
+
+    std::vector<uint64_t> mCounts;
+    uint64_t mCount{0};
+    double mMin{0};
+    double mMax{0};
+    double mSum{0};
+    double mSumSquares{0};
+};
+
+//!
+//! \brief Prints a LatencySummary on one line, prefixed by name.
+//!
+inline void printLatencySummary(std::ostream& os, const std::string& name, const LatencySummary& summary)
+{
+    os << name << ": min = " << summary.min << " ms, max = " << summary.max << " ms, mean = " << summary.mean
+       << " ms, stddev = " << summary.stddev << " ms, p50 = " << summary.p50 << " ms, p90 = " << summary.p90
+       << " ms, p95 = " << summary.p95 << " ms, p99 = " << summary.p99 << " ms, p99.9 = " << summary.p999 << " ms";
+    if (summary.throughput > 0)
+    {
+        os << ", " << summary.throughput << " per second";
+    }
+    os << std::endl;
+}
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_LATENCY_HISTOGRAM_H
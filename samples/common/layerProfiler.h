@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_LAYER_PROFILER_H
+#define TENSORRT_LAYER_PROFILER_H
+
+#include "NvInfer.h"
+#include "latencyHistogram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The LayerStats structure holds the statistics of one layer reported by a LayerProfiler.
+//!
+struct LayerStats
+{
+    std::string name;
+    uint64_t count{0};     //!< Number of invocations
+    double total{0};       //!< Sum of the invocation times, in milliseconds
+    double average{0};     //!< Average invocation time, in milliseconds
+    double p50{0};         //!< Median invocation time, in milliseconds
+    double p99{0};         //!< 99th percentile of the invocation times, in milliseconds
+    double percentage{0};  //!< Share of the total time of all layers
+};
+
+//!
+//! \brief  The LayerIndex class gives every layer reported to a profiler a dense index, in the order of its first
+//!         report.
+//!
+//! \details A name is only copied, and memory allocated, the first time it is reported. TensorRT reports the layers
+//!          in the same order on every inference, so the index expects the layer following the previous one and
+//!          only compares the name with it. A layer out of that order is looked up among all the known layers.
+//!
+class LayerIndex
+{
+public:
+    //!
+    //! \brief Returns the index of a layer; a layer never reported gets index size().
+    //!
+    size_t indexOf(const char* layerName)
+    {
+        size_t index = mNext;
+        if (index >= mNames.size() || !matches(index, layerName))
+        {
+            index = 0;
+            while (index < mNames.size() && !matches(index, layerName))
+            {
+                ++index;
+            }
+            if (index == mNames.size())
+            {
+                mNames.emplace_back(layerName);
+            }
+        }
+        mNext = index + 1 < mNames.size() ? index + 1 : 0;
+        return index;
+    }
+
+    //!
+    //! \brief Returns the number of distinct layers reported.
+    //!
+    size_t size() const
+    {
+        return mNames.size();
+    }
+
+    const std::string& getName(size_t index) const
+    {
+        return mNames[index];
+    }
+
+private:
+    bool matches(size_t index, const char* layerName) const
+    {
+        return std::strcmp(mNames[index].c_str(), layerName) == 0;
+    }
+
+    std::vector<std::string> mNames;
+    size_t mNext{0}; //!< The index of the layer expected next
+};
+
+//!
+//! \brief  The LayerProfiler class records the distribution of the time of every layer with little overhead.
+//!
+//! \details Each layer gets a LatencyHistogram the first time its name is reported, at the dense index given by a
+//!          LayerIndex; that is the only time memory is allocated. Every histogram takes about 34 KiB.
+//!
+class LayerProfiler : public nvinfer1::IProfiler
+{
+public:
+    explicit LayerProfiler(const std::string& name = "Layer time")
+        : mName(name)
+    {
+    }
+
+    void reportLayerTime(const char* layerName, float ms) override
+    {
+        const size_t index = mIndex.indexOf(layerName);
+        if (index == mLayers.size())
+        {
+            mLayers.emplace_back();
+        }
+        mLayers[index].record(ms);
+    }
+
+    //!
+    //! \brief Returns the number of distinct layers reported.
+    //!
+    size_t getNbLayers() const
+    {
+        return mLayers.size();
+    }
+
+    //!
+    //! \brief Returns the statistics of every layer, in the order of their first report.
+    //!
+    std::vector<LayerStats> getLayerStats() const
+    {
+        std::vector<LayerStats> stats;
+        stats.reserve(mLayers.size());
+        double total{0};
+        for (size_t i = 0; i < mLayers.size(); ++i)
+        {
+            const LatencySummary summary = mLayers[i].summarize();
+            LayerStats s;
+            s.name = mIndex.getName(i);
+            s.count = summary.count;
+            s.total = summary.mean * summary.count;
+            s.average = summary.mean;
+            s.p50 = summary.p50;
+            s.p99 = summary.p99;
+            total += s.total;
+            stats.push_back(s);
+        }
+        for (auto& s : stats)
+        {
+            s.percentage = total > 0 ? s.total * 100 / total : 0;
+        }
+        return stats;
+    }
+
+    //!
+    //! \brief Prints the statistics of every layer in the order of their first report.
+    //!
+    void print(std::ostream& os) const
+    {
+        const std::vector<LayerStats> stats = getLayerStats();
+        os << "========== " << mName << " profile ==========" << std::endl;
+        printTable(os, stats);
+        double total{0};
+        for (const auto& s : stats)
+        {
+            total += s.total;
+        }
+        os << "========== " << mName << " total runtime = " << total << " ms ==========" << std::endl;
+    }
+
+    //!
+    //! \brief Prints the statistics of the nb layers with the largest total time, largest first.
+    //!
+    void printHotspots(std::ostream& os, size_t nb) const
+    {
+        std::vector<LayerStats> stats = getLayerStats();
+        nb = std::min(nb, stats.size());
+        std::partial_sort(stats.begin(), stats.begin() + nb, stats.end(),
+            [](const LayerStats& a, const LayerStats& b) { return a.total > b.total; });
+        stats.resize(nb);
+        os << "========== " << mName << " top " << nb << " layers ==========" << std::endl;
+        printTable(os, stats);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const LayerProfiler& profiler)
+    {
+        profiler.print(os);
+        return os;
+    }
+
+private:
+    static void printTable(std::ostream& os, const std::vector<LayerStats>& stats)
+    {
+        int nameWidth = 20;
+        for (const auto& s : stats)
+        {
+            nameWidth = std::max(nameWidth, static_cast<int>(s.name.size()));
+        }
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::left << std::setw(nameWidth) << "TensorRT layer name" << std::right << std::setw(12) << "Runtime, %"
+           << std::setw(12) << "Invocations" << std::setw(12) << "Runtime, ms" << std::setw(12) << "Average, ms"
+           << std::setw(12) << "p50, ms" << std::setw(12) << "p99, ms" << std::endl;
+        for (const auto& s : stats)
+        {
+            os << std::left << std::setw(nameWidth) << s.name << std::right << std::fixed << std::setprecision(1)
+               << std::setw(11) << s.percentage << "%" << std::setw(12) << s.count << std::setprecision(3)
+               << std::setw(12) << s.total << std::setw(12) << s.average << std::setw(12) << s.p50 << std::setw(12)
+               << s.p99 << std::endl;
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    std::string mName;
+    LayerIndex mIndex;
+    std::vector<LatencyHistogram> mLayers; //!< Times of every layer, by index in mIndex
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_LAYER_PROFILER_H
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_MAPPED_FILE_H
+#define TENSORRT_MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace samplesCommon
+{
+
+//!
+//! \brief  The MappedFile class maps a whole file privately into the address space of the process.
+//!
+//! \details This RAII class keeps the mapping alive for its lifetime, so pointers returned by data()
+//!          stay valid until it is destroyed. The pages are only read from disk when they are touched.
+//!          On platforms without mmap the file is read into a host buffer instead.
+//!
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& fileName)
+    {
+        open(fileName);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    //!
+    //! \brief Maps the file. Returns false if the file cannot be opened or mapped.
+    //!
+    bool open(const std::string& fileName)
+    {
+        close();
+#ifdef _MSC_VER
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return false;
+        }
+        mFallback.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, std::ios::beg);
+        file.read(mFallback.data(), mFallback.size());
+        mData = reinterpret_cast<const uint8_t*>(mFallback.data());
+        mSize = mFallback.size();
+        return static_cast<bool>(file);
+#else
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        mSize = static_cast<size_t>(st.st_size);
+        if (mSize)
+        {
+            // Private writable pages are copy-on-write, so callers may modify what they read without touching
+            // the file.
+            void* addr = mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                mSize = 0;
+                ::close(fd);
+                return false;
+            }
+            mData = static_cast<const uint8_t*>(addr);
+        }
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    void close()
+    {
+#ifdef _MSC_VER
+        mFallback.clear();
+#else
+        if (mData)
+        {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        }
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    //!
+    //! \brief Hints the kernel that the byte range [offset, offset + length) will be read soon.
+    //!
+    void prefetch(size_t offset, size_t length) const
+    {
+#ifndef _MSC_VER
+        if (mData && offset < mSize)
+        {
+            // madvise requires a page aligned start address.
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            const size_t begin = offset - offset % pageSize;
+            madvise(const_cast<uint8_t*>(mData) + begin, std::min(mSize, offset + length) - begin, MADV_WILLNEED);
+        }
+#endif
+    }
+
+    const uint8_t* data() const
+    {
+        return mData;
+    }
+
+    uint8_t* data()
+    {
+        return const_cast<uint8_t*>(mData);
+    }
+
+    size_t size() const
+    {
+        return mSize;
+    }
+
+    bool isOpen() const
+    {
+        return mData != nullptr;
+    }
+
+private:
+    const uint8_t* mData{nullptr};
+    size_t mSize{0};
+#ifdef _MSC_VER
+    std::vector<char> mFallback;
+#endif
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_MAPPED_FILE_H
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_NPY_FILE_H
+#define TENSORRT_NPY_FILE_H
+
+#include "NvInfer.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The NpyHeader structure describes the array stored in a .npy file.
+//!
+struct NpyHeader
+{
+    std::string descr;          //!< The numpy type string, for example "<f4"
+    bool fortranOrder{false};   //!< Whether the data is stored in column-major order
+    std::vector<int64_t> shape; //!< The dimensions of the array, outermost first
+    size_t dataOffset{0};       //!< The offset of the data from the beginning of the file
+};
+
+//! The magic string that starts every .npy file.
+constexpr char kNPY_MAGIC[] = "\x93NUMPY";
+constexpr size_t kNPY_MAGIC_SIZE = sizeof(kNPY_MAGIC) - 1;
+
+//!
+//! \brief Returns the numpy type string of a TensorRT data type. The data is assumed to be little-endian.
+//!
+inline std::string npyDescr(nvinfer1::DataType type)
+{
+    switch (type)
+    {
+    case nvinfer1::DataType::kFLOAT: return "<f4";
+    case nvinfer1::DataType::kHALF: return "<f2";
+    case nvinfer1::DataType::kINT8: return "|i1";
+    case nvinfer1::DataType::kINT32: return "<i4";
+    }
+    return "";
+}
+
+//!
+//! \brief Returns the number of elements of an array of the given shape; a shape with no dimension is a scalar.
+//!
+inline int64_t npyVolume(const std::vector<int64_t>& shape)
+{
+    int64_t volume = 1;
+    for (const auto d : shape)
+    {
+        volume *= d;
+    }
+    return volume;
+}
+
+//!
+//! \brief Formats the header of a version 1.0 .npy file, magic string included.
+//!
+//! \details The header is padded with spaces so that the data starts at a multiple of 64 bytes, as numpy does,
+//!          which lets the data be memory-mapped and read with aligned loads.
+//!
+inline std::string formatNpyHeader(const std::string& descr, const std::vector<int64_t>& shape)
+{
+    std::ostringstream dict;
+    dict << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < shape.size(); ++i)
+    {
+        dict << shape[i] << (shape.size() == 1 ? "," : i + 1 < shape.size() ? ", " : "");
+    }
+    dict << "), }";
+
+    const size_t prefixSize = kNPY_MAGIC_SIZE + 2 + 2;
+    std::string header = dict.str();
+    header.append(63 - (prefixSize + header.size()) % 64, ' ');
+    header.push_back('\n');
+
+    const size_t headerSize = header.size();
+    std::string prefix(kNPY_MAGIC, kNPY_MAGIC_SIZE);
+    prefix.push_back('\x01');
+    prefix.push_back('\x00');
+    prefix.push_back(static_cast<char>(headerSize & 0xFF));
+    prefix.push_back(static_cast<char>((headerSize >> 8) & 0xFF));
+    return prefix + header;
+}
+
+//!
+//! \brief Parses the header of a .npy file of version 1.0, 2.0 or 3.0 from its first size bytes.
+//!
+//! \return False if the bytes do not start with a complete, well-formed header.
+//!
+inline bool parseNpyHeader(const char* bytes, size_t size, NpyHeader& header)
+{
+    if (size < kNPY_MAGIC_SIZE + 4 || std::memcmp(bytes, kNPY_MAGIC, kNPY_MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+    const auto* lengthBytes = reinterpret_cast<const unsigned char*>(bytes + kNPY_MAGIC_SIZE + 2);
+    const int major = static_cast<unsigned char>(bytes[kNPY_MAGIC_SIZE]);
+    size_t prefixSize = kNPY_MAGIC_SIZE + 4;
+    size_t length = lengthBytes[0] | (static_cast<size_t>(lengthBytes[1]) << 8);
+    if (major == 2 || major == 3)
+    {
+        prefixSize += 2;
+        if (size < prefixSize)
+        {
+            return false;
+        }
+        length |= (static_cast<size_t>(lengthBytes[2]) << 16) | (static_cast<size_t>(lengthBytes[3]) << 24);
+    }
+    else if (major != 1)
+    {
+        return false;
+    }
+    if (size < prefixSize + length)
+    {
+        return false;
+    }
+    const std::string dict(bytes + prefixSize, length);
+    header.dataOffset = prefixSize + length;
+
+    // The dictionary is a Python literal; its keys are looked up rather than parsed in full.
+    auto valueOf = [&dict](const std::string& key) -> size_t {
+        size_t pos = dict.find("'" + key + "'");
+        if (pos == std::string::npos)
+        {
+            pos = dict.find('"' + key + '"');
+        }
+        if (pos == std::string::npos)
+        {
+            return std::string::npos;
+        }
+        const size_t colon = dict.find(':', pos);
+        return colon == std::string::npos ? colon : dict.find_first_not_of(' ', colon + 1);
+    };
+
+    const size_t descr = valueOf("descr");
+    if (descr == std::string::npos || (dict[descr] != '\'' && dict[descr] != '"'))
+    {
+        return false;
+    }
+    const size_t descrEnd = dict.find(dict[descr], descr + 1);
+    if (descrEnd == std::string::npos)
+    {
+        return false;
+    }
+    header.descr = dict.substr(descr + 1, descrEnd - descr - 1);
+
+    const size_t fortranOrder = valueOf("fortran_order");
+    if (fortranOrder == std::string::npos)
+    {
+        return false;
+    }
+    header.fortranOrder = dict.compare(fortranOrder, 4, "True") == 0;
+
+    const size_t shape = valueOf("shape");
+    const size_t shapeEnd = shape == std::string::npos ? shape : dict.find(')', shape);
+    if (shapeEnd == std::string::npos || dict[shape] != '(')
+    {
+        return false;
+    }
+    header.shape.clear();
+    std::istringstream dims(dict.substr(shape + 1, shapeEnd - shape - 1));
+    for (std::string dim; std::getline(dims, dim, ',');)
+    {
+        if (dim.find_first_not_of(' ') == std::string::npos)
+        {
+            continue;
+        }
+        try
+        {
+            header.shape.push_back(std::stoll(dim));
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//!
+//! \brief Writes size bytes of data as a .npy file of the given type and shape.
+//!
+inline bool writeNpy(const std::string& fileName, const std::string& descr, const std::vector<int64_t>& shape,
+    const void* data, size_t size)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    const std::string header = formatNpyHeader(descr, shape);
+    file.write(header.data(), header.size());
+    file.write(static_cast<const char*>(data), size);
+    return static_cast<bool>(file);
+}
+
+//!
+//! \brief Reads the header of a .npy file.
+//!
+inline bool readNpyHeader(std::istream& file, NpyHeader& header)
+{
+    // Version 1.0 headers are at most 64 KiB, later versions announce their length in the first 12 bytes.
+    std::vector<char> bytes(kNPY_MAGIC_SIZE + 6);
+    if (!file.read(bytes.data(), bytes.size()) || std::memcmp(bytes.data(), kNPY_MAGIC, kNPY_MAGIC_SIZE) != 0)
+    {
+        return false;
+    }
+    // The length of the header is only trusted once the magic string and the version are known.
+    const int major = static_cast<unsigned char>(bytes[kNPY_MAGIC_SIZE]);
+    if (major < 1 || major > 3)
+    {
+        return false;
+    }
+    const auto* lengthBytes = reinterpret_cast<const unsigned char*>(bytes.data() + kNPY_MAGIC_SIZE + 2);
+    const bool longHeader = major >= 2;
+    const size_t length = lengthBytes[0] | (static_cast<size_t>(lengthBytes[1]) << 8)
+        | (longHeader ? (static_cast<size_t>(lengthBytes[2]) << 16) | (static_cast<size_t>(lengthBytes[3]) << 24) : 0);
+    const size_t total = kNPY_MAGIC_SIZE + (longHeader ? 6 : 4) + length;
+    if (total > bytes.size())
+    {
+        const size_t read = bytes.size();
+        bytes.resize(total);
+        if (!file.read(bytes.data() + read, total - read))
+        {
+            return false;
+        }
+    }
+    return parseNpyHeader(bytes.data(), bytes.size(), header) && file.seekg(header.dataOffset);
+}
+
+//!
+//! \brief Reads the data of a .npy file of the expected type and size into data, and its shape into shape.
+//!
+//! \return False if the file cannot be read, is in Fortran order, or does not hold exactly size bytes of descr
+//!         elements.
+//!
+inline bool readNpy(const std::string& fileName, const std::string& descr, void* data, size_t size,
+    std::vector<int64_t>& shape)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    NpyHeader header;
+    if (!readNpyHeader(file, header) || header.fortranOrder || header.descr != descr)
+    {
+        return false;
+    }
+    const size_t elementSize = std::stoul(descr.substr(2));
+    if (npyVolume(header.shape) * elementSize != size)
+    {
+        return false;
+    }
+    shape = header.shape;
+    return static_cast<bool>(file.read(static_cast<char*>(data), size));
+}
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_NPY_FILE_H
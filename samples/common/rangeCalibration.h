@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_RANGE_CALIBRATION_H
+#define TENSORRT_RANGE_CALIBRATION_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief  The StreamingHistogram class accumulates a histogram of absolute values in constant memory.
+//!
+//! \details The histogram covers [0, range), where range is the smallest power of two above every value seen.
+//!          When a larger value arrives, the range is doubled as often as needed and pairs of adjacent bins
+//!          are merged, so values can be added in any number of chunks without knowing the maximum in
+//!          advance. Because ranges are powers of two, histograms built independently, for example by
+//!          several threads, can be merged exactly.
+//!
+class StreamingHistogram
+{
+public:
+    explicit StreamingHistogram(int nbBins = 4096)
+        : mBins(nbBins, 0)
+    {
+        assert(nbBins > 1 && nbBins % 2 == 0);
+    }
+
+    //!
+    //! \brief Adds the absolute values of count values. Values that are not finite are ignored.
+    //!
+    void add(const float* values, size_t count)
+    {
+        const int nbBins = static_cast<int>(mBins.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            const float value = std::fabs(values[i]);
+            if (!std::isfinite(value))
+            {
+                continue;
+            }
+            if (value >= mRange)
+            {
+                grow(value);
+            }
+            mMax = std::max(mMax, value);
+            const int bin = mRange > 0.0F ? static_cast<int>(value / mRange * nbBins) : 0;
+            ++mBins[std::min(bin, nbBins - 1)];
+            ++mCount;
+        }
+    }
+
+    //!
+    //! \brief Adds the contents of another histogram with the same number of bins.
+    //!
+    void merge(const StreamingHistogram& other)
+    {
+        assert(other.mBins.size() == mBins.size());
+        StreamingHistogram widened(other);
+        if (widened.mRange > mRange)
+        {
+            grow(widened.mRange / 2);
+        }
+        else if (mRange > widened.mRange)
+        {
+            widened.grow(mRange / 2);
+        }
+        for (size_t i = 0; i < mBins.size(); ++i)
+        {
+            mBins[i] += widened.mBins[i];
+        }
+        mMax = std::max(mMax, other.mMax);
+        mCount += other.mCount;
+    }
+
+    const std::vector<uint64_t>& getBins() const
+    {
+        return mBins;
+    }
+
+    float getBinWidth() const
+    {
+        return mRange / mBins.size();
+    }
+
+    float getMax() const
+    {
+        return mMax;
+    }
+
+    uint64_t getCount() const
+    {
+        return mCount;
+    }
+
+    //!
+    //! \brief Writes the histogram in a binary form that read() restores exactly.
+    //!
+    bool write(std::ostream& os) const
+    {
+        const uint64_t nbBins = mBins.size();
+        os.write(reinterpret_cast<const char*>(&nbBins), sizeof(nbBins));
+        os.write(reinterpret_cast<const char*>(&mRange), sizeof(mRange));
+        os.write(reinterpret_cast<const char*>(&mMax), sizeof(mMax));
+        os.write(reinterpret_cast<const char*>(&mCount), sizeof(mCount));
+        os.write(reinterpret_cast<const char*>(mBins.data()), nbBins * sizeof(uint64_t));
+        return static_cast<bool>(os);
+    }
+
+    //!
+    //! \brief Restores a histogram written by write(). Returns false if it has a different number of bins.
+    //!
+    bool read(std::istream& is)
+    {
+        uint64_t nbBins{0};
+        if (!is.read(reinterpret_cast<char*>(&nbBins), sizeof(nbBins)) || nbBins != mBins.size())
+        {
+            return false;
+        }
+        is.read(reinterpret_cast<char*>(&mRange), sizeof(mRange));
+        is.read(reinterpret_cast<char*>(&mMax), sizeof(mMax));
+        is.read(reinterpret_cast<char*>(&mCount), sizeof(mCount));
+        is.read(reinterpret_cast<char*>(mBins.data()), nbBins * sizeof(uint64_t));
+        return static_cast<bool>(is);
+    }
+
+private:
+    //! Doubles the range, merging bins, until it is above value.
+    void grow(float value)
+    {
+        if (mRange == 0.0F)
+        {
+            // Only bin 0 can be populated (with zeros), and it stays valid for any range.
+            int exponent;
+            std::frexp(value, &exponent);
+            mRange = std::ldexp(1.0F, exponent);
+            return;
+        }
+        const size_t half = mBins.size() / 2;
+        while (value >= mRange)
+        {
+            for (size_t i = 0; i < half; ++i)
+            {
+                mBins[i] = mBins[2 * i] + mBins[2 * i + 1];
+            }
+            std::fill(mBins.begin() + half, mBins.end(), 0);
+            mRange *= 2;
+        }
+    }
+
+    std::vector<uint64_t> mBins;
+    float mRange{0.0F}; //!< Upper bound of the last bin, 0 until a non zero value is added
+    float mMax{0.0F};   //!< Largest absolute value added
+    uint64_t mCount{0}; //!< Number of values added
+};
+
+namespace detail
+{
+
+//! Normalizes a distribution and moves a small mass from its non zero to its zero entries, so that the
+//! KL divergence stays finite.
+inline bool smoothDistribution(std::vector<double>& distribution, double eps = 1e-4)
+{
+    const double sum = std::accumulate(distribution.begin(), distribution.end(), 0.0);
+    const size_t nbZeros = std::count(distribution.begin(), distribution.end(), 0.0);
+    const size_t nbNonZeros = distribution.size() - nbZeros;
+    if (sum <= 0.0 || nbNonZeros == 0)
+    {
+        return false;
+    }
+    const double eps1 = eps * nbZeros / nbNonZeros;
+    for (auto& p : distribution)
+    {
+        p = p == 0.0 ? eps : p / sum - eps1;
+    }
+    return true;
+}
+
+} // namespace detail
+
+//!
+//! \brief Returns the threshold that minimizes the KL divergence between the histogram clipped at the threshold
+//!        and its quantization to nbQuantizedBins levels, as done by entropy calibration.
+//!
+inline float entropyThreshold(const StreamingHistogram& histogram, int nbQuantizedBins = 128)
+{
+    const std::vector<uint64_t>& bins = histogram.getBins();
+    const int nbBins = static_cast<int>(bins.size());
+    // Bins above the last populated one cannot give a better threshold than the maximum.
+    int lastBin = nbBins;
+    while (lastBin > 0 && bins[lastBin - 1] == 0)
+    {
+        --lastBin;
+    }
+    if (lastBin <= nbQuantizedBins)
+    {
+        return histogram.getMax();
+    }
+
+    double bestDivergence = std::numeric_limits<double>::max();
+    int bestBin = lastBin;
+    std::vector<double> reference;
+    std::vector<double> quantized;
+    for (int i = nbQuantizedBins; i <= lastBin; ++i)
+    {
+        // Reference distribution: the first i bins, with the outliers folded into the last one.
+        reference.assign(bins.begin(), bins.begin() + i);
+        reference[i - 1] += std::accumulate(bins.begin() + i, bins.begin() + lastBin, 0.0);
+
+        // Candidate distribution: the first i bins merged into nbQuantizedBins levels, then expanded back
+        // over the bins that were populated.
+        quantized.assign(i, 0.0);
+        for (int j = 0; j < nbQuantizedBins; ++j)
+        {
+            const int start = static_cast<int>(static_cast<int64_t>(j) * i / nbQuantizedBins);
+            const int end = j == nbQuantizedBins - 1 ? i : static_cast<int>(static_cast<int64_t>(j + 1) * i / nbQuantizedBins);
+            double sum = 0.0;
+            int nbNonZeros = 0;
+            for (int k = start; k < end; ++k)
+            {
+                sum += bins[k];
+                nbNonZeros += bins[k] != 0;
+            }
+            for (int k = start; k < end && nbNonZeros; ++k)
+            {
+                quantized[k] = bins[k] ? sum / nbNonZeros : 0.0;
+            }
+        }
+
+        if (!detail::smoothDistribution(reference) || !detail::smoothDistribution(quantized))
+        {
+            continue;
+        }
+        double divergence = 0.0;
+        for (int k = 0; k < i; ++k)
+        {
+            divergence += reference[k] * std::log(reference[k] / quantized[k]);
+        }
+        if (divergence < bestDivergence)
+        {
+            bestDivergence = divergence;
+            bestBin = i;
+        }
+    }
+    return std::min((bestBin + 0.5F) * histogram.getBinWidth(), histogram.getMax());
+}
+
+//!
+//! \brief Returns the smallest bin edge below which at least percentile percent of the values lie.
+//!
+inline float percentileThreshold(const StreamingHistogram& histogram, double percentile)
+{
+    const std::vector<uint64_t>& bins = histogram.getBins();
+    const double target = histogram.getCount() * std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+    double cumulative = 0.0;
+    for (size_t i = 0; i < bins.size(); ++i)
+    {
+        cumulative += bins[i];
+        if (cumulative >= target)
+        {
+            return std::min((i + 1) * histogram.getBinWidth(), histogram.getMax());
+        }
+    }
+    return histogram.getMax();
+}
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_RANGE_CALIBRATION_H
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_RANGE_CHECKPOINT_H
+#define TENSORRT_RANGE_CHECKPOINT_H
+
+#include "calibrationCache.h"
+#include "rangeCalibration.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace samplesCommon
+{
+
+using HistogramMap = std::map<std::string, StreamingHistogram>;
+
+//! Magic number that starts checkpoint files.
+constexpr uint32_t kRANGE_CHECKPOINT_MAGIC = 0x54524348;
+
+//!
+//! \brief  The CheckpointedHistograms class accumulates the histograms of tensors over a list of sources of values,
+//!         such as dumps, in rounds, and checkpoints them after every round so that an interrupted run can resume.
+//!
+//! \details Every source belongs to a tensor and has an identity that changes with its content, see fileIdentity().
+//!          A checkpoint holds the histograms and the number of sources done, and is written atomically, so a run
+//!          killed at any point resumes from the last round it completed. It is only resumed by a run over the same
+//!          sources with the same number of bins. Merging is exact, so the result depends neither on the rounds nor
+//!          on the order in which the sources of a round are added.
+//!
+class CheckpointedHistograms
+{
+public:
+    //!
+    //! \param sources The tensor name and identity of every source.
+    //! \param checkpoint The checkpoint file, or an empty string to add all sources in a single round.
+    //! \param interval The number of sources of a round.
+    //!
+    CheckpointedHistograms(std::vector<std::pair<std::string, std::string>> sources, int nbBins,
+        std::string checkpoint = "", int interval = 64)
+        : mSources(std::move(sources))
+        , mNbBins(nbBins)
+        , mCheckpoint(std::move(checkpoint))
+        , mInterval(mCheckpoint.empty() ? static_cast<int>(mSources.size()) : std::max(interval, 1))
+    {
+        for (const auto& source : mSources)
+        {
+            mHistograms.emplace(source.first, StreamingHistogram(nbBins));
+        }
+    }
+
+    //!
+    //! \brief Restores the checkpoint of the same run, if any. Returns the number of sources it covers.
+    //!
+    int resume()
+    {
+        if (mCheckpoint.empty())
+        {
+            return 0;
+        }
+        std::ifstream checkpoint(mCheckpoint, std::ios::binary);
+        uint32_t magic{0};
+        std::string key(16, '\0');
+        int64_t sourcesDone{0};
+        uint64_t nbTensors{0};
+        checkpoint.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        checkpoint.read(&key[0], key.size());
+        checkpoint.read(reinterpret_cast<char*>(&sourcesDone), sizeof(sourcesDone));
+        checkpoint.read(reinterpret_cast<char*>(&nbTensors), sizeof(nbTensors));
+        if (!checkpoint || magic != kRANGE_CHECKPOINT_MAGIC || key != runKey() || nbTensors != mHistograms.size()
+            || sourcesDone < 0 || sourcesDone > static_cast<int64_t>(mSources.size()))
+        {
+            return 0;
+        }
+        HistogramMap restored(mHistograms);
+        for (uint64_t i = 0; i < nbTensors; ++i)
+        {
+            uint64_t nameSize{0};
+            checkpoint.read(reinterpret_cast<char*>(&nameSize), sizeof(nameSize));
+            std::string name(checkpoint ? nameSize : 0, '\0');
+            checkpoint.read(&name[0], name.size());
+            auto tensor = restored.find(name);
+            if (!checkpoint || tensor == restored.end() || !tensor->second.read(checkpoint))
+            {
+                return 0;
+            }
+        }
+        mHistograms.swap(restored);
+        mSourcesDone = static_cast<int>(sourcesDone);
+        return mSourcesDone;
+    }
+
+    int getNbSources() const
+    {
+        return static_cast<int>(mSources.size());
+    }
+
+    //! Returns the number of sources added in the completed rounds.
+    int getSourcesDone() const
+    {
+        return mSourcesDone;
+    }
+
+    bool isDone() const
+    {
+        return mSourcesDone == getNbSources();
+    }
+
+    //! Returns the end of the current round, which adds the sources from getSourcesDone() to it.
+    int getRoundEnd() const
+    {
+        return std::min(getNbSources(), mSourcesDone + mInterval);
+    }
+
+    //!
+    //! \brief Merges the histogram of a source of the current round into that of its tensor. It is thread safe.
+    //!
+    void add(int source, const StreamingHistogram& histogram)
+    {
+        assert(source >= mSourcesDone && source < getRoundEnd());
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHistograms.at(mSources[source].first).merge(histogram);
+    }
+
+    //!
+    //! \brief Ends the current round, whose sources must all have been added, and checkpoints it unless it was
+    //!        the last. Returns false if the checkpoint could not be written.
+    //!
+    bool endRound()
+    {
+        mSourcesDone = getRoundEnd();
+        if (mCheckpoint.empty() || isDone())
+        {
+            return true;
+        }
+        std::ostringstream checkpoint;
+        const std::string key = runKey();
+        const int64_t sourcesDone = mSourcesDone;
+        const uint64_t nbTensors = mHistograms.size();
+        checkpoint.write(reinterpret_cast<const char*>(&kRANGE_CHECKPOINT_MAGIC), sizeof(kRANGE_CHECKPOINT_MAGIC));
+        checkpoint.write(key.data(), key.size());
+        checkpoint.write(reinterpret_cast<const char*>(&sourcesDone), sizeof(sourcesDone));
+        checkpoint.write(reinterpret_cast<const char*>(&nbTensors), sizeof(nbTensors));
+        for (const auto& tensor : mHistograms)
+        {
+            const uint64_t nameSize = tensor.first.size();
+            checkpoint.write(reinterpret_cast<const char*>(&nameSize), sizeof(nameSize));
+            checkpoint.write(tensor.first.data(), nameSize);
+            tensor.second.write(checkpoint);
+        }
+        return writeFileAtomically(mCheckpoint, checkpoint.str());
+    }
+
+    //!
+    //! \brief Deletes the checkpoint, once the result of the run is safely written.
+    //!
+    void removeCheckpoint() const
+    {
+        if (!mCheckpoint.empty())
+        {
+            std::remove(mCheckpoint.c_str());
+        }
+    }
+
+    //! Returns the histograms of the tensors, complete once isDone().
+    const HistogramMap& getHistograms() const
+    {
+        return mHistograms;
+    }
+
+private:
+    //! Returns a key of the inputs of the run, so that a checkpoint is only resumed by the same run.
+    std::string runKey() const
+    {
+        CacheKeyHasher hasher;
+        hasher.add(static_cast<int64_t>(mNbBins));
+        for (const auto& source : mSources)
+        {
+            hasher.add(source.first).add(source.second);
+        }
+        return hasher.str();
+    }
+
+    std::vector<std::pair<std::string, std::string>> mSources; //!< Tensor name and identity of every source
+    int mNbBins;
+    std::string mCheckpoint;
+    int mInterval;
+    int mSourcesDone{0};
+    std::mutex mMutex;
+    HistogramMap mHistograms;
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_RANGE_CHECKPOINT_H
@@ -61,6 +61,7 @@
 #include "NvOnnxParser.h"
 #include "NvUffParser.h"
 
+#include "calibrationCache.h"
 #include "logger.h"
 #include "sampleUtils.h"
 #include "sampleOptions.h"
@@ -175,7 +176,7 @@ namespace
 class RndInt8Calibrator : public nvinfer1::IInt8EntropyCalibrator2
 {
 public:
-    RndInt8Calibrator(int batches, const std::string& cacheFile, const nvinfer1::INetworkDefinition& network, std::ostream& err);
+    RndInt8Calibrator(int batches, const std::string& cacheFile, const std::string& cacheDirectory, const nvinfer1::INetworkDefinition& network, std::ostream& err);
 
     ~RndInt8Calibrator()
     {
@@ -191,20 +192,29 @@ public:
 
     const void* readCalibrationCache(size_t& length) override;
 
-    virtual void writeCalibrationCache(const void*, size_t) override {}
+    virtual void writeCalibrationCache(const void* cache, size_t length) override;
 
 private:
     int mBatches{};
     int mCurrentBatch{};
     std::string mCacheFile;
+    std::string mCacheKey;
+    bool mUseCacheStore{false}; //!< Only store random tables where the user asked for a cache directory
+    samplesCommon::CalibrationCacheStore mCacheStore;
     std::map<std::string, void*> mInputDeviceBuffers;
     std::vector<char> mCalibrationCache;
     std::ostream& mErr;
 };
 
-RndInt8Calibrator::RndInt8Calibrator(int batches, const std::string& cacheFile, const INetworkDefinition& network, std::ostream& err)
-    : mBatches(batches), mCurrentBatch(0), mCacheFile(cacheFile), mErr(err)
+RndInt8Calibrator::RndInt8Calibrator(int batches, const std::string& cacheFile, const std::string& cacheDirectory, const INetworkDefinition& network, std::ostream& err)
+    : mBatches(batches), mCurrentBatch(0), mCacheFile(cacheFile)
+    , mUseCacheStore(!cacheDirectory.empty() || !samplesCommon::CalibrationCacheStore::environmentDirectory().empty())
+    , mCacheStore(cacheDirectory), mErr(err)
 {
+    // The random data only depends on the number of batches, which thus identifies the dataset.
+    const std::string networkKey = samplesCommon::networkCacheKey(network, "random " + std::to_string(batches));
+    mCacheKey = samplesCommon::calibrationCacheKey(networkKey, getBatchSize(), getAlgorithm());
+
     std::default_random_engine generator;
     std::uniform_real_distribution<float> distribution(-1.0F, 1.0F);
     auto gen = [&generator, &distribution]() { return distribution(generator); };
@@ -251,8 +261,29 @@ const void* RndInt8Calibrator::readCalibrationCache(size_t& length)
         std::copy(std::istream_iterator<char>(input), std::istream_iterator<char>(),
             std::back_inserter(mCalibrationCache));
     }
+    else if (mUseCacheStore && mCacheStore.read(mCacheKey, mCalibrationCache))
+    {
+        gLogInfo << "Using calibration table " << mCacheStore.getPath(mCacheKey) << std::endl;
+    }
 
-    return mCalibrationCache.size() ? mCalibrationCache.data() : nullptr;
+    length = mCalibrationCache.size();
+    return length ? mCalibrationCache.data() : nullptr;
+}
+
+void RndInt8Calibrator::writeCalibrationCache(const void* cache, size_t length)
+{
+    if (!mUseCacheStore)
+    {
+        return;
+    }
+    if (!mCacheStore.write(mCacheKey, cache, length))
+    {
+        gLogWarning << "Could not store calibration table in " << mCacheStore.getDirectory() << std::endl;
+    }
+    else if (!mCacheStore.addToIndex(mCacheKey, "trtexec random calibration"))
+    {
+        gLogWarning << "Could not record calibration table in " << mCacheStore.getIndexPath() << std::endl;
+    }
 }
 
 void setTensorScales(const INetworkDefinition& network, float inScales = 2.0f, float outScales = 4.0f)
@@ -401,7 +432,7 @@ ICudaEngine* networkToEngine(const BuildOptions& build, const SystemOptions& sys
     }
     else if (build.int8)
     {
-        config->setInt8Calibrator(new RndInt8Calibrator(1, build.calibration, network, err));
+        config->setInt8Calibrator(new RndInt8Calibrator(1, build.calibration, build.calibrationCacheDir, network, err));
     }
 
     if (build.safe)
@@ -0,0 +1,321 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latencyHistogram.h"
+#include "sampleInference.h"
+#include "sampleTrace.h"
+
+namespace sample
+{
+
+namespace
+{
+
+void printThroughput(std::ostream& os, const std::string& name, uint64_t count, float walltime, int batch)
+{
+    const float qps = walltime > 0 ? count * 1000 / walltime : 0;
+    os << name << ": " << count << " inferences in " << walltime << " ms, throughput " << qps << " qps";
+    if (batch > 1)
+    {
+        os << " (" << qps * batch << " samples/s)";
+    }
+    os << std::endl;
+}
+
+void printLatencies(
+    std::ostream& os, const char* name, const samplesCommon::LatencyHistogram& latencies, float percentage)
+{
+    // The throughput is printed once, by printThroughput().
+    samplesCommon::printLatencySummary(os, std::string("  ") + name, latencies.summarize());
+    const float reported[] = {50, 90, 95, 99, 99.9F};
+    if (std::find(std::begin(reported), std::end(reported), percentage) == std::end(reported))
+    {
+        os << "  " << name << ": " << percentage << "% percentile = " << latencies.percentile(percentage) << " ms"
+           << std::endl;
+    }
+}
+
+//! Records the host latencies and GPU times of traces into latencies and gpuTimes, and prints them.
+void reportTraces(std::ostream& os, const std::string& name, const std::vector<InferenceTrace>& traces,
+    float walltime, int batch, float percentage, samplesCommon::LatencyHistogram& latencies,
+    samplesCommon::LatencyHistogram& gpuTimes)
+{
+    for (const auto& t : traces)
+    {
+        latencies.record(t.latency());
+        gpuTimes.record(t.gpuTime);
+    }
+    printThroughput(os, name, latencies.count(), walltime, batch);
+    printLatencies(os, "Host latency", latencies, percentage);
+    printLatencies(os, "GPU compute", gpuTimes, percentage);
+}
+
+} // namespace
+
+double SystemClock::now()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SystemClock::sleep(double ms)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+}
+
+bool runInference(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    std::vector<std::vector<InferenceTrace>>& traces, float& walltime, IClock& clock)
+{
+    traces.assign(workers.size(), std::vector<InferenceTrace>());
+    for (auto& t : traces)
+    {
+        t.reserve(options.iterations);
+    }
+    std::atomic<bool> failed{false};
+    const double start = clock.now() + options.warmup;
+    const double end = start + options.duration;
+    auto elapsed = [&clock, start]() { return static_cast<float>(clock.now() - start); };
+    // Whether the worker has to run another inference, and whether to record it
+    auto keepRunning = [&](size_t worker, bool& record) {
+        const double now = clock.now();
+        record = now >= start;
+        if (record && worker == 0 && options.recording)
+        {
+            *options.recording = true;
+        }
+        const bool stopped = options.stop && *options.stop;
+        return !failed
+            && (!record || (now < end && !stopped) || static_cast<int>(traces[worker].size()) < options.iterations);
+    };
+    auto recordTrace = [&](size_t worker, const InferenceTrace& trace) {
+        traces[worker].push_back(trace);
+        for (auto* listener : options.listeners)
+        {
+            listener->onInference(static_cast<int>(worker), static_cast<int>(traces[worker].size()) - 1, trace);
+        }
+    };
+
+    if (options.threads)
+    {
+        std::vector<std::thread> pool;
+        for (size_t w = 0; w < workers.size(); ++w)
+        {
+            pool.emplace_back([&, w]() {
+                SAMPLE_TRACE_THREAD_NAME("Stream " + std::to_string(w));
+                bool record{false};
+                for (int i = 0; keepRunning(w, record); ++i)
+                {
+                    InferenceTrace trace;
+                    trace.arrival = trace.enqueueStart = elapsed();
+                    bool done{false};
+                    {
+                        SAMPLE_TRACE_SPAN("Enqueue");
+                        done = workers[w]->enqueue(i);
+                    }
+                    if (done)
+                    {
+                        SAMPLE_TRACE_SPAN("Synchronize");
+                        done = workers[w]->synchronize(trace.gpuTime);
+                    }
+                    if (!done)
+                    {
+                        failed = true;
+                        return;
+                    }
+                    trace.hostEnd = elapsed();
+                    if (record)
+                    {
+                        recordTrace(w, trace);
+                    }
+                    if (options.sleep > 0)
+                    {
+                        SAMPLE_TRACE_SPAN("Sleep");
+                        clock.sleep(options.sleep);
+                    }
+                }
+            });
+        }
+        for (auto& t : pool)
+        {
+            t.join();
+        }
+    }
+    else
+    {
+        std::vector<InferenceTrace> inFlight(workers.size());
+        // Workers run in lockstep, so worker 0 stands for all of them.
+        bool record{false};
+        for (int i = 0; keepRunning(0, record); ++i)
+        {
+            size_t enqueued = 0;
+            for (; enqueued < workers.size(); ++enqueued)
+            {
+                SAMPLE_TRACE_SPAN("Enqueue");
+                inFlight[enqueued].arrival = inFlight[enqueued].enqueueStart = elapsed();
+                if (!workers[enqueued]->enqueue(i))
+                {
+                    failed = true;
+                    break;
+                }
+            }
+            // Inferences already enqueued are waited for even after a failure.
+            for (size_t w = 0; w < enqueued; ++w)
+            {
+                SAMPLE_TRACE_SPAN("Synchronize");
+                const bool done = workers[w]->synchronize(inFlight[w].gpuTime);
+                inFlight[w].hostEnd = elapsed();
+                if (done && !failed && record)
+                {
+                    recordTrace(w, inFlight[w]);
+                }
+                failed = failed || !done;
+            }
+            if (options.sleep > 0 && !failed)
+            {
+                SAMPLE_TRACE_SPAN("Sleep");
+                clock.sleep(options.sleep);
+            }
+        }
+    }
+
+    walltime = std::max(0.0F, elapsed());
+    return !failed;
+}
+
+bool runInference(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    std::vector<std::vector<InferenceTrace>>& traces, float& walltime)
+{
+    SystemClock clock;
+    return runInference(workers, options, traces, walltime, clock);
+}
+
+void StabilityMonitor::onInference(int /*worker*/, int /*index*/, const InferenceTrace& trace)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mController.add(trace.endToEndLatency());
+    if (mStopWhenStable && mController.isStable())
+    {
+        mStop = true;
+    }
+}
+
+samplesCommon::StabilityReport StabilityMonitor::getReport()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mController.getReport();
+}
+
+samplesCommon::StabilityReport computeStability(
+    const std::vector<std::vector<InferenceTrace>>& traces, const samplesCommon::StabilityOptions& options)
+{
+    std::vector<const InferenceTrace*> completed;
+    for (const auto& workerTraces : traces)
+    {
+        for (const auto& trace : workerTraces)
+        {
+            completed.push_back(&trace);
+        }
+    }
+    std::stable_sort(completed.begin(), completed.end(),
+        [](const InferenceTrace* a, const InferenceTrace* b) { return a->hostEnd < b->hostEnd; });
+    samplesCommon::StabilityController controller(options);
+    for (const InferenceTrace* trace : completed)
+    {
+        controller.add(trace->endToEndLatency());
+    }
+    return controller.getReport();
+}
+
+void printStabilityReport(std::ostream& os, const samplesCommon::StabilityReport& report, bool median, float confidence)
+{
+    if (report.windows < 2)
+    {
+        os << "Stability: too few inferences for a confidence interval" << std::endl;
+        return;
+    }
+    os << "Stability: " << (median ? "median" : "mean") << " host latency " << report.estimate << " ms, "
+       << confidence * 100 << "% confidence interval [" << report.low << ", " << report.high << "] ms (+/- "
+       << report.precision * 100 << "%) from " << report.windows << " windows of " << report.windowSize
+       << " inferences" << std::endl;
+}
+
+void printInferenceReport(std::ostream& os, const std::vector<std::vector<InferenceTrace>>& traces, float walltime,
+    int batch, float percentage)
+{
+    if (traces.size() == 1)
+    {
+        samplesCommon::LatencyHistogram latencies;
+        samplesCommon::LatencyHistogram gpuTimes;
+        reportTraces(os, "Throughput", traces.front(), walltime, batch, percentage, latencies, gpuTimes);
+        return;
+    }
+    samplesCommon::LatencyHistogram allLatencies;
+    samplesCommon::LatencyHistogram allGpuTimes;
+    for (size_t s = 0; s < traces.size(); ++s)
+    {
+        samplesCommon::LatencyHistogram latencies;
+        samplesCommon::LatencyHistogram gpuTimes;
+        reportTraces(os, "Stream " + std::to_string(s), traces[s], walltime, batch, percentage, latencies, gpuTimes);
+        allLatencies.merge(latencies);
+        allGpuTimes.merge(gpuTimes);
+    }
+    printThroughput(os, "All streams", allLatencies.count(), walltime, batch);
+    printLatencies(os, "Host latency", allLatencies, percentage);
+    printLatencies(os, "GPU compute", allGpuTimes, percentage);
+}
+
+} // namespace sample
@@ -0,0 +1,261 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_INFERENCE_H
+#define TRT_SAMPLE_INFERENCE_H
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "stabilityController.h"
+
+namespace sample
+{
+
+//!
+//! \brief Timing of one inference; host times are in milliseconds since the start of the run
+//!
+struct InferenceTrace
+{
+    float arrival{0};      //!< Host time when the request arrived, the enqueue time unless it waited in a queue
+    float enqueueStart{0}; //!< Host time when the inference was enqueued
+    float hostEnd{0};      //!< Host time when its results were available
+    float gpuTime{0};      //!< Time spent on the GPU, in milliseconds
+
+    float latency() const
+    {
+        return hostEnd - enqueueStart;
+    }
+
+    float queueTime() const
+    {
+        return enqueueStart - arrival;
+    }
+
+    float endToEndLatency() const
+    {
+        return hostEnd - arrival;
+    }
+};
+
+//!
+//! \brief The IInferenceWorker class runs inferences on one stream with its own resources.
+//!
+//! \details The scheduler only goes through this interface, so it does not depend on CUDA and can drive a
+//!          simulated engine. An inference is enqueued, then waited for before the next one is enqueued on
+//!          the same worker.
+//!
+class IInferenceWorker
+{
+public:
+    virtual ~IInferenceWorker() = default;
+
+    //!
+    //! \brief Start the inference of an iteration without waiting for it
+    //!
+    //! \return boolean Return false if the inference could not be enqueued
+    //!
+    virtual bool enqueue(int iteration) = 0;
+
+    //!
+    //! \brief Wait for the last inference enqueued and set gpuTime to its GPU time in milliseconds
+    //!
+    //! \return boolean Return false if the inference failed
+    //!
+    virtual bool synchronize(float& gpuTime) = 0;
+};
+
+//!
+//! \brief The IInferenceListener class receives every recorded inference as soon as it completes, to stream
+//!        results out while the run goes on.
+//!
+//! \details With threads, onInference() is called from the thread of each worker, so implementations have to
+//!          synchronize. It is called on the critical path of the worker and should return quickly.
+//!
+class IInferenceListener
+{
+public:
+    virtual ~IInferenceListener() = default;
+
+    //!
+    //! \brief Receive the index-th recorded inference of worker
+    //!
+    virtual void onInference(int worker, int index, const InferenceTrace& trace) = 0;
+};
+
+//!
+//! \brief The IClock class is the time source of runInference(), so that schedules can be tested with a fake clock.
+//!
+class IClock
+{
+public:
+    virtual ~IClock() = default;
+
+    //!
+    //! \brief Return the current time in milliseconds since an arbitrary origin
+    //!
+    virtual double now() = 0;
+
+    //!
+    //! \brief Block the calling thread for ms milliseconds
+    //!
+    virtual void sleep(double ms) = 0;
+};
+
+//!
+//! \brief The SystemClock class reads the steady clock of the host.
+//!
+class SystemClock : public IClock
+{
+public:
+    double now() override;
+
+    void sleep(double ms) override;
+};
+
+//!
+//! \brief How long runInference() runs inferences, and how they are driven
+//!
+struct RunOptions
+{
+    float warmup{0};   //!< Time to run inferences before recording them, in milliseconds
+    float duration{0}; //!< Minimum time to record inferences, in milliseconds
+    int iterations{1}; //!< Minimum number of inferences recorded on each worker
+    float sleep{0};    //!< Time to wait after an inference before enqueuing the next one, in milliseconds
+    bool threads{false}; //!< Drive every worker with its own thread
+    std::vector<IInferenceListener*> listeners; //!< Receive the recorded inferences
+    const std::atomic<bool>* stop{nullptr};     //!< Once set, ends the recording before the duration has elapsed
+    std::atomic<bool>* recording{nullptr};      //!< Set before the first recorded inference of worker 0 is enqueued
+};
+
+//!
+//! \brief Run inferences on each worker: first unrecorded for the warm up time, then recorded until both the
+//!        duration has elapsed, or stop is set, and every worker has run the minimum number of iterations
+//!
+//! \details With threads, every worker is driven by its own thread and sleeps on its own. Otherwise the calling
+//!          thread enqueues an inference on every worker, waits for them in turn, and then sleeps, so the streams
+//!          still run concurrently. Sleeping between inferences emulates requests arriving at a lower rate than
+//!          the engine can serve. Iterations are numbered from 0 across the warm up and the recorded phase.
+//!          traces receives the recorded inferences of each worker in order, with host times relative to the end
+//!          of the warm up, and walltime the duration of the recorded phase.
+//!
+//! \return boolean Return false if any inference failed
+//!
+bool runInference(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    std::vector<std::vector<InferenceTrace>>& traces, float& walltime, IClock& clock);
+
+//!
+//! \brief Run inferences with the system clock, see runInference()
+//!
+bool runInference(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    std::vector<std::vector<InferenceTrace>>& traces, float& walltime);
+
+//!
+//! \brief The StabilityMonitor class feeds the end-to-end latencies of all the workers to a StabilityController, and
+//!        requests the end of the run once the estimate is precise enough, if asked to.
+//!
+class StabilityMonitor : public IInferenceListener
+{
+public:
+    StabilityMonitor(const samplesCommon::StabilityOptions& options, bool stopWhenStable)
+        : mController(options)
+        , mStopWhenStable(stopWhenStable)
+    {
+    }
+
+    void onInference(int worker, int index, const InferenceTrace& trace) override;
+
+    //!
+    //! \brief Return the flag set once the run can stop, for RunOptions::stop
+    //!
+    const std::atomic<bool>* getStop() const
+    {
+        return &mStop;
+    }
+
+    samplesCommon::StabilityReport getReport();
+
+private:
+    std::mutex mMutex;
+    samplesCommon::StabilityController mController;
+    bool mStopWhenStable{false};
+    std::atomic<bool> mStop{false};
+};
+
+//!
+//! \brief Return the stability of the end-to-end latencies of a run, given to a StabilityController in the order
+//!        the inferences completed.
+//!
+//! \details This gives the report of a StabilityMonitor after the run, without its work on the measured path.
+//!
+samplesCommon::StabilityReport computeStability(
+    const std::vector<std::vector<InferenceTrace>>& traces, const samplesCommon::StabilityOptions& options);
+
+//!
+//! \brief Print the estimate of a StabilityMonitor and its confidence interval
+//!
+void printStabilityReport(
+    std::ostream& os, const samplesCommon::StabilityReport& report, bool median, float confidence);
+
+//!
+//! \brief Print the throughput and the latency distributions of every stream, and of all streams together
+//!
+//! \details The latencies of the requested percentage are printed too, unless they are among the fixed
+//!          percentiles of samplesCommon::LatencySummary.
+//!
+//! \param batch The number of samples per inference, 1 when the batch size is part of the input shapes
+//!
+void printInferenceReport(std::ostream& os, const std::vector<std::vector<InferenceTrace>>& traces, float walltime,
+    int batch, float percentage);
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_INFERENCE_H
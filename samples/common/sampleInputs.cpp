@@ -0,0 +1,207 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include <cuda_runtime_api.h>
+
+#include "NvInfer.h"
+
+#include "buffers.h"
+#include "mappedFile.h"
+#include "npyFile.h"
+#include "sampleInputs.h"
+#include "sampleUtils.h"
+
+using namespace nvinfer1;
+
+namespace sample
+{
+
+std::vector<std::string> listInputFiles(const std::string& path)
+{
+    std::vector<std::string> files;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return files;
+    }
+    if (!S_ISDIR(st.st_mode))
+    {
+        files.push_back(path);
+        return files;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+    {
+        return files;
+    }
+    while (const dirent* entry = readdir(dir))
+    {
+        const std::string fileName = path + "/" + entry->d_name;
+        if (entry->d_name[0] != '.' && stat(fileName.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        {
+            files.push_back(fileName);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool copyInputFile(const std::string& fileName, DataType type, size_t size, void* device, std::ostream& err)
+{
+    samplesCommon::MappedFile file;
+    if (!file.open(fileName))
+    {
+        err << "Cannot open input file " << fileName << std::endl;
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(file.data());
+    size_t bytes = file.size();
+
+    if (bytes >= samplesCommon::kNPY_MAGIC_SIZE
+        && !memcmp(data, samplesCommon::kNPY_MAGIC, samplesCommon::kNPY_MAGIC_SIZE))
+    {
+        samplesCommon::NpyHeader header;
+        if (!samplesCommon::parseNpyHeader(data, bytes, header))
+        {
+            err << "Invalid .npy header in input file " << fileName << std::endl;
+            return false;
+        }
+        const std::string descr = samplesCommon::npyDescr(type);
+        const int64_t count = static_cast<int64_t>(size / samplesCommon::getElementSize(type));
+        if (header.fortranOrder || header.descr != descr || samplesCommon::npyVolume(header.shape) != count
+            || bytes - header.dataOffset < size)
+        {
+            err << "Input file " << fileName << " holds " << samplesCommon::npyVolume(header.shape) << " "
+                << header.descr << (header.fortranOrder ? " elements in Fortran order" : " elements") << ", expected "
+                << count << " " << descr << " elements in C order" << std::endl;
+            return false;
+        }
+        data += header.dataOffset;
+        bytes -= header.dataOffset;
+    }
+    else if (bytes != size)
+    {
+        err << "Input file " << fileName << " holds " << bytes << " bytes, expected " << size << std::endl;
+        return false;
+    }
+
+    // The pages of the mapping are read from disk by the copy itself.
+    cudaCheck(cudaMemcpy(device, data, size, cudaMemcpyHostToDevice), err);
+    return true;
+}
+
+bool InputSets::load(const ICudaEngine& engine, const samplesCommon::BufferManager& buffers,
+    const std::unordered_map<std::string, std::string>& inputs, std::ostream& err)
+{
+    mBindings.assign(1, buffers.getDeviceBindings());
+    mBuffers.clear();
+
+    std::vector<std::pair<int, std::vector<std::string>>> files;
+    size_t nbSets = 1;
+    for (const auto& input : inputs)
+    {
+        const int index = engine.getBindingIndex(input.first.c_str());
+        if (index == -1 || !engine.bindingIsInput(index))
+        {
+            err << "Cannot load " << input.second << ": " << input.first << " is not an input tensor" << std::endl;
+            return false;
+        }
+        std::vector<std::string> list = listInputFiles(input.second);
+        if (list.empty())
+        {
+            err << "No input file found at " << input.second << std::endl;
+            return false;
+        }
+        if (list.size() > 1)
+        {
+            if (nbSets > 1 && list.size() != nbSets)
+            {
+                err << input.second << " holds " << list.size() << " input files, but another input directory holds "
+                    << nbSets << std::endl;
+                return false;
+            }
+            nbSets = list.size();
+        }
+        files.emplace_back(index, std::move(list));
+    }
+
+    mBindings.resize(nbSets, mBindings.front());
+    for (const auto& input : files)
+    {
+        const int index = input.first;
+        const size_t size = buffers.size(engine.getBindingName(index));
+        const size_t nbFiles = input.second.size();
+        for (size_t f = 0; f < nbFiles; ++f)
+        {
+            mBuffers.emplace_back(size, DataType::kINT8);
+            if (!copyInputFile(input.second[f], engine.getBindingDataType(index), size, mBuffers.back().data(), err))
+            {
+                return false;
+            }
+            // A single file is shared by all sets.
+            for (size_t set = f; set < nbSets; set += nbFiles)
+            {
+                mBindings[set][index] = mBuffers.back().data();
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace sample
@@ -0,0 +1,124 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_INPUTS_H
+#define TRT_SAMPLE_INPUTS_H
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "buffers.h"
+
+namespace sample
+{
+
+//!
+//! \brief List the files of an input: the sorted regular files of a directory, or the file itself
+//!
+//! \return The files, or an empty vector if the path does not exist or the directory holds no file
+//!
+std::vector<std::string> listInputFiles(const std::string& path);
+
+//!
+//! \brief Copy a .npy or raw binary file to device memory through a memory mapping, without parsing the data
+//!
+//! \details Files starting with the .npy magic string must hold C ordered elements of type, as many as fit in size
+//!          bytes; other files are raw data and must be exactly size bytes long.
+//!
+//! \return boolean Return true if the file matched and was copied
+//!
+bool copyInputFile(const std::string& fileName, nvinfer1::DataType type, size_t size, void* device, std::ostream& err);
+
+//!
+//! \brief The InputSets class holds sets of input tensors loaded from files, and the bindings that use each set.
+//!
+//! \details Each input given a directory gets one set per file in it, and an input given a single file uses it in
+//!          all sets. Inputs that are not loaded keep the device buffers of the BufferManager. Every set is copied
+//!          to its own device buffers once, so rotating sets across iterations only changes the bindings, and
+//!          does not time copies or leave the same data in the caches of the GPU.
+//!
+class InputSets
+{
+public:
+    //!
+    //! \brief Load the files of inputs, a map from tensor names to files or directories
+    //!
+    //! \return boolean Return true if all the files were loaded
+    //!
+    bool load(const nvinfer1::ICudaEngine& engine, const samplesCommon::BufferManager& buffers,
+        const std::unordered_map<std::string, std::string>& inputs, std::ostream& err);
+
+    //!
+    //! \brief Return the number of sets, 1 if no input is loaded from a directory
+    //!
+    int size() const
+    {
+        return static_cast<int>(mBindings.size());
+    }
+
+    //!
+    //! \brief Return the device bindings of the set used by an iteration, the sets being used in turn
+    //!
+    std::vector<void*>& getBindings(int iteration)
+    {
+        return mBindings[iteration % mBindings.size()];
+    }
+
+private:
+    std::vector<std::vector<void*>> mBindings;
+    std::vector<samplesCommon::DeviceBuffer> mBuffers;
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_INPUTS_H
@@ -0,0 +1,348 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "sampleLoad.h"
+#include "sampleTrace.h"
+
+namespace sample
+{
+
+bool parseArrivalProcess(const std::string& name, ArrivalProcess& process)
+{
+    if (name == "constant")
+    {
+        process = ArrivalProcess::kCONSTANT;
+        return true;
+    }
+    if (name == "poisson")
+    {
+        process = ArrivalProcess::kPOISSON;
+        return true;
+    }
+    return false;
+}
+
+bool readArrivals(const std::string& fileName, std::vector<double>& times)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        return false;
+    }
+    times.clear();
+    for (std::string line; std::getline(file, line);)
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+        std::istringstream is(line);
+        double time{0};
+        std::string rest;
+        if (!(is >> time) || (is >> rest) || !std::isfinite(time))
+        {
+            return false;
+        }
+        times.push_back(time);
+    }
+    std::sort(times.begin(), times.end());
+    return times.size() >= 2 && times.back() > times.front();
+}
+
+std::vector<double> generateArrivals(const ArrivalOptions& options, double horizon)
+{
+    std::vector<double> arrivals;
+    if (options.process != ArrivalProcess::kREPLAY && options.rate <= 0)
+    {
+        return arrivals;
+    }
+    switch (options.process)
+    {
+    case ArrivalProcess::kCONSTANT:
+    {
+        const double gap = 1000.0 / options.rate;
+        for (double t = 0; t < horizon; t = arrivals.size() * gap)
+        {
+            arrivals.push_back(t);
+        }
+        break;
+    }
+    case ArrivalProcess::kPOISSON:
+    {
+        // Inverse transform sampling from the raw generator, whose sequence, unlike that of the standard
+        // distributions, is the same with every standard library.
+        std::mt19937 generator(options.seed);
+        const double mean = 1000.0 / options.rate;
+        for (double t = -mean * std::log((generator() + 0.5) / 4294967296.0); t < horizon;
+             t -= mean * std::log((generator() + 0.5) / 4294967296.0))
+        {
+            arrivals.push_back(t);
+        }
+        break;
+    }
+    case ArrivalProcess::kREPLAY:
+    {
+        const std::vector<double>& replay = options.replay;
+        if (replay.size() < 2)
+        {
+            break;
+        }
+        const double span = replay.back() - replay.front();
+        const double period = span * replay.size() / (replay.size() - 1);
+        const double recordedRate = 1000.0 * replay.size() / period;
+        const double scale = options.rate > 0 ? recordedRate / options.rate : 1.0;
+        for (double offset = 0; offset < horizon; offset += period * scale)
+        {
+            for (const double time : replay)
+            {
+                const double t = offset + (time - replay.front()) * scale;
+                if (t >= horizon)
+                {
+                    break;
+                }
+                arrivals.push_back(t);
+            }
+        }
+        break;
+    }
+    }
+    return arrivals;
+}
+
+bool runLoad(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    const std::vector<double>& arrivals, std::vector<std::vector<InferenceTrace>>& traces, LoadCounters& counters,
+    IClock& clock)
+{
+    traces.assign(workers.size(), std::vector<InferenceTrace>());
+    std::atomic<bool> failed{false};
+    const double origin = clock.now();
+    const double start = origin + options.warmup;
+    const double end = start + options.duration;
+    const double deadline = end + options.duration;
+    auto elapsed = [&clock, start]() { return static_cast<float>(clock.now() - start); };
+    // The queue: requests are taken in order of arrival by the first worker to be free.
+    std::atomic<size_t> next{0};
+    // Requests arriving from then on are not part of the run: the end of the duration, or when stop was seen.
+    std::atomic<double> cutoff{end};
+    std::mutex cutoffMutex;
+    auto isCutOff = [&](double arrival, double now) {
+        if (now >= start && options.stop && *options.stop)
+        {
+            std::lock_guard<std::mutex> lock(cutoffMutex);
+            cutoff = std::min<double>(cutoff, now);
+        }
+        return arrival >= cutoff;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers.size(); ++w)
+    {
+        pool.emplace_back([&, w]() {
+            SAMPLE_TRACE_THREAD_NAME("Stream " + std::to_string(w));
+            while (!failed)
+            {
+                const size_t request = next++;
+                if (request >= arrivals.size() || isCutOff(origin + arrivals[request], clock.now()))
+                {
+                    return;
+                }
+                const double arrival = origin + arrivals[request];
+                const double now = clock.now();
+                if (arrival > now)
+                {
+                    // The queue is empty until then.
+                    SAMPLE_TRACE_SPAN("Idle");
+                    clock.sleep(arrival - now);
+                }
+                // Requests left when the queue has not drained in time count in the backlog.
+                const double ready = clock.now();
+                if (isCutOff(arrival, ready) || ready >= deadline)
+                {
+                    return;
+                }
+                if (arrival >= start && w == 0 && options.recording)
+                {
+                    *options.recording = true;
+                }
+                InferenceTrace trace;
+                trace.arrival = static_cast<float>(arrival - start);
+                trace.enqueueStart = elapsed();
+                bool done{false};
+                {
+                    SAMPLE_TRACE_SPAN("Enqueue");
+                    done = workers[w]->enqueue(static_cast<int>(request));
+                }
+                if (done)
+                {
+                    SAMPLE_TRACE_SPAN("Synchronize");
+                    done = workers[w]->synchronize(trace.gpuTime);
+                }
+                if (!done)
+                {
+                    failed = true;
+                    return;
+                }
+                trace.hostEnd = elapsed();
+                if (arrival >= start)
+                {
+                    traces[w].push_back(trace);
+                    for (auto* listener : options.listeners)
+                    {
+                        listener->onInference(static_cast<int>(w), static_cast<int>(traces[w].size()) - 1, trace);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& t : pool)
+    {
+        t.join();
+    }
+
+    // Every recorded request that arrived before the cutoff and was not served is still queued.
+    const auto first = std::lower_bound(arrivals.begin(), arrivals.end(), static_cast<double>(options.warmup));
+    const auto last = std::lower_bound(first, arrivals.end(), cutoff - origin);
+    size_t served{0};
+    for (const auto& t : traces)
+    {
+        served += t.size();
+    }
+    counters.walltime = std::max(0.0F, elapsed());
+    counters.window = static_cast<float>(std::max(0.0, cutoff - start));
+    counters.arrived = static_cast<int>(std::distance(first, last));
+    counters.backlog = std::max(0, counters.arrived - static_cast<int>(served));
+    return !failed;
+}
+
+bool runLoad(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    const std::vector<double>& arrivals, std::vector<std::vector<InferenceTrace>>& traces, LoadCounters& counters)
+{
+    SystemClock clock;
+    return runLoad(workers, options, arrivals, traces, counters, clock);
+}
+
+LoadSummary summarizeLoad(const std::vector<std::vector<InferenceTrace>>& traces, const LoadCounters& counters)
+{
+    samplesCommon::LatencyHistogram endToEnd;
+    samplesCommon::LatencyHistogram queue;
+    samplesCommon::LatencyHistogram execution;
+    for (const auto& stream : traces)
+    {
+        for (const auto& t : stream)
+        {
+            endToEnd.record(t.endToEndLatency());
+            queue.record(t.queueTime());
+            execution.record(t.latency());
+        }
+    }
+    LoadSummary summary;
+    summary.endToEnd = endToEnd.summarize(counters.walltime);
+    summary.queue = queue.summarize();
+    summary.execution = execution.summarize();
+    summary.throughput = static_cast<float>(summary.endToEnd.throughput);
+    summary.backlog = counters.backlog;
+    summary.offered = counters.window > 0 ? counters.arrived * 1000 / counters.window : 0;
+    return summary;
+}
+
+void printLoadReport(std::ostream& os, const LoadSummary& summary, int batch)
+{
+    os << "Open loop: offered " << summary.offered << " qps, served " << summary.endToEnd.count
+       << " requests, throughput " << summary.throughput << " qps";
+    if (batch > 1)
+    {
+        os << " (" << summary.throughput * batch << " samples/s)";
+    }
+    os << std::endl;
+    // The throughputs of the summaries are the same, and printed above.
+    samplesCommon::LatencySummary endToEnd = summary.endToEnd;
+    endToEnd.throughput = 0;
+    samplesCommon::printLatencySummary(os, "  End-to-end latency", endToEnd);
+    samplesCommon::printLatencySummary(os, "  Queue time", summary.queue);
+    samplesCommon::printLatencySummary(os, "  Execution time", summary.execution);
+    if (summary.saturated())
+    {
+        os << "  The arrival rate exceeds the capacity, the queue grew during the whole run";
+        if (summary.backlog > 0)
+        {
+            os << "; " << summary.backlog << " requests were still queued at the end, so the latencies above are "
+               << "underestimated";
+        }
+        os << std::endl;
+    }
+}
+
+void printLoadSweep(std::ostream& os, const std::vector<float>& rates, const std::vector<LoadSummary>& summaries)
+{
+    os << "Rate sweep (latencies in ms):" << std::endl;
+    os << std::setw(10) << "rate" << std::setw(12) << "throughput" << std::setw(10) << "p50" << std::setw(10)
+       << "p99" << std::setw(12) << "queue p99" << std::setw(12) << "exec p99" << std::setw(10) << "backlog"
+       << std::endl;
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        const LoadSummary& s = summaries[i];
+        const std::string rate = rates[i] > 0 ? std::to_string(static_cast<int>(rates[i])) : "recorded";
+        os << std::setw(10) << rate << std::setw(12) << s.throughput << std::setw(10) << s.endToEnd.p50
+           << std::setw(10) << s.endToEnd.p99 << std::setw(12) << s.queue.p99 << std::setw(12) << s.execution.p99
+           << std::setw(10) << s.backlog << (s.saturated() ? "  saturated" : "") << std::endl;
+    }
+}
+
+} // namespace sample
@@ -0,0 +1,181 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_LOAD_H
+#define TRT_SAMPLE_LOAD_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "latencyHistogram.h"
+#include "sampleInference.h"
+
+namespace sample
+{
+
+//!
+//! \brief How the requests of an open-loop run arrive
+//!
+enum class ArrivalProcess
+{
+    kCONSTANT, //!< Evenly spaced
+    kPOISSON,  //!< Exponentially distributed gaps, as independent clients would send them
+    kREPLAY    //!< Recorded arrival times
+};
+
+struct ArrivalOptions
+{
+    ArrivalProcess process{ArrivalProcess::kPOISSON};
+    float rate{0};              //!< Requests per second; with kREPLAY, 0 keeps the recorded rate
+    std::vector<double> replay; //!< Recorded arrival times in milliseconds, in increasing order
+    uint32_t seed{1};           //!< Seed of the Poisson process
+};
+
+//!
+//! \brief Parse an arrival process name, "constant" or "poisson"
+//!
+//! \return boolean Return false if the name is unknown
+//!
+bool parseArrivalProcess(const std::string& name, ArrivalProcess& process);
+
+//!
+//! \brief Read arrival times in milliseconds, one per line, and sort them
+//!
+//! \return boolean Return false if the file cannot be read, holds anything but numbers, or less than two times
+//!
+bool readArrivals(const std::string& fileName, std::vector<double>& times);
+
+//!
+//! \brief Generate the arrival times of the requests from 0 to horizon milliseconds
+//!
+//! \details The same options always give the same times. A replayed recording starts at 0, is scaled to the
+//!          requested rate, and is repeated until the horizon, the gap between repetitions being its mean gap.
+//!
+std::vector<double> generateArrivals(const ArrivalOptions& options, double horizon);
+
+//!
+//! \brief Counts of an open-loop run besides the traces of the requests served
+//!
+struct LoadCounters
+{
+    float walltime{0}; //!< Time from the end of the warm up to the last request served, in milliseconds
+    float window{0};   //!< Time over which the recorded requests arrived, in milliseconds
+    int arrived{0};    //!< Requests that arrived in the window
+    int backlog{0};    //!< Requests of the window still queued at the end of the run
+};
+
+//!
+//! \brief Serve requests arriving at the given times in an open loop, each on the first worker to be free
+//!
+//! \details Unlike runInference(), requests do not wait for the previous one to complete: they queue until a
+//!          worker is free, in the order they arrive, and every worker is driven by its own thread. Arrival
+//!          times are relative to the start of the run, and the requests arriving in the warm up are served but
+//!          not recorded. Requests arrive for the duration, or until stop is set, and the queue is then drained
+//!          until twice the duration has elapsed at most. Requests left in the queue are counted in the backlog
+//!          rather than served, since their latency is unbounded when the arrival rate is above what the workers
+//!          can serve. traces receives the recorded requests of each worker, whose arrival is the time they
+//!          entered the queue. The iterations, sleep and threads members of options are ignored.
+//!
+//! \return boolean Return false if any inference failed
+//!
+bool runLoad(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    const std::vector<double>& arrivals, std::vector<std::vector<InferenceTrace>>& traces, LoadCounters& counters,
+    IClock& clock);
+
+//!
+//! \brief Run an open loop with the system clock, see runLoad()
+//!
+bool runLoad(const std::vector<IInferenceWorker*>& workers, const RunOptions& options,
+    const std::vector<double>& arrivals, std::vector<std::vector<InferenceTrace>>& traces, LoadCounters& counters);
+
+//!
+//! \brief Result of an open-loop run at one arrival rate
+//!
+struct LoadSummary
+{
+    float offered{0};    //!< Requests that arrived per second
+    float throughput{0}; //!< Requests served per second
+    int backlog{0};      //!< Requests still queued at the end of the run
+    samplesCommon::LatencySummary endToEnd;  //!< From the arrival to the availability of the results
+    samplesCommon::LatencySummary queue;     //!< From the arrival to the enqueue on a worker
+    samplesCommon::LatencySummary execution; //!< From the enqueue to the availability of the results
+
+    //!
+    //! \brief Whether the workers could not keep up with the arrivals, so the queue grew for the whole run
+    //!
+    //! \details Below saturation the queue drains almost as soon as the arrivals stop, and the throughput is the
+    //!          offered rate up to noise.
+    //!
+    bool saturated() const
+    {
+        return backlog > 0 || throughput < 0.95F * offered;
+    }
+};
+
+LoadSummary summarizeLoad(const std::vector<std::vector<InferenceTrace>>& traces, const LoadCounters& counters);
+
+//!
+//! \brief Print the throughput of an open-loop run and its latencies split into queue and execution time
+//!
+//! \param batch The number of samples per inference, 1 when the batch size is part of the input shapes
+//!
+void printLoadReport(std::ostream& os, const LoadSummary& summary, int batch);
+
+//!
+//! \brief Print one line per arrival rate of a sweep, to read off the rate past which the p99 latency breaks down
+//!
+//! \details A rate of 0 stands for a recording replayed at its own rate.
+//!
+void printLoadSweep(std::ostream& os, const std::vector<float>& rates, const std::vector<LoadSummary>& summaries);
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_LOAD_H
@@ -254,6 +254,7 @@ void BuildOptions::parse(Arguments& arguments)
     checkEraseOption(arguments, "--int8", int8);
     checkEraseOption(arguments, "--safe", safe);
     checkEraseOption(arguments, "--calib", calibration);
+    checkEraseOption(arguments, "--calibCacheDir", calibrationCacheDir);
     if (checkEraseOption(arguments, "--loadEngine", engine))
     {
         load = true;
@@ -286,12 +287,42 @@ void InferenceOptions::parse(Arguments& arguments)
     checkEraseOption(arguments, "--iterations", iterations);
     checkEraseOption(arguments, "--duration", duration);
     checkEraseOption(arguments, "--warmUp", warmup);
+    checkEraseOption(arguments, "--sleepTime", sleep);
     checkEraseOption(arguments, "--useSpinWait", spin);
     checkEraseOption(arguments, "--threads", threads);
     checkEraseOption(arguments, "--useCudaGraph", graph);
     checkEraseOption(arguments, "--buildOnly", skip);
+    checkEraseOption(arguments, "--untilStable", untilStable);
+    checkEraseOption(arguments, "--stableMean", stableMean);
+    if (untilStable < 0)
+    {
+        throw std::invalid_argument(std::string("Negative stability target ") + std::to_string(untilStable));
+    }
 
     std::string list;
+    checkEraseOption(arguments, "--loadRates", list);
+    for (const auto& r : splitToStringVec(list, ','))
+    {
+        loadRates.push_back(stringToValue<float>(r));
+        if (!(loadRates.back() > 0))
+        {
+            throw std::invalid_argument(std::string("Invalid arrival rate ") + r);
+        }
+    }
+    checkEraseOption(arguments, "--arrivals", arrivals);
+    if (arrivals != "constant" && arrivals != "poisson")
+    {
+        throw std::invalid_argument(std::string("Unknown arrival process ") + arrivals);
+    }
+    checkEraseOption(arguments, "--replayArrivals", replayArrivals);
+    checkEraseOption(arguments, "--sweepShapes", sweepShapes);
+    checkEraseOption(arguments, "--latencyBudget", latencyBudget);
+    if (latencyBudget < 0)
+    {
+        throw std::invalid_argument(std::string("Negative latency budget ") + std::to_string(latencyBudget));
+    }
+
+    list.erase();
     checkEraseOption(arguments, "--shapes", list);
     std::vector<std::string> shapeList{splitToStringVec(list, ',')};
     for (const auto& s : shapeList)
@@ -300,6 +331,23 @@ void InferenceOptions::parse(Arguments& arguments)
         shapes.insert({shapeSpec[0], stringToValue<nvinfer1::Dims>(shapeSpec[1])});
     }
 
+    list.erase();
+    checkEraseOption(arguments, "--loadInputs", list);
+    for (const auto& i : splitToStringVec(list, ','))
+    {
+        // Tensor names may contain colons, file names rarely do.
+        const size_t colon = i.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == i.size())
+        {
+            throw std::invalid_argument(std::string("Invalid input file specification ") + i);
+        }
+        inputs[i.substr(0, colon)] = i.substr(colon + 1);
+    }
+    if (sweepShapes && (!inputs.empty() || !loadRates.empty() || !replayArrivals.empty()))
+    {
+        throw std::invalid_argument("Shape sweeps use random inputs in a closed loop");
+    }
+
     int batchOpt{0};
     checkEraseOption(arguments, "--batch", batchOpt);
     if (!shapes.empty() && batchOpt)
@@ -326,9 +374,12 @@ void ReportingOptions::parse(Arguments& arguments)
     checkEraseOption(arguments, "--avgRuns", avgs);
     checkEraseOption(arguments, "--verbose", verbose);
     checkEraseOption(arguments, "--dumpOutput", output);
+    checkEraseOption(arguments, "--exportOutput", exportOutput);
     checkEraseOption(arguments, "--dumpProfile", profile);
     checkEraseOption(arguments, "--exportTimes", exportTimes);
     checkEraseOption(arguments, "--exportProfile", exportProfile);
+    checkEraseOption(arguments, "--exportTrace", exportTrace);
+    checkEraseOption(arguments, "--exportSweep", exportSweep);
     if (percentile < 0 || percentile > 100)
     {
         throw std::invalid_argument(std::string("Percentile ") + std::to_string(percentile) + "is not in [0,100]");
@@ -649,6 +700,7 @@ std::ostream& operator<<(std::ostream& os, const BuildOptions& options)
           "avgTiming: "      << options.avgTiming                                                                       << std::endl <<
           "Precision: "      << (options.fp16 ? "FP16" : (options.int8 ? "INT8" : "FP32"))                              << std::endl <<
           "Calibration: "    << (options.int8 && options.calibration.empty() ? "Dynamic" : options.calibration.c_str()) << std::endl <<
+          "Calib cache dir: "<< (options.calibrationCacheDir.empty() ? "Default" : options.calibrationCacheDir.c_str())  << std::endl <<
           "Safe mode: "      << boolToEnabled(options.safe)                                                             << std::endl <<
           "Save engine: "    << (options.save ? options.engine : "")                                                    << std::endl <<
           "Load engine: "    << (options.load ? options.engine : "")                                                    << std::endl;
@@ -712,7 +764,52 @@ std::ostream& operator<<(std::ostream& os, const InferenceOptions& options)
     os << "Iterations: "     << options.iterations << " (" << options.warmup <<
                                                       " ms warm up)"         << std::endl <<
           "Duration: "       << options.duration   << "s"                    << std::endl <<
-          "Sleep time: "     << options.sleep      << "ms"                   << std::endl <<
+          "Until stable: ";
+    if (options.untilStable > 0)
+    {
+                          os << "+/- " << options.untilStable << "% of the " << (options.stableMean ? "mean" : "median")
+                             << " latency, at most the duration"             << std::endl;
+    }
+    else
+    {
+                          os << "Disabled"                                   << std::endl;
+    }
+    os << "Arrivals: ";
+    if (!options.replayArrivals.empty())
+    {
+                          os << "Replayed from " << options.replayArrivals;
+    }
+    else if (!options.loadRates.empty())
+    {
+                          os << "Open loop, " << options.arrivals;
+    }
+    else
+    {
+                          os << "Closed loop";
+    }
+    for (size_t i = 0; i < options.loadRates.size(); ++i)
+    {
+                          os << (i ? ", " : " at ") << options.loadRates[i] << (i + 1 < options.loadRates.size() ? "" : " qps");
+    }
+                          os                                                 << std::endl;
+    os << "Shape sweep: ";
+    if (options.sweepShapes)
+    {
+                          os << "Enabled, p99 latency budget ";
+        if (options.latencyBudget > 0)
+        {
+                          os << options.latencyBudget << " ms"               << std::endl;
+        }
+        else
+        {
+                          os << "none"                                       << std::endl;
+        }
+    }
+    else
+    {
+                          os << "Disabled"                                   << std::endl;
+    }
+    os << "Sleep time: "     << options.sleep      << "ms"                   << std::endl <<
           "Streams: "        << options.streams                              << std::endl <<
           "Spin-wait: "      << boolToEnabled(options.spin)                  << std::endl <<
           "Multithreading: " << boolToEnabled(options.threads)               << std::endl <<
@@ -723,6 +820,16 @@ std::ostream& operator<<(std::ostream& os, const InferenceOptions& options)
     {
         printShapes(os, "inference", options.shapes);
     }
+    os << "Inputs: ";
+    if (options.inputs.empty())
+    {
+        os << "Not loaded";
+    }
+    for (const auto& i : options.inputs)
+    {
+        os << std::endl << "  " << i.first << " <- " << i.second;
+    }
+    os << std::endl;
 
     return os;
 }
@@ -736,9 +843,12 @@ std::ostream& operator<<(std::ostream& os, const ReportingOptions& options)
           "Averages: "                    << options.avgs << " inferences"  << std::endl <<
           "Percentile: "                  << options.percentile             << std::endl <<
           "Dump output: "                 << boolToEnabled(options.output)  << std::endl <<
+          "Export output to npy files: "  << options.exportOutput           << std::endl <<
           "Profile: "                     << boolToEnabled(options.profile) << std::endl <<
-          "Export timing to JSON file: "  << options.exportTimes            << std::endl <<
-          "Export profile to JSON file: " << options.exportProfile          << std::endl;
+          "Export timing to file: "       << options.exportTimes            << std::endl <<
+          "Export profile to file: "      << options.exportProfile          << std::endl <<
+          "Export trace to file: "        << options.exportTrace            << std::endl <<
+          "Export sweep to JSON file: "   << options.exportSweep            << std::endl;
 // clang-format on
 
     return os;
@@ -812,6 +922,8 @@ void BuildOptions::help(std::ostream& os)
           "  --fp16                      Enable fp16 mode (default = disabled)"                                                       << std::endl <<
           "  --int8                      Run in int8 mode (default = disabled)"                                                       << std::endl <<
           "  --calib=<file>              Read INT8 calibration cache file"                                                            << std::endl <<
+          "  --calibCacheDir=<dir>       Store calibration tables by network in this directory and reuse them when the --calib"       << std::endl <<
+          "                              file does not exist (default = $TRT_CALIBRATION_CACHE_DIR, or no store if it is unset)"       << std::endl <<
           "  --safe                      Only test the functionality available in safety restricted flows"                            << std::endl <<
           "  --saveEngine=<file>         Save the serialized engine"                                                                  << std::endl <<
           "  --loadEngine=<file>         Load a serialized engine"                                                                    << std::endl;
@@ -839,17 +951,35 @@ void InferenceOptions::help(std::ostream& os)
           "                              Input shapes spec ::= Ishp[\",\"spec]"                                                  << std::endl <<
           "                                           Ishp ::= name\":\"shape"                                                   << std::endl <<
           "                                          shape ::= N[[\"x\"N]*\"*\"]"                                                << std::endl <<
-          "  --iterations=N              Run at least N inference iterations (default = "            << defaultIterations << ")" << std::endl <<
+          "  --loadInputs=spec           Load input tensors from .npy or raw binary files, or from directories of such files "
+                                                                              "used in turn by successive iterations"    << std::endl <<
+          "                              Input files spec ::= Ifile[\",\"spec]"                                             << std::endl <<
+          "                                         Ifile ::= name\":\"(file|directory)"                                    << std::endl <<
+          "  --iterations=N              Run at least N inference iterations of avgRuns inferences (default = " << defaultIterations << ")" << std::endl <<
           "  --warmUp=N                  Run for N milliseconds to warmup before measuring performance (default = "
                                                                                                          << defaultWarmUp << ")" << std::endl <<
           "  --duration=N                Run performance measurements for at least N seconds wallclock time (default = "
                                                                                                << defaultDuration << ")"         << std::endl <<
-          "  --sleepTime=N               Delay inference start with a gap of N milliseconds between launch and compute "
-                                                                                            "(default = " << defaultSleep << ")" << std::endl <<
-          "  --streams=N                 Instantiate N engines to use concurrently (default = "         << defaultStreams << ")" << std::endl <<
+          "  --untilStable=P             Stop measuring once the 95% confidence interval of the median latency is within +/- P%, "
+                                 "or when the duration is over, whichever comes first (default = disabled)"             << std::endl <<
+          "  --stableMean                Use the mean instead of the median latency for --untilStable"                          << std::endl <<
+          "  --sleepTime=N               Sleep N milliseconds after each inference before the next one on the same stream, "
+                                                    "to emulate a lower request rate (default = " << defaultSleep << ")" << std::endl <<
+          "  --loadRates=R[,R]*          Run an open loop instead: requests arrive at R queries per second and queue for the first "
+                                         "free stream, each driven by its own thread. End-to-end latencies are split into "
+                                         "queue and execution times, and several rates are swept (default = closed loop)" << std::endl <<
+          "  --arrivals=process          Arrivals of --loadRates: \"constant\" or \"poisson\" (default = poisson)"               << std::endl <<
+          "  --replayArrivals=file       Run an open loop with the arrival times in milliseconds of a file, one per line, "
+                                         "scaled to each of --loadRates if given"                                             << std::endl <<
+          "  --sweepShapes               Measure the engine at every power of two of the dynamic dimensions of its optimization "
+                                         "profile, from min to max, then refine around the shape of highest throughput. "
+                                         "Other dimensions are taken from --shapes, or the opt shapes (default = disabled)" << std::endl <<
+          "  --latencyBudget=N           Only pick shapes of --sweepShapes whose p99 latency is at most N ms (default = no budget)" << std::endl <<
+          "  --streams=N                 Instantiate N execution contexts, each with its own stream and buffers, to use concurrently "
+                                                                                          "(default = " << defaultStreams << ")" << std::endl <<
           "  --useSpinWait               Actively synchronize on GPU events. This option may decrease synchronization time but "
                                                                                 "increase CPU usage and power (default = false)" << std::endl <<
-          "  --threads                   Enable multithreading to drive engines with independent threads (default = disabled)"   << std::endl <<
+          "  --threads                   Enable multithreading to drive the streams with independent threads (default = disabled)" << std::endl <<
           "  --useCudaGraph              Use cuda graph to capture engine execution and then launch inference (default = false)" << std::endl <<
           "  --buildOnly                 Skip inference perf measurement (default = disabled)"                                   << std::endl;
 // clang-format on
@@ -867,10 +997,17 @@ void ReportingOptions::help(std::ostream& os)
                                                                       " = " << defaultPercentile << "%)" << std::endl <<
           "  --dumpOutput                Print the output tensor(s) of the last inference iteration "
                                                                                   "(default = disabled)" << std::endl <<
+          "  --exportOutput=<prefix>     Write the output tensor(s) of the last inference iteration to "
+                                 "<prefix><tensor>.npy files (default = disabled)"                       << std::endl <<
           "  --dumpProfile               Print profile information per layer (default = disabled)"       << std::endl <<
-          "  --exportTimes=<file>        Write the timing results in a json file (default = disabled)"   << std::endl <<
-          "  --exportProfile=<file>      Write the profile information per layer in a json file "
-                                                                              "(default = disabled)"     << std::endl;
+          "  --exportTimes=<file>        Write the timing of every inference in a json file, or in a csv file"
+                                             " if <file> ends in .csv (default = disabled)"              << std::endl <<
+          "  --exportProfile=<file>      Write the time of every layer invocation and the totals per layer"
+                                " in a json file, or in csv files if <file> is <name>.csv, with the"
+                                 " totals in <name>_layers.csv (default = disabled)"             << std::endl <<
+          "  --exportTrace=<file>        Write a timeline of the host phases of every thread in a Chrome"
+                                            " trace_event json file (default = disabled)"               << std::endl <<
+          "  --exportSweep=<file>        Write the points of --sweepShapes and the best one to a json file (default = disabled)" << std::endl;
 // clang-format on
 }
 
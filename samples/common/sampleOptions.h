@@ -144,6 +144,7 @@ struct BuildOptions: public Options
     bool load{false};
     std::string engine;
     std::string calibration;
+    std::string calibrationCacheDir;
     std::unordered_map<std::string, ShapeRange> shapes;
     std::vector<IOFormat> inputFormats;
     std::vector<IOFormat> outputFormats;
@@ -174,10 +175,18 @@ struct InferenceOptions: public Options
     int sleep{defaultSleep};
     int streams{defaultStreams};
     bool spin{false};
-    bool threads{true};
+    bool threads{false};
     bool graph{false};
     bool skip{false};
+    float untilStable{0}; // Target half-width of the latency confidence interval in %, 0 to run a fixed duration
+    bool stableMean{false};
+    std::vector<float> loadRates; // Open-loop arrival rates in queries per second, empty for a closed loop
+    std::string arrivals{"poisson"};
+    std::string replayArrivals;
+    bool sweepShapes{false};
+    float latencyBudget{0}; // Largest p99 latency of the shapes picked by a sweep in ms, 0 for no budget
     std::unordered_map<std::string, nvinfer1::Dims> shapes;
+    std::unordered_map<std::string, std::string> inputs;
 
     void parse(Arguments& arguments) override;
 
@@ -190,9 +199,12 @@ struct ReportingOptions: public Options
     int avgs{defaultAvgRuns};
     float percentile{defaultPercentile};
     bool output{false};
+    std::string exportOutput{};
     bool profile{false};
     std::string exportTimes{};
     std::string exportProfile{};
+    std::string exportTrace{};
+    std::string exportSweep{};
 
     void parse(Arguments& arguments) override;
 
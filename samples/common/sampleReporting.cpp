@@ -0,0 +1,419 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <cmath>
+#include <iomanip>
+
+#include "sampleReporting.h"
+
+namespace sample
+{
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separate();
+    mOs << '{';
+    mScopes.push_back(Scope{false, true});
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    mScopes.pop_back();
+    mOs << '}';
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separate();
+    mOs << '[';
+    mScopes.push_back(Scope{true, true});
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    const bool multiline = !mScopes.back().empty && mScopes.size() <= 2;
+    mScopes.pop_back();
+    if (multiline)
+    {
+        mOs << '\n';
+    }
+    mOs << ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name)
+{
+    separate();
+    writeString(name);
+    mOs << ':';
+    mAfterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number)
+{
+    separate();
+    if (std::isfinite(number))
+    {
+        mOs << std::setprecision(9) << number;
+    }
+    else
+    {
+        mOs << "null";
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t number)
+{
+    separate();
+    mOs << number;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& text)
+{
+    separate();
+    writeString(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag)
+{
+    separate();
+    mOs << (flag ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separate();
+    mOs << "null";
+    return *this;
+}
+
+void JsonWriter::separate()
+{
+    if (mAfterKey)
+    {
+        // The value of a member follows its key directly.
+        mAfterKey = false;
+        return;
+    }
+    if (mScopes.empty())
+    {
+        return;
+    }
+    Scope& scope = mScopes.back();
+    if (!scope.empty)
+    {
+        mOs << ',';
+    }
+    scope.empty = false;
+    // Arrays nested deeper, such as the coordinates of a record, stay on the line of their record.
+    if ((scope.array && mScopes.size() <= 2) || mScopes.size() == 1)
+    {
+        mOs << '\n';
+    }
+}
+
+void JsonWriter::writeString(const std::string& text)
+{
+    mOs << '"';
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"': mOs << "\\\""; break;
+        case '\\': mOs << "\\\\"; break;
+        case '\n': mOs << "\\n"; break;
+        case '\r': mOs << "\\r"; break;
+        case '\t': mOs << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                mOs << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec
+                    << std::setfill(' ');
+            }
+            else
+            {
+                mOs << c;
+            }
+        }
+    }
+    mOs << '"';
+}
+
+CsvWriter& CsvWriter::field(const std::string& text)
+{
+    separate();
+    if (text.find_first_of(",\"\r\n") == std::string::npos)
+    {
+        mOs << text;
+        return *this;
+    }
+    mOs << '"';
+    for (const char c : text)
+    {
+        if (c == '"')
+        {
+            mOs << '"';
+        }
+        mOs << c;
+    }
+    mOs << '"';
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(double number)
+{
+    separate();
+    if (std::isfinite(number))
+    {
+        mOs << std::setprecision(9) << number;
+    }
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(int64_t number)
+{
+    separate();
+    mOs << number;
+    return *this;
+}
+
+void CsvWriter::endRow()
+{
+    mOs << '\n';
+    mRowEmpty = true;
+}
+
+void CsvWriter::separate()
+{
+    if (!mRowEmpty)
+    {
+        mOs << ',';
+    }
+    mRowEmpty = false;
+}
+
+bool isCsvFile(const std::string& fileName)
+{
+    const std::string extension{".csv"};
+    return fileName.size() >= extension.size()
+        && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool TimesExporter::open(const std::string& fileName)
+{
+    mFile.open(fileName);
+    if (!mFile)
+    {
+        return false;
+    }
+    if (isCsvFile(fileName))
+    {
+        mCsv.reset(new CsvWriter(mFile));
+        mCsv->field("stream").field("index").field("arrivalMs").field("startMs").field("endMs").field("queueMs");
+        mCsv->field("latencyMs").field("gpuMs");
+        mCsv->endRow();
+    }
+    else
+    {
+        mJson.reset(new JsonWriter(mFile));
+        mJson->beginArray();
+    }
+    return true;
+}
+
+void TimesExporter::onInference(int worker, int index, const InferenceTrace& trace)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mCsv)
+    {
+        mCsv->field(worker).field(index).field(trace.arrival).field(trace.enqueueStart).field(trace.hostEnd);
+        mCsv->field(trace.queueTime()).field(trace.latency()).field(trace.gpuTime);
+        mCsv->endRow();
+    }
+    else if (mJson)
+    {
+        mJson->beginObject();
+        mJson->key("stream").value(worker).key("index").value(index);
+        mJson->key("arrivalMs").value(trace.arrival).key("startMs").value(trace.enqueueStart);
+        mJson->key("endMs").value(trace.hostEnd).key("queueMs").value(trace.queueTime());
+        mJson->key("latencyMs").value(trace.latency()).key("gpuMs").value(trace.gpuTime);
+        mJson->endObject();
+    }
+}
+
+bool TimesExporter::close()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mJson)
+    {
+        mJson->endArray();
+        mFile << '\n';
+    }
+    mJson.reset();
+    mCsv.reset();
+    mFile.close();
+    return static_cast<bool>(mFile);
+}
+
+bool ProfileExporter::open(const std::string& fileName)
+{
+    mFileName = fileName;
+    mFile.open(fileName);
+    if (!mFile)
+    {
+        return false;
+    }
+    if (isCsvFile(fileName))
+    {
+        mCsv.reset(new CsvWriter(mFile));
+        mCsv->field("inference").field("layer").field("timeMs");
+        mCsv->endRow();
+    }
+    else
+    {
+        mJson.reset(new JsonWriter(mFile));
+        mJson->beginObject().key("invocations").beginArray();
+    }
+    return true;
+}
+
+void ProfileExporter::reportLayerTime(const char* layerName, float ms)
+{
+    if (mNext)
+    {
+        mNext->reportLayerTime(layerName, ms);
+    }
+    if (!mRecording)
+    {
+        return;
+    }
+
+    const size_t index = mIndex.indexOf(layerName);
+    if (index == mLayers.size())
+    {
+        mLayers.emplace_back();
+    }
+    LayerTotal& layer = mLayers[index];
+    layer.time += ms;
+    ++layer.count;
+    // The first layer reported starts every inference.
+    if (index == 0)
+    {
+        ++mInference;
+    }
+    const std::string& name = mIndex.getName(index);
+
+    if (mCsv)
+    {
+        mCsv->field(mInference).field(name).field(ms);
+        mCsv->endRow();
+    }
+    else if (mJson)
+    {
+        mJson->beginObject().key("inference").value(mInference).key("layer").value(name).key("timeMs").value(ms);
+        mJson->endObject();
+    }
+}
+
+bool ProfileExporter::close()
+{
+    double total{0};
+    for (const auto& l : mLayers)
+    {
+        total += l.time;
+    }
+    auto percentage = [total](double time) { return total > 0 ? time * 100 / total : 0; };
+
+    bool good{true};
+    if (mCsv)
+    {
+        const std::string stem = mFileName.substr(0, mFileName.size() - 4);
+        std::ofstream layersFile(stem + "_layers.csv");
+        CsvWriter layers(layersFile);
+        layers.field("layer").field("timeMs").field("count").field("averageMs").field("percentage");
+        layers.endRow();
+        for (size_t i = 0; i < mLayers.size(); ++i)
+        {
+            const LayerTotal& l = mLayers[i];
+            layers.field(mIndex.getName(i)).field(l.time).field(l.count).field(l.time / l.count);
+            layers.field(percentage(l.time));
+            layers.endRow();
+        }
+        layersFile.close();
+        good = static_cast<bool>(layersFile);
+    }
+    else if (mJson)
+    {
+        mJson->endArray().key("layers").beginArray();
+        for (size_t i = 0; i < mLayers.size(); ++i)
+        {
+            const LayerTotal& l = mLayers[i];
+            mJson->beginObject().key("name").value(mIndex.getName(i)).key("timeMs").value(l.time);
+            mJson->key("count").value(l.count);
+            mJson->key("averageMs").value(l.time / l.count).key("percentage").value(percentage(l.time));
+            mJson->endObject();
+        }
+        mJson->endArray().key("totalMs").value(total).endObject();
+        mFile << '\n';
+    }
+    mJson.reset();
+    mCsv.reset();
+    mFile.close();
+    return good && static_cast<bool>(mFile);
+}
+
+} // namespace sample
@@ -0,0 +1,259 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_REPORTING_H
+#define TRT_SAMPLE_REPORTING_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "NvInfer.h"
+
+#include "layerProfiler.h"
+#include "sampleInference.h"
+
+namespace sample
+{
+
+//!
+//! \brief The JsonWriter class writes a JSON document to a stream as it is produced, without building it in memory.
+//!
+//! \details Commas are inserted automatically. Non-finite numbers are written as null. The members of the
+//!          outermost object and the elements of the arrays at the first two levels start on a new line, so that
+//!          exports with one record per line stay readable and diffable.
+//!
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream& os)
+        : mOs(os)
+    {
+    }
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    //!
+    //! \brief Write the key of the next member of the current object
+    //!
+    JsonWriter& key(const std::string& name);
+
+    JsonWriter& value(double number);
+    JsonWriter& value(int64_t number);
+    JsonWriter& value(int number)
+    {
+        return value(static_cast<int64_t>(number));
+    }
+    JsonWriter& value(const std::string& text);
+    JsonWriter& value(const char* text)
+    {
+        return value(std::string(text));
+    }
+    JsonWriter& value(bool flag);
+
+    //!
+    //! \brief Write null, for a missing value
+    //!
+    JsonWriter& null();
+
+private:
+    //! Write the separator before a new element
+    void separate();
+    void writeString(const std::string& text);
+
+    struct Scope
+    {
+        bool array; //!< Whether the scope is an array or an object
+        bool empty; //!< Whether no element was written in the scope yet
+    };
+
+    std::ostream& mOs;
+    std::vector<Scope> mScopes; //!< The objects and arrays open, innermost last
+    bool mAfterKey{false};
+};
+
+//!
+//! \brief The CsvWriter class writes comma separated rows, quoting the fields that need it.
+//!
+class CsvWriter
+{
+public:
+    explicit CsvWriter(std::ostream& os)
+        : mOs(os)
+    {
+    }
+
+    CsvWriter& field(const std::string& text);
+    CsvWriter& field(double number);
+    CsvWriter& field(int64_t number);
+    CsvWriter& field(int number)
+    {
+        return field(static_cast<int64_t>(number));
+    }
+    void endRow();
+
+private:
+    void separate();
+
+    std::ostream& mOs;
+    bool mRowEmpty{true};
+};
+
+//!
+//! \brief Return true if fileName ends in ".csv", in which case exports are written as CSV instead of JSON
+//!
+bool isCsvFile(const std::string& fileName);
+
+//!
+//! \brief The TimesExporter class writes the timing of every recorded inference as it completes.
+//!
+//! \details JSON files hold an array of objects, CSV files a header and one row per inference, with the stream,
+//!          the index of the inference on the stream, the host arrival, start and end times in milliseconds since
+//!          the start of the measurements, the time spent queued, the host latency from the start and the GPU
+//!          time. Requests only queue in open-loop runs. Nothing is kept in memory.
+//!
+class TimesExporter : public IInferenceListener
+{
+public:
+    //!
+    //! \brief Create the file and write its header
+    //!
+    //! \return boolean Return false if the file cannot be created
+    //!
+    bool open(const std::string& fileName);
+
+    void onInference(int worker, int index, const InferenceTrace& trace) override;
+
+    //!
+    //! \brief Complete the file
+    //!
+    //! \return boolean Return false if any write failed
+    //!
+    bool close();
+
+private:
+    std::mutex mMutex;
+    std::ofstream mFile;
+    std::unique_ptr<JsonWriter> mJson;
+    std::unique_ptr<CsvWriter> mCsv;
+};
+
+//!
+//! \brief The ProfileExporter class writes the time of every layer invocation as it is reported, and the totals
+//!        of every layer when it is closed.
+//!
+//! \details Inferences are numbered by counting the reports of the first layer reported. JSON files hold an object
+//!          with an "invocations" array and a "layers" array. For CSV files, the invocations go to the file and the
+//!          per layer totals to a second file whose name ends in "_layers.csv" instead of ".csv". Only the totals
+//!          are kept in memory, indexed by a LayerIndex like those of LayerProfiler, so that a report of a known
+//!          layer neither copies its name nor allocates memory. Reports are forwarded to next, if any, so that another profiler can print them.
+//!          Reports are only exported once the flag of getRecording() is set, by runInference() at the end of the
+//!          warm up, so that inference 0 of the profile is the first inference of the times of the first stream.
+//!
+class ProfileExporter : public nvinfer1::IProfiler
+{
+public:
+    explicit ProfileExporter(nvinfer1::IProfiler* next = nullptr)
+        : mNext(next)
+    {
+    }
+
+    //!
+    //! \brief Create the file and write its header
+    //!
+    //! \return boolean Return false if the file cannot be created
+    //!
+    bool open(const std::string& fileName);
+
+    void reportLayerTime(const char* layerName, float ms) override;
+
+    //!
+    //! \brief Return the flag that starts the export, for RunOptions::recording
+    //!
+    std::atomic<bool>* getRecording()
+    {
+        return &mRecording;
+    }
+
+    //!
+    //! \brief Write the per layer totals and complete the file
+    //!
+    //! \return boolean Return false if any write failed
+    //!
+    bool close();
+
+private:
+    struct LayerTotal
+    {
+        double time{0};
+        int64_t count{0};
+    };
+
+    nvinfer1::IProfiler* mNext{nullptr};
+    std::string mFileName;
+    std::ofstream mFile;
+    std::unique_ptr<JsonWriter> mJson;
+    std::unique_ptr<CsvWriter> mCsv;
+    samplesCommon::LayerIndex mIndex;
+    std::vector<LayerTotal> mLayers; //!< Totals of every layer, by index in mIndex
+    int64_t mInference{-1};
+    std::atomic<bool> mRecording{false};
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_REPORTING_H
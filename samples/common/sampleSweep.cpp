@@ -0,0 +1,353 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+#include "sampleReporting.h"
+#include "sampleSweep.h"
+
+namespace sample
+{
+
+namespace
+{
+
+std::string axisName(const SweepAxis& axis)
+{
+    return axis.position == 0 ? "batch" : "dim" + std::to_string(axis.position);
+}
+
+} // namespace
+
+std::vector<int> ShapeSweep::gridValues(int min, int max)
+{
+    std::vector<int> values{min};
+    int power = 1;
+    while (power <= min)
+    {
+        power *= 2;
+    }
+    for (; power < max; power *= 2)
+    {
+        values.push_back(power);
+    }
+    if (max > min)
+    {
+        values.push_back(max);
+    }
+    return values;
+}
+
+bool ShapeSweep::run(const SweepMeasureFunction& measure)
+{
+    mMeasure = measure;
+    mPoints.clear();
+    mIndices.clear();
+    mBest = -1;
+    mRefinements = 0;
+
+    // Every combination of the grid values of the axes, the last axis moving fastest
+    std::vector<std::vector<int>> grids;
+    for (const auto& a : mAxes)
+    {
+        grids.push_back(gridValues(a.min, a.max));
+    }
+    std::vector<size_t> position(mAxes.size(), 0);
+    std::vector<int> values(mAxes.size());
+    for (bool done = false; !done;)
+    {
+        for (size_t a = 0; a < mAxes.size(); ++a)
+        {
+            values[a] = grids[a][position[a]];
+        }
+        this->measure(values, false);
+        done = true;
+        for (size_t a = mAxes.size(); a-- > 0;)
+        {
+            if (++position[a] < grids[a].size())
+            {
+                done = false;
+                break;
+            }
+            position[a] = 0;
+        }
+    }
+
+    // Refine until an axis by axis pass no longer moves the best point.
+    for (int previous = -1; mBest >= 0 && mBest != previous && mRefinements < mOptions.maxRefinements;)
+    {
+        previous = mBest;
+        for (size_t a = 0; a < mAxes.size(); ++a)
+        {
+            // The nearest points measured on both sides of the best one along the axis bracket the search.
+            const std::vector<int>& best = mPoints[mBest].values;
+            int lo = best[a];
+            int hi = best[a];
+            for (const auto& p : mPoints)
+            {
+                bool aligned{true};
+                for (size_t other = 0; other < mAxes.size(); ++other)
+                {
+                    aligned = aligned && (other == a || p.values[other] == best[other]);
+                }
+                if (aligned && p.values[a] < best[a] && (lo == best[a] || p.values[a] > lo))
+                {
+                    lo = p.values[a];
+                }
+                if (aligned && p.values[a] > best[a] && (hi == best[a] || p.values[a] < hi))
+                {
+                    hi = p.values[a];
+                }
+            }
+            refine(a, lo, hi);
+        }
+    }
+
+    return std::any_of(mPoints.begin(), mPoints.end(), [](const SweepPoint& p) { return !p.failed; });
+}
+
+int ShapeSweep::measure(const std::vector<int>& values, bool refined)
+{
+    const auto known = mIndices.find(values);
+    if (known != mIndices.end())
+    {
+        return known->second;
+    }
+    SweepPoint point;
+    point.values = values;
+    point.refined = refined;
+    point.failed = !mMeasure(values, point.measurement);
+    point.feasible = !point.failed
+        && (mOptions.latencyBudget <= 0 || point.measurement.latency.p99 <= mOptions.latencyBudget);
+    const int index = static_cast<int>(mPoints.size());
+    mPoints.push_back(point);
+    mIndices[values] = index;
+    if (refined)
+    {
+        ++mRefinements;
+    }
+    if (isBetter(index, mBest))
+    {
+        mBest = index;
+    }
+    return index;
+}
+
+bool ShapeSweep::isBetter(int a, int b) const
+{
+    if (!mPoints[a].feasible)
+    {
+        return false;
+    }
+    if (b < 0)
+    {
+        return true;
+    }
+    const SweepMeasurement& ma = mPoints[a].measurement;
+    const SweepMeasurement& mb = mPoints[b].measurement;
+    return ma.throughput > mb.throughput || (ma.throughput == mb.throughput && ma.latency.p99 < mb.latency.p99);
+}
+
+void ShapeSweep::refine(size_t axis, int lo, int hi)
+{
+    while (mRefinements < mOptions.maxRefinements)
+    {
+        std::vector<int> values = mPoints[mBest].values;
+        const int current = values[axis];
+        values[axis] = hi;
+        const SweepPoint& upper = mPoints[mIndices.at(values)];
+        values[axis] = lo;
+        const SweepPoint& lower = mPoints[mIndices.at(values)];
+        // When the point above is over budget, the best value is the largest one within it. When the best point
+        // is between two slower ones, the peak of the throughput is on either side, more likely that of the
+        // faster neighbour. At the edge of the range, the throughput is taken to keep decreasing away from it.
+        const bool overBudget = hi != current && !upper.feasible;
+        const bool bracketed = hi != current && lo != current;
+        bool up = hi - current > 1 && (overBudget || bracketed);
+        const bool down = current - lo > 1 && bracketed && !overBudget;
+        if (up && down && lower.feasible && lower.measurement.throughput > upper.measurement.throughput)
+        {
+            up = false;
+        }
+        if (up)
+        {
+            values[axis] = current + (hi - current) / 2;
+        }
+        else if (down)
+        {
+            values[axis] = lo + (current - lo) / 2;
+        }
+        else
+        {
+            break;
+        }
+        const int index = measure(values, true);
+        if (index == mBest)
+        {
+            (values[axis] > current ? lo : hi) = current;
+        }
+        else
+        {
+            (values[axis] > current ? hi : lo) = values[axis];
+        }
+    }
+}
+
+void ShapeSweep::print(std::ostream& os) const
+{
+    os << "Shape sweep (throughput in samples/s, latencies in ms):" << std::endl;
+    for (const auto& a : mAxes)
+    {
+        os << std::setw(8) << axisName(a);
+    }
+    os << std::setw(14) << "throughput" << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99"
+       << std::endl;
+
+    std::vector<int> order(mPoints.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) { return mPoints[a].values < mPoints[b].values; });
+    for (const int i : order)
+    {
+        const SweepPoint& p = mPoints[i];
+        for (const int v : p.values)
+        {
+            os << std::setw(8) << v;
+        }
+        if (p.failed)
+        {
+            os << "  failed" << std::endl;
+            continue;
+        }
+        const samplesCommon::LatencySummary& l = p.measurement.latency;
+        os << std::setw(14) << p.measurement.throughput << std::setw(10) << l.mean << std::setw(10) << l.p50
+           << std::setw(10) << l.p99 << (p.feasible ? "" : "  over budget") << (p.refined ? "  refined" : "")
+           << (i == mBest ? "  best" : "") << std::endl;
+    }
+
+    if (mBest < 0)
+    {
+        os << "No shape meets the p99 latency budget of " << mOptions.latencyBudget << " ms" << std::endl;
+        return;
+    }
+    const SweepPoint& best = mPoints[mBest];
+    os << "Best shape:";
+    for (size_t a = 0; a < mAxes.size(); ++a)
+    {
+        os << " " << axisName(mAxes[a]) << " = " << best.values[a];
+    }
+    os << ", throughput " << best.measurement.throughput << " samples/s, p99 latency " << best.measurement.latency.p99
+       << " ms";
+    if (mOptions.latencyBudget > 0)
+    {
+        os << " (budget " << mOptions.latencyBudget << " ms)";
+    }
+    os << std::endl;
+}
+
+void ShapeSweep::exportJson(std::ostream& os) const
+{
+    JsonWriter json(os);
+    json.beginObject().key("latencyBudgetMs");
+    if (mOptions.latencyBudget > 0)
+    {
+        json.value(mOptions.latencyBudget);
+    }
+    else
+    {
+        json.null();
+    }
+
+    json.key("axes").beginArray();
+    for (const auto& a : mAxes)
+    {
+        json.beginObject().key("name").value(axisName(a)).key("position").value(a.position);
+        json.key("min").value(a.min).key("max").value(a.max).key("inputs").beginArray();
+        for (const auto& input : a.inputs)
+        {
+            json.value(input);
+        }
+        json.endArray().endObject();
+    }
+    json.endArray();
+
+    json.key("points").beginArray();
+    for (const auto& p : mPoints)
+    {
+        json.beginObject().key("values").beginArray();
+        for (const int v : p.values)
+        {
+            json.value(v);
+        }
+        json.endArray().key("refined").value(p.refined).key("failed").value(p.failed);
+        json.key("feasible").value(p.feasible);
+        if (!p.failed)
+        {
+            const samplesCommon::LatencySummary& l = p.measurement.latency;
+            json.key("throughput").value(p.measurement.throughput).key("meanMs").value(l.mean);
+            json.key("p50Ms").value(l.p50).key("p90Ms").value(l.p90).key("p99Ms").value(l.p99);
+            json.key("maxMs").value(l.max);
+        }
+        json.endObject();
+    }
+    json.endArray().key("best");
+    if (mBest >= 0)
+    {
+        json.value(mBest);
+    }
+    else
+    {
+        json.null();
+    }
+    json.endObject();
+    os << '\n';
+}
+
+} // namespace sample
@@ -0,0 +1,190 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_SWEEP_H
+#define TRT_SAMPLE_SWEEP_H
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "latencyHistogram.h"
+
+namespace sample
+{
+
+//!
+//! \brief A dimension swept, at the same position in the shapes of every input that is dynamic there
+//!
+//! \details Tying the inputs by position makes the batch size, the first dimension, move together in all the
+//!          inputs, as it has to.
+//!
+struct SweepAxis
+{
+    int position{0};                 //!< Index of the dimension in the input shapes
+    int min{1};                      //!< Smallest value allowed by the optimization profile of every input
+    int max{1};                      //!< Largest value allowed by the optimization profile of every input
+    std::vector<std::string> inputs; //!< Inputs with a dynamic dimension at this position
+};
+
+//!
+//! \brief Performance of the engine at one point of a sweep
+//!
+struct SweepMeasurement
+{
+    float throughput{0};                   //!< Samples per second, counting the batch size of each inference
+    samplesCommon::LatencySummary latency; //!< Host latency of the inferences
+};
+
+//!
+//! \brief A point of a sweep and its measurement
+//!
+struct SweepPoint
+{
+    std::vector<int> values; //!< Value of every axis
+    SweepMeasurement measurement;
+    bool failed{false};      //!< Whether the engine could not run at this point
+    bool feasible{false};    //!< Whether the p99 latency is within the budget
+    bool refined{false};     //!< Whether the point was added by the refinement rather than the grid
+};
+
+struct SweepOptions
+{
+    float latencyBudget{0}; //!< Largest acceptable p99 latency in milliseconds, 0 for no budget
+    int maxRefinements{8};  //!< Points measured after the grid, at most
+};
+
+//!
+//! \brief Measure the engine at the values of the axes; return false if it cannot run there
+//!
+using SweepMeasureFunction = std::function<bool(const std::vector<int>& values, SweepMeasurement& measurement)>;
+
+//!
+//! \brief  The ShapeSweep class looks for the shape of highest throughput whose p99 latency meets a budget.
+//!
+//! \details The search first measures a grid: on each axis, the minimum, the maximum and the powers of two in
+//!          between, since throughput tends to change with the logarithm of the batch size. The best feasible
+//!          grid point is then refined one axis at a time by bisection between its neighbours on the axis,
+//!          moving to a midpoint whenever it is feasible and faster. When the neighbour above is over budget,
+//!          the search converges on the largest value within the budget, which is the usual outcome for the
+//!          batch size; when both neighbours are slower, it looks for the peak of the throughput between them.
+//!          Points are measured at most once. The search only sees measurements, so it can be driven by a
+//!          latency model instead of an engine.
+//!
+class ShapeSweep
+{
+public:
+    ShapeSweep(const std::vector<SweepAxis>& axes, const SweepOptions& options)
+        : mAxes(axes)
+        , mOptions(options)
+    {
+    }
+
+    //!
+    //! \brief Return the values of the grid on an axis from min to max, in increasing order
+    //!
+    static std::vector<int> gridValues(int min, int max);
+
+    //!
+    //! \brief Measure the grid, then refine the best point
+    //!
+    //! \return boolean Return false if no point could be measured
+    //!
+    bool run(const SweepMeasureFunction& measure);
+
+    //!
+    //! \brief Return the points in the order they were measured
+    //!
+    const std::vector<SweepPoint>& getPoints() const
+    {
+        return mPoints;
+    }
+
+    //!
+    //! \brief Return the index of the feasible point of highest throughput, or -1 if no point is feasible
+    //!
+    int getBest() const
+    {
+        return mBest;
+    }
+
+    //!
+    //! \brief Print one line per point, the axes first, and the best point
+    //!
+    void print(std::ostream& os) const;
+
+    //!
+    //! \brief Write the axes, the budget, every point and the index of the best one as JSON
+    //!
+    void exportJson(std::ostream& os) const;
+
+private:
+    //! Measure the point at values unless it was already, and return its index.
+    int measure(const std::vector<int>& values, bool refined);
+
+    //! Whether point a is a better choice than point b, which may be -1.
+    bool isBetter(int a, int b) const;
+
+    //! Bisect on axis between the best point and the values lo and hi around it.
+    void refine(size_t axis, int lo, int hi);
+
+    std::vector<SweepAxis> mAxes;
+    SweepOptions mOptions;
+    SweepMeasureFunction mMeasure;
+    std::vector<SweepPoint> mPoints;
+    std::map<std::vector<int>, int> mIndices; //!< Index of each point measured
+    int mBest{-1};
+    int mRefinements{0};
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_SWEEP_H
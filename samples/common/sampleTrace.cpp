@@ -0,0 +1,178 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#include <fstream>
+
+#include "sampleReporting.h"
+#include "sampleTrace.h"
+
+namespace sample
+{
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::~Tracer()
+{
+    for (auto& buffer : mBuffers)
+    {
+        for (auto& chunk : buffer->chunks)
+        {
+            delete[] chunk.load();
+        }
+    }
+}
+
+Tracer::ThreadSlot::~ThreadSlot()
+{
+    if (buffer)
+    {
+        Tracer& tracer = Tracer::instance();
+        std::lock_guard<std::mutex> lock(tracer.mMutex);
+        tracer.mFreeBuffers.push_back(buffer);
+    }
+}
+
+Tracer::ThreadSlot& Tracer::threadSlot()
+{
+    static thread_local ThreadSlot slot;
+    if (!slot.buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFreeBuffers.empty())
+        {
+            mBuffers.emplace_back(new ThreadBuffer);
+            slot.buffer = mBuffers.back().get();
+            slot.buffer->thread = static_cast<int>(mBuffers.size()) - 1;
+        }
+        else
+        {
+            slot.buffer = mFreeBuffers.back();
+            mFreeBuffers.pop_back();
+        }
+    }
+    return slot;
+}
+
+void Tracer::record(const char* name, int64_t start, int64_t end)
+{
+    ThreadBuffer& buffer = *threadSlot().buffer;
+    // Only the owning thread appends, so the size can be read and published without a read-modify-write.
+    const size_t size = buffer.size.load(std::memory_order_relaxed);
+    const size_t chunkIndex = size / kCHUNK_EVENTS;
+    if (chunkIndex >= kMAX_CHUNKS)
+    {
+        ++mDropped;
+        return;
+    }
+    TraceEvent* chunk = buffer.chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new TraceEvent[kCHUNK_EVENTS];
+        buffer.chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    TraceEvent& event = chunk[size % kCHUNK_EVENTS];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    buffer.size.store(size + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    const int thread = threadSlot().buffer->thread;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mThreadNames[thread] = name;
+}
+
+void Tracer::write(std::ostream& os)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    JsonWriter json(os);
+    json.beginObject().key("displayTimeUnit").value(std::string("ms")).key("traceEvents").beginArray();
+    for (const auto& name : mThreadNames)
+    {
+        json.beginObject().key("name").value(std::string("thread_name")).key("ph").value(std::string("M"));
+        json.key("pid").value(0).key("tid").value(name.first);
+        json.key("args").beginObject().key("name").value(name.second).endObject();
+        json.endObject();
+    }
+    for (const auto& buffer : mBuffers)
+    {
+        const size_t size = buffer->size.load(std::memory_order_acquire);
+        for (size_t e = 0; e < size; ++e)
+        {
+            const TraceEvent& event
+                = buffer->chunks[e / kCHUNK_EVENTS].load(std::memory_order_acquire)[e % kCHUNK_EVENTS];
+            // Complete events, with times in microseconds
+            json.beginObject().key("name").value(std::string(event.name)).key("ph").value(std::string("X"));
+            json.key("ts").value(event.start * 1e-3).key("dur").value(event.duration * 1e-3);
+            json.key("pid").value(0).key("tid").value(buffer->thread);
+            json.endObject();
+        }
+    }
+    json.endArray().endObject();
+    os << std::endl;
+}
+
+bool Tracer::write(const std::string& fileName)
+{
+    std::ofstream file(fileName);
+    write(file);
+    return static_cast<bool>(file);
+}
+
+} // namespace sample
@@ -0,0 +1,238 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+#ifndef TRT_SAMPLE_TRACE_H
+#define TRT_SAMPLE_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sample
+{
+
+//!
+//! \brief One span of a trace, in nanoseconds since the creation of the Tracer
+//!
+struct TraceEvent
+{
+    const char* name{nullptr}; //!< Must outlive the Tracer, typically a string literal
+    int64_t start{0};
+    int64_t duration{0};
+};
+
+//!
+//! \brief The Tracer class collects spans of time from all threads and writes them as a Chrome trace_event
+//!        JSON file, to be viewed in chrome://tracing or Perfetto.
+//!
+//! \details Every thread appends to a buffer of its own, in chunks that are never moved, and publishes the number
+//!          of its events with an atomic store, so recording takes no lock and write() can run while threads record.
+//!          A thread takes a buffer on its first event and hands it back when it exits, for the next new thread to
+//!          continue, so threads created per task do not each hold a buffer. A buffer keeps its thread id in the
+//!          trace, so those threads share a row. Events past the capacity of a buffer are dropped and counted.
+//!          Nothing is recorded, and threads are not named, until start() is called.
+//!
+//!          Spans are recorded with the SAMPLE_TRACE_SPAN macro, which compiles to nothing when SAMPLES_DISABLE_TRACING
+//!          is defined (make DISABLE_TRACING=1).
+//!
+class Tracer
+{
+public:
+    static constexpr size_t kCHUNK_EVENTS = 1024; //!< Events allocated at once by a thread
+    static constexpr size_t kMAX_CHUNKS = 4096;   //!< Chunks of a buffer, for 4M events
+
+    static Tracer& instance();
+
+    void start()
+    {
+        mEnabled.store(true, std::memory_order_relaxed);
+    }
+
+    void stop()
+    {
+        mEnabled.store(false, std::memory_order_relaxed);
+    }
+
+    bool isEnabled() const
+    {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    //!
+    //! \brief Return the time in nanoseconds since the creation of the tracer
+    //!
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mOrigin).count();
+    }
+
+    //!
+    //! \brief Record a span of the calling thread; name must outlive the tracer
+    //!
+    void record(const char* name, int64_t start, int64_t end);
+
+    //!
+    //! \brief Name the calling thread in the trace, if the tracer is started
+    //!
+    void setThreadName(const std::string& name);
+
+    //!
+    //! \brief Write the events recorded so far as a Chrome trace_event JSON document
+    //!
+    void write(std::ostream& os);
+
+    //!
+    //! \brief Write the events recorded so far to a file
+    //!
+    //! \return boolean Return false if the file cannot be written
+    //!
+    bool write(const std::string& fileName);
+
+    //!
+    //! \brief Return the number of events dropped because a buffer was full
+    //!
+    uint64_t getDropped() const
+    {
+        return mDropped;
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        std::array<std::atomic<TraceEvent*>, kMAX_CHUNKS> chunks{};
+        std::atomic<size_t> size{0}; //!< Published events
+        int thread{0};               //!< Id in the trace of the threads using the buffer
+    };
+
+    //! Hands the buffer of a thread back to the tracer when the thread exits.
+    struct ThreadSlot
+    {
+        ThreadBuffer* buffer{nullptr};
+
+        ~ThreadSlot();
+    };
+
+    Tracer()
+        : mOrigin(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~Tracer();
+
+    ThreadSlot& threadSlot();
+
+    std::atomic<bool> mEnabled{false};
+    std::chrono::steady_clock::time_point mOrigin;
+    std::atomic<uint64_t> mDropped{0};
+
+    std::mutex mMutex; //!< Guards the members below, which change when a thread starts or exits
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+    std::vector<ThreadBuffer*> mFreeBuffers;
+    std::map<int, std::string> mThreadNames; //!< By thread id, at most one per buffer
+};
+
+//!
+//! \brief The TraceSpan class records the span of its scope if the tracer is started when it is created.
+//!
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name)
+        : mName(Tracer::instance().isEnabled() ? name : nullptr)
+        , mStart(mName ? Tracer::instance().now() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (mName)
+        {
+            Tracer& tracer = Tracer::instance();
+            tracer.record(mName, mStart, tracer.now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* mName;
+    int64_t mStart;
+};
+
+} // namespace sample
+
+#define SAMPLE_TRACE_CONCAT_IMPL(a, b) a##b
+#define SAMPLE_TRACE_CONCAT(a, b) SAMPLE_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(SAMPLES_DISABLE_TRACING)
+#define SAMPLE_TRACE_SPAN(name)
+#define SAMPLE_TRACE_THREAD_NAME(name)
+#else
+//! Record the rest of the enclosing scope as a span named by a string literal
+#define SAMPLE_TRACE_SPAN(name) sample::TraceSpan SAMPLE_TRACE_CONCAT(traceSpan, __LINE__)(name)
+//! Name the calling thread in the trace; name is not evaluated unless the tracer is started
+#define SAMPLE_TRACE_THREAD_NAME(name)                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (sample::Tracer::instance().isEnabled())                                                                    \
+        {                                                                                                              \
+            sample::Tracer::instance().setThreadName(name);                                                            \
+        }                                                                                                              \
+    } while (0)
+#endif
+
+#endif // TRT_SAMPLE_TRACE_H
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_STABILITY_CONTROLLER_H
+#define TENSORRT_STABILITY_CONTROLLER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief Returns the quantile of the standard normal distribution at probability p, 0 < p < 1.
+//!
+//! \details Rational approximation of Acklam, with a relative error below 1.2e-9.
+//!
+inline double normalQuantile(double p)
+{
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+        1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+        6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+        -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+        3.754408661907416e+00};
+    const double low = 0.02425;
+    if (p < low || p > 1 - low)
+    {
+        const double q = std::sqrt(-2 * std::log(p < low ? p : 1 - p));
+        const double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+            / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+        return p < low ? x : -x;
+    }
+    const double q = p - 0.5;
+    const double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+        / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+//!
+//! \brief Returns the quantile of the Student t distribution with df degrees of freedom at probability p.
+//!
+//! \details Exact for 1 and 2 degrees of freedom; above, Cornish-Fisher expansion around the normal quantile
+//!          (Abramowitz and Stegun 26.7.5), with a relative error below 0.5%.
+//!
+inline double studentQuantile(double p, int df)
+{
+    if (df <= 1)
+    {
+        return std::tan(3.14159265358979323846 * (p - 0.5));
+    }
+    if (df == 2)
+    {
+        return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+    }
+    const double z = normalQuantile(p);
+    const double n = std::max(df, 1);
+    const double z2 = z * z;
+    const double g1 = (z2 + 1) * z / 4;
+    const double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+    const double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+    const double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+    return z + g1 / n + g2 / (n * n) + g3 / (n * n * n) + g4 / (n * n * n * n);
+}
+
+//!
+//! \brief The StabilityOptions structure configures a StabilityController.
+//!
+struct StabilityOptions
+{
+    bool median{true};              //!< Estimate the median latency, or the mean if false
+    double confidence{0.95};        //!< Confidence level of the interval
+    double targetPrecision{0.01};   //!< Stable once the half-width of the interval is below this share of the estimate
+    int minWindows{8};              //!< Windows needed before the interval is trusted
+    int maxWindows{64};             //!< Windows are merged pairwise when there are this many
+    int initialWindowSize{8};       //!< Samples per window until the first merge
+    double driftThreshold{0.02};    //!< Relative change over the run past which a significant trend is drift
+};
+
+//!
+//! \brief The StabilityReport structure describes the latencies seen by a StabilityController.
+//!
+struct StabilityReport
+{
+    uint64_t samples{0};
+    int windows{0};            //!< Complete windows
+    int windowSize{0};         //!< Samples per window
+    double estimate{0};        //!< Mean of the window statistics
+    double low{0};             //!< Lower bound of the confidence interval of the estimate
+    double high{0};            //!< Upper bound of the confidence interval of the estimate
+    double precision{0};       //!< Half-width of the interval relative to the estimate
+    double drift{0};           //!< Relative change of the window statistics over the run, from their linear trend
+    bool drifting{false};      //!< Whether the trend is significant and larger than the drift threshold
+    bool stable{false};        //!< Whether the interval is narrow enough and no drift is seen
+};
+
+//!
+//! \brief  The StabilityController class decides when enough latencies have been measured for a precise estimate.
+//!
+//! \details Latencies of consecutive inferences are correlated, so the controller uses batch means: the samples
+//!          are cut into consecutive windows, each window is summarized by its median or mean, and the confidence
+//!          interval is the Student t interval of the window statistics, which are close to independent once the
+//!          windows are long enough. Until then, the variance of the statistics is inflated by (1 + r) / (1 - r),
+//!          from their lag-1 autocorrelation r, so that windows too short for the correlation of the latencies widen
+//!          the interval instead of ending the run early. The number of windows is kept between maxWindows / 2
+//!          and maxWindows by doubling the window size, so windows grow with the run. Each window is summarized
+//!          once, when it completes, and its samples are dropped; doubling then averages adjacent statistics, which
+//!          is exact for means and the usual batch-median approximation for medians. A least-squares trend of the
+//!          window statistics detects drift, such as thermal throttling or clock changes, in which case the
+//!          estimate is not stationary and the run is never reported stable. The controller only sees the latencies
+//!          it is given, so the same series always gives the same decisions.
+//!
+class StabilityController
+{
+public:
+    explicit StabilityController(const StabilityOptions& options = StabilityOptions())
+        : mOptions(options)
+        , mWindowSize(std::max(1, options.initialWindowSize))
+    {
+    }
+
+    //!
+    //! \brief Adds a latency, and updates the report each time it completes a window.
+    //!
+    void add(double latency)
+    {
+        ++mNbSamples;
+        mWindow.push_back(latency);
+        if (mWindow.size() < mWindowSize)
+        {
+            return;
+        }
+        mStatistics.push_back(summarize(mWindow));
+        mWindow.clear();
+        // An even limit lets every pair of windows merge, so no statistic is left without its raw samples.
+        const size_t limit = (std::max(mOptions.maxWindows, 4) + 1) / 2 * 2;
+        if (mStatistics.size() >= limit)
+        {
+            for (size_t w = 0; w < mStatistics.size() / 2; ++w)
+            {
+                mStatistics[w] = (mStatistics[2 * w] + mStatistics[2 * w + 1]) / 2;
+            }
+            mStatistics.resize(mStatistics.size() / 2);
+            mWindowSize *= 2;
+        }
+        update();
+    }
+
+    //!
+    //! \brief Returns true once the interval is narrow enough, with enough windows and without drift.
+    //!
+    bool isStable() const
+    {
+        return mReport.stable;
+    }
+
+    //!
+    //! \brief Returns the state as of the last complete window.
+    //!
+    const StabilityReport& getReport() const
+    {
+        return mReport;
+    }
+
+private:
+    //! Returns the median or mean of the samples of a window, which it reorders.
+    double summarize(std::vector<double>& window) const
+    {
+        if (!mOptions.median)
+        {
+            double sum{0};
+            for (const double v : window)
+            {
+                sum += v;
+            }
+            return sum / window.size();
+        }
+        const auto middle = window.begin() + window.size() / 2;
+        std::nth_element(window.begin(), middle, window.end());
+        // With an even size, the median is the average of the middle sample and the largest below it.
+        return window.size() % 2 ? *middle : (*middle + *std::max_element(window.begin(), middle)) / 2;
+    }
+
+    void update()
+    {
+        const std::vector<double>& statistics = mStatistics;
+        const int k = static_cast<int>(statistics.size());
+        StabilityReport& r = mReport;
+        r.samples = mNbSamples;
+        r.windows = k;
+        r.windowSize = static_cast<int>(mWindowSize);
+        double sum{0};
+        for (const double s : statistics)
+        {
+            sum += s;
+        }
+        r.estimate = sum / k;
+        if (k < 2)
+        {
+            r.stable = false;
+            return;
+        }
+
+        // Student t interval of the window statistics, widened if consecutive windows are still correlated
+        double squares{0};
+        double lagged{0};
+        for (int w = 0; w < k; ++w)
+        {
+            squares += (statistics[w] - r.estimate) * (statistics[w] - r.estimate);
+            if (w > 0)
+            {
+                lagged += (statistics[w] - r.estimate) * (statistics[w - 1] - r.estimate);
+            }
+        }
+        const double correlation = squares > 0 ? std::min(std::max(lagged / squares, 0.0), 0.9) : 0;
+        const double variance = squares / (k - 1) / k * (1 + correlation) / (1 - correlation);
+        const double tail = (1 + mOptions.confidence) / 2;
+        const double halfWidth = studentQuantile(tail, k - 1) * std::sqrt(variance);
+        r.low = r.estimate - halfWidth;
+        r.high = r.estimate + halfWidth;
+        r.precision = r.estimate > 0 ? halfWidth / r.estimate : 0;
+
+        // Least-squares trend of the statistics over the window index, and the t statistic of its slope
+        r.drift = 0;
+        r.drifting = false;
+        if (k >= 3 && r.estimate > 0)
+        {
+            const double meanIndex = (k - 1) / 2.0;
+            double sxx{0};
+            double sxy{0};
+            for (int w = 0; w < k; ++w)
+            {
+                sxx += (w - meanIndex) * (w - meanIndex);
+                sxy += (w - meanIndex) * (statistics[w] - r.estimate);
+            }
+            const double slope = sxy / sxx;
+            double residuals{0};
+            for (int w = 0; w < k; ++w)
+            {
+                const double e = statistics[w] - r.estimate - slope * (w - meanIndex);
+                residuals += e * e;
+            }
+            const double slopeError = std::sqrt(residuals / (k - 2) / sxx);
+            r.drift = slope * (k - 1) / r.estimate;
+            const bool significant = slopeError == 0 ? slope != 0
+                                                     : std::abs(slope) / slopeError > studentQuantile(tail, k - 2);
+            r.drifting = significant && std::abs(r.drift) > mOptions.driftThreshold;
+        }
+        r.stable = k >= mOptions.minWindows && r.precision <= mOptions.targetPrecision && !r.drifting;
+    }
+
+    StabilityOptions mOptions;
+    size_t mWindowSize;
+    uint64_t mNbSamples{0};
+    std::vector<double> mWindow;     //!< Samples of the window in progress
+    std::vector<double> mStatistics; //!< Statistics of the complete windows
+    StabilityReport mReport;
+};
+
+} // namespace samplesCommon
+
+#endif // TENSORRT_STABILITY_CONTROLLER_H
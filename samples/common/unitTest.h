@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TENSORRT_UNIT_TEST_H
+#define TENSORRT_UNIT_TEST_H
+
+#include "logger.h"
+
+#include <cmath>
+#include <string>
+
+namespace samplesCommon
+{
+
+//!
+//! \brief The UnitTest class counts the failed expectations of a test program of the common code, which runs
+//!        without TensorRT or a GPU, and reports its result like the samples do.
+//!
+//! \details A test program checks its expectations with UNIT_EXPECT and UNIT_EXPECT_NEAR, which log the failures
+//!          with the current case and keep going, and returns report() from main().
+//!
+class UnitTest
+{
+public:
+    UnitTest(const std::string& name, int argc, char** argv)
+        : mTest(gLogger.defineTest(name, argc, argv))
+    {
+        gLogger.reportTestStart(mTest);
+    }
+
+    //!
+    //! \brief Name the case that the next failures belong to
+    //!
+    void setCase(const std::string& name)
+    {
+        mCase = name;
+        gLogVerbose << "Case: " << name << std::endl;
+    }
+
+    bool expect(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition)
+        {
+            ++mFailures;
+            gLogError << file << ":" << line << ": " << mCase << ": expected " << expression << std::endl;
+        }
+        return condition;
+    }
+
+    bool expectNear(
+        double actual, double expected, double tolerance, const char* expression, const char* file, int line)
+    {
+        const bool near = std::fabs(actual - expected) <= tolerance;
+        if (!near)
+        {
+            ++mFailures;
+            gLogError << file << ":" << line << ": " << mCase << ": expected " << expression << " = " << expected
+                      << " +/- " << tolerance << ", got " << actual << std::endl;
+        }
+        return near;
+    }
+
+    int getFailures() const
+    {
+        return mFailures;
+    }
+
+    //!
+    //! \brief Report the result of the test, and return the exit code of the program
+    //!
+    int report()
+    {
+        return gLogger.reportTest(mTest, mFailures == 0);
+    }
+
+private:
+    Logger::TestAtom mTest;
+    std::string mCase;
+    int mFailures{0};
+};
+
+} // namespace samplesCommon
+
+//! Check a condition of a UnitTest, and log it if it does not hold
+#define UNIT_EXPECT(test, condition) (test).expect((condition), #condition, __FILE__, __LINE__)
+//! Check that a value of a UnitTest is within tolerance of the expected value
+#define UNIT_EXPECT_NEAR(test, actual, expected, tolerance)                                                            \
+    (test).expectNear((actual), (expected), (tolerance), #actual, __FILE__, __LINE__)
+
+#endif // TENSORRT_UNIT_TEST_H
@@ -0,0 +1,175 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! compareStatsTest.cpp
+//! This file contains the unit test of the statistics of benchmark_compare: Mann-Whitney p-values of fixed samples,
+//! with and without ties, against values computed independently by counting the pairs of samples, and bootstrap
+//! intervals of relative changes. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./compare_stats_test
+//!
+
+#include "../benchmarkCompare/compareStats.h"
+#include "unitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace benchmarkCompare;
+
+namespace
+{
+
+void testPercentile(samplesCommon::UnitTest& test)
+{
+    test.setCase("percentile");
+    std::vector<double> samples{5, 1, 4, 2, 3};
+    UNIT_EXPECT(test, percentile(samples, 0) == 1);
+    UNIT_EXPECT(test, percentile(samples, 50) == 3);
+    UNIT_EXPECT(test, percentile(samples, 80) == 4);
+    UNIT_EXPECT(test, percentile(samples, 81) == 5);
+    UNIT_EXPECT(test, percentile(samples, 100) == 5);
+    std::vector<double> empty;
+    UNIT_EXPECT(test, percentile(empty, 50) == 0);
+}
+
+void testMannWhitney(samplesCommon::UnitTest& test)
+{
+    // The expected p-values come from U counted over all pairs of samples, a tie counting as one half, with the
+    // same normal approximation, tie correction and continuity correction.
+    test.setCase("Mann-Whitney");
+    const std::vector<double> x{0.80, 0.83, 1.89, 1.04, 1.45, 1.38, 1.91, 1.64, 0.73, 1.46};
+    const std::vector<double> y{1.15, 0.88, 0.90, 0.74, 1.21};
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue(x, y), 0.24462360512698333, 1e-12);
+    // The test is symmetric, and only depends on the order of the samples.
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue(y, x), 0.24462360512698333, 1e-12);
+    std::vector<double> logX(x.size());
+    std::vector<double> logY(y.size());
+    std::transform(x.begin(), x.end(), logX.begin(), [](double v) { return std::log(v); });
+    std::transform(y.begin(), y.end(), logY.begin(), [](double v) { return std::log(v); });
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue(logX, logY), 0.24462360512698333, 1e-12);
+
+    // Separated samples.
+    std::vector<double> low(10);
+    std::vector<double> high(10);
+    std::iota(low.begin(), low.end(), 0.0);
+    std::iota(high.begin(), high.end(), 10.0);
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue(low, high), 0.0001826717911095504, 1e-15);
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue({1, 2, 3}, {4}), 0.37109336952269767, 1e-12);
+    // Identical samples.
+    UNIT_EXPECT(test, mannWhitneyPValue(low, low) == 1);
+
+    test.setCase("Mann-Whitney ties");
+    UNIT_EXPECT_NEAR(test, mannWhitneyPValue({1, 2, 2, 3, 3, 3, 4}, {3, 4, 4, 5, 5, 6}), 0.012999854364387314, 1e-12);
+    // All samples tied: there is no evidence of a difference.
+    UNIT_EXPECT(test, mannWhitneyPValue({5, 5, 5}, {5, 5}) == 1);
+
+    test.setCase("Mann-Whitney empty sides");
+    UNIT_EXPECT(test, mannWhitneyPValue({}, {1, 2, 3}) == 1);
+    UNIT_EXPECT(test, mannWhitneyPValue({1, 2, 3}, {}) == 1);
+    UNIT_EXPECT(test, mannWhitneyPValue({}, {}) == 1);
+}
+
+void testBootstrap(samplesCommon::UnitTest& test)
+{
+    test.setCase("bootstrap");
+    // Constant samples have a single possible change.
+    const Interval constant = bootstrapRelativeChange({10, 10, 10}, {12, 12}, 50, 0.95, 100, 1);
+    UNIT_EXPECT_NEAR(test, constant.low, 0.2, 1e-12);
+    UNIT_EXPECT_NEAR(test, constant.high, 0.2, 1e-12);
+
+    // Candidate latencies 10% above the baseline.
+    std::mt19937 generator(11);
+    std::lognormal_distribution<double> latency(0.0, 0.25);
+    std::vector<double> baseline(2000);
+    std::vector<double> candidate(2000);
+    for (auto& v : baseline)
+    {
+        v = latency(generator);
+    }
+    for (auto& v : candidate)
+    {
+        v = 1.1 * latency(generator);
+    }
+    const Interval median = bootstrapRelativeChange(baseline, candidate, 50, 0.95, 500, 7);
+    UNIT_EXPECT(test, median.low < 0.1 && median.high > 0.1);
+    UNIT_EXPECT(test, median.low > 0.05 && median.high < 0.15);
+
+    // The interval is reproducible from the seed, and grows with the confidence.
+    const Interval again = bootstrapRelativeChange(baseline, candidate, 50, 0.95, 500, 7);
+    UNIT_EXPECT(test, again.low == median.low && again.high == median.high);
+    const Interval narrow = bootstrapRelativeChange(baseline, candidate, 50, 0.5, 500, 7);
+    UNIT_EXPECT(test, narrow.low >= median.low && narrow.high <= median.high);
+    UNIT_EXPECT(test, narrow.high - narrow.low < median.high - median.low);
+
+    test.setCase("bootstrap degenerate");
+    const Interval none{};
+    for (const Interval& interval : {bootstrapRelativeChange({}, candidate, 50, 0.95, 100, 1),
+             bootstrapRelativeChange(baseline, {}, 50, 0.95, 100, 1),
+             bootstrapRelativeChange(baseline, candidate, 50, 0.95, 0, 1),
+             bootstrapRelativeChange({0, 0}, {1, 2}, 50, 0.95, 100, 1)})
+    {
+        UNIT_EXPECT(test, interval.low == none.low && interval.high == none.high);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.compare_stats_test", argc, argv);
+    testPercentile(test);
+    testMannWhitney(test);
+    testBootstrap(test);
+    return test.report();
+}
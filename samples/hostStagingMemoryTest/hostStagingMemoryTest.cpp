@@ -0,0 +1,313 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! hostStagingMemoryTest.cpp
+//! This file contains the unit test of HostStagingMemory of hostStagingMemory.h, which allocates the host buffers of
+//! a BufferManager. Page-locked memory is allocated by a stand-in of CUDA with a limited capacity, so the test checks
+//! the policy, the accounting and the fallback to pageable memory without TensorRT or a GPU.
+//! It can be run with the following command line:
+//! Command: ./host_staging_memory_test
+//!
+
+#include "hostStagingMemory.h"
+#include "unitTest.h"
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+//!
+//! \brief The FakeHostMemoryAllocator class allocates all types of memory with malloc, but fails page-locked
+//!        allocations beyond a capacity, as cudaHostAlloc does when the page-locked memory is exhausted.
+//!
+class FakeHostMemoryAllocator : public IHostMemoryAllocator
+{
+public:
+    explicit FakeHostMemoryAllocator(size_t pageLockedCapacity, bool failPageable = false)
+        : mCapacity(pageLockedCapacity)
+        , mFailPageable(failPageable)
+    {
+    }
+
+    void* allocate(size_t size, HostMemoryType type) override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const bool pageLocked = type != HostMemoryType::kPAGEABLE;
+        if (pageLocked ? mPageLockedBytes + size > mCapacity : mFailPageable)
+        {
+            return nullptr;
+        }
+        void* ptr = malloc(size);
+        mBlocks[ptr] = std::make_pair(type, size);
+        mPageLockedBytes += pageLocked ? size : 0;
+        return ptr;
+    }
+
+    void free(void* ptr, HostMemoryType type) override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mBlocks.find(ptr);
+        if (found == mBlocks.end() || found->second.first != type)
+        {
+            ++mBadFrees;
+            return;
+        }
+        mPageLockedBytes -= type != HostMemoryType::kPAGEABLE ? found->second.second : 0;
+        mBlocks.erase(found);
+        ::free(ptr);
+    }
+
+    //! Returns the type the buffer was allocated with, or -1 if it is not allocated.
+    int getType(void* ptr)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto found = mBlocks.find(ptr);
+        return found == mBlocks.end() ? -1 : static_cast<int>(found->second.first);
+    }
+
+    size_t getLiveBlocks()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mBlocks.size();
+    }
+
+    //! Returns the number of frees of unknown buffers, or with another type than they were allocated with.
+    int getBadFrees()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mBadFrees;
+    }
+
+private:
+    size_t mCapacity;
+    bool mFailPageable;
+    std::mutex mMutex;
+    std::unordered_map<void*, std::pair<HostMemoryType, size_t>> mBlocks;
+    size_t mPageLockedBytes{0};
+    int mBadFrees{0};
+};
+
+constexpr int kPAGEABLE = static_cast<int>(HostMemoryType::kPAGEABLE);
+constexpr int kPINNED = static_cast<int>(HostMemoryType::kPINNED);
+constexpr int kWRITE_COMBINED = static_cast<int>(HostMemoryType::kWRITE_COMBINED);
+
+void testPolicies(UnitTest& test)
+{
+    test.setCase("policies");
+    const auto allocator = std::make_shared<FakeHostMemoryAllocator>(1 << 20);
+    for (const HostMemoryType policy : {HostMemoryType::kPAGEABLE, HostMemoryType::kPINNED})
+    {
+        HostStagingMemory memory(policy, allocator);
+        UNIT_EXPECT(test, memory.getPolicy() == policy);
+        UNIT_EXPECT(test, memory.getType(true) == policy && memory.getType(false) == policy);
+    }
+    // The host does not read inputs, but reads outputs, which must not be write-combined.
+    HostStagingMemory memory(HostMemoryType::kWRITE_COMBINED, allocator);
+    UNIT_EXPECT(test, memory.getType(true) == HostMemoryType::kWRITE_COMBINED);
+    UNIT_EXPECT(test, memory.getType(false) == HostMemoryType::kPINNED);
+
+    void* input = memory.allocate(100, true);
+    void* output = memory.allocate(200, false);
+    UNIT_EXPECT(test, allocator->getType(input) == kWRITE_COMBINED);
+    UNIT_EXPECT(test, allocator->getType(output) == kPINNED);
+    memory.free(input);
+    memory.free(output);
+    UNIT_EXPECT(test, allocator->getLiveBlocks() == 0);
+    UNIT_EXPECT(test, allocator->getBadFrees() == 0);
+}
+
+void testAccounting(UnitTest& test)
+{
+    test.setCase("accounting");
+    const auto allocator = std::make_shared<FakeHostMemoryAllocator>(1 << 20);
+    HostStagingMemory memory(HostMemoryType::kWRITE_COMBINED, allocator);
+    void* a = memory.allocate(1000, true);
+    void* b = memory.allocate(300, false);
+    void* c = memory.allocate(500, false);
+    HostMemoryStats stats = memory.getStats();
+    UNIT_EXPECT(test, stats.bytes[kWRITE_COMBINED] == 1000 && stats.bytes[kPINNED] == 800);
+    UNIT_EXPECT(test, stats.bytes[kPAGEABLE] == 0);
+    UNIT_EXPECT(test, stats.allocations[kWRITE_COMBINED] == 1 && stats.allocations[kPINNED] == 2);
+    UNIT_EXPECT(test, stats.fallbacks == 0);
+
+    // Freeing lowers the bytes but not the high-water marks.
+    memory.free(b);
+    memory.free(a);
+    void* d = memory.allocate(100, false);
+    stats = memory.getStats();
+    UNIT_EXPECT(test, stats.bytes[kWRITE_COMBINED] == 0 && stats.bytes[kPINNED] == 600);
+    UNIT_EXPECT(test, stats.peakBytes[kWRITE_COMBINED] == 1000 && stats.peakBytes[kPINNED] == 800);
+    UNIT_EXPECT(test, stats.allocations[kPINNED] == 3);
+    memory.free(c);
+    memory.free(d);
+    memory.free(nullptr);
+    stats = memory.getStats();
+    UNIT_EXPECT(test, stats.bytes[kPINNED] == 0 && stats.peakBytes[kPINNED] == 800);
+    UNIT_EXPECT(test, allocator->getLiveBlocks() == 0);
+
+    test.setCase("zero sized buffers");
+    // Zero sized bindings still get distinct addresses, accounted for one byte each.
+    void* e = memory.allocate(0, true);
+    void* f = memory.allocate(0, true);
+    UNIT_EXPECT(test, e && f && e != f);
+    UNIT_EXPECT(test, memory.getStats().bytes[kWRITE_COMBINED] == 2);
+    memory.free(e);
+    memory.free(f);
+    UNIT_EXPECT(test, allocator->getBadFrees() == 0);
+}
+
+void testFallback(UnitTest& test)
+{
+    test.setCase("fallback to pageable memory");
+    const auto allocator = std::make_shared<FakeHostMemoryAllocator>(1000);
+    HostStagingMemory memory(HostMemoryType::kPINNED, allocator);
+    void* a = memory.allocate(600, true);
+    void* b = memory.allocate(600, false);
+    UNIT_EXPECT(test, allocator->getType(a) == kPINNED);
+    UNIT_EXPECT(test, allocator->getType(b) == kPAGEABLE);
+    HostMemoryStats stats = memory.getStats();
+    UNIT_EXPECT(test, stats.bytes[kPINNED] == 600 && stats.bytes[kPAGEABLE] == 600);
+    UNIT_EXPECT(test, stats.fallbacks == 1);
+
+    // The buffer that fell back is freed as pageable memory, which makes room for page-locked memory again.
+    memory.free(b);
+    memory.free(a);
+    UNIT_EXPECT(test, allocator->getBadFrees() == 0);
+    void* c = memory.allocate(1000, true);
+    UNIT_EXPECT(test, allocator->getType(c) == kPINNED);
+    memory.free(c);
+    UNIT_EXPECT(test, memory.getStats().fallbacks == 1);
+
+    test.setCase("out of memory");
+    const auto exhausted = std::make_shared<FakeHostMemoryAllocator>(0, true);
+    HostStagingMemory empty(HostMemoryType::kPINNED, exhausted);
+    UNIT_EXPECT(test, empty.allocate(10, true) == nullptr);
+    stats = empty.getStats();
+    UNIT_EXPECT(test, stats.allocations[kPINNED] == 0 && stats.allocations[kPAGEABLE] == 0);
+    UNIT_EXPECT(test, stats.fallbacks == 0);
+}
+
+void testDeleter(UnitTest& test)
+{
+    test.setCase("deleter keeps the memory alive");
+    const auto allocator = std::make_shared<FakeHostMemoryAllocator>(1 << 20);
+    auto memory = std::make_shared<HostStagingMemory>(HostMemoryType::kPINNED, allocator);
+    const std::weak_ptr<HostStagingMemory> weak = memory;
+    {
+        std::unique_ptr<void, HostStagingDeleter> buffer(memory->allocate(64, true), HostStagingDeleter{memory});
+        memory.reset();
+        UNIT_EXPECT(test, !weak.expired());
+        UNIT_EXPECT(test, allocator->getLiveBlocks() == 1);
+    }
+    UNIT_EXPECT(test, weak.expired());
+    UNIT_EXPECT(test, allocator->getLiveBlocks() == 0);
+    UNIT_EXPECT(test, allocator->getBadFrees() == 0);
+}
+
+void testThreads(UnitTest& test)
+{
+    test.setCase("shared by threads");
+    // Several BufferManager instances on different threads share one HostStagingMemory.
+    const auto allocator = std::make_shared<FakeHostMemoryAllocator>(32 * 1024);
+    HostStagingMemory memory(HostMemoryType::kPINNED, allocator);
+    constexpr int kTHREADS = 4;
+    constexpr int kROUNDS = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kTHREADS; ++t)
+    {
+        threads.emplace_back([&memory, t]() {
+            std::vector<void*> buffers;
+            for (int r = 0; r < kROUNDS; ++r)
+            {
+                buffers.push_back(memory.allocate(1024 + 16 * ((r + t) % 64), r % 2));
+                if (buffers.size() == 8)
+                {
+                    for (void* buffer : buffers)
+                    {
+                        memory.free(buffer);
+                    }
+                    buffers.clear();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const HostMemoryStats stats = memory.getStats();
+    UNIT_EXPECT(test, stats.bytes[kPINNED] == 0 && stats.bytes[kPAGEABLE] == 0);
+    UNIT_EXPECT(test, stats.allocations[kPINNED] + stats.allocations[kPAGEABLE] == kTHREADS * kROUNDS);
+    UNIT_EXPECT(test, stats.allocations[kPAGEABLE] == stats.fallbacks);
+    UNIT_EXPECT(test, stats.peakBytes[kPINNED] <= 32 * 1024);
+    UNIT_EXPECT(test, allocator->getLiveBlocks() == 0);
+    UNIT_EXPECT(test, allocator->getBadFrees() == 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    UnitTest test("TensorRT.host_staging_memory_test", argc, argv);
+    testPolicies(test);
+    testAccounting(test);
+    testFallback(test);
+    testDeleter(test);
+    testThreads(test);
+    return test.report();
+}
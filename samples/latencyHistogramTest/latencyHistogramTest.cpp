@@ -0,0 +1,232 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! latencyHistogramTest.cpp
+//! This file contains the unit test of samplesCommon::LatencyHistogram. On several seeded distributions, it compares
+//! percentile() and summarize() to the nearest rank of the sorted values, within the relative error bound of 1/256,
+//! and checks that merging histograms of parts of the values gives the histogram of all of them. It needs neither
+//! TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./latency_histogram_test
+//!
+
+#include "latencyHistogram.h"
+#include "unitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using Generator = std::function<double(std::mt19937&)>;
+
+const double kPERCENTAGES[] = {0, 0.1, 1, 10, 25, 50, 75, 90, 95, 99, 99.9, 99.99, 100};
+const int kNB_VALUES = 100000;
+
+//! A bucket is reported by its middle, at most half a width of 1/128 of its lower bound away from any of its values,
+//! and values are rounded to the nanosecond.
+double tolerance(double exact)
+{
+    return exact / 256 + 1e-6;
+}
+
+//! Returns the value of rank ceil(percentage / 100 * n), from 1 to n, of sorted values, like the histogram.
+double nearestRank(const std::vector<double>& sorted, double percentage)
+{
+    const uint64_t count = sorted.size();
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentage / 100 * count)));
+    return sorted[rank - 1];
+}
+
+struct Distribution
+{
+    Distribution(const std::string& name, const Generator& generate)
+        : name(name)
+        , generate(generate)
+    {
+    }
+
+    std::string name;
+    Generator generate; //!< Draws a latency in milliseconds
+};
+
+std::vector<Distribution> distributions()
+{
+    return {Distribution("uniform", [](std::mt19937& g) { return std::uniform_real_distribution<double>(0.1, 10)(g); }),
+        Distribution("exponential", [](std::mt19937& g) { return std::exponential_distribution<double>(0.5)(g); }),
+        Distribution("lognormal", [](std::mt19937& g) { return std::lognormal_distribution<double>(0, 1)(g); }),
+        Distribution("bimodal",
+            [](std::mt19937& g) {
+                // Mostly fast inferences, with a tail of slow ones an order of magnitude later.
+                const bool slow = std::uniform_real_distribution<double>(0, 1)(g) < 0.1;
+                return std::max(0.0, slow ? std::normal_distribution<double>(20, 1)(g)
+                                          : std::normal_distribution<double>(1, 0.05)(g));
+            }),
+        Distribution("log-uniform over 8 decades",
+            [](std::mt19937& g) { return std::pow(10.0, std::uniform_real_distribution<double>(-4, 4)(g)); }),
+        Distribution("sub-microsecond",
+            [](std::mt19937& g) { return std::uniform_real_distribution<double>(0, 1e-3)(g); }),
+        Distribution("constant", [](std::mt19937&) { return 2.5; })};
+}
+
+void expectSummary(samplesCommon::UnitTest& test, const samplesCommon::LatencySummary& summary,
+    const std::vector<double>& sorted, double walltime)
+{
+    double sum{0};
+    for (const double v : sorted)
+    {
+        sum += v;
+    }
+    const double mean = sum / sorted.size();
+    double squares{0};
+    for (const double v : sorted)
+    {
+        squares += (v - mean) * (v - mean);
+    }
+    const double stddev = std::sqrt(squares / sorted.size());
+
+    UNIT_EXPECT(test, summary.count == sorted.size());
+    UNIT_EXPECT(test, summary.min == sorted.front());
+    UNIT_EXPECT(test, summary.max == sorted.back());
+    UNIT_EXPECT_NEAR(test, summary.mean, mean, 1e-9 * sorted.back());
+    // The histogram computes the deviation from the sum of squares, which loses a few digits.
+    UNIT_EXPECT_NEAR(test, summary.stddev, stddev, 1e-6 * sorted.back());
+    UNIT_EXPECT_NEAR(test, summary.p50, nearestRank(sorted, 50), tolerance(nearestRank(sorted, 50)));
+    UNIT_EXPECT_NEAR(test, summary.p90, nearestRank(sorted, 90), tolerance(nearestRank(sorted, 90)));
+    UNIT_EXPECT_NEAR(test, summary.p95, nearestRank(sorted, 95), tolerance(nearestRank(sorted, 95)));
+    UNIT_EXPECT_NEAR(test, summary.p99, nearestRank(sorted, 99), tolerance(nearestRank(sorted, 99)));
+    UNIT_EXPECT_NEAR(test, summary.p999, nearestRank(sorted, 99.9), tolerance(nearestRank(sorted, 99.9)));
+    UNIT_EXPECT_NEAR(test, summary.throughput, sorted.size() * 1000.0 / walltime, 1e-9 * summary.throughput);
+}
+
+void testAccuracy(samplesCommon::UnitTest& test, const Distribution& distribution, unsigned seed)
+{
+    test.setCase(distribution.name + " accuracy");
+    std::mt19937 generator(seed);
+    samplesCommon::LatencyHistogram histogram;
+    std::vector<double> values;
+    for (int i = 0; i < kNB_VALUES; ++i)
+    {
+        values.push_back(distribution.generate(generator));
+        histogram.record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    double worst{0};
+    for (const double percentage : kPERCENTAGES)
+    {
+        const double exact = nearestRank(values, percentage);
+        const double reported = histogram.percentile(percentage);
+        UNIT_EXPECT_NEAR(test, reported, exact, tolerance(exact));
+        worst = std::max(worst, std::fabs(reported - exact) / tolerance(exact));
+    }
+    UNIT_EXPECT(test, histogram.percentile(0) == values.front());
+    UNIT_EXPECT(test, histogram.percentile(100) == values.back());
+    gLogInfo << distribution.name << ": worst error of the percentiles " << worst * 100 << "% of the bound"
+             << std::endl;
+
+    expectSummary(test, histogram.summarize(1000), values, 1000);
+}
+
+void testMerge(samplesCommon::UnitTest& test, const Distribution& distribution, unsigned seed)
+{
+    test.setCase(distribution.name + " merge");
+    std::mt19937 generator(seed);
+    samplesCommon::LatencyHistogram whole;
+    std::vector<samplesCommon::LatencyHistogram> parts(3);
+    std::vector<double> values;
+    for (int i = 0; i < kNB_VALUES; ++i)
+    {
+        values.push_back(distribution.generate(generator));
+        whole.record(values.back());
+        // Uneven parts, like the streams of a run
+        parts[std::uniform_int_distribution<int>(0, 5)(generator) % 3].record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    samplesCommon::LatencyHistogram merged;
+    merged.merge(samplesCommon::LatencyHistogram());
+    for (const auto& part : parts)
+    {
+        merged.merge(part);
+    }
+    merged.merge(samplesCommon::LatencyHistogram());
+
+    UNIT_EXPECT(test, merged.count() == whole.count());
+    for (const double percentage : kPERCENTAGES)
+    {
+        UNIT_EXPECT(test, merged.percentile(percentage) == whole.percentile(percentage));
+    }
+    expectSummary(test, merged.summarize(500), values, 500);
+
+    merged.reset();
+    UNIT_EXPECT(test, merged.count() == 0);
+    UNIT_EXPECT(test, merged.percentile(50) == 0);
+    UNIT_EXPECT(test, merged.summarize().max == 0);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.latency_histogram_test", argc, argv);
+    unsigned seed = 1;
+    for (const auto& distribution : distributions())
+    {
+        testAccuracy(test, distribution, seed++);
+        testMerge(test, distribution, seed++);
+    }
+    return test.report();
+}
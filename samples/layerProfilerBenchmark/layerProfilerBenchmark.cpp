@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! layerProfilerBenchmark.cpp
+//! This file contains a CPU benchmark of the cost of IProfiler::reportLayerTime(), for the SimpleProfiler and the
+//! LayerProfiler, fed with the same synthetic layer names and times in the order TensorRT reports them.
+//! It can be run with the following command line:
+//! Command: ./layer_profiler_benchmark [--layers=N] [--iterations=N]
+//!
+
+#include "common.h"
+#include "getOptions.h"
+#include "layerProfiler.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.layer_profiler_benchmark";
+
+//!
+//! \brief The BenchmarkOptions structure groups the command line options of the benchmark.
+//!
+struct BenchmarkOptions
+{
+    int layers{200};       //!< Number of layers of the synthetic network
+    int iterations{1000};  //!< Number of inferences reported
+    int hotspots{5};       //!< Number of layers printed from the LayerProfiler
+};
+
+//!
+//! \brief Reports every layer of every inference to a profiler and returns the average cost of a report in ns.
+//!
+//! \details Names and times are generated before the clock starts, so only the profiler is measured.
+//!
+double feed(nvinfer1::IProfiler& profiler, const std::vector<std::string>& names, const std::vector<float>& times,
+    int iterations)
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        const float* time = &times[(i % 16) * names.size()];
+        for (size_t l = 0; l < names.size(); ++l)
+        {
+            profiler.reportLayerTime(names[l].c_str(), time[l]);
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(iterations) * names.size());
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./layer_profiler_benchmark [options]" << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    const std::vector<TRTOption> optionList = {
+        {0, "layers", true, "Number of layers of the synthetic network (default = 200)"},
+        {0, "iterations", true, "Number of inferences reported (default = 1000)"},
+        {0, "hotspots", true, "Number of slowest layers to print (default = 5)"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kLAYERS, kITERATIONS, kHOTSPOTS, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    try
+    {
+        if (parsed.values[kLAYERS].first)
+        {
+            options.layers = std::stoi(value(kLAYERS));
+        }
+        if (parsed.values[kITERATIONS].first)
+        {
+            options.iterations = std::stoi(value(kITERATIONS));
+        }
+        if (parsed.values[kHOTSPOTS].first)
+        {
+            options.hotspots = std::stoi(value(kHOTSPOTS));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (options.layers < 1 || options.iterations < 1 || options.hotspots < 0)
+    {
+        gLogError << "Please provide positive counts" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    // Names as long as those of fused TensorRT layers, and log-normal times that differ across inferences.
+    std::vector<std::string> names;
+    for (int l = 0; l < options.layers; ++l)
+    {
+        names.push_back("(Unnamed Layer* " + std::to_string(l) + ") [Convolution] + (Unnamed Layer* "
+            + std::to_string(l) + ") [Activation]");
+    }
+    std::mt19937 generator(1);
+    std::lognormal_distribution<float> time(-3, 1);
+    std::vector<float> times(16 * names.size());
+    std::generate(times.begin(), times.end(), [&]() { return time(generator); });
+
+    gLogInfo << options.layers << " layers, " << options.iterations << " inferences" << std::endl;
+    SimpleProfiler simple("Simple");
+    const double simpleCost = feed(simple, names, times, options.iterations);
+    gLogInfo << "SimpleProfiler: " << simpleCost << " ns per layer report" << std::endl;
+    samplesCommon::LayerProfiler indexed("Indexed");
+    const double indexedCost = feed(indexed, names, times, options.iterations);
+    gLogInfo << "LayerProfiler: " << indexedCost << " ns per layer report (" << simpleCost / indexedCost
+             << "x faster)" << std::endl;
+    indexed.printHotspots(gLogInfo, options.hotspots);
+
+    return gLogger.reportPass(toolTest);
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! mnistBatchStreamBenchmark.cpp
+//! This file contains a CPU benchmark that makes a pass over an MNIST training set with MNISTBatchStream, which
+//! maps the IDX files and converts one batch at a time, and with the former stream, which expanded the whole image
+//! file to floats up front, and reports the peak resident memory of both.
+//! It can be run with the following command line:
+//! Command: ./mnist_batch_stream_benchmark [--images=N] [--batchSize=N] [--datadir=<directory>]
+//!
+
+#include "BatchStream.h"
+#include "getOptions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#ifndef _MSC_VER
+#include <sys/resource.h>
+#endif
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.mnist_batch_stream_benchmark";
+
+const std::string kIMAGES_FILE = "train-images-idx3-ubyte";
+const std::string kLABELS_FILE = "train-labels-idx1-ubyte";
+
+//!
+//! \brief The BenchmarkOptions structure groups the command line options of the benchmark.
+//!
+struct BenchmarkOptions
+{
+    int images{60000};   //!< Number of images of the synthetic training set
+    int batchSize{32};   //!< Number of images per batch
+    std::string dataDir; //!< Directory of the MNIST training set, if not synthetic
+};
+
+//!
+//! \brief Returns the peak resident set size of the process in MB, or a negative value if it is not known.
+//!
+double peakRssMB()
+{
+#ifdef _MSC_VER
+    return -1.0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // Linux reports kilobytes.
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+//!
+//! \brief  The EagerMNISTBatchStream class is the former MNISTBatchStream, kept for comparison: it reads the whole
+//!         IDX files and expands them to floats when it is constructed.
+//!
+class EagerMNISTBatchStream : public IBatchStream
+{
+public:
+    EagerMNISTBatchStream(int batchSize, int maxBatches, const std::string& dataFile, const std::string& labelsFile)
+        : mBatchSize{batchSize}
+        , mMaxBatches{maxBatches}
+    {
+        readDataFile(dataFile);
+        readLabelsFile(labelsFile);
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = firstBatch;
+    }
+
+    bool next() override
+    {
+        if (mBatchCount >= mMaxBatches)
+        {
+            return false;
+        }
+        ++mBatchCount;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mBatchCount += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return mData.data() + (mBatchCount * mBatchSize * samplesCommon::volume(getImageDims()));
+    }
+
+    float* getLabels() override
+    {
+        return mLabels.data() + (mBatchCount * mBatchSize);
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return nvinfer1::Dims3{1, 28, 28};
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return nvinfer1::Dims3{1, 28, 28};
+    }
+
+private:
+    static int readHeader(std::ifstream& file)
+    {
+        int value{0};
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return samplesCommon::swapEndianness(value);
+    }
+
+    void readDataFile(const std::string& dataFilePath)
+    {
+        std::ifstream file{dataFilePath, std::ios::binary};
+        readHeader(file);
+        const int numImages = readHeader(file);
+        const int imageH = readHeader(file);
+        const int imageW = readHeader(file);
+        const int numElements = numImages * imageH * imageW;
+        std::vector<uint8_t> rawData(numElements);
+        file.read(reinterpret_cast<char*>(rawData.data()), numElements);
+        mData.resize(numElements);
+        std::transform(
+            rawData.begin(), rawData.end(), mData.begin(), [](uint8_t val) { return static_cast<float>(val) / 255.f; });
+    }
+
+    void readLabelsFile(const std::string& labelsFilePath)
+    {
+        std::ifstream file{labelsFilePath, std::ios::binary};
+        readHeader(file);
+        const int numImages = readHeader(file);
+        std::vector<uint8_t> rawLabels(numImages);
+        file.read(reinterpret_cast<char*>(rawLabels.data()), numImages);
+        mLabels.resize(numImages);
+        std::transform(
+            rawLabels.begin(), rawLabels.end(), mLabels.begin(), [](uint8_t val) { return static_cast<float>(val); });
+    }
+
+    int mBatchSize{0};
+    int mBatchCount{0};
+    int mMaxBatches{0};
+    std::vector<float> mData;
+    std::vector<float> mLabels;
+};
+
+//! Returns the number of images of an IDX image file.
+int readImageCount(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    int header[2]{};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    return file ? samplesCommon::swapEndianness(header[1]) : 0;
+}
+
+//! Writes a big endian header value.
+void writeHeader(std::ofstream& file, int value)
+{
+    value = samplesCommon::swapEndianness(value);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//!
+//! \brief Writes a synthetic training set of random images and labels in the IDX format of MNIST.
+//!
+bool writeSyntheticSet(int images)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> pixel(0, 255);
+    std::uniform_int_distribution<int> label(0, 9);
+    std::ofstream imagesFile(kIMAGES_FILE, std::ios::binary);
+    for (const int value : {2051, images, 28, 28})
+    {
+        writeHeader(imagesFile, value);
+    }
+    std::vector<char> image(28 * 28);
+    for (int i = 0; i < images; ++i)
+    {
+        std::generate(image.begin(), image.end(), [&]() { return static_cast<char>(pixel(generator)); });
+        imagesFile.write(image.data(), image.size());
+    }
+    std::ofstream labelsFile(kLABELS_FILE, std::ios::binary);
+    for (const int value : {2049, images})
+    {
+        writeHeader(labelsFile, value);
+    }
+    for (int i = 0; i < images; ++i)
+    {
+        labelsFile.put(static_cast<char>(label(generator)));
+    }
+    return imagesFile && labelsFile;
+}
+
+//!
+//! \brief Reads every batch and label of a stream, as a calibrator does, and returns their sum.
+//!
+double pass(IBatchStream& stream)
+{
+    const int batchVolume = stream.getBatchSize() * samplesCommon::volume(stream.getImageDims());
+    double sum = 0.0;
+    stream.reset(0);
+    while (stream.next())
+    {
+        const float* batch = stream.getBatch();
+        const float* labels = stream.getLabels();
+        sum += std::accumulate(batch, batch + batchVolume, 0.0);
+        sum += std::accumulate(labels, labels + stream.getBatchSize(), 0.0);
+    }
+    return sum;
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./mnist_batch_stream_benchmark [options]" << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    const std::vector<TRTOption> optionList = {
+        {0, "images", true, "Number of images of the synthetic training set (default = 60000)"},
+        {0, "batchSize", true, "Number of images per batch (default = 32)"},
+        {0, "datadir", true, "Directory of " + kIMAGES_FILE + " and " + kLABELS_FILE + ", instead of a synthetic set"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kIMAGES, kBATCH_SIZE, kDATADIR, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    try
+    {
+        if (parsed.values[kIMAGES].first)
+        {
+            options.images = std::stoi(value(kIMAGES));
+        }
+        if (parsed.values[kBATCH_SIZE].first)
+        {
+            options.batchSize = std::stoi(value(kBATCH_SIZE));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+    if (parsed.values[kDATADIR].first)
+    {
+        options.dataDir = value(kDATADIR);
+    }
+
+    if (options.images < 1 || options.batchSize < 1)
+    {
+        gLogError << "Please provide positive counts" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    const bool synthetic = options.dataDir.empty();
+    if (synthetic && !writeSyntheticSet(options.images))
+    {
+        gLogError << "Could not write the synthetic training set" << std::endl;
+        return gLogger.reportFail(toolTest);
+    }
+    const std::vector<std::string> directories{synthetic ? "./" : options.dataDir};
+    const std::string imagesFile = locateFile(kIMAGES_FILE, directories);
+    const std::string labelsFile = locateFile(kLABELS_FILE, directories);
+    const double baseline = peakRssMB();
+
+    // The peak of a process never decreases, so the stream with the lower peak is measured first.
+    // Both streams return the batch after the one next() counted, so one whole batch is kept in reserve: the former
+    // stream read past its data otherwise.
+    const int batches = readImageCount(imagesFile) / options.batchSize - 1;
+    if (batches < 1)
+    {
+        gLogError << "The training set holds less than two batches" << std::endl;
+        return gLogger.reportFail(toolTest);
+    }
+    double lazySum{0.0};
+    double lazyPeak{0.0};
+    {
+        MNISTBatchStream stream(options.batchSize, batches, kIMAGES_FILE, kLABELS_FILE, directories);
+        lazySum = pass(stream);
+        lazyPeak = peakRssMB();
+    }
+    double eagerSum{0.0};
+    double eagerPeak{0.0};
+    {
+        EagerMNISTBatchStream stream(options.batchSize, batches, imagesFile, labelsFile);
+        eagerSum = pass(stream);
+        eagerPeak = peakRssMB();
+    }
+    if (synthetic)
+    {
+        std::remove(kIMAGES_FILE.c_str());
+        std::remove(kLABELS_FILE.c_str());
+    }
+
+    gLogInfo << "One pass over " << batches << " batches of " << options.batchSize << " images" << std::endl;
+    if (baseline >= 0.0)
+    {
+        gLogInfo << "Peak RSS of the process before the streams: " << baseline << " MB" << std::endl;
+        gLogInfo << "Peak RSS before (eager float expansion): " << eagerPeak << " MB" << std::endl;
+        gLogInfo << "Peak RSS after (mapped uint8, converted per batch): " << lazyPeak << " MB" << std::endl;
+    }
+    else
+    {
+        gLogWarning << "The peak RSS is not measured on this platform" << std::endl;
+    }
+    if (lazySum != eagerSum)
+    {
+        gLogError << "The batches differ: their sums are " << lazySum << " and " << eagerSum << std::endl;
+        return gLogger.reportFail(toolTest);
+    }
+    return gLogger.reportPass(toolTest);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! npyFileTest.cpp
+//! This file contains the unit test of the .npy reader and writer of npyFile.h. It round-trips arrays of every data
+//! type through files, reads headers of versions 2.0 and 3.0 and headers of other writers, and checks that files in
+//! Fortran order, of another data type or of another size are rejected. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./npy_file_test
+//!
+
+#include "npyFile.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+const std::string kFILE_NAME = "npy_file_test.npy";
+
+//! Writes bytes to the test file.
+bool writeFile(const std::string& bytes)
+{
+    std::ofstream file(kFILE_NAME, std::ios::binary);
+    file.write(bytes.data(), bytes.size());
+    return static_cast<bool>(file);
+}
+
+//! Returns the bytes of a file with the given header dictionary and data, with a header of the given major version.
+std::string makeFile(int major, const std::string& dict, const std::string& data)
+{
+    std::string header = dict;
+    header.push_back('\n');
+    std::string file(kNPY_MAGIC, kNPY_MAGIC_SIZE);
+    file.push_back(static_cast<char>(major));
+    file.push_back('\x00');
+    const int lengthBytes = major >= 2 ? 4 : 2;
+    for (int b = 0; b < lengthBytes; ++b)
+    {
+        file.push_back(static_cast<char>((header.size() >> (8 * b)) & 0xFF));
+    }
+    return file + header + data;
+}
+
+template <typename T>
+std::string bytesOf(const std::vector<T>& values)
+{
+    return std::string(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+void testRoundTrip(
+    UnitTest& test, nvinfer1::DataType type, const std::vector<T>& values, const std::vector<int64_t>& shape)
+{
+    const std::string descr = npyDescr(type);
+    test.setCase("round trip of " + descr + " with " + std::to_string(shape.size()) + " dimensions");
+    UNIT_EXPECT(test, writeNpy(kFILE_NAME, descr, shape, values.data(), values.size() * sizeof(T)));
+
+    std::ifstream file(kFILE_NAME, std::ios::binary);
+    NpyHeader header;
+    UNIT_EXPECT(test, readNpyHeader(file, header));
+    UNIT_EXPECT(test, header.descr == descr);
+    UNIT_EXPECT(test, !header.fortranOrder);
+    UNIT_EXPECT(test, header.shape == shape);
+    // The data is aligned for memory mapping.
+    UNIT_EXPECT(test, header.dataOffset % 64 == 0);
+
+    std::vector<T> read(values.size());
+    std::vector<int64_t> readShape;
+    UNIT_EXPECT(test, readNpy(kFILE_NAME, descr, read.data(), read.size() * sizeof(T), readShape));
+    UNIT_EXPECT(test, read == values);
+    UNIT_EXPECT(test, readShape == shape);
+}
+
+void testRoundTrips(UnitTest& test)
+{
+    testRoundTrip<float>(test, nvinfer1::DataType::kFLOAT, {1.5F, -2.25F, 0.0F, 3.0e38F, -1.0e-38F, 7.0F}, {2, 3});
+    // Half precision values are handled as their bit patterns: 1, -2, the largest and the smallest subnormal.
+    testRoundTrip<uint16_t>(test, nvinfer1::DataType::kHALF, {0x3C00, 0xC000, 0x7BFF, 0x0001}, {4});
+    testRoundTrip<int8_t>(test, nvinfer1::DataType::kINT8, {-128, -1, 0, 1, 127, 42, 7, -7}, {2, 2, 2});
+    testRoundTrip<int32_t>(test, nvinfer1::DataType::kINT32, {INT32_MIN, -1, 0, INT32_MAX}, {1, 4, 1});
+    testRoundTrip<float>(test, nvinfer1::DataType::kFLOAT, {42.0F}, {});
+    // A shape long enough for the header to need more than one 64 byte line
+    testRoundTrip<int8_t>(test, nvinfer1::DataType::kINT8, {5}, std::vector<int64_t>(20, 1));
+}
+
+void testVersions(UnitTest& test)
+{
+    const std::vector<int32_t> values{1, 2, 3, 4, 5, 6};
+    const std::string dict = "{'descr': '<i4', 'fortran_order': False, 'shape': (3, 2), }";
+    for (const int major : {1, 2, 3})
+    {
+        test.setCase("version " + std::to_string(major) + ".0 header");
+        UNIT_EXPECT(test, writeFile(makeFile(major, dict, bytesOf(values))));
+        std::vector<int32_t> read(values.size());
+        std::vector<int64_t> shape;
+        UNIT_EXPECT(test, readNpy(kFILE_NAME, "<i4", read.data(), read.size() * sizeof(int32_t), shape));
+        UNIT_EXPECT(test, read == values);
+        UNIT_EXPECT(test, shape == std::vector<int64_t>({3, 2}));
+    }
+
+    test.setCase("version 2.0 header longer than 64 KiB");
+    std::string padded = dict;
+    padded.append(70000, ' ');
+    const std::string bytes = makeFile(2, padded, bytesOf(values));
+    NpyHeader header;
+    UNIT_EXPECT(test, parseNpyHeader(bytes.data(), bytes.size(), header));
+    UNIT_EXPECT(test, header.dataOffset == bytes.size() - values.size() * sizeof(int32_t));
+    UNIT_EXPECT(test, header.shape == std::vector<int64_t>({3, 2}));
+
+    test.setCase("unknown version");
+    const std::string future = makeFile(4, dict, bytesOf(values));
+    UNIT_EXPECT(test, !parseNpyHeader(future.data(), future.size(), header));
+}
+
+void testNumpyHeaders(UnitTest& test)
+{
+    test.setCase("headers of other writers");
+    NpyHeader header;
+    // Key order, quotes and spacing vary across writers and numpy versions.
+    const std::string reordered
+        = makeFile(1, "{\"shape\": (7,), \"fortran_order\": False, \"descr\": \"<f2\"}", std::string(14, '\0'));
+    UNIT_EXPECT(test, parseNpyHeader(reordered.data(), reordered.size(), header));
+    UNIT_EXPECT(test, header.descr == "<f2");
+    UNIT_EXPECT(test, header.shape == std::vector<int64_t>({7}));
+
+    const std::string scalar = makeFile(1, "{'descr':'|i1','fortran_order':False,'shape':()}", std::string(1, '\0'));
+    UNIT_EXPECT(test, parseNpyHeader(scalar.data(), scalar.size(), header));
+    UNIT_EXPECT(test, header.descr == "|i1");
+    UNIT_EXPECT(test, header.shape.empty());
+    UNIT_EXPECT(test, npyVolume(header.shape) == 1);
+
+    UNIT_EXPECT(test, formatNpyHeader("<f4", {3}).find("'shape': (3,)") != std::string::npos);
+    UNIT_EXPECT(test, formatNpyHeader("<f4", {2, 3}).find("'shape': (2, 3)") != std::string::npos);
+}
+
+void testRejections(UnitTest& test)
+{
+    const std::vector<float> values{1, 2, 3, 4, 5, 6};
+    std::vector<float> read(values.size());
+    std::vector<int64_t> shape;
+    const size_t size = values.size() * sizeof(float);
+
+    test.setCase("Fortran order");
+    UNIT_EXPECT(test,
+        writeFile(makeFile(1, "{'descr': '<f4', 'fortran_order': True, 'shape': (2, 3), }", bytesOf(values))));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f4", read.data(), size, shape));
+
+    test.setCase("wrong data type");
+    UNIT_EXPECT(test, writeNpy(kFILE_NAME, "<f4", {2, 3}, values.data(), size));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<i4", read.data(), size, shape));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f2", read.data(), size / 2, shape));
+    UNIT_EXPECT(test,
+        writeFile(makeFile(1, "{'descr': '>f4', 'fortran_order': False, 'shape': (2, 3), }", bytesOf(values))));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f4", read.data(), size, shape));
+
+    test.setCase("wrong size");
+    UNIT_EXPECT(test, writeNpy(kFILE_NAME, "<f4", {2, 3}, values.data(), size));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f4", read.data(), size - sizeof(float), shape));
+    std::vector<float> larger(values.size() + 1);
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f4", larger.data(), larger.size() * sizeof(float), shape));
+
+    test.setCase("truncated data");
+    UNIT_EXPECT(test, writeNpy(kFILE_NAME, "<f4", {2, 3}, values.data(), size - sizeof(float)));
+    UNIT_EXPECT(test, !readNpy(kFILE_NAME, "<f4", read.data(), size, shape));
+
+    test.setCase("malformed headers");
+    NpyHeader header;
+    const std::string valid = formatNpyHeader("<f4", {2, 3});
+    UNIT_EXPECT(test, parseNpyHeader(valid.data(), valid.size(), header));
+    UNIT_EXPECT(test, !parseNpyHeader(valid.data(), valid.size() - 1, header));
+    UNIT_EXPECT(test, !parseNpyHeader(valid.data(), 4, header));
+    for (const std::string dict : {"{'fortran_order': False, 'shape': (2, 3), }",
+             "{'descr': '<f4', 'shape': (2, 3), }", "{'descr': '<f4', 'fortran_order': False, }",
+             "{'descr': '<f4', 'fortran_order': False, 'shape': (2, x), }",
+             "{'descr': '<f4, 'fortran_order': False, 'shape': (2, 3 }"})
+    {
+        const std::string bytes = makeFile(1, dict, std::string(24, '\0'));
+        UNIT_EXPECT(test, !parseNpyHeader(bytes.data(), bytes.size(), header));
+    }
+
+    test.setCase("not a .npy file");
+    // Without the magic string, the length bytes of the header mean nothing and must not be read.
+    UNIT_EXPECT(test, writeFile(std::string("\x93NUMPZ\x02\x00\xFF\xFF\xFF\x7F", 12) + std::string(64, ' ')));
+    std::ifstream file(kFILE_NAME, std::ios::binary);
+    UNIT_EXPECT(test, !readNpyHeader(file, header));
+    UNIT_EXPECT(test, !readNpy("npy_file_test_missing.npy", "<f4", read.data(), size, shape));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    UnitTest test("TensorRT.npy_file_test", argc, argv);
+    testRoundTrips(test);
+    testVersions(test);
+    testNumpyHeaders(test);
+    testRejections(test);
+    std::remove(kFILE_NAME.c_str());
+    return test.report();
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2019, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! prefetchingBatchStreamBenchmark.cpp
+//! This file contains a CPU benchmark that reads an artificially slow stand-in stream, once directly and once
+//! through a PrefetchingBatchStream, with a fixed amount of work per batch, and shows how much loading overlaps.
+//! It can be run with the following command line:
+//! Command: ./prefetching_batch_stream_benchmark [--batches=N] [--loadTime=ms] [--computeTime=ms] [--depth=N]
+//!
+
+#include "PrefetchingBatchStream.h"
+#include "getOptions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace nvinfer1::utility;
+
+namespace
+{
+
+const std::string gToolName = "TensorRT.prefetching_batch_stream_benchmark";
+
+//!
+//! \brief The BenchmarkOptions structure groups the command line options of the benchmark.
+//!
+struct BenchmarkOptions
+{
+    int batches{32};                  //!< Number of batches of the stream
+    int batchSize{8};                 //!< Number of images per batch
+    int loadTime{20};                 //!< Milliseconds next() of the stand-in stream takes to load a batch
+    int computeTime{20};              //!< Milliseconds of work on every batch, such as a calibration step
+    std::vector<int> depths{1, 2, 4}; //!< Prefetch depths to measure
+};
+
+//!
+//! \brief  The SlowBatchStream class stands in for a stream that reads and decodes images, such as BatchStream.
+//!
+//! \details next() sleeps for the load time, then fills the batch with values that only depend on the batch
+//!          and image indices, and the labels with the batch index, so that the batches can be checked.
+//!
+class SlowBatchStream : public IBatchStream
+{
+public:
+    SlowBatchStream(int batchSize, int maxBatches, std::chrono::milliseconds loadTime)
+        : mBatchSize(batchSize)
+        , mMaxBatches(maxBatches)
+        , mLoadTime(loadTime)
+        , mBatch(batchSize * samplesCommon::volume(getImageDims()))
+        , mLabels(batchSize)
+    {
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatchCount = firstBatch;
+    }
+
+    bool next() override
+    {
+        if (mBatchCount >= mMaxBatches)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(mLoadTime);
+        for (size_t i = 0; i < mBatch.size(); ++i)
+        {
+            mBatch[i] = static_cast<float>((mBatchCount * 131 + i) % 251);
+        }
+        std::fill(mLabels.begin(), mLabels.end(), static_cast<float>(mBatchCount));
+        ++mBatchCount;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mBatchCount += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return mBatch.data();
+    }
+
+    float* getLabels() override
+    {
+        return mLabels.data();
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchCount;
+    }
+
+    int getBatchSize() const override
+    {
+        return mBatchSize;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return nvinfer1::Dims4{mBatchSize, 3, 64, 64};
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return nvinfer1::Dims3{3, 64, 64};
+    }
+
+private:
+    int mBatchSize{0};
+    int mMaxBatches{0};
+    int mBatchCount{0};
+    std::chrono::milliseconds mLoadTime;
+    std::vector<float> mBatch;
+    std::vector<float> mLabels;
+};
+
+//!
+//! \brief The RunResult structure reports a pass over a stream.
+//!
+struct RunResult
+{
+    double seconds{0};    //!< Wall time of the pass
+    int batches{0};       //!< Number of batches read
+    uint64_t checksum{0}; //!< Checksum of the batches and labels in the order they were read
+};
+
+//!
+//! \brief Reads every batch of a stream from its first one, as a calibrator does, and works on each for the
+//!        compute time.
+//!
+RunResult run(IBatchStream& stream, const BenchmarkOptions& options)
+{
+    RunResult result;
+    const auto start = std::chrono::high_resolution_clock::now();
+    stream.reset(0);
+    const size_t batchVolume = stream.getBatchSize() * samplesCommon::volume(stream.getImageDims());
+    while (stream.next())
+    {
+        const float* batch = stream.getBatch();
+        const float* labels = stream.getLabels();
+        for (size_t i = 0; i < batchVolume; i += 97)
+        {
+            result.checksum = result.checksum * 31 + static_cast<uint64_t>(batch[i]);
+        }
+        result.checksum = result.checksum * 31 + static_cast<uint64_t>(labels[0]);
+        ++result.batches;
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.computeTime));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+void printHelpInfo(const std::vector<TRTOption>& options)
+{
+    std::cout << "Usage: ./prefetching_batch_stream_benchmark [options]" << std::endl;
+    for (const auto& option : options)
+    {
+        std::cout << "  --" << option.longName << std::string(std::max<int>(1, 14 - option.longName.size()), ' ')
+                  << option.helpText << std::endl;
+    }
+}
+
+bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    const std::vector<TRTOption> optionList = {{0, "batches", true, "Number of batches of the stream (default = 32)"},
+        {0, "batchSize", true, "Number of 3x64x64 images per batch (default = 8)"},
+        {0, "loadTime", true, "Milliseconds the stand-in stream takes to load a batch (default = 20)"},
+        {0, "computeTime", true, "Milliseconds of work on every batch (default = 20)"},
+        {0, "depth", true, "Prefetch depth to measure, can be repeated (default = 1, 2 and 4)"},
+        {'h', "help", false, "Display help information"}};
+    enum OptionIndex
+    {
+        kBATCHES, kBATCH_SIZE, kLOAD_TIME, kCOMPUTE_TIME, kDEPTH, kHELP
+    };
+
+    const TRTParsedArgs parsed = getOptions(argc, argv, optionList);
+    if (!parsed.errMsg.empty())
+    {
+        gLogError << parsed.errMsg << std::endl;
+        return false;
+    }
+    if (parsed.values[kHELP].first)
+    {
+        printHelpInfo(optionList);
+        return false;
+    }
+    auto value = [&parsed](int option) { return parsed.values[option].second.back(); };
+
+    try
+    {
+        if (parsed.values[kBATCHES].first)
+        {
+            options.batches = std::stoi(value(kBATCHES));
+        }
+        if (parsed.values[kBATCH_SIZE].first)
+        {
+            options.batchSize = std::stoi(value(kBATCH_SIZE));
+        }
+        if (parsed.values[kLOAD_TIME].first)
+        {
+            options.loadTime = std::stoi(value(kLOAD_TIME));
+        }
+        if (parsed.values[kCOMPUTE_TIME].first)
+        {
+            options.computeTime = std::stoi(value(kCOMPUTE_TIME));
+        }
+        if (parsed.values[kDEPTH].first)
+        {
+            options.depths.clear();
+            for (const auto& depth : parsed.values[kDEPTH].second)
+            {
+                options.depths.push_back(std::stoi(depth));
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        gLogError << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+
+    if (options.batches < 1 || options.batchSize < 1 || options.loadTime < 0 || options.computeTime < 0
+        || std::any_of(options.depths.begin(), options.depths.end(), [](int depth) { return depth < 1; }))
+    {
+        gLogError << "Please provide positive counts and depths, and non-negative times" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto toolTest = gLogger.defineTest(gToolName, argc, argv);
+    gLogger.reportTestStart(toolTest);
+
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return gLogger.reportFail(toolTest);
+    }
+
+    gLogInfo << options.batches << " batches of " << options.batchSize << " images, " << options.loadTime
+             << " ms to load and " << options.computeTime << " ms to compute each" << std::endl;
+    const std::chrono::milliseconds loadTime(options.loadTime);
+    SlowBatchStream direct(options.batchSize, options.batches, loadTime);
+    const RunResult serial = run(direct, options);
+    gLogInfo << "direct: " << serial.seconds * 1000 / serial.batches << " ms/batch" << std::endl;
+
+    // With full overlap, a batch takes the longer of the load and compute times instead of their sum.
+    const double bound = std::max(options.loadTime, options.computeTime);
+    bool identical = true;
+    for (const int depth : options.depths)
+    {
+        PrefetchingBatchStream<SlowBatchStream> prefetching(
+            SlowBatchStream(options.batchSize, options.batches, loadTime), depth);
+        const RunResult overlapped = run(prefetching, options);
+        gLogInfo << "prefetching, depth " << depth << ": " << overlapped.seconds * 1000 / overlapped.batches
+                 << " ms/batch (" << serial.seconds / overlapped.seconds << "x, bound " << bound << " ms/batch)"
+                 << std::endl;
+        if (overlapped.batches != serial.batches || overlapped.checksum != serial.checksum)
+        {
+            gLogError << "prefetching, depth " << depth << ": read " << overlapped.batches
+                      << " batches that differ from those of the direct stream" << std::endl;
+            identical = false;
+        }
+    }
+
+    return identical ? gLogger.reportPass(toolTest) : gLogger.reportFail(toolTest);
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! rangeCalibrationTest.cpp
+//! This file contains the unit test of rangeCalibration.h, which calibrate_ranges uses to pick dynamic ranges:
+//! StreamingHistogram bins values the same however they are chunked or merged, percentileThreshold finds the
+//! percentiles of a uniform histogram, and entropyThreshold clips long tails below the maximum but keeps the whole
+//! range of a uniform distribution. The distributions are built from their quantiles, so the test is deterministic.
+//! It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./range_calibration_test
+//!
+
+#include "rangeCalibration.h"
+#include "unitTest.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+constexpr int kNB_VALUES = 200000;
+
+//! Returns the kNB_VALUES quantiles of an exponential distribution of mean 1, times scale.
+std::vector<float> exponentialValues(float scale = 1.0F)
+{
+    std::vector<float> values(kNB_VALUES);
+    for (int k = 0; k < kNB_VALUES; ++k)
+    {
+        values[k] = scale * static_cast<float>(-std::log(1.0 - (k + 0.5) / kNB_VALUES));
+    }
+    return values;
+}
+
+StreamingHistogram makeHistogram(const std::vector<float>& values, int nbBins = 2048)
+{
+    StreamingHistogram histogram(nbBins);
+    histogram.add(values.data(), values.size());
+    return histogram;
+}
+
+void testHistogram(samplesCommon::UnitTest& test)
+{
+    test.setCase("histogram");
+    const std::vector<float> values = exponentialValues();
+    const StreamingHistogram whole = makeHistogram(values);
+    UNIT_EXPECT(test, whole.getCount() == kNB_VALUES);
+    UNIT_EXPECT(test, whole.getMax() == values.back());
+    // The range is the smallest power of two above the maximum, 16.
+    UNIT_EXPECT(test, whole.getBinWidth() == 16.0F / 2048);
+
+    // Chunks in increasing order make the range grow many times; the bins must not depend on it.
+    StreamingHistogram chunked(2048);
+    StreamingHistogram first(2048);
+    StreamingHistogram second(2048);
+    for (size_t i = 0; i < values.size(); i += 1000)
+    {
+        chunked.add(values.data() + i, 1000);
+        (i < values.size() / 2 ? first : second).add(values.data() + i, 1000);
+    }
+    UNIT_EXPECT(test, chunked.getBins() == whole.getBins());
+    // Negative values count by their magnitude, and values that are not finite are ignored.
+    const float special[] = {-1.0F, INFINITY, NAN};
+    StreamingHistogram negative(2048);
+    negative.add(special, 3);
+    UNIT_EXPECT(test, negative.getCount() == 1 && negative.getMax() == 1.0F);
+
+    second.merge(first);
+    UNIT_EXPECT(test, second.getBins() == whole.getBins());
+    UNIT_EXPECT(test, second.getCount() == whole.getCount() && second.getMax() == whole.getMax());
+}
+
+void testPercentile(samplesCommon::UnitTest& test)
+{
+    test.setCase("percentile");
+    // One value in the middle of every bin of [0, 1024).
+    std::vector<float> uniform(1024);
+    for (size_t i = 0; i < uniform.size(); ++i)
+    {
+        uniform[i] = i + 0.5F;
+    }
+    const StreamingHistogram histogram = makeHistogram(uniform, 1024);
+    UNIT_EXPECT(test, histogram.getBinWidth() == 1.0F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 25) == 256.0F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 50) == 512.0F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 99.9) == 1023.0F);
+    // The threshold is a bin edge, and never above the maximum.
+    UNIT_EXPECT(test, percentileThreshold(histogram, 50.01) == 513.0F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 100) == 1023.5F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 0) == 1.0F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, 150) == 1023.5F);
+    UNIT_EXPECT(test, percentileThreshold(histogram, -5) == 1.0F);
+
+    // Percentiles of a histogram are within one bin of those of its values.
+    const std::vector<float> values = exponentialValues();
+    const StreamingHistogram exponential = makeHistogram(values);
+    for (const double percentile : {50.0, 90.0, 99.0, 99.99})
+    {
+        const float exact = values[static_cast<size_t>(std::ceil(percentile / 100 * kNB_VALUES)) - 1];
+        const float threshold = percentileThreshold(exponential, percentile);
+        UNIT_EXPECT(test, threshold >= exact && threshold <= exact + exponential.getBinWidth());
+    }
+}
+
+void testEntropy(samplesCommon::UnitTest& test)
+{
+    test.setCase("entropy long tail");
+    std::vector<float> values = exponentialValues();
+    const StreamingHistogram exponential = makeHistogram(values);
+    const float threshold = entropyThreshold(exponential);
+    // The tail is clipped, but not the bulk of the values.
+    UNIT_EXPECT(test, threshold < 0.8F * exponential.getMax());
+    UNIT_EXPECT(test, threshold > percentileThreshold(exponential, 99));
+    // With the range a power of two apart, the bins are the same and so is the threshold, scaled.
+    UNIT_EXPECT(test, entropyThreshold(makeHistogram(exponentialValues(4.0F))) == 4.0F * threshold);
+
+    // A few outliers stretch the range five times, but hardly move the threshold.
+    values.insert(values.end(), {60.0F, 61.0F, -62.0F});
+    const StreamingHistogram outliers = makeHistogram(values);
+    const float outlierThreshold = entropyThreshold(outliers);
+    UNIT_EXPECT(test, outliers.getMax() == 62.0F);
+    UNIT_EXPECT(test, outlierThreshold < outliers.getMax() / 4);
+    UNIT_EXPECT(test, outlierThreshold > percentileThreshold(outliers, 99));
+
+    test.setCase("entropy uniform");
+    // Clipping a uniform distribution only loses information: the whole range is kept.
+    std::vector<float> uniform(kNB_VALUES);
+    for (int k = 0; k < kNB_VALUES; ++k)
+    {
+        uniform[k] = (k + 0.5F) / kNB_VALUES * 10.0F;
+    }
+    const StreamingHistogram flat = makeHistogram(uniform);
+    UNIT_EXPECT_NEAR(test, entropyThreshold(flat), flat.getMax(), flat.getBinWidth());
+
+    test.setCase("entropy few bins");
+    // Histograms with no more bins than the quantized levels are kept whole.
+    const std::vector<float> tailed = exponentialValues();
+    UNIT_EXPECT(test, entropyThreshold(makeHistogram(tailed, 128)) == tailed.back());
+    UNIT_EXPECT(test, entropyThreshold(makeHistogram(tailed, 256), 256) == tailed.back());
+    UNIT_EXPECT(test, entropyThreshold(StreamingHistogram(2048)) == 0.0F);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.range_calibration_test", argc, argv);
+    testHistogram(test);
+    testPercentile(test);
+    testEntropy(test);
+    return test.report();
+}
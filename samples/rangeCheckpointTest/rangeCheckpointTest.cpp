@@ -0,0 +1,328 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! rangeCheckpointTest.cpp
+//! This file contains the unit test of CheckpointedHistograms of rangeCheckpoint.h, which lets calibrate_ranges
+//! resume an interrupted calibration. Runs over a stand-in stream of batches are killed after every round, and in
+//! the middle of rounds, then resumed, and their ranges must be identical to those of an uninterrupted run. It needs
+//! neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./range_checkpoint_test
+//!
+
+#include "rangeCheckpoint.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+const std::string kCHECKPOINT = "range_checkpoint_test.ckpt";
+constexpr int kBINS = 1024;
+constexpr int kINTERVAL = 4;
+
+//!
+//! \brief The StandInStream class stands in for the dumps of a calibration: batch i is a tensor of seeded random
+//!        values, whose scale grows along the stream so that histograms have to widen their ranges as they go.
+//!
+class StandInStream
+{
+public:
+    explicit StandInStream(int nbBatches)
+        : mNbBatches(nbBatches)
+    {
+    }
+
+    //! Returns the tensor name and identity of every batch.
+    std::vector<std::pair<std::string, std::string>> getSources() const
+    {
+        std::vector<std::pair<std::string, std::string>> sources;
+        for (int i = 0; i < mNbBatches; ++i)
+        {
+            sources.emplace_back(tensorOf(i), "batch " + std::to_string(i));
+        }
+        return sources;
+    }
+
+    StreamingHistogram read(int batch) const
+    {
+        std::mt19937 generator(1000 + batch);
+        std::normal_distribution<float> normal(0.0F, 1.0F + batch * 0.5F);
+        std::exponential_distribution<float> exponential(4.0F / (1 + batch));
+        std::vector<float> values(2000);
+        for (auto& value : values)
+        {
+            value = batch % 3 == 2 ? exponential(generator) : normal(generator);
+        }
+        StreamingHistogram histogram(kBINS);
+        histogram.add(values.data(), values.size());
+        return histogram;
+    }
+
+private:
+    static std::string tensorOf(int batch)
+    {
+        return std::string("tensor") + std::to_string(batch % 3);
+    }
+
+    int mNbBatches;
+};
+
+//!
+//! \brief Adds the batches of the current round, in reverse order or from several threads, and ends it.
+//!
+bool addRound(CheckpointedHistograms& histograms, const StandInStream& stream, bool reverse = false, int nbThreads = 1)
+{
+    const int begin = histograms.getSourcesDone();
+    const int end = histograms.getRoundEnd();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nbThreads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = begin + t; i < end; i += nbThreads)
+            {
+                const int batch = reverse ? begin + end - 1 - i : i;
+                histograms.add(batch, stream.read(batch));
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return histograms.endRound();
+}
+
+//! Returns the output of calibrate_ranges for the histograms, with the entropy and the maximum methods.
+std::string rangesOf(const HistogramMap& histograms)
+{
+    std::ostringstream output;
+    output << std::setprecision(9);
+    for (const auto& tensor : histograms)
+    {
+        output << tensor.first << ":" << entropyThreshold(tensor.second) << " " << tensor.second.getMax() << "\n";
+    }
+    return output.str();
+}
+
+//! Returns the histograms in binary form, to check that they are identical and not only their ranges.
+std::string bytesOf(const HistogramMap& histograms)
+{
+    std::ostringstream bytes;
+    for (const auto& tensor : histograms)
+    {
+        bytes << tensor.first;
+        tensor.second.write(bytes);
+    }
+    return bytes.str();
+}
+
+bool fileExists(const std::string& path)
+{
+    return static_cast<bool>(std::ifstream(path));
+}
+
+//!
+//! \brief Runs until killed after killedRounds rounds and half of the next one, as if the process had died, and
+//!        returns the number of batches the checkpoint covers.
+//!
+int runUntilKilled(const StandInStream& stream, int killedRounds, int interval = kINTERVAL)
+{
+    CheckpointedHistograms histograms(stream.getSources(), kBINS, kCHECKPOINT, interval);
+    histograms.resume();
+    for (int r = 0; r < killedRounds && !histograms.isDone(); ++r)
+    {
+        addRound(histograms, stream);
+    }
+    const int covered = histograms.getSourcesDone();
+    for (int i = covered; i < (covered + histograms.getRoundEnd()) / 2; ++i)
+    {
+        histograms.add(i, stream.read(i));
+    }
+    return covered;
+}
+
+void testKillAndResume(UnitTest& test)
+{
+    const StandInStream stream(30);
+    CheckpointedHistograms uninterrupted(stream.getSources(), kBINS);
+    UNIT_EXPECT(test, uninterrupted.getRoundEnd() == 30);
+    addRound(uninterrupted, stream);
+    UNIT_EXPECT(test, uninterrupted.isDone());
+    const std::string expectedRanges = rangesOf(uninterrupted.getHistograms());
+    const std::string expectedBytes = bytesOf(uninterrupted.getHistograms());
+    UNIT_EXPECT(test, !fileExists(kCHECKPOINT));
+
+    const int nbRounds = (30 + kINTERVAL - 1) / kINTERVAL;
+    for (int killedRounds = 0; killedRounds <= nbRounds; ++killedRounds)
+    {
+        test.setCase("killed after " + std::to_string(killedRounds) + " rounds");
+        std::remove(kCHECKPOINT.c_str());
+        const int covered = runUntilKilled(stream, killedRounds);
+        UNIT_EXPECT(test, covered == std::min(30, killedRounds * kINTERVAL));
+
+        // The last round is not checkpointed: a run killed before writing its ranges starts again from the one
+        // before.
+        CheckpointedHistograms resumed(stream.getSources(), kBINS, kCHECKPOINT, kINTERVAL);
+        const int expectedResume = killedRounds < nbRounds ? covered : (nbRounds - 1) * kINTERVAL;
+        UNIT_EXPECT(test, resumed.resume() == expectedResume);
+        UNIT_EXPECT(test, resumed.getSourcesDone() == expectedResume);
+        int rounds = 0;
+        while (!resumed.isDone())
+        {
+            UNIT_EXPECT(test, addRound(resumed, stream, true));
+            ++rounds;
+        }
+        UNIT_EXPECT(test, rounds == nbRounds - expectedResume / kINTERVAL);
+        UNIT_EXPECT(test, rangesOf(resumed.getHistograms()) == expectedRanges);
+        UNIT_EXPECT(test, bytesOf(resumed.getHistograms()) == expectedBytes);
+        resumed.removeCheckpoint();
+        UNIT_EXPECT(test, !fileExists(kCHECKPOINT));
+    }
+
+    test.setCase("killed twice");
+    runUntilKilled(stream, 2);
+    UNIT_EXPECT(test, runUntilKilled(stream, 3) == 5 * kINTERVAL);
+    CheckpointedHistograms resumed(stream.getSources(), kBINS, kCHECKPOINT, kINTERVAL);
+    UNIT_EXPECT(test, resumed.resume() == 5 * kINTERVAL);
+    while (!resumed.isDone())
+    {
+        addRound(resumed, stream);
+    }
+    UNIT_EXPECT(test, bytesOf(resumed.getHistograms()) == expectedBytes);
+    resumed.removeCheckpoint();
+
+    test.setCase("resumed with another interval and threads");
+    runUntilKilled(stream, 3);
+    CheckpointedHistograms threaded(stream.getSources(), kBINS, kCHECKPOINT, 7);
+    UNIT_EXPECT(test, threaded.resume() == 3 * kINTERVAL);
+    UNIT_EXPECT(test, threaded.getRoundEnd() == 3 * kINTERVAL + 7);
+    while (!threaded.isDone())
+    {
+        addRound(threaded, stream, false, 3);
+    }
+    UNIT_EXPECT(test, rangesOf(threaded.getHistograms()) == expectedRanges);
+    UNIT_EXPECT(test, bytesOf(threaded.getHistograms()) == expectedBytes);
+    threaded.removeCheckpoint();
+}
+
+void testStaleCheckpoints(UnitTest& test)
+{
+    const StandInStream stream(30);
+
+    test.setCase("changed batch");
+    runUntilKilled(stream, 3);
+    auto sources = stream.getSources();
+    sources[20].second += " rewritten";
+    UNIT_EXPECT(test, CheckpointedHistograms(sources, kBINS, kCHECKPOINT, kINTERVAL).resume() == 0);
+
+    test.setCase("other batches");
+    sources = stream.getSources();
+    sources.pop_back();
+    UNIT_EXPECT(test, CheckpointedHistograms(sources, kBINS, kCHECKPOINT, kINTERVAL).resume() == 0);
+
+    test.setCase("other bins");
+    UNIT_EXPECT(test, CheckpointedHistograms(stream.getSources(), kBINS * 2, kCHECKPOINT, kINTERVAL).resume() == 0);
+    // Ignored checkpoints are left alone, so the run they belong to can still resume.
+    UNIT_EXPECT(test, CheckpointedHistograms(stream.getSources(), kBINS, kCHECKPOINT, kINTERVAL).resume() == 12);
+
+    test.setCase("corrupt checkpoint");
+    std::string content;
+    {
+        std::ifstream file(kCHECKPOINT, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    for (const size_t size : {size_t{0}, size_t{10}, size_t{40}, content.size() / 2, content.size() - 1})
+    {
+        UNIT_EXPECT(test, writeFileAtomically(kCHECKPOINT, content.substr(0, size)));
+        CheckpointedHistograms histograms(stream.getSources(), kBINS, kCHECKPOINT, kINTERVAL);
+        UNIT_EXPECT(test, histograms.resume() == 0);
+        // A failed resume leaves the histograms empty.
+        for (const auto& tensor : histograms.getHistograms())
+        {
+            UNIT_EXPECT(test, tensor.second.getCount() == 0);
+        }
+    }
+    std::string wrongCount = content;
+    wrongCount[20] = 100;
+    UNIT_EXPECT(test, writeFileAtomically(kCHECKPOINT, wrongCount));
+    UNIT_EXPECT(test, CheckpointedHistograms(stream.getSources(), kBINS, kCHECKPOINT, kINTERVAL).resume() == 0);
+    std::remove(kCHECKPOINT.c_str());
+
+    test.setCase("no checkpoint file");
+    CheckpointedHistograms histograms(stream.getSources(), kBINS, "", kINTERVAL);
+    UNIT_EXPECT(test, histograms.resume() == 0);
+    UNIT_EXPECT(test, histograms.getRoundEnd() == 30);
+    UNIT_EXPECT(test, addRound(histograms, stream));
+    UNIT_EXPECT(test, histograms.isDone());
+    UNIT_EXPECT(test, !fileExists(kCHECKPOINT));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    UnitTest test("TensorRT.range_checkpoint_test", argc, argv);
+    testKillAndResume(test);
+    testStaleCheckpoints(test);
+    std::remove(kCHECKPOINT.c_str());
+    return test.report();
+}
@@ -556,8 +556,11 @@ void SampleCharRNN::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builde
 //!
 bool SampleCharRNN::infer()
 {
-    // Create RAII buffer manager object
-    samplesCommon::BufferManager buffers(mEngine, mParams.batchSize);
+    // Create RAII buffer manager object. Every step copies all inputs and outputs, so one arena holding all
+    // bindings turns those copies into one per direction, and pinned host memory lets them run as DMA.
+    samplesCommon::BufferManager buffers(mEngine, mParams.batchSize, nullptr,
+        samplesCommon::BufferAllocation::kARENA,
+        samplesCommon::createHostStagingMemory(samplesCommon::HostMemoryType::kPINNED));
 
     auto context = SampleUniquePtr<nvinfer1::IExecutionContext>(
         mEngine->createExecutionContext());
@@ -20,19 +20,24 @@
 //! the caffe model.
 //! It can be run with the following command line:
 //! Command: ./sample_int8 [-h or --help] [-d=/path/to/data/dir or --datadir=/path/to/data/dir]
+//!          [calibDataset=<file>]
 //!
 
 #include "BatchStream.h"
 #include "EntropyCalibrator.h"
+#include "ShardedBatchStream.h"
+#include "SubsetBatchStream.h"
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
+#include "latencyHistogram.h"
 #include "logger.h"
 
 #include "NvCaffeParser.h"
 #include "NvInfer.h"
 #include <cuda_runtime_api.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -49,6 +54,13 @@ struct SampleINT8Params : public samplesCommon::CaffeSampleParams
     int nbCalBatches; //!< The number of batches for calibration
     int calBatchSize; //!< The calibration batch size
     std::string networkName;  //!< The name of the network
+    int shardIndex{0}; //!< The shard of the scored batches run by this process
+    int shardCount{1}; //!< The number of shards the scored batches are split into
+    ShardMode shardMode{ShardMode::kCONTIGUOUS}; //!< How scored batches are assigned to shards
+    int nbSelectBatches{0};  //!< If positive, the number of calibration batches selected for diversity
+    int nbPoolBatches{0};    //!< The number of calibration batches the selection chooses from
+    std::string subsetFile;  //!< File that caches the selected images, if any
+    std::string calibrationDataset; //!< Calibration dataset file, used instead of the MNIST training set if set
 };
 
 //! \brief  The SampleINT8 class implements the INT8 sample
@@ -83,7 +95,7 @@ public:
     //!
     //! \brief Runs the TensorRT inference engine for this sample
     //!
-    bool infer(std::pair<float, float>& score, int firstScoreBatch, int nbScoreBatches);
+    bool infer(ScoreCounters& counters, int firstScoreBatch, int nbScoreBatches);
 
     //!
     //! \brief Cleans up any state created in the sample class
@@ -232,12 +244,64 @@ bool SampleINT8::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder,
     }
     builder->setMaxBatchSize(mParams.batchSize);
 
-    if (dataType == DataType::kINT8)
+    if (dataType == DataType::kINT8 && mParams.nbSelectBatches > 0)
+    {
+        // Calibrate with diverse images chosen among all those before the scored ones, instead of the first ones.
+        MNISTBatchStream poolStream(mParams.calBatchSize, mParams.nbPoolBatches, "train-images-idx3-ubyte",
+            "train-labels-idx1-ubyte", mParams.dataDirs);
+        std::vector<int64_t> images;
+        if (mParams.subsetFile.empty() || !samplesCommon::readSubsetList(mParams.subsetFile, images))
+        {
+            images = samplesCommon::selectDiverseImages(
+                poolStream, mParams.nbPoolBatches, mParams.nbSelectBatches * mParams.calBatchSize);
+            if (!mParams.subsetFile.empty() && !samplesCommon::writeSubsetList(mParams.subsetFile, images))
+            {
+                gLogWarning << "Could not write " << mParams.subsetFile << std::endl;
+            }
+        }
+        gLogInfo << "Calibrating with " << images.size() << " images selected from " << mParams.nbPoolBatches
+                 << " batches" << std::endl;
+        SubsetBatchStream<MNISTBatchStream> calibrationStream(poolStream, images, mParams.calBatchSize);
+        const std::string datasetIdentity
+            = samplesCommon::fileIdentity(locateFile("train-images-idx3-ubyte", mParams.dataDirs)) + " subset "
+            + samplesCommon::CacheKeyHasher().add(images.data(), images.size() * sizeof(int64_t)).str();
+        calibrator.reset(new Int8EntropyCalibrator2<SubsetBatchStream<MNISTBatchStream>>(calibrationStream, 0,
+            mParams.networkName.c_str(), mParams.inputTensorNames[0].c_str(), true,
+            samplesCommon::networkCacheKey(*network, datasetIdentity)));
+        config->setInt8Calibrator(calibrator.get());
+    }
+    else if (dataType == DataType::kINT8 && !mParams.calibrationDataset.empty())
+    {
+        DatasetBatchStream calibrationStream(
+            mParams.calBatchSize, mParams.nbCalBatches, mParams.calibrationDataset, mParams.dataDirs);
+        const Dims inputDims = network->getInput(0)->getDimensions();
+        const Dims imageDims = calibrationStream.getImageDims();
+        if (imageDims.nbDims != inputDims.nbDims
+            || !std::equal(inputDims.d, inputDims.d + inputDims.nbDims, imageDims.d))
+        {
+            gLogError << "The images of " << mParams.calibrationDataset << " do not match the network input"
+                      << std::endl;
+            return false;
+        }
+        const std::string datasetIdentity
+            = samplesCommon::fileIdentity(locateFile(mParams.calibrationDataset, mParams.dataDirs)) + " batches 0-"
+            + std::to_string(mParams.nbCalBatches);
+        calibrator.reset(new Int8EntropyCalibrator2<DatasetBatchStream>(calibrationStream, 0,
+            mParams.networkName.c_str(), mParams.inputTensorNames[0].c_str(), true,
+            samplesCommon::networkCacheKey(*network, datasetIdentity)));
+        config->setInt8Calibrator(calibrator.get());
+    }
+    else if (dataType == DataType::kINT8)
     {
         MNISTBatchStream calibrationStream(mParams.calBatchSize, mParams.nbCalBatches, "train-images-idx3-ubyte",
             "train-labels-idx1-ubyte", mParams.dataDirs);
-        calibrator.reset(new Int8EntropyCalibrator2<MNISTBatchStream>(
-            calibrationStream, 0, mParams.networkName.c_str(), mParams.inputTensorNames[0].c_str()));
+        // The table is keyed by the network and the calibration data, so a repeat build reuses it.
+        const std::string datasetIdentity
+            = samplesCommon::fileIdentity(locateFile("train-images-idx3-ubyte", mParams.dataDirs)) + " batches 0-"
+            + std::to_string(mParams.nbCalBatches);
+        calibrator.reset(new Int8EntropyCalibrator2<MNISTBatchStream>(calibrationStream, 0,
+            mParams.networkName.c_str(), mParams.inputTensorNames[0].c_str(), true,
+            samplesCommon::networkCacheKey(*network, datasetIdentity)));
         config->setInt8Calibrator(calibrator.get());
     }
 
@@ -267,12 +331,13 @@ bool SampleINT8::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder,
 //! \details This function is the main execution function of the sample. It allocates the buffer,
 //!          sets inputs and executes the engine.
 //!
-bool SampleINT8::infer(std::pair<float, float>& score, int firstScoreBatch, int nbScoreBatches)
+bool SampleINT8::infer(ScoreCounters& counters, int firstScoreBatch, int nbScoreBatches)
 {
     float ms{0.0f};
 
-    // Create RAII buffer manager object
-    samplesCommon::BufferManager buffers(mEngine, mParams.batchSize);
+    // Create RAII buffer manager object. Pooled buffers let the runs of the successive data types reuse the
+    // same memory.
+    samplesCommon::BufferManager buffers(mEngine, mParams.batchSize, nullptr, samplesCommon::BufferAllocation::kPOOLED);
 
     auto context = SampleUniquePtr<nvinfer1::IExecutionContext>(mEngine->createExecutionContext());
     if (!context)
@@ -280,15 +345,18 @@ bool SampleINT8::infer(std::pair<float, float>& score, int firstScoreBatch, int
         return false;
     }
 
-    MNISTBatchStream batchStream(
+    // Only the batches of this process' shard of the scored range are read.
+    MNISTBatchStream mnistStream(
         mParams.batchSize, nbScoreBatches, "train-images-idx3-ubyte", "train-labels-idx1-ubyte", mParams.dataDirs);
-    batchStream.skip(firstScoreBatch);
+    ShardedBatchStream<MNISTBatchStream> batchStream(mnistStream, firstScoreBatch,
+        std::max(nbScoreBatches - firstScoreBatch, 0), mParams.shardIndex, mParams.shardCount, mParams.shardMode);
 
     Dims outputDims = context->getEngine().getBindingDimensions(
         context->getEngine().getBindingIndex(mParams.outputTensorNames[0].c_str()));
     int outputSize = samplesCommon::volume(outputDims);
     int top1{0}, top5{0};
     float totalTime{0.0f};
+    samplesCommon::LatencyHistogram batchTimes;
 
     while (batchStream.next())
     {
@@ -324,6 +392,7 @@ bool SampleINT8::infer(std::pair<float, float>& score, int firstScoreBatch, int
         cudaEventDestroy(end);
 
         totalTime += ms;
+        batchTimes.record(ms);
 
         // Memcpy from device output buffers to host output buffers
         buffers.copyOutputToHost();
@@ -340,12 +409,19 @@ bool SampleINT8::infer(std::pair<float, float>& score, int firstScoreBatch, int
     }
 
     int imagesRead = batchStream.getBatchesRead() * mParams.batchSize;
-    score.first = float(top1) / float(imagesRead);
-    score.second = float(top5) / float(imagesRead);
+    counters.top1 = top1;
+    counters.top5 = top5;
+    counters.images = imagesRead;
+    std::pair<float, float> score = counters.score();
 
+    if (mParams.shardCount > 1)
+    {
+        gLogInfo << "Shard " << mParams.shardIndex << " of " << mParams.shardCount << ": ";
+    }
     gLogInfo << "Top1: " << score.first << ", Top5: " << score.second << std::endl;
     gLogInfo << "Processing " << imagesRead << " images averaged " << totalTime / imagesRead << " ms/image and "
              << totalTime / batchStream.getBatchesRead() << " ms/batch." << std::endl;
+    samplesCommon::printLatencySummary(gLogInfo, "Batch time", batchTimes.summarize(totalTime));
 
     return true;
 }
@@ -449,6 +525,24 @@ void printHelpInfo()
                  "be used for calibration."
               << std::endl;
     std::cout << "score=N         Set the number of batches to be scored (default = 400)." << std::endl;
+    std::cout << "shard=I         Score only shard I of the scored batches (default = 0)." << std::endl;
+    std::cout << "shards=N        Split the scored batches into N shards, one per process (default = 1)." << std::endl;
+    std::cout << "shardMode=M     Assign batches to shards in contiguous blocks or strided, M is contiguous or "
+                 "strided (default = contiguous)."
+              << std::endl;
+    std::cout << "scoreFile=F     Write the top1/top5 counters of each data type to file F." << std::endl;
+    std::cout << "mergeScores=L   Do not run inference; merge the comma separated list L of score files written by "
+                 "the shards and check the global scores."
+              << std::endl;
+    std::cout << "calibSelect=N   Calibrate with N batches of diverse images selected among all the images before "
+                 "the scored ones, instead of the first 10 batches."
+              << std::endl;
+    std::cout << "calibSubset=F   Reuse the images selected by calibSelect from file F, or write them to F if it "
+                 "does not exist."
+              << std::endl;
+    std::cout << "calibDataset=F  Calibrate with the first 10 batches of the dataset file F written by "
+                 "calibration_pack instead of the MNIST training set."
+              << std::endl;
 }
 
 int main(int argc, char** argv)
@@ -463,6 +557,14 @@ int main(int argc, char** argv)
     int batchSize = 32;
     int firstScoreBatch = 100;
     int nbScoreBatches = 400;
+    int shardIndex = 0;
+    int shardCount = 1;
+    ShardMode shardMode = ShardMode::kCONTIGUOUS;
+    std::string scoreFile;
+    std::vector<std::string> mergeFiles;
+    int nbSelectBatches = 0;
+    std::string subsetFile;
+    std::string datasetFile;
 
     // Parse extra arguments
     for (int i = 1; i < argc; ++i)
@@ -479,6 +581,60 @@ int main(int argc, char** argv)
         {
             nbScoreBatches = atoi(argv[i] + 6);
         }
+        else if (!strncmp(argv[i], "shard=", 6))
+        {
+            shardIndex = atoi(argv[i] + 6);
+        }
+        else if (!strncmp(argv[i], "shards=", 7))
+        {
+            shardCount = atoi(argv[i] + 7);
+        }
+        else if (!strncmp(argv[i], "shardMode=", 10))
+        {
+            try
+            {
+                shardMode = parseShardMode(argv[i] + 10);
+            }
+            catch (const std::invalid_argument& e)
+            {
+                gLogError << e.what() << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (!strncmp(argv[i], "scoreFile=", 10))
+        {
+            scoreFile = argv[i] + 10;
+        }
+        else if (!strncmp(argv[i], "calibSelect=", 12))
+        {
+            nbSelectBatches = atoi(argv[i] + 12);
+        }
+        else if (!strncmp(argv[i], "calibSubset=", 12))
+        {
+            subsetFile = argv[i] + 12;
+        }
+        else if (!strncmp(argv[i], "calibDataset=", 13))
+        {
+            datasetFile = argv[i] + 13;
+        }
+        else if (!strncmp(argv[i], "mergeScores=", 12))
+        {
+            std::istringstream list(argv[i] + 12);
+            std::string fileName;
+            while (std::getline(list, fileName, ','))
+            {
+                if (!fileName.empty())
+                {
+                    mergeFiles.push_back(fileName);
+                }
+            }
+        }
+    }
+
+    if (shardCount < 1 || shardIndex < 0 || shardIndex >= shardCount)
+    {
+        gLogError << "Please provide 0 <= shard < shards" << std::endl;
+        return EXIT_FAILURE;
     }
 
     if (batchSize > 128)
@@ -496,7 +652,28 @@ int main(int argc, char** argv)
     samplesCommon::Args args;
     samplesCommon::parseArgs(args, argc, argv);
 
-    SampleINT8 sample(initializeSampleParams(args, batchSize));
+    SampleINT8Params params = initializeSampleParams(args, batchSize);
+    params.shardIndex = shardIndex;
+    params.shardCount = shardCount;
+    params.shardMode = shardMode;
+    params.nbSelectBatches = nbSelectBatches;
+    params.subsetFile = subsetFile;
+    params.calibrationDataset = datasetFile;
+    if (nbSelectBatches > 0 && !datasetFile.empty())
+    {
+        gLogError << "Please provide only one of calibSelect and calibDataset" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // MNISTBatchStream returns batch b + 1 after reset(b), so one batch of headroom keeps the pool clear of the
+    // scored images.
+    params.nbPoolBatches = std::max(firstScoreBatch * batchSize / params.calBatchSize - 1, 0);
+    if (nbSelectBatches > params.nbPoolBatches)
+    {
+        gLogError << "Please provide calibSelect <= " << params.nbPoolBatches
+                  << ", the number of calibration batches before the scored ones" << std::endl;
+        return EXIT_FAILURE;
+    }
+    SampleINT8 sample(params);
 
     auto sampleTest = gLogger.defineTest(gSampleName, argc, argv);
 
@@ -506,11 +683,16 @@ int main(int argc, char** argv)
 
     std::vector<std::string> dataTypeNames = {"FP32", "FP16", "INT8"};
     std::vector<DataType> dataTypes = {DataType::kFLOAT, DataType::kHALF, DataType::kINT8};
-    std::vector<std::pair<float, float>> scores(3, std::make_pair(0.0f, 0.0f));
-    for (size_t i = 0; i < dataTypes.size(); i++)
+    std::vector<ScoreCounters> counters(3);
+    for (size_t i = 0; i < dataTypes.size() && mergeFiles.empty(); i++)
     {
         gLogInfo << dataTypeNames[i] << " run:" << nbScoreBatches << " batches of size " << batchSize << " starting at "
-                 << firstScoreBatch << std::endl;
+                 << firstScoreBatch;
+        if (shardCount > 1)
+        {
+            gLogInfo << ", shard " << shardIndex << " of " << shardCount;
+        }
+        gLogInfo << std::endl;
 
         if (!sample.build(dataTypes[i]))
         {
@@ -522,11 +704,45 @@ int main(int argc, char** argv)
             }
             return gLogger.reportFail(sampleTest);
         }
-        if (!sample.infer(scores[i], firstScoreBatch, nbScoreBatches))
+        if (!sample.infer(counters[i], firstScoreBatch, nbScoreBatches))
+        {
+            return gLogger.reportFail(sampleTest);
+        }
+    }
+
+    samplesCommon::printBufferPoolStats(gLogVerbose);
+    samplesCommon::trimBufferPools();
+
+    for (const auto& fileName : mergeFiles)
+    {
+        if (!mergeScoreFile(fileName, dataTypeNames, counters))
         {
             return gLogger.reportFail(sampleTest);
         }
     }
+    if (!mergeFiles.empty())
+    {
+        for (size_t i = 0; i < dataTypes.size(); i++)
+        {
+            if (counters[i].images)
+            {
+                const auto score = counters[i].score();
+                gLogInfo << dataTypeNames[i] << " merged " << counters[i].images << " images, Top1: " << score.first
+                         << ", Top5: " << score.second << std::endl;
+            }
+        }
+    }
+
+    if (!scoreFile.empty() && !writeScoreFile(scoreFile, dataTypeNames, counters))
+    {
+        return gLogger.reportFail(sampleTest);
+    }
+
+    std::vector<std::pair<float, float>> scores;
+    for (const auto& c : counters)
+    {
+        scores.push_back(c.score());
+    }
 
     auto isApproximatelyEqual = [](float a, float b, double tolerance) { return (std::abs(a - b) <= tolerance); };
     double fp16tolerance{0.5}, int8tolerance{1.0};
@@ -0,0 +1,449 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! sampleInferenceTest.cpp
+//! This file contains the unit test of the scheduling of runInference(): warm up, duration, minimum iterations,
+//! sleep, stop, and failures, with one thread per worker and with all the workers in lockstep. The workers and the
+//! clock are fakes whose time only advances when they sleep, so every schedule is exact, and the test needs neither
+//! TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./sample_inference_test
+//!
+
+#include "sampleInference.h"
+#include "unitTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace sample;
+
+namespace
+{
+
+const double kTOLERANCE = 1e-4;
+
+//!
+//! \brief The FakeClock class gives every thread a time of its own, which only advances when the thread sleeps.
+//!
+//! \details Threads start at the time of the thread that created the clock, and that thread sees the latest time
+//!          of all threads, as it would after joining them. A clock serves a single run, since thread ids may be
+//!          reused once threads exit.
+//!
+class FakeClock : public IClock
+{
+public:
+    FakeClock()
+        : mOwner(std::this_thread::get_id())
+    {
+    }
+
+    double now() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (std::this_thread::get_id() == mOwner)
+        {
+            for (const auto& t : mTimes)
+            {
+                mOwnerTime = std::max(mOwnerTime, t.second);
+            }
+        }
+        return time();
+    }
+
+    void sleep(double ms) override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        time() += ms;
+    }
+
+private:
+    //! Returns the time of the calling thread; requires mMutex.
+    double& time()
+    {
+        const std::thread::id id = std::this_thread::get_id();
+        if (id == mOwner)
+        {
+            return mOwnerTime;
+        }
+        auto found = mTimes.find(id);
+        if (found == mTimes.end())
+        {
+            found = mTimes.emplace(id, mOwnerTime).first;
+        }
+        return found->second;
+    }
+
+    std::mutex mMutex;
+    std::thread::id mOwner;
+    double mOwnerTime{0};
+    std::map<std::thread::id, double> mTimes;
+};
+
+//!
+//! \brief The FakeWorker class takes a fixed time to synchronize, and records the iterations it was given.
+//!
+class FakeWorker : public IInferenceWorker
+{
+public:
+    FakeWorker(IClock& clock, float latency, const std::atomic<bool>* recording = nullptr, int failAt = -1)
+        : mClock(clock)
+        , mLatency(latency)
+        , mRecording(recording)
+        , mFailAt(failAt)
+    {
+    }
+
+    bool enqueue(int iteration) override
+    {
+        mIterations.push_back(iteration);
+        mRecordingAtEnqueue.push_back(mRecording && *mRecording);
+        return iteration != mFailAt;
+    }
+
+    bool synchronize(float& gpuTime) override
+    {
+        mClock.sleep(mLatency);
+        gpuTime = mLatency;
+        return true;
+    }
+
+    //! The iterations enqueued, in order
+    const std::vector<int>& getIterations() const
+    {
+        return mIterations;
+    }
+
+    //! Whether the recording flag was set when each iteration was enqueued
+    const std::vector<bool>& getRecordingAtEnqueue() const
+    {
+        return mRecordingAtEnqueue;
+    }
+
+private:
+    IClock& mClock;
+    float mLatency{0};
+    const std::atomic<bool>* mRecording{nullptr};
+    int mFailAt{-1};
+    std::vector<int> mIterations;
+    std::vector<bool> mRecordingAtEnqueue;
+};
+
+//!
+//! \brief The StopAfter class sets the stop flag of a run once it has received a number of inferences.
+//!
+class StopAfter : public IInferenceListener
+{
+public:
+    explicit StopAfter(int count)
+        : mCount(count)
+    {
+    }
+
+    void onInference(int worker, int index, const InferenceTrace& /*trace*/) override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mReceived.emplace_back(worker, index);
+        if (static_cast<int>(mReceived.size()) >= mCount)
+        {
+            mStop = true;
+        }
+    }
+
+    const std::atomic<bool>* getStop() const
+    {
+        return &mStop;
+    }
+
+    const std::vector<std::pair<int, int>>& getReceived() const
+    {
+        return mReceived;
+    }
+
+private:
+    std::mutex mMutex;
+    int mCount{0};
+    std::vector<std::pair<int, int>> mReceived;
+    std::atomic<bool> mStop{false};
+};
+
+RunOptions makeOptions(float warmup, float duration, int iterations, float sleep, bool threads)
+{
+    RunOptions options;
+    options.warmup = warmup;
+    options.duration = duration;
+    options.iterations = iterations;
+    options.sleep = sleep;
+    options.threads = threads;
+    return options;
+}
+
+std::vector<int> range(int first, int last)
+{
+    std::vector<int> values;
+    for (int i = first; i < last; ++i)
+    {
+        values.push_back(i);
+    }
+    return values;
+}
+
+//! Checks that the traces of a worker were enqueued every period ms from first, and each took latency ms, of which
+//! gpuTime ms were spent by the worker.
+void expectSchedule(samplesCommon::UnitTest& test, const std::vector<InferenceTrace>& traces, size_t count,
+    float first, float period, float latency, float gpuTime)
+{
+    if (!UNIT_EXPECT(test, traces.size() == count))
+    {
+        return;
+    }
+    for (size_t k = 0; k < traces.size(); ++k)
+    {
+        UNIT_EXPECT_NEAR(test, traces[k].enqueueStart, first + k * period, kTOLERANCE);
+        UNIT_EXPECT_NEAR(test, traces[k].arrival, traces[k].enqueueStart, kTOLERANCE);
+        UNIT_EXPECT_NEAR(test, traces[k].latency(), latency, kTOLERANCE);
+        UNIT_EXPECT_NEAR(test, traces[k].gpuTime, gpuTime, kTOLERANCE);
+    }
+}
+
+void testWarmupAndDuration(samplesCommon::UnitTest& test)
+{
+    test.setCase("warm up and duration");
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&worker}, makeOptions(10, 20, 1, 0, false), traces, walltime, clock));
+    // 5 inferences of warm up from 0 to 10 ms, then 10 recorded until 30 ms.
+    expectSchedule(test, traces[0], 10, 0, 2, 2, 2);
+    UNIT_EXPECT(test, worker.getIterations() == range(0, 15));
+    UNIT_EXPECT_NEAR(test, walltime, 20, kTOLERANCE);
+}
+
+void testMinimumIterations(samplesCommon::UnitTest& test)
+{
+    test.setCase("minimum iterations");
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&worker}, makeOptions(10, 20, 15, 0, false), traces, walltime, clock));
+    expectSchedule(test, traces[0], 15, 0, 2, 2, 2);
+    UNIT_EXPECT_NEAR(test, walltime, 30, kTOLERANCE);
+}
+
+void testSleep(samplesCommon::UnitTest& test, bool threads)
+{
+    test.setCase(threads ? "sleep with threads" : "sleep");
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&worker}, makeOptions(0, 20, 1, 3, threads), traces, walltime, clock));
+    // Every inference takes 2 ms and is followed by 3 ms of sleep.
+    expectSchedule(test, traces[0], 4, 0, 5, 2, 2);
+    UNIT_EXPECT_NEAR(test, walltime, 20, kTOLERANCE);
+}
+
+void testLockstep(samplesCommon::UnitTest& test)
+{
+    test.setCase("lockstep");
+    FakeClock clock;
+    FakeWorker fast(clock, 2);
+    FakeWorker slow(clock, 3);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&fast, &slow}, makeOptions(10, 20, 1, 0, false), traces, walltime, clock));
+    // Both are enqueued at once and waited for in turn, so the fake workers, which only take time to synchronize,
+    // complete an iteration every 5 ms: 2 of warm up, then 4 recorded.
+    UNIT_EXPECT(test, traces.size() == 2);
+    expectSchedule(test, traces[0], 4, 0, 5, 2, 2);
+    expectSchedule(test, traces[1], 4, 0, 5, 5, 3);
+    UNIT_EXPECT(test, fast.getIterations() == range(0, 6));
+    UNIT_EXPECT(test, slow.getIterations() == range(0, 6));
+    UNIT_EXPECT_NEAR(test, walltime, 20, kTOLERANCE);
+}
+
+void testThreads(samplesCommon::UnitTest& test)
+{
+    test.setCase("threads");
+    FakeClock clock;
+    FakeWorker fast(clock, 2);
+    FakeWorker slow(clock, 3);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&fast, &slow}, makeOptions(10, 20, 1, 0, true), traces, walltime, clock));
+    // Each worker runs at its own pace: the slow one is first recorded at 12 ms, 2 ms after the warm up.
+    UNIT_EXPECT(test, traces.size() == 2);
+    expectSchedule(test, traces[0], 10, 0, 2, 2, 2);
+    expectSchedule(test, traces[1], 6, 2, 3, 3, 3);
+    UNIT_EXPECT(test, fast.getIterations() == range(0, 15));
+    UNIT_EXPECT(test, slow.getIterations() == range(0, 10));
+    UNIT_EXPECT_NEAR(test, walltime, 20, kTOLERANCE);
+
+    test.setCase("threads with minimum iterations");
+    FakeClock iterationsClock;
+    FakeWorker iterationsFast(iterationsClock, 2);
+    FakeWorker iterationsSlow(iterationsClock, 3);
+    UNIT_EXPECT(test, runInference({&iterationsFast, &iterationsSlow}, makeOptions(10, 20, 8, 0, true), traces,
+                          walltime, iterationsClock));
+    // Only the slow worker runs past the duration, until its 8th inference ends at 36 ms.
+    expectSchedule(test, traces[0], 10, 0, 2, 2, 2);
+    expectSchedule(test, traces[1], 8, 2, 3, 3, 3);
+    UNIT_EXPECT_NEAR(test, walltime, 26, kTOLERANCE);
+}
+
+void testStop(samplesCommon::UnitTest& test, bool threads)
+{
+    test.setCase(threads ? "stop with threads" : "stop");
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    StopAfter listener(3);
+    RunOptions options = makeOptions(10, 1000, 1, 0, threads);
+    options.listeners.push_back(&listener);
+    options.stop = listener.getStop();
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&worker}, options, traces, walltime, clock));
+    expectSchedule(test, traces[0], 3, 0, 2, 2, 2);
+    const std::vector<std::pair<int, int>> received{{0, 0}, {0, 1}, {0, 2}};
+    UNIT_EXPECT(test, listener.getReceived() == received);
+    UNIT_EXPECT_NEAR(test, walltime, 6, kTOLERANCE);
+}
+
+void testRecording(samplesCommon::UnitTest& test, bool threads)
+{
+    test.setCase(threads ? "recording flag with threads" : "recording flag");
+    FakeClock clock;
+    std::atomic<bool> recording{false};
+    FakeWorker worker(clock, 2, &recording);
+    FakeWorker other(clock, 3);
+    RunOptions options = makeOptions(10, 20, 1, 0, threads);
+    options.recording = &recording;
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, runInference({&worker, &other}, options, traces, walltime, clock));
+    // The flag is set right before the first recorded inference of worker 0 is enqueued.
+    const size_t warmup = worker.getIterations().size() - traces[0].size();
+    std::vector<bool> expected(warmup, false);
+    expected.resize(worker.getIterations().size(), true);
+    UNIT_EXPECT(test, worker.getRecordingAtEnqueue() == expected);
+}
+
+void testFailure(samplesCommon::UnitTest& test, bool threads)
+{
+    test.setCase(threads ? "failure with threads" : "failure");
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    FakeWorker failing(clock, 2, nullptr, 7);
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    UNIT_EXPECT(test, !runInference({&worker, &failing}, makeOptions(10, 20, 1, 0, threads), traces, walltime, clock));
+    // The failing worker stops at the inference it could not enqueue.
+    UNIT_EXPECT(test, failing.getIterations() == range(0, 8));
+}
+
+void testComputeStability(samplesCommon::UnitTest& test)
+{
+    test.setCase("stability from traces");
+    // The traces of two workers interleave in time; the report after the run is that of a monitor which saw the
+    // inferences as they completed.
+    std::vector<std::vector<InferenceTrace>> traces(2);
+    samplesCommon::StabilityOptions options;
+    options.median = false;
+    StabilityMonitor monitor(options, false);
+    for (int i = 0; i < 200; ++i)
+    {
+        InferenceTrace trace;
+        trace.arrival = static_cast<float>(i);
+        trace.enqueueStart = trace.arrival;
+        trace.hostEnd = trace.arrival + 1 + (i % 7) * 0.25F + (i % 2) * 0.5F;
+        traces[i % 2].push_back(trace);
+    }
+    std::vector<InferenceTrace> completed(traces[0]);
+    completed.insert(completed.end(), traces[1].begin(), traces[1].end());
+    std::stable_sort(completed.begin(), completed.end(),
+        [](const InferenceTrace& a, const InferenceTrace& b) { return a.hostEnd < b.hostEnd; });
+    for (const auto& trace : completed)
+    {
+        monitor.onInference(0, 0, trace);
+    }
+    const samplesCommon::StabilityReport expected = monitor.getReport();
+    const samplesCommon::StabilityReport report = computeStability(traces, options);
+    UNIT_EXPECT(test, report.samples == 200);
+    UNIT_EXPECT(test, report.windows == expected.windows && report.windowSize == expected.windowSize);
+    UNIT_EXPECT(test, report.estimate == expected.estimate);
+    UNIT_EXPECT(test, report.low == expected.low && report.high == expected.high);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.sample_inference_test", argc, argv);
+    testWarmupAndDuration(test);
+    testMinimumIterations(test);
+    for (const bool threads : {false, true})
+    {
+        testSleep(test, threads);
+        testStop(test, threads);
+        testRecording(test, threads);
+        testFailure(test, threads);
+    }
+    testLockstep(test);
+    testThreads(test);
+    testComputeStability(test);
+    return test.report();
+}
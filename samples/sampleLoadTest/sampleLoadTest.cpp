@@ -0,0 +1,418 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! sampleLoadTest.cpp
+//! This file contains the unit test of the open loop of sampleLoad: the arrival times of the constant, Poisson and
+//! replayed processes, and runLoad() serving them from its queue, with the split of the latencies into queue and
+//! execution time, the backlog above capacity, and the end of the arrivals when the run is stopped. The worker and
+//! the clock are fakes whose time only advances when they sleep, so every schedule is exact, and the test needs
+//! neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./sample_load_test
+//!
+
+#include "sampleLoad.h"
+#include "unitTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace sample;
+
+namespace
+{
+
+const double kTOLERANCE = 1e-4;
+
+//!
+//! \brief The FakeClock class gives every thread a time of its own, which only advances when the thread sleeps.
+//!
+//! \details Threads start at the time of the thread that created the clock, and that thread sees the latest time
+//!          of all threads, as it would after joining them.
+//!
+class FakeClock : public IClock
+{
+public:
+    FakeClock()
+        : mOwner(std::this_thread::get_id())
+    {
+    }
+
+    double now() override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (std::this_thread::get_id() == mOwner)
+        {
+            for (const auto& t : mTimes)
+            {
+                mOwnerTime = std::max(mOwnerTime, t.second);
+            }
+        }
+        return time();
+    }
+
+    void sleep(double ms) override
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        time() += ms;
+    }
+
+private:
+    //! Returns the time of the calling thread; requires mMutex.
+    double& time()
+    {
+        const std::thread::id id = std::this_thread::get_id();
+        if (id == mOwner)
+        {
+            return mOwnerTime;
+        }
+        auto found = mTimes.find(id);
+        if (found == mTimes.end())
+        {
+            found = mTimes.emplace(id, mOwnerTime).first;
+        }
+        return found->second;
+    }
+
+    std::mutex mMutex;
+    std::thread::id mOwner;
+    double mOwnerTime{0};
+    std::map<std::thread::id, double> mTimes;
+};
+
+//!
+//! \brief The FakeWorker class takes a fixed time to synchronize, and records the requests it was given.
+//!
+class FakeWorker : public IInferenceWorker
+{
+public:
+    FakeWorker(IClock& clock, float latency)
+        : mClock(clock)
+        , mLatency(latency)
+    {
+    }
+
+    bool enqueue(int iteration) override
+    {
+        mRequests.push_back(iteration);
+        return true;
+    }
+
+    bool synchronize(float& gpuTime) override
+    {
+        mClock.sleep(mLatency);
+        gpuTime = mLatency;
+        return true;
+    }
+
+    //! The requests enqueued, in order
+    const std::vector<int>& getRequests() const
+    {
+        return mRequests;
+    }
+
+private:
+    IClock& mClock;
+    float mLatency{0};
+    std::vector<int> mRequests;
+};
+
+//!
+//! \brief The StopAfter class sets the stop flag of a run once it has received a number of inferences.
+//!
+class StopAfter : public IInferenceListener
+{
+public:
+    explicit StopAfter(int count)
+        : mCount(count)
+    {
+    }
+
+    void onInference(int /*worker*/, int /*index*/, const InferenceTrace& /*trace*/) override
+    {
+        if (++mReceived >= mCount)
+        {
+            mStop = true;
+        }
+    }
+
+    const std::atomic<bool>* getStop() const
+    {
+        return &mStop;
+    }
+
+private:
+    int mCount{0};
+    std::atomic<int> mReceived{0};
+    std::atomic<bool> mStop{false};
+};
+
+RunOptions makeOptions(float warmup, float duration)
+{
+    RunOptions options;
+    options.warmup = warmup;
+    options.duration = duration;
+    return options;
+}
+
+ArrivalOptions makeArrivals(ArrivalProcess process, float rate, uint32_t seed = 1)
+{
+    ArrivalOptions options;
+    options.process = process;
+    options.rate = rate;
+    options.seed = seed;
+    return options;
+}
+
+//! Checks that times are first, first + gap, ... for count times.
+void expectEvenlySpaced(samplesCommon::UnitTest& test, const std::vector<double>& times, size_t count, double first,
+    double gap)
+{
+    if (!UNIT_EXPECT(test, times.size() == count))
+    {
+        return;
+    }
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        UNIT_EXPECT_NEAR(test, times[i], first + i * gap, kTOLERANCE);
+    }
+}
+
+void testConstant(samplesCommon::UnitTest& test)
+{
+    test.setCase("constant arrivals");
+    // 100 requests per second are 10 ms apart, from 0 to before the horizon.
+    expectEvenlySpaced(test, generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 100), 100), 10, 0, 10);
+    expectEvenlySpaced(test, generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 100), 100.5), 11, 0, 10);
+    UNIT_EXPECT(test, generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 0), 100).empty());
+    UNIT_EXPECT(test, generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 100), 100)
+            == generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 100, 7), 100));
+}
+
+void testPoisson(samplesCommon::UnitTest& test)
+{
+    test.setCase("Poisson arrivals");
+    const std::vector<double> times = generateArrivals(makeArrivals(ArrivalProcess::kPOISSON, 1000), 10000);
+    // The same seed gives the same times, another seed other times.
+    UNIT_EXPECT(test, times == generateArrivals(makeArrivals(ArrivalProcess::kPOISSON, 1000), 10000));
+    UNIT_EXPECT(test, times != generateArrivals(makeArrivals(ArrivalProcess::kPOISSON, 1000, 2), 10000));
+    // The times are increasing and within the horizon, about rate * horizon of them, with exponential gaps: their
+    // mean is 1 ms, and their coefficient of variation 1.
+    UNIT_EXPECT(test, std::is_sorted(times.begin(), times.end()));
+    UNIT_EXPECT(test, !times.empty() && times.front() >= 0 && times.back() < 10000);
+    UNIT_EXPECT_NEAR(test, static_cast<double>(times.size()), 10000, 4 * 100);
+    double sum{0};
+    double squares{0};
+    for (size_t i = 1; i < times.size(); ++i)
+    {
+        const double gap = times[i] - times[i - 1];
+        sum += gap;
+        squares += gap * gap;
+    }
+    const double mean = sum / (times.size() - 1);
+    const double deviation = std::sqrt(squares / (times.size() - 1) - mean * mean);
+    UNIT_EXPECT_NEAR(test, mean, 1, 0.04);
+    UNIT_EXPECT_NEAR(test, deviation / mean, 1, 0.05);
+    UNIT_EXPECT(test, generateArrivals(makeArrivals(ArrivalProcess::kPOISSON, 0), 100).empty());
+}
+
+void testReplay(samplesCommon::UnitTest& test)
+{
+    test.setCase("replayed arrivals");
+    // 4 requests 10 ms apart: the recording repeats every 40 ms, the mean gap past its last request, so its rate
+    // is 100 requests per second. It starts at 0 wherever it was recorded.
+    ArrivalOptions options = makeArrivals(ArrivalProcess::kREPLAY, 0);
+    options.replay = {1000, 1010, 1020, 1030};
+    expectEvenlySpaced(test, generateArrivals(options, 100), 10, 0, 10);
+    // Scaled to 200 requests per second, the gaps and the period are halved.
+    options.rate = 200;
+    expectEvenlySpaced(test, generateArrivals(options, 50), 10, 0, 5);
+    // Uneven recordings keep their shape, scaled, in every period: 4 requests over 15 ms repeat every 20 ms, a
+    // recorded rate of 200 requests per second.
+    options.replay = {0, 2, 3, 15};
+    options.rate = 0;
+    const std::vector<double> expected{0, 2, 3, 15, 20, 22, 23, 35, 40, 42, 43};
+    const std::vector<double> times = generateArrivals(options, 45);
+    UNIT_EXPECT(test, times.size() == expected.size());
+    for (size_t i = 0; i < std::min(times.size(), expected.size()); ++i)
+    {
+        UNIT_EXPECT_NEAR(test, times[i], expected[i], kTOLERANCE);
+    }
+    options.rate = 400;
+    const std::vector<double> scaled = generateArrivals(options, 12);
+    UNIT_EXPECT(test, scaled.size() == 7);
+    for (size_t i = 0; i < std::min<size_t>(scaled.size(), 7); ++i)
+    {
+        UNIT_EXPECT_NEAR(test, scaled[i], expected[i] / 2, kTOLERANCE);
+    }
+    options.replay = {5};
+    UNIT_EXPECT(test, generateArrivals(options, 100).empty());
+}
+
+void testQueueSplit(samplesCommon::UnitTest& test)
+{
+    test.setCase("queue and execution time");
+    FakeClock clock;
+    FakeWorker worker(clock, 4);
+    // Three requests at once on one worker: each waits for the previous ones, then executes for 4 ms. The request
+    // in the warm up is served but not recorded.
+    const std::vector<double> arrivals{0, 10, 10, 10, 30};
+    std::vector<std::vector<InferenceTrace>> traces;
+    LoadCounters counters;
+    UNIT_EXPECT(test, runLoad({&worker}, makeOptions(5, 100), arrivals, traces, counters, clock));
+    UNIT_EXPECT(test, worker.getRequests() == std::vector<int>({0, 1, 2, 3, 4}));
+    if (UNIT_EXPECT(test, traces.size() == 1 && traces[0].size() == 4))
+    {
+        const float queue[] = {0, 4, 8, 0};
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const InferenceTrace& t = traces[0][i];
+            UNIT_EXPECT_NEAR(test, t.arrival, arrivals[i + 1] - 5, kTOLERANCE);
+            UNIT_EXPECT_NEAR(test, t.queueTime(), queue[i], kTOLERANCE);
+            UNIT_EXPECT_NEAR(test, t.latency(), 4, kTOLERANCE);
+            UNIT_EXPECT_NEAR(test, t.endToEndLatency(), queue[i] + 4, kTOLERANCE);
+        }
+    }
+    UNIT_EXPECT(test, counters.arrived == 4);
+    UNIT_EXPECT(test, counters.backlog == 0);
+    UNIT_EXPECT_NEAR(test, counters.window, 100, kTOLERANCE);
+    // The last request completes at 34 ms, 29 ms after the warm up.
+    UNIT_EXPECT_NEAR(test, counters.walltime, 29, kTOLERANCE);
+    const LoadSummary summary = summarizeLoad(traces, counters);
+    UNIT_EXPECT(test, summary.endToEnd.count == 4);
+    UNIT_EXPECT_NEAR(test, summary.queue.max, 8, 8 * 0.004);
+    UNIT_EXPECT_NEAR(test, summary.execution.p50, 4, 4 * 0.004);
+    UNIT_EXPECT_NEAR(test, summary.offered, 40, kTOLERANCE);
+}
+
+void testCapacity(samplesCommon::UnitTest& test)
+{
+    test.setCase("below capacity");
+    // A request every 20 ms on a worker taking 10 ms: nothing queues.
+    FakeClock clock;
+    FakeWorker worker(clock, 10);
+    std::vector<std::vector<InferenceTrace>> traces;
+    LoadCounters counters;
+    const std::vector<double> arrivals = generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 50), 100);
+    UNIT_EXPECT(test, runLoad({&worker}, makeOptions(0, 100), arrivals, traces, counters, clock));
+    const LoadSummary summary = summarizeLoad(traces, counters);
+    UNIT_EXPECT(test, summary.endToEnd.count == 5);
+    UNIT_EXPECT(test, summary.queue.max == 0);
+    UNIT_EXPECT(test, summary.backlog == 0);
+    UNIT_EXPECT(test, !summary.saturated());
+
+    test.setCase("above capacity");
+    // A request every 2.5 ms on the same worker: it serves one every 10 ms until twice the duration, and the rest
+    // of the 40 requests are left in the backlog.
+    FakeClock saturatedClock;
+    FakeWorker saturatedWorker(saturatedClock, 10);
+    const std::vector<double> burst = generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 400), 100);
+    UNIT_EXPECT(test, runLoad({&saturatedWorker}, makeOptions(0, 100), burst, traces, counters, saturatedClock));
+    UNIT_EXPECT(test, traces[0].size() == 20);
+    UNIT_EXPECT(test, counters.arrived == 40);
+    UNIT_EXPECT(test, counters.backlog == 20);
+    UNIT_EXPECT_NEAR(test, counters.walltime, 200, kTOLERANCE);
+    const LoadSummary saturated = summarizeLoad(traces, counters);
+    UNIT_EXPECT_NEAR(test, saturated.offered, 400, kTOLERANCE);
+    UNIT_EXPECT_NEAR(test, saturated.throughput, 100, kTOLERANCE);
+    UNIT_EXPECT(test, saturated.saturated());
+    // The queue time of the last request served grows with the backlog: it arrived at 47.5 ms and started at 190.
+    UNIT_EXPECT_NEAR(test, traces[0].back().queueTime(), 190 - 47.5, kTOLERANCE);
+}
+
+void testStop(samplesCommon::UnitTest& test)
+{
+    test.setCase("stop");
+    // The run stops after the third request, which completes at 22 ms: the requests arriving from then on are
+    // not part of the run, and are neither served nor counted in the backlog.
+    FakeClock clock;
+    FakeWorker worker(clock, 2);
+    StopAfter listener(3);
+    RunOptions options = makeOptions(0, 1000);
+    options.listeners.push_back(&listener);
+    options.stop = listener.getStop();
+    std::vector<std::vector<InferenceTrace>> traces;
+    LoadCounters counters;
+    const std::vector<double> arrivals = generateArrivals(makeArrivals(ArrivalProcess::kCONSTANT, 100), 1000);
+    UNIT_EXPECT(test, runLoad({&worker}, options, arrivals, traces, counters, clock));
+    UNIT_EXPECT(test, traces[0].size() == 3);
+    UNIT_EXPECT(test, worker.getRequests() == std::vector<int>({0, 1, 2}));
+    UNIT_EXPECT(test, counters.arrived == 3);
+    UNIT_EXPECT(test, counters.backlog == 0);
+    UNIT_EXPECT_NEAR(test, counters.window, 22, kTOLERANCE);
+    UNIT_EXPECT(test, !summarizeLoad(traces, counters).saturated());
+
+    test.setCase("cutoff at the duration");
+    // Without a stop, arrivals past the duration are not served, even though the queue is still drained.
+    FakeClock cutoffClock;
+    FakeWorker cutoffWorker(cutoffClock, 2);
+    UNIT_EXPECT(test, runLoad({&cutoffWorker}, makeOptions(0, 50), arrivals, traces, counters, cutoffClock));
+    UNIT_EXPECT(test, traces[0].size() == 5);
+    UNIT_EXPECT(test, counters.arrived == 5);
+    UNIT_EXPECT_NEAR(test, counters.window, 50, kTOLERANCE);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.sample_load_test", argc, argv);
+    testConstant(test);
+    testPoisson(test);
+    testReplay(test);
+    testQueueSplit(test);
+    testCapacity(test);
+    testStop(test);
+    return test.report();
+}
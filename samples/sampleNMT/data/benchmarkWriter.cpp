@@ -59,6 +59,7 @@ BenchmarkWriter::BenchmarkWriter()
     , mInputTokenCount(0)
     , mOutputTokenCount(0)
     , mStartTS(std::chrono::high_resolution_clock::now())
+    , mBatchStartTS(mStartTS)
 {
 }
 
@@ -68,6 +69,8 @@ void BenchmarkWriter::write(
     int actualInputSequenceLength)
 {
     ++mSampleCount;
+    mLatencies.record(
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - mBatchStartTS).count());
     mInputTokenCount += actualInputSequenceLength;
     mOutputTokenCount += actualOutputSequenceLength;
 }
@@ -75,6 +78,13 @@ void BenchmarkWriter::write(
 void BenchmarkWriter::initialize()
 {
     mStartTS = std::chrono::high_resolution_clock::now();
+    mBatchStartTS = mStartTS;
+    mLatencies.reset();
+}
+
+void BenchmarkWriter::beginBatch()
+{
+    mBatchStartTS = std::chrono::high_resolution_clock::now();
 }
 
 void BenchmarkWriter::finalize()
@@ -83,6 +93,7 @@ void BenchmarkWriter::finalize()
     int totalTokenCount = mInputTokenCount + mOutputTokenCount;
     gLogInfo << mSampleCount << " sequences generated in " << sec.count() << " seconds, " << (mSampleCount / sec.count()) << " samples/sec" << std::endl;
     gLogInfo << totalTokenCount << " tokens processed (source and destination), " << (totalTokenCount / sec.count()) << " tokens/sec" << std::endl;
+    samplesCommon::printLatencySummary(gLogInfo, "Sequence latency", mLatencies.summarize(sec.count() * 1000));
 }
 
 std::string BenchmarkWriter::getInfo()
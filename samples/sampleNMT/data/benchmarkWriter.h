@@ -54,6 +54,7 @@
 #include <memory>
 
 #include "dataWriter.h"
+#include "latencyHistogram.h"
 
 namespace nmtSample
 {
@@ -61,6 +62,8 @@ namespace nmtSample
     *
     * \brief all it does is to measure the performance of sequence generation
     *
+    * The latency of a sequence is the time from the beginning of its batch to its write.
+    *
     */
 class BenchmarkWriter : public DataWriter
 {
@@ -76,6 +79,8 @@ public:
 
     void finalize() override;
 
+    void beginBatch() override;
+
     std::string getInfo() override;
 
     ~BenchmarkWriter() override = default;
@@ -85,6 +90,8 @@ private:
     int mInputTokenCount;
     int mOutputTokenCount;
     std::chrono::high_resolution_clock::time_point mStartTS;
+    std::chrono::high_resolution_clock::time_point mBatchStartTS;
+    samplesCommon::LatencyHistogram mLatencies;
 };
 } // namespace nmtSample
 
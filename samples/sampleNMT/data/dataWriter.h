@@ -89,6 +89,11 @@ public:
         */
     virtual void finalize() = 0;
 
+    /**
+        * \brief it is called right before a batch of sequences is processed
+        */
+    virtual void beginBatch() {}
+
     ~DataWriter() override = default;
 
 protected:
@@ -96,6 +96,7 @@
 #include "model/slpProjection.h"
 #include "model/softmaxLikelihood.h"
 #include "pinnedHostBuffer.h"
+#include "sampleTrace.h"
 #include "trtUtil.h"
 
 bool gPrintComponentInfo = true;
@@ -113,6 +114,7 @@ int gMaxWorkspaceSize = 256_MiB;
 std::string gDataDirectory("data/samples/nmt/deen");
 bool gEnableProfiling = false;
 bool gAggregateProfiling = false;
+std::string gTraceFileName;
 bool gFp16 = false;
 bool gVerbose = false;
 bool gInt8 = false;
@@ -329,6 +331,9 @@ void printUsage()
         "  --profile                            Profile TensorRT execution layer by layer. Use benchmark data_writer "
         "when profiling on, disregard benchmark results\n");
     printf("  --aggregate_profile                  Merge profiles from multiple TensorRT engines\n");
+    printf(
+        "  --trace_file=<path_to_file>          Write a Chrome trace_event timeline of the host phases of the "
+        "translation loop\n");
     printf("  --fp16                               Switch on fp16 math\n");
     printf("  --int8                               Switch on int8 math\n");
     printf(
@@ -375,6 +380,8 @@ bool parseNMTArgs(samplesCommon::Args& args, int argc, char* argv[])
             continue;
         if (parseBool(argv[j], "aggregate_profile", gAggregateProfiling))
             continue;
+        if (parseString(argv[j], "trace_file", gTraceFileName))
+            continue;
         if (parseBool(argv[j], "fp16", gFp16))
             continue;
         if (parseBool(argv[j], "int8", gInt8))
@@ -1152,10 +1159,20 @@ int main(int argc, char** argv)
 
     dataWriter->initialize();
 
+    if (!gTraceFileName.empty())
+    {
+        sample::Tracer::instance().start();
+        SAMPLE_TRACE_THREAD_NAME("Main");
+    }
+
     std::vector<int> outputHostBuffer;
     auto startDataRead = std::chrono::high_resolution_clock::now();
-    int inputSamplesRead = dataReader->read(
-        gMaxBatchSize, gMaxInputSequenceLength, *inputOriginalHostBuffer, *inputOriginalSequenceLengthsHostBuffer);
+    int inputSamplesRead{0};
+    {
+        SAMPLE_TRACE_SPAN("Data Read");
+        inputSamplesRead = dataReader->read(
+            gMaxBatchSize, gMaxInputSequenceLength, *inputOriginalHostBuffer, *inputOriginalSequenceLengthsHostBuffer);
+    }
     if (gEnableProfiling)
         profilers[0].reportLayerTime("Data Read",
             std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startDataRead)
@@ -1165,7 +1182,9 @@ int main(int argc, char** argv)
     int batchCount = 0;
     while (inputSamplesRead > 0)
     {
+        SAMPLE_TRACE_SPAN("Batch");
         ++batchCount;
+        dataWriter->beginBatch();
 
         // Sort input sequences in the batch in the order of decreasing length
         // The idea is that shorter input sequences gets translated faster so we can reduce batch size quickly for the
@@ -1173,6 +1192,7 @@ int main(int argc, char** argv)
         auto startBatchSort = std::chrono::high_resolution_clock::now();
         std::vector<int> samplePositions(inputSamplesRead);
         {
+            SAMPLE_TRACE_SPAN("Intra-batch Sort");
             std::vector<std::pair<int, int>> sequenceSampleIdAndLength(inputSamplesRead);
             for (int sampleId = 0; sampleId < inputSamplesRead; ++sampleId)
                 sequenceSampleIdAndLength[sampleId]
@@ -1194,18 +1214,26 @@ int main(int argc, char** argv)
                 std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startBatchSort)
                     .count());
 
-        CUDA_CHECK(cudaMemcpyAsync(*inputEncoderDeviceBuffer, *inputHostBuffer,
-            inputSamplesRead * gMaxInputSequenceLength * sizeof(int), cudaMemcpyHostToDevice, stream));
-        CUDA_CHECK(cudaMemcpyAsync(*inputSequenceLengthsDeviceBuffer, *inputSequenceLengthsHostBuffer,
-            inputSamplesRead * sizeof(int), cudaMemcpyHostToDevice, stream));
+        {
+            SAMPLE_TRACE_SPAN("H2D Copy");
+            CUDA_CHECK(cudaMemcpyAsync(*inputEncoderDeviceBuffer, *inputHostBuffer,
+                inputSamplesRead * gMaxInputSequenceLength * sizeof(int), cudaMemcpyHostToDevice, stream));
+            CUDA_CHECK(cudaMemcpyAsync(*inputSequenceLengthsDeviceBuffer, *inputSequenceLengthsHostBuffer,
+                inputSamplesRead * sizeof(int), cudaMemcpyHostToDevice, stream));
+        }
 
         // Overlap host and device: Read data for the next batch while encode for this one is running
         std::future<int> nextInputSamplesReadFuture = std::async(std::launch::async, [&]() {
+            SAMPLE_TRACE_THREAD_NAME("Data Reader");
+            SAMPLE_TRACE_SPAN("Data Read");
             return dataReader->read(gMaxBatchSize, gMaxInputSequenceLength, *inputOriginalHostBuffer,
                 *inputOriginalSequenceLengthsHostBuffer);
         });
 
-        encoderContext->enqueue(inputSamplesRead, &encoderBindings[0], stream, nullptr);
+        {
+            SAMPLE_TRACE_SPAN("Encoder Enqueue");
+            encoderContext->enqueue(inputSamplesRead, &encoderBindings[0], stream, nullptr);
+        }
 
         // Limit output sequences length to input_sequence_length * 2
         std::transform((const int*) *inputSequenceLengthsHostBuffer,
@@ -1229,56 +1257,76 @@ int main(int argc, char** argv)
             // Generator initialization and beam shuffling
             if (outputTimestep == 0)
             {
+                SAMPLE_TRACE_SPAN("Generator Enqueue");
                 generatorContext->enqueue(validSampleCount, &generatorBindingsFirstStep[0], stream, nullptr);
             }
             else
             {
+                SAMPLE_TRACE_SPAN("Generator Enqueue");
                 generatorShuffleContext->enqueue(validSampleCount, &generatorShuffleBindings[0], stream, nullptr);
                 generatorContext->enqueue(validSampleCount, &generatorBindings[0], stream, nullptr);
             }
 
-            CUDA_CHECK(cudaMemcpyAsync(*outputCombinedLikelihoodHostBuffer, *outputCombinedLikelihoodDeviceBuffer,
-                validSampleCount * gBeamWidth * sizeof(float), cudaMemcpyDeviceToHost, stream));
-            CUDA_CHECK(cudaMemcpyAsync(*outputVocabularyIndicesHostBuffer, *inputDecoderDeviceBuffer,
-                validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyDeviceToHost, stream));
-            CUDA_CHECK(cudaMemcpyAsync(*outputRayOptionIndicesHostBuffer, *outputRayOptionIndicesDeviceBuffer,
-                validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyDeviceToHost, stream));
+            {
+                SAMPLE_TRACE_SPAN("D2H Copy");
+                CUDA_CHECK(cudaMemcpyAsync(*outputCombinedLikelihoodHostBuffer, *outputCombinedLikelihoodDeviceBuffer,
+                    validSampleCount * gBeamWidth * sizeof(float), cudaMemcpyDeviceToHost, stream));
+                CUDA_CHECK(cudaMemcpyAsync(*outputVocabularyIndicesHostBuffer, *inputDecoderDeviceBuffer,
+                    validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyDeviceToHost, stream));
+                CUDA_CHECK(cudaMemcpyAsync(*outputRayOptionIndicesHostBuffer, *outputRayOptionIndicesDeviceBuffer,
+                    validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyDeviceToHost, stream));
+            }
 
-            CUDA_CHECK(cudaStreamSynchronize(stream));
+            {
+                SAMPLE_TRACE_SPAN("Sync");
+                CUDA_CHECK(cudaStreamSynchronize(stream));
+            }
 
             auto startBeamSearch = std::chrono::high_resolution_clock::now();
-            searchPolicy->processTimestep(validSampleCount, *outputCombinedLikelihoodHostBuffer,
-                *outputVocabularyIndicesHostBuffer, *outputRayOptionIndicesHostBuffer, *sourceRayIndicesHostBuffer,
-                *sourceLikelihoodsHostBuffer);
+            {
+                SAMPLE_TRACE_SPAN("Beam Search");
+                searchPolicy->processTimestep(validSampleCount, *outputCombinedLikelihoodHostBuffer,
+                    *outputVocabularyIndicesHostBuffer, *outputRayOptionIndicesHostBuffer, *sourceRayIndicesHostBuffer,
+                    *sourceLikelihoodsHostBuffer);
+            }
             if (gEnableProfiling)
                 profilers[0].reportLayerTime("Beam Search",
                     std::chrono::duration<float, std::milli>(
                         std::chrono::high_resolution_clock::now() - startBeamSearch)
                         .count());
 
-            CUDA_CHECK(cudaMemcpyAsync(*sourceRayIndicesDeviceBuffer, *sourceRayIndicesHostBuffer,
-                validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyHostToDevice, stream));
-            CUDA_CHECK(cudaMemcpyAsync(*inputLikelihoodsDeviceBuffer, *sourceLikelihoodsHostBuffer,
-                validSampleCount * gBeamWidth * sizeof(float), cudaMemcpyHostToDevice, stream));
+            {
+                SAMPLE_TRACE_SPAN("H2D Copy");
+                CUDA_CHECK(cudaMemcpyAsync(*sourceRayIndicesDeviceBuffer, *sourceRayIndicesHostBuffer,
+                    validSampleCount * gBeamWidth * sizeof(int), cudaMemcpyHostToDevice, stream));
+                CUDA_CHECK(cudaMemcpyAsync(*inputLikelihoodsDeviceBuffer, *sourceLikelihoodsHostBuffer,
+                    validSampleCount * gBeamWidth * sizeof(float), cudaMemcpyHostToDevice, stream));
+            }
 
             validSampleCount = searchPolicy->getTailWithNoWorkRemaining();
         } // for(int outputTimestep
 
         auto startBacktrack = std::chrono::high_resolution_clock::now();
-        searchPolicy->readGeneratedResult(
-            inputSamplesRead, batchMaxOutputSequenceLength, &outputHostBuffer[0], *outputSequenceLengthsHostBuffer);
+        {
+            SAMPLE_TRACE_SPAN("Read Result");
+            searchPolicy->readGeneratedResult(
+                inputSamplesRead, batchMaxOutputSequenceLength, &outputHostBuffer[0], *outputSequenceLengthsHostBuffer);
+        }
         if (gEnableProfiling)
             profilers[0].reportLayerTime("Read Result",
                 std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startBacktrack)
                     .count());
 
         auto startDataWrite = std::chrono::high_resolution_clock::now();
-        for (int sampleId = 0; sampleId < inputSamplesRead; ++sampleId)
         {
-            int position = samplePositions[sampleId];
-            dataWriter->write(&outputHostBuffer[0] + position * batchMaxOutputSequenceLength,
-                ((const int*) *outputSequenceLengthsHostBuffer)[position],
-                ((const int*) *inputSequenceLengthsHostBuffer)[position]);
+            SAMPLE_TRACE_SPAN("Data Write");
+            for (int sampleId = 0; sampleId < inputSamplesRead; ++sampleId)
+            {
+                int position = samplePositions[sampleId];
+                dataWriter->write(&outputHostBuffer[0] + position * batchMaxOutputSequenceLength,
+                    ((const int*) *outputSequenceLengthsHostBuffer)[position],
+                    ((const int*) *inputSequenceLengthsHostBuffer)[position]);
+            }
         }
         if (gEnableProfiling)
             profilers[0].reportLayerTime("Data Write",
@@ -1286,7 +1334,10 @@ int main(int argc, char** argv)
                     .count());
 
         auto startDataRead = std::chrono::high_resolution_clock::now();
-        inputSamplesRead = nextInputSamplesReadFuture.get();
+        {
+            SAMPLE_TRACE_SPAN("Data Read Wait");
+            inputSamplesRead = nextInputSamplesReadFuture.get();
+        }
         if (gEnableProfiling)
             profilers[0].reportLayerTime("Data Read",
                 std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startDataRead)
@@ -1296,6 +1347,15 @@ int main(int argc, char** argv)
         = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startLatency).count();
 
     dataWriter->finalize();
+
+    if (!gTraceFileName.empty())
+    {
+        sample::Tracer::instance().stop();
+        if (!sample::Tracer::instance().write(gTraceFileName))
+        {
+            gLogError << "Cannot write the trace to " << gTraceFileName << std::endl;
+        }
+    }
     float score
         = gDataWriterStr == "bleu" ? static_cast<nmtSample::BLEUScoreWriter*>(dataWriter.get())->getScore() : -1.0f;
 
@@ -53,6 +53,7 @@
 //! the SSD caffe model.
 //! It can be run with the following command line:
 //! Command: ./sample_ssd [-h or --help] [-d=/path/to/data/dir or --datadir=/path/to/data/dir]
+//!          [--int8 [--calibDataset=<file>]]
 //!
 
 #include "argsParser.h"
@@ -66,6 +67,7 @@
 #include "NvInfer.h"
 #include <cuda_runtime_api.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -84,6 +86,7 @@ struct SampleSSDParams : public samplesCommon::CaffeSampleParams
     int nbCalBatches;  //!< The number of batches for calibration
     float visualThreshold; //!< The minimum score threshold to consider a detection
     std::string calibrationBatches; //!< The path to calibration batches
+    std::string calibrationDataset; //!< Calibration dataset file, used instead of the batches if set
 };
 
 //! \brief  The SampleSSD class implements the SSD sample
@@ -227,8 +230,36 @@ bool SampleSSD::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder,
     if (mParams.int8)
     {
         gLogInfo << "Using Entropy Calibrator 2" << std::endl;
-        BatchStream calibrationStream(mParams.batchSize, mParams.nbCalBatches, mParams.calibrationBatches, mParams.dataDirs);
-        calibrator.reset(new Int8EntropyCalibrator2<BatchStream>(calibrationStream, 0, "SSD", mParams.inputTensorNames[0].c_str()));
+        std::string datasetIdentity = "batches 0-" + std::to_string(mParams.nbCalBatches);
+        if (!mParams.calibrationDataset.empty())
+        {
+            DatasetBatchStream calibrationStream(
+                mParams.batchSize, mParams.nbCalBatches, mParams.calibrationDataset, mParams.dataDirs);
+            const Dims inputDims = network->getInput(0)->getDimensions();
+            const Dims imageDims = calibrationStream.getImageDims();
+            if (imageDims.nbDims != inputDims.nbDims
+                || !std::equal(inputDims.d, inputDims.d + inputDims.nbDims, imageDims.d))
+            {
+                gLogError << "The images of " << mParams.calibrationDataset << " do not match the network input"
+                          << std::endl;
+                return false;
+            }
+            const std::string datasetFile = locateFile(mParams.calibrationDataset, mParams.dataDirs);
+            datasetIdentity += "\n" + samplesCommon::fileIdentity(datasetFile);
+            calibrator.reset(new Int8EntropyCalibrator2<DatasetBatchStream>(calibrationStream, 0, "SSD",
+                mParams.inputTensorNames[0].c_str(), true, samplesCommon::networkCacheKey(*network, datasetIdentity)));
+        }
+        else
+        {
+            MappedBatchStream calibrationStream(
+                mParams.batchSize, mParams.nbCalBatches, mParams.calibrationBatches, mParams.dataDirs);
+            for (const auto& fileName : calibrationStream.getFileNames())
+            {
+                datasetIdentity += "\n" + samplesCommon::fileIdentity(fileName);
+            }
+            calibrator.reset(new Int8EntropyCalibrator2<MappedBatchStream>(calibrationStream, 0, "SSD",
+                mParams.inputTensorNames[0].c_str(), true, samplesCommon::networkCacheKey(*network, datasetIdentity)));
+        }
         config->setFlag(BuilderFlag::kINT8);
         config->setInt8Calibrator(calibrator.get());
     }
@@ -401,7 +432,7 @@ bool SampleSSD::verifyOutput(const samplesCommon::BufferManager& buffers)
 //!
 //! \brief Initializes members of the params struct using the command line args
 //!
-SampleSSDParams initializeSampleParams(const samplesCommon::Args& args)
+SampleSSDParams initializeSampleParams(const samplesCommon::Args& args, const std::string& calibrationDataset)
 {
     SampleSSDParams params;
     if (args.dataDirs.empty()) //!< Use default directories if user hasn't provided directory paths
@@ -430,6 +461,7 @@ SampleSSDParams initializeSampleParams(const samplesCommon::Args& args)
     params.nbCalBatches = 500;
     params.visualThreshold = 0.6f;
     params.calibrationBatches = "batches/batch_calibration";
+    params.calibrationDataset = calibrationDataset;
 
     return params;
 }
@@ -445,12 +477,45 @@ void printHelpInfo()
     std::cout << "--useDLACore=N  Specify a DLA engine for layers that support DLA. Value can range from 0 to n-1, where n is the number of DLA engines on the platform." << std::endl;
     std::cout << "--fp16          Specify to run in fp16 mode." << std::endl;
     std::cout << "--int8          Specify to run in int8 mode." << std::endl;
+    std::cout << "--calibDataset=<file>  Calibrate from a dataset file written by calibration_pack instead of the "
+                 "batches/batch_calibrationN.batch files."
+              << std::endl;
+}
+
+//!
+//! \brief Removes the --calibDataset=<file> options, which only this sample accepts, from the command line args
+//!
+//! \return false if an option has no file, true otherwise
+//!
+bool takeCalibDataset(std::vector<char*>& argv, std::string& file)
+{
+    const char option[] = "--calibDataset=";
+    const size_t length = sizeof(option) - 1;
+    auto isOption = [&](const char* arg) { return !strncmp(arg, option, length); };
+    const size_t nbArgs = argv.size();
+    for (const char* arg : argv)
+    {
+        if (isOption(arg))
+        {
+            file = arg + length;
+        }
+    }
+    argv.erase(std::remove_if(argv.begin(), argv.end(), isOption), argv.end());
+    return argv.size() == nbArgs || !file.empty();
 }
 
 int main(int argc, char** argv)
 {
+    // The shared parser rejects the options it does not know, so --calibDataset is taken out first.
+    std::vector<char*> sharedArgv(argv, argv + argc);
+    std::string calibrationDataset;
+    bool argsOK = takeCalibDataset(sharedArgv, calibrationDataset);
+    if (!argsOK)
+    {
+        gLogError << "--calibDataset requires option argument" << std::endl;
+    }
     samplesCommon::Args args;
-    bool argsOK = samplesCommon::parseArgs(args, argc, argv);
+    argsOK = argsOK && samplesCommon::parseArgs(args, static_cast<int>(sharedArgv.size()), sharedArgv.data());
     if (!argsOK)
     {
         gLogError << "Invalid arguments" << std::endl;
@@ -467,7 +532,7 @@ int main(int argc, char** argv)
 
     gLogger.reportTestStart(sampleTest);
 
-    SampleSSD sample(initializeSampleParams(args));
+    SampleSSD sample(initializeSampleParams(args, calibrationDataset));
 
     gLogInfo << "Building and running a GPU inference engine for SSD" << std::endl;
 
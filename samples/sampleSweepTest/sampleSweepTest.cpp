@@ -0,0 +1,300 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! sampleSweepTest.cpp
+//! This file contains the unit test of sample::ShapeSweep. Latency models stand in for the engine: a latency that
+//! grows with the batch size under a budget, a throughput that peaks inside the range, shapes that fail, and a
+//! budget no shape meets. It checks the grid, the point the refinement converges on, and that no point is measured
+//! twice. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./sample_sweep_test
+//!
+
+#include "sampleSweep.h"
+#include "unitTest.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+using namespace sample;
+
+namespace
+{
+
+//!
+//! \brief The LatencyModel class measures a shape from a model of its latency and throughput, or fails it, and
+//!        counts the measurements of every shape.
+//!
+class LatencyModel
+{
+public:
+    using Function = std::function<bool(const std::vector<int>& values, double& latency, double& throughput)>;
+
+    explicit LatencyModel(Function function)
+        : mFunction(function)
+    {
+    }
+
+    SweepMeasureFunction measure()
+    {
+        return [this](const std::vector<int>& values, SweepMeasurement& measurement) {
+            mMeasured.push_back(values);
+            double latency{0};
+            double throughput{0};
+            if (!mFunction(values, latency, throughput))
+            {
+                return false;
+            }
+            measurement.latency.mean = latency;
+            measurement.latency.p50 = latency;
+            measurement.latency.p99 = latency;
+            measurement.throughput = static_cast<float>(throughput);
+            return true;
+        };
+    }
+
+    //! The shapes measured, in order
+    const std::vector<std::vector<int>>& getMeasured() const
+    {
+        return mMeasured;
+    }
+
+private:
+    Function mFunction;
+    std::vector<std::vector<int>> mMeasured;
+};
+
+SweepAxis makeAxis(int min, int max)
+{
+    SweepAxis axis;
+    axis.min = min;
+    axis.max = max;
+    axis.inputs = {"input"};
+    return axis;
+}
+
+SweepOptions makeOptions(float latencyBudget, int maxRefinements = 8)
+{
+    SweepOptions options;
+    options.latencyBudget = latencyBudget;
+    options.maxRefinements = maxRefinements;
+    return options;
+}
+
+//! Checks that every point was measured once, in the order of the points, and returns the values of the best one.
+std::vector<int> checkPoints(samplesCommon::UnitTest& test, const ShapeSweep& sweep, const LatencyModel& model)
+{
+    const std::vector<SweepPoint>& points = sweep.getPoints();
+    UNIT_EXPECT(test, points.size() == model.getMeasured().size());
+    std::set<std::vector<int>> unique;
+    for (size_t i = 0; i < points.size() && i < model.getMeasured().size(); ++i)
+    {
+        UNIT_EXPECT(test, points[i].values == model.getMeasured()[i]);
+        unique.insert(points[i].values);
+    }
+    UNIT_EXPECT(test, unique.size() == points.size());
+    if (sweep.getBest() < 0)
+    {
+        return {};
+    }
+    // The best point is the feasible one of highest throughput.
+    const SweepPoint& best = points[sweep.getBest()];
+    UNIT_EXPECT(test, best.feasible && !best.failed);
+    for (const auto& p : points)
+    {
+        UNIT_EXPECT(test, !p.feasible || p.measurement.throughput <= best.measurement.throughput);
+        UNIT_EXPECT(test, !p.failed || !p.feasible);
+    }
+    return best.values;
+}
+
+void testGrid(samplesCommon::UnitTest& test)
+{
+    test.setCase("grid");
+    UNIT_EXPECT(test, ShapeSweep::gridValues(1, 128) == std::vector<int>({1, 2, 4, 8, 16, 32, 64, 128}));
+    UNIT_EXPECT(test, ShapeSweep::gridValues(3, 20) == std::vector<int>({3, 4, 8, 16, 20}));
+    UNIT_EXPECT(test, ShapeSweep::gridValues(4, 8) == std::vector<int>({4, 8}));
+    UNIT_EXPECT(test, ShapeSweep::gridValues(5, 5) == std::vector<int>({5}));
+
+    // Without refinement, the grid of two axes is measured with the last axis moving fastest.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1;
+        throughput = values[0] * values[1];
+        return true;
+    });
+    ShapeSweep sweep({makeAxis(1, 4), makeAxis(2, 3)}, makeOptions(0, 0));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    const std::vector<std::vector<int>> grid{{1, 2}, {1, 3}, {2, 2}, {2, 3}, {4, 2}, {4, 3}};
+    UNIT_EXPECT(test, model.getMeasured() == grid);
+    UNIT_EXPECT(test, checkPoints(test, sweep, model) == std::vector<int>({4, 3}));
+}
+
+void testLatencyBudget(samplesCommon::UnitTest& test)
+{
+    test.setCase("latency budget");
+    // The latency grows by 0.25 ms per sample over 1 ms, so 28 is the largest batch within 8 ms, and the fastest
+    // since the throughput grows with the batch.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1 + 0.25 * values[0];
+        throughput = values[0] * 1000 / latency;
+        return true;
+    });
+    ShapeSweep sweep({makeAxis(1, 64)}, makeOptions(8));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    UNIT_EXPECT(test, checkPoints(test, sweep, model) == std::vector<int>({28}));
+    // The grid bracket [16, 32] is bisected: 24, then 28, then 30 and 29 over budget.
+    const std::vector<std::vector<int>> measured{{1}, {2}, {4}, {8}, {16}, {32}, {64}, {24}, {28}, {30}, {29}};
+    UNIT_EXPECT(test, model.getMeasured() == measured);
+    for (size_t i = 0; i < sweep.getPoints().size(); ++i)
+    {
+        UNIT_EXPECT(test, sweep.getPoints()[i].refined == (i >= 7));
+    }
+}
+
+void testPeak(samplesCommon::UnitTest& test)
+{
+    test.setCase("throughput peak");
+    // Without a budget, the throughput peaks at 45, between the grid points 32 and 64.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1;
+        throughput = 1000 - std::pow(std::abs(values[0] - 45), 1.5) - (values[0] > 45 ? 1 : 0);
+        return true;
+    });
+    ShapeSweep sweep({makeAxis(1, 128)}, makeOptions(0));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    UNIT_EXPECT(test, checkPoints(test, sweep, model) == std::vector<int>({45}));
+
+    test.setCase("refinement limit");
+    // The refinement stops after maxRefinements points, on the best point measured so far.
+    LatencyModel limited([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1;
+        throughput = 1000 - std::pow(std::abs(values[0] - 45), 1.5) - (values[0] > 45 ? 1 : 0);
+        return true;
+    });
+    ShapeSweep limitedSweep({makeAxis(1, 128)}, makeOptions(0, 2));
+    UNIT_EXPECT(test, limitedSweep.run(limited.measure()));
+    UNIT_EXPECT(test, limitedSweep.getPoints().size() == ShapeSweep::gridValues(1, 128).size() + 2);
+    checkPoints(test, limitedSweep, limited);
+}
+
+void testFailures(samplesCommon::UnitTest& test)
+{
+    test.setCase("failed points");
+    // Batches above 40 cannot run; they are never the best, and bound the search like points over budget.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1 + 0.1 * values[0];
+        throughput = values[0] * 1000 / latency;
+        return values[0] <= 40;
+    });
+    ShapeSweep sweep({makeAxis(1, 64)}, makeOptions(0));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    UNIT_EXPECT(test, checkPoints(test, sweep, model) == std::vector<int>({40}));
+    UNIT_EXPECT(test, sweep.getPoints()[6].values == std::vector<int>({64}) && sweep.getPoints()[6].failed);
+
+    test.setCase("all points failed");
+    LatencyModel failing([](const std::vector<int>&, double&, double&) { return false; });
+    ShapeSweep failed({makeAxis(1, 8)}, makeOptions(0));
+    UNIT_EXPECT(test, !failed.run(failing.measure()));
+    UNIT_EXPECT(test, failed.getBest() == -1);
+    UNIT_EXPECT(test, failed.getPoints().size() == 4);
+}
+
+void testUnmeetableBudget(samplesCommon::UnitTest& test)
+{
+    test.setCase("unmeetable budget");
+    // Every shape takes at least 10 ms: the grid is measured, nothing is feasible, and nothing is refined.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 10 + values[0];
+        throughput = values[0] * 1000 / latency;
+        return true;
+    });
+    ShapeSweep sweep({makeAxis(1, 32)}, makeOptions(8));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    UNIT_EXPECT(test, sweep.getBest() == -1);
+    UNIT_EXPECT(test, sweep.getPoints().size() == ShapeSweep::gridValues(1, 32).size());
+    checkPoints(test, sweep, model);
+}
+
+void testTwoAxes(samplesCommon::UnitTest& test)
+{
+    test.setCase("two axes");
+    // The latency grows with the number of elements of the shape, so at most 140 fit within 8 ms. The best grid
+    // point, (8, 16), is refined along the batch, where every value above is over budget, then along the second
+    // axis, up to (8, 17); a second pass finds no neighbour left to bisect towards.
+    LatencyModel model([](const std::vector<int>& values, double& latency, double& throughput) {
+        latency = 1 + 0.05 * values[0] * values[1];
+        throughput = values[0] * values[1] * 1000 / latency;
+        return true;
+    });
+    ShapeSweep sweep({makeAxis(1, 16), makeAxis(8, 24)}, makeOptions(8, 16));
+    UNIT_EXPECT(test, sweep.run(model.measure()));
+    UNIT_EXPECT(test, checkPoints(test, sweep, model) == std::vector<int>({8, 17}));
+    const std::vector<std::vector<int>>& measured = model.getMeasured();
+    const std::vector<std::vector<int>> refined{{12, 16}, {10, 16}, {9, 16}, {8, 20}, {8, 18}, {8, 17}};
+    UNIT_EXPECT(test, measured.size() == 15 + refined.size());
+    UNIT_EXPECT(test, measured.size() >= 15 && std::vector<std::vector<int>>(measured.begin() + 15, measured.end())
+            == refined);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.sample_sweep_test", argc, argv);
+    testGrid(test);
+    testLatencyBudget(test);
+    testPeak(test);
+    testFailures(test);
+    testUnmeetableBudget(test);
+    testTwoAxes(test);
+    return test.report();
+}
@@ -57,6 +57,7 @@
 
 #include "BatchStream.h"
 #include "EntropyCalibrator.h"
+#include "PrefetchingBatchStream.h"
 #include "argsParser.h"
 #include "buffers.h"
 #include "common.h"
@@ -66,6 +67,7 @@
 #include "NvUffParser.h"
 #include <cuda_runtime_api.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -237,9 +239,22 @@ bool SampleUffSSD::constructNetwork(SampleUniquePtr<nvinfer1::IBuilder>& builder
         const int imageW = 300;
         nvinfer1::DimsNCHW imageDims{};
         imageDims = nvinfer1::DimsNCHW{mParams.calBatchSize, imageC, imageH, imageW};
-        BatchStream calibrationStream(mParams.nbCalBatches, imageDims, listFileName, mParams.dataDirs);
-        calibrator.reset(
-            new Int8EntropyCalibrator2<BatchStream>(calibrationStream, 0, "UffSSD", mParams.inputTensorNames[0].c_str()));
+        // Decoding the calibration images is expensive, so overlap it with calibration on the GPU.
+        BatchStream imageStream(mParams.nbCalBatches, imageDims, listFileName, mParams.dataDirs);
+        // Replacing an image must invalidate the table, so every image read by calibration is part of the identity.
+        std::string datasetIdentity = samplesCommon::fileIdentity(locateFile(listFileName, mParams.dataDirs))
+            + " batches 0-" + std::to_string(mParams.nbCalBatches);
+        const std::vector<std::string>& imageNames = imageStream.getImageNames();
+        const size_t nbImages = std::min<size_t>(
+            imageNames.size(), static_cast<size_t>(mParams.nbCalBatches) * mParams.calBatchSize);
+        for (size_t i = 0; i < nbImages; ++i)
+        {
+            datasetIdentity += "\n" + samplesCommon::fileIdentity(locateFile(imageNames[i], mParams.dataDirs));
+        }
+        PrefetchingBatchStream<BatchStream> calibrationStream(imageStream);
+        calibrator.reset(new Int8EntropyCalibrator2<PrefetchingBatchStream<BatchStream>>(calibrationStream, 0,
+            "UffSSD", mParams.inputTensorNames[0].c_str(), true,
+            samplesCommon::networkCacheKey(*network, datasetIdentity)));
         config->setFlag(BuilderFlag::kINT8);
         config->setInt8Calibrator(calibrator.get());
     }
@@ -0,0 +1,334 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! shardedBatchStreamTest.cpp
+//! This file contains the unit test of ShardedBatchStream.h: for both shard modes, every batch of a range is read by
+//! exactly one shard, including uneven batch counts and more shards than batches, and the score files written by the
+//! shards of sample_int8 merge into the counters of the whole run. It needs neither TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./sharded_batch_stream_test
+//!
+
+#include "ShardedBatchStream.h"
+#include "unitTest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//!
+//! \brief A stream of nbBatches batches of one value, the index of the batch, that counts how often each batch
+//!        is read.
+//!
+class CountingBatchStream : public IBatchStream
+{
+public:
+    explicit CountingBatchStream(int nbBatches)
+        : mReads(std::make_shared<std::vector<int>>(nbBatches, 0))
+    {
+    }
+
+    void reset(int firstBatch) override
+    {
+        mBatch = firstBatch;
+    }
+
+    bool next() override
+    {
+        if (mBatch >= static_cast<int>(mReads->size()))
+        {
+            return false;
+        }
+        ++(*mReads)[mBatch];
+        mValue = static_cast<float>(mBatch++);
+        ++mBatchesRead;
+        return true;
+    }
+
+    void skip(int skipCount) override
+    {
+        mBatch += skipCount;
+    }
+
+    float* getBatch() override
+    {
+        return &mValue;
+    }
+
+    float* getLabels() override
+    {
+        return &mValue;
+    }
+
+    int getBatchesRead() const override
+    {
+        return mBatchesRead;
+    }
+
+    int getBatchSize() const override
+    {
+        return 1;
+    }
+
+    nvinfer1::Dims getDims() const override
+    {
+        return nvinfer1::Dims4{1, 1, 1, 1};
+    }
+
+    nvinfer1::Dims getImageDims() const override
+    {
+        return nvinfer1::Dims3{1, 1, 1};
+    }
+
+    //! Returns how often each batch was read, shared between copies.
+    const std::vector<int>& getReads() const
+    {
+        return *mReads;
+    }
+
+private:
+    std::shared_ptr<std::vector<int>> mReads;
+    int mBatch{0};
+    int mBatchesRead{0};
+    float mValue{-1.0F};
+};
+
+const std::string kSCORE_FILE = "sharded_batch_stream_test.score";
+
+//! Reads a whole shard and returns its batches in the order they were read.
+std::vector<int> readShard(ShardedBatchStream<CountingBatchStream>& shard)
+{
+    std::vector<int> batches;
+    while (shard.next())
+    {
+        batches.push_back(static_cast<int>(*shard.getBatch()));
+    }
+    return batches;
+}
+
+void testPartition(samplesCommon::UnitTest& test, ShardMode mode)
+{
+    const int firstBatch = 3;
+    bool allOnce = true;
+    bool balanced = true;
+    bool ordered = true;
+    for (int nbBatches : {0, 1, 5, 7, 12, 13})
+    {
+        for (int shardCount : {1, 2, 3, 4, 5, 16})
+        {
+            // The stream is longer than the range, so reading past the range would show.
+            const CountingBatchStream stream(firstBatch + nbBatches + shardCount + 2);
+            int total = 0;
+            for (int shardIndex = 0; shardIndex < shardCount; ++shardIndex)
+            {
+                ShardedBatchStream<CountingBatchStream> shard(
+                    stream, firstBatch, nbBatches, shardIndex, shardCount, mode);
+                const std::vector<int> batches = readShard(shard);
+                total += shard.getShardBatches();
+                balanced &= static_cast<int>(batches.size()) == shard.getShardBatches()
+                    && shard.getBatchesRead() == shard.getShardBatches()
+                    && shard.getShardBatches() >= nbBatches / shardCount
+                    && shard.getShardBatches() <= (nbBatches + shardCount - 1) / shardCount;
+                for (size_t i = 0; i < batches.size(); ++i)
+                {
+                    if (mode == ShardMode::kCONTIGUOUS)
+                    {
+                        ordered &= i == 0 || batches[i] == batches[i - 1] + 1;
+                    }
+                    else
+                    {
+                        ordered &= batches[i] == firstBatch + shardIndex + static_cast<int>(i) * shardCount;
+                    }
+                }
+            }
+            allOnce &= total == nbBatches;
+            const std::vector<int>& reads = stream.getReads();
+            for (int b = 0; b < static_cast<int>(reads.size()); ++b)
+            {
+                const bool inRange = b >= firstBatch && b < firstBatch + nbBatches;
+                allOnce &= reads[b] == (inRange ? 1 : 0);
+            }
+        }
+    }
+    UNIT_EXPECT(test, allOnce);
+    UNIT_EXPECT(test, balanced);
+    UNIT_EXPECT(test, ordered);
+}
+
+void testContiguous(samplesCommon::UnitTest& test)
+{
+    test.setCase("contiguous");
+    testPartition(test, ShardMode::kCONTIGUOUS);
+
+    // 7 batches over 3 shards: the first shard takes the extra batch.
+    const CountingBatchStream stream(20);
+    const std::vector<std::vector<int>> expected{{10, 11, 12}, {13, 14}, {15, 16}};
+    for (int shardIndex = 0; shardIndex < 3; ++shardIndex)
+    {
+        ShardedBatchStream<CountingBatchStream> shard(stream, 10, 7, shardIndex, 3);
+        UNIT_EXPECT(test, readShard(shard) == expected[shardIndex]);
+    }
+}
+
+void testStrided(samplesCommon::UnitTest& test)
+{
+    test.setCase("strided");
+    testPartition(test, ShardMode::kSTRIDED);
+
+    const CountingBatchStream stream(20);
+    const std::vector<std::vector<int>> expected{{10, 13, 16}, {11, 14}, {12, 15}};
+    for (int shardIndex = 0; shardIndex < 3; ++shardIndex)
+    {
+        ShardedBatchStream<CountingBatchStream> shard(stream, 10, 7, shardIndex, 3, ShardMode::kSTRIDED);
+        UNIT_EXPECT(test, readShard(shard) == expected[shardIndex]);
+    }
+}
+
+void testPositioning(samplesCommon::UnitTest& test)
+{
+    test.setCase("positioning");
+    // Positions seen through reset() and skip() are local to the shard.
+    for (const ShardMode mode : {ShardMode::kCONTIGUOUS, ShardMode::kSTRIDED})
+    {
+        const CountingBatchStream stream(40);
+        ShardedBatchStream<CountingBatchStream> shard(stream, 5, 20, 1, 4, mode);
+        const std::vector<int> all = readShard(shard);
+        UNIT_EXPECT(test, all.size() == 5);
+        shard.reset(2);
+        UNIT_EXPECT(test, shard.next() && *shard.getBatch() == all[2]);
+        shard.skip(1);
+        UNIT_EXPECT(test, shard.next() && *shard.getBatch() == all[4]);
+        UNIT_EXPECT(test, !shard.next());
+        UNIT_EXPECT(test, shard.getBatchesRead() == 2);
+    }
+
+    test.setCase("shard mode");
+    UNIT_EXPECT(test, parseShardMode("contiguous") == ShardMode::kCONTIGUOUS);
+    UNIT_EXPECT(test, parseShardMode("strided") == ShardMode::kSTRIDED);
+    bool thrown = false;
+    try
+    {
+        parseShardMode("random");
+    }
+    catch (const std::invalid_argument&)
+    {
+        thrown = true;
+    }
+    UNIT_EXPECT(test, thrown);
+}
+
+void testScoreFiles(samplesCommon::UnitTest& test)
+{
+    test.setCase("score files");
+    const std::vector<std::string> names{"FP32", "FP16", "INT8"};
+    std::vector<std::vector<ScoreCounters>> shards(3, std::vector<ScoreCounters>(3));
+    std::vector<ScoreCounters> expected(3);
+    for (int s = 0; s < 3; ++s)
+    {
+        for (int t = 0; t < 3; ++t)
+        {
+            // A data type may be skipped, and then left at zero, by some runs.
+            ScoreCounters& counters = shards[s][t];
+            counters.images = t == 1 && s == 2 ? 0 : 100 + s;
+            counters.top1 = counters.images ? 90 - t - s : 0;
+            counters.top5 = counters.images ? 99 - s : 0;
+            expected[t] += counters;
+        }
+    }
+    std::vector<ScoreCounters> merged(3);
+    for (int s = 0; s < 3; ++s)
+    {
+        UNIT_EXPECT(test, writeScoreFile(kSCORE_FILE, names, shards[s]));
+        UNIT_EXPECT(test, mergeScoreFile(kSCORE_FILE, names, merged));
+    }
+    for (int t = 0; t < 3; ++t)
+    {
+        UNIT_EXPECT(test, merged[t].top1 == expected[t].top1);
+        UNIT_EXPECT(test, merged[t].top5 == expected[t].top5);
+        UNIT_EXPECT(test, merged[t].images == expected[t].images);
+    }
+    UNIT_EXPECT_NEAR(test, merged[0].score().first, 267.0 / 303.0, 1e-6);
+    UNIT_EXPECT(test, ScoreCounters().score() == std::make_pair(0.0F, 0.0F));
+
+    test.setCase("malformed score files");
+    auto mergeText = [&](const std::string& text) {
+        {
+            std::ofstream file(kSCORE_FILE);
+            file << text;
+        }
+        std::vector<ScoreCounters> counters(3);
+        const bool merged = mergeScoreFile(kSCORE_FILE, names, counters);
+        return merged ? counters[0].images + counters[2].images : -1;
+    };
+    UNIT_EXPECT(test, mergeText("FP32 1 2 3\n\nINT8 4 5 6\n") == 9);
+    UNIT_EXPECT(test, mergeText("FP32 1 2\n") == -1);
+    UNIT_EXPECT(test, mergeText("FP64 1 2 3\n") == -1);
+    UNIT_EXPECT(test, mergeText("FP32 a b c\n") == -1);
+    std::remove(kSCORE_FILE.c_str());
+    std::vector<ScoreCounters> counters(3);
+    UNIT_EXPECT(test, !mergeScoreFile(kSCORE_FILE, names, counters));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.sharded_batch_stream_test", argc, argv);
+    testContiguous(test);
+    testStrided(test);
+    testPositioning(test);
+    testScoreFiles(test);
+    return test.report();
+}
@@ -0,0 +1,329 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! stabilityControllerTest.cpp
+//! This file contains the unit test of samplesCommon::StabilityController. It feeds seeded series to the controller:
+//! autocorrelated AR(1) latencies, which must become stable with intervals that cover the true value at about the
+//! confidence level, and latencies with a trend, which must be reported as drifting and never stable. It also checks
+//! the doubling of the windows, the merging of their statistics, and the quantile approximations. It needs neither
+//! TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./stability_controller_test
+//!
+
+#include "stabilityController.h"
+#include "unitTest.h"
+
+#include <random>
+#include <vector>
+
+using samplesCommon::StabilityController;
+using samplesCommon::StabilityOptions;
+using samplesCommon::StabilityReport;
+
+namespace
+{
+
+//!
+//! \brief The Ar1Series class generates latencies x(t) = level + phi * (x(t-1) - level) + e(t), with normal e(t)
+//!        of standard deviation sigma, optionally on a linear trend of the level, starting from the stationary
+//!        distribution.
+//!
+class Ar1Series
+{
+public:
+    Ar1Series(unsigned seed, double level, double phi, double sigma, double trend = 0)
+        : mGenerator(seed)
+        , mNoise(0, sigma)
+        , mLevel(level)
+        , mPhi(phi)
+        , mTrend(trend)
+    {
+        mDeviation = mNoise(mGenerator) / std::sqrt(1 - phi * phi);
+    }
+
+    double next()
+    {
+        const double value = mLevel + mTrend * mIndex++ + mDeviation;
+        mDeviation = mPhi * mDeviation + mNoise(mGenerator);
+        return value;
+    }
+
+private:
+    std::mt19937 mGenerator;
+    std::normal_distribution<double> mNoise;
+    double mLevel{0};
+    double mPhi{0};
+    double mTrend{0};    //!< Change of the level per sample
+    double mDeviation{0}; //!< Deviation of the next value from the level
+    int64_t mIndex{0};
+};
+
+StabilityOptions makeOptions(bool median, double targetPrecision)
+{
+    StabilityOptions options;
+    options.median = median;
+    options.targetPrecision = targetPrecision;
+    return options;
+}
+
+void testQuantiles(samplesCommon::UnitTest& test)
+{
+    test.setCase("quantiles");
+    UNIT_EXPECT_NEAR(test, samplesCommon::normalQuantile(0.5), 0, 1e-9);
+    UNIT_EXPECT_NEAR(test, samplesCommon::normalQuantile(0.975), 1.959963985, 1e-8);
+    UNIT_EXPECT_NEAR(test, samplesCommon::normalQuantile(0.005), -2.575829304, 1e-8);
+    // Tables of the Student t distribution; the expansion is within 0.5% from 4 degrees of freedom.
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 4), 2.776445, 0.005 * 2.776445);
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 10), 2.228139, 0.005 * 2.228139);
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 31), 2.039513, 0.005 * 2.039513);
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.995, 62), 2.657479, 0.005 * 2.657479);
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 3), 3.182446, 0.005 * 3.182446);
+    // Exact below
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 1), 12.706205, 1e-5);
+    UNIT_EXPECT_NEAR(test, samplesCommon::studentQuantile(0.975, 2), 4.302653, 1e-5);
+}
+
+void testWindowDoubling(samplesCommon::UnitTest& test)
+{
+    test.setCase("window doubling");
+    StabilityController controller;
+    Ar1Series series(1, 10, 0.5, 0.1);
+    // The default windows start with 8 samples and double whenever there are 64 of them.
+    for (int i = 0; i < 8 * 64 - 1; ++i)
+    {
+        controller.add(series.next());
+    }
+    UNIT_EXPECT(test, controller.getReport().windowSize == 8);
+    UNIT_EXPECT(test, controller.getReport().windows == 63);
+    controller.add(series.next());
+    UNIT_EXPECT(test, controller.getReport().windowSize == 16);
+    UNIT_EXPECT(test, controller.getReport().windows == 32);
+    UNIT_EXPECT(test, controller.getReport().samples == 8 * 64);
+    int minWindows{64};
+    int maxWindows{0};
+    for (int i = 8 * 64; i < 8 * 64 * 8; ++i)
+    {
+        controller.add(series.next());
+        minWindows = std::min(minWindows, controller.getReport().windows);
+        maxWindows = std::max(maxWindows, controller.getReport().windows);
+    }
+    // From then on, between maxWindows / 2 and maxWindows - 1 windows
+    UNIT_EXPECT(test, controller.getReport().windowSize == 128);
+    UNIT_EXPECT(test, controller.getReport().windows == 32);
+    UNIT_EXPECT(test, minWindows == 32);
+    UNIT_EXPECT(test, maxWindows == 63);
+    // The report only changes when a window completes.
+    const StabilityReport before = controller.getReport();
+    controller.add(1000);
+    UNIT_EXPECT(test, controller.getReport().samples == before.samples);
+    UNIT_EXPECT(test, controller.getReport().estimate == before.estimate);
+}
+
+void testMergedMeans(samplesCommon::UnitTest& test)
+{
+    test.setCase("merged means");
+    // The samples are dropped once summarized, but merging the means of windows keeps the estimate the mean of
+    // all the samples of the complete windows.
+    StabilityController controller(makeOptions(false, 0.01));
+    Ar1Series series(2, 10, 0.5, 0.1);
+    std::vector<double> samples;
+    for (int i = 0; i < 100000; ++i)
+    {
+        samples.push_back(series.next());
+        controller.add(samples.back());
+    }
+    const StabilityReport& report = controller.getReport();
+    const size_t complete = static_cast<size_t>(report.windows) * report.windowSize;
+    UNIT_EXPECT(test, complete <= samples.size() && samples.size() - complete < static_cast<size_t>(report.windowSize));
+    double sum{0};
+    for (size_t i = 0; i < complete; ++i)
+    {
+        sum += samples[i];
+    }
+    UNIT_EXPECT_NEAR(test, report.estimate, sum / complete, 1e-9);
+    UNIT_EXPECT(test, report.samples == complete);
+}
+
+void testMinimumWindows(samplesCommon::UnitTest& test)
+{
+    test.setCase("minimum windows");
+    StabilityController controller;
+    // Constant latencies have an interval of width 0, but are only trusted from 8 windows of 8 samples.
+    for (int i = 0; i < 63; ++i)
+    {
+        controller.add(2);
+        UNIT_EXPECT(test, !controller.isStable());
+    }
+    controller.add(2);
+    UNIT_EXPECT(test, controller.isStable());
+    UNIT_EXPECT(test, controller.getReport().estimate == 2);
+    UNIT_EXPECT(test, !controller.getReport().drifting);
+}
+
+//! Feeds an AR(1) series until the controller is stable, and returns the samples it took, or 0 past maxSamples.
+int runUntilStable(StabilityController& controller, Ar1Series& series, int maxSamples)
+{
+    for (int i = 1; i <= maxSamples; ++i)
+    {
+        controller.add(series.next());
+        if (controller.isStable())
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void testAr1(samplesCommon::UnitTest& test, bool median)
+{
+    test.setCase(median ? "AR(1) median" : "AR(1) mean");
+    // Strongly correlated latencies around 10 ms, with a stationary deviation of 0.46 ms.
+    const double level = 10;
+    const int runs = 200;
+    int covered{0};
+    int stable{0};
+    int drifting{0};
+    for (int run = 0; run < runs; ++run)
+    {
+        StabilityController controller(makeOptions(median, 0.01));
+        Ar1Series series(100 + run, level, 0.9, 0.2);
+        if (runUntilStable(controller, series, 100000))
+        {
+            ++stable;
+        }
+        const StabilityReport& report = controller.getReport();
+        UNIT_EXPECT(test, report.precision <= 0.01);
+        covered += report.low <= level && level <= report.high;
+        drifting += report.drifting;
+    }
+    gLogInfo << (median ? "Median" : "Mean") << " of AR(1) latencies: " << stable << " of " << runs
+             << " runs stable, " << covered << " intervals cover the level, " << drifting << " drifting" << std::endl;
+    UNIT_EXPECT(test, stable == runs);
+    // The intervals cover the level at nearly the confidence level of 95%: stopping at the first interval narrow
+    // enough favors intervals that are too narrow, and 200 runs leave some binomial noise.
+    UNIT_EXPECT(test, covered >= runs * 85 / 100);
+    UNIT_EXPECT(test, drifting == 0);
+}
+
+void testCorrelationNeedsLongerRuns(samplesCommon::UnitTest& test)
+{
+    test.setCase("AR(1) needs longer runs");
+    // With the same noise, correlated latencies need more samples for the same precision.
+    StabilityController independent(makeOptions(false, 0.002));
+    StabilityController correlated(makeOptions(false, 0.002));
+    Ar1Series independentSeries(7, 10, 0, 0.2);
+    Ar1Series correlatedSeries(7, 10, 0.9, 0.2 * std::sqrt(1 - 0.9 * 0.9));
+    const int independentSamples = runUntilStable(independent, independentSeries, 1000000);
+    const int correlatedSamples = runUntilStable(correlated, correlatedSeries, 1000000);
+    gLogInfo << "Samples until stable: " << independentSamples << " independent, " << correlatedSamples
+             << " correlated" << std::endl;
+    UNIT_EXPECT(test, independentSamples > 0);
+    UNIT_EXPECT(test, correlatedSamples > 4 * independentSamples);
+}
+
+void testTrend(samplesCommon::UnitTest& test, bool median, double trend)
+{
+    test.setCase(std::string(median ? "median" : "mean") + (trend > 0 ? " upward" : " downward") + " trend");
+    const int samples = 4096;
+    // The level moves by trend over the run, on top of AR(1) noise.
+    for (unsigned seed = 0; seed < 20; ++seed)
+    {
+        StabilityController controller(makeOptions(median, 0.01));
+        Ar1Series series(200 + seed, 10, 0.5, 0.05, 10 * trend / samples);
+        bool everStable{false};
+        for (int i = 0; i < samples; ++i)
+        {
+            controller.add(series.next());
+            everStable = everStable || (i > samples / 2 && controller.isStable());
+        }
+        const StabilityReport& report = controller.getReport();
+        UNIT_EXPECT(test, report.drifting);
+        UNIT_EXPECT(test, !report.stable);
+        UNIT_EXPECT(test, !everStable);
+        // The drift is the change of the level relative to its average over the run.
+        UNIT_EXPECT_NEAR(test, report.drift, trend / (1 + trend / 2), 0.02);
+    }
+}
+
+void testSmallTrend(samplesCommon::UnitTest& test)
+{
+    test.setCase("trend below the threshold");
+    // A change of 0.5% over the run is detected as a trend but is below the 2% drift threshold.
+    StabilityController controller(makeOptions(true, 0.01));
+    Ar1Series series(300, 10, 0.5, 0.01, 10 * 0.005 / 4096);
+    for (int i = 0; i < 4096; ++i)
+    {
+        controller.add(series.next());
+    }
+    UNIT_EXPECT(test, !controller.getReport().drifting);
+    UNIT_EXPECT(test, controller.isStable());
+    UNIT_EXPECT_NEAR(test, controller.getReport().drift, 0.005, 0.002);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.stability_controller_test", argc, argv);
+    testQuantiles(test);
+    testWindowDoubling(test);
+    testMergedMeans(test);
+    testMinimumWindows(test);
+    for (const bool median : {true, false})
+    {
+        testAr1(test, median);
+        testTrend(test, median, 0.1);
+        testTrend(test, median, -0.1);
+    }
+    testCorrelationNeedsLongerRuns(test);
+    testSmallTrend(test);
+    return test.report();
+}
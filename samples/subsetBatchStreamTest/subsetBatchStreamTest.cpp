@@ -0,0 +1,313 @@
+/*
+ * Copyright 1993-2019 NVIDIA Corporation.  All rights reserved.
+ *
+ * NOTICE TO LICENSEE:
+ *
+ * This source code and/or documentation ("Licensed Deliverables") are
+ * subject to NVIDIA intellectual property rights under U.S. and
+ * international Copyright laws.
+ *
+ * These Licensed Deliverables contained herein is PROPRIETARY and
+ * CONFIDENTIAL to NVIDIA and is being provided under the terms and
+ * conditions of a form of NVIDIA software license agreement by and
+ * between NVIDIA and Licensee ("License Agreement") or electronically
+ * accepted by Licensee.  Notwithstanding any terms or conditions to
+ * the contrary in the License Agreement, reproduction or disclosure
+ * of the Licensed Deliverables to any third party without the express
+ * written consent of NVIDIA is prohibited.
+ *
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, NVIDIA MAKES NO REPRESENTATION ABOUT THE
+ * SUITABILITY OF THESE LICENSED DELIVERABLES FOR ANY PURPOSE.  IT IS
+ * PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF ANY KIND.
+ * NVIDIA DISCLAIMS ALL WARRANTIES WITH REGARD TO THESE LICENSED
+ * DELIVERABLES, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE.
+ * NOTWITHSTANDING ANY TERMS OR CONDITIONS TO THE CONTRARY IN THE
+ * LICENSE AGREEMENT, IN NO EVENT SHALL NVIDIA BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, OR ANY
+ * DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS
+ * ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE
+ * OF THESE LICENSED DELIVERABLES.
+ *
+ * U.S. Government End Users.  These Licensed Deliverables are a
+ * "commercial item" as that term is defined at 48 C.F.R. 2.101 (OCT
+ * 1995), consisting of "commercial computer software" and "commercial
+ * computer software documentation" as such terms are used in 48
+ * C.F.R. 12.212 (SEPT 1995) and is provided to the U.S. Government
+ * only as a commercial end item.  Consistent with 48 C.F.R.12.212 and
+ * 48 C.F.R. 227.7202-1 through 227.7202-4 (JUNE 1995), all
+ * U.S. Government End Users acquire the Licensed Deliverables with
+ * only those rights set forth herein.
+ *
+ * Any use of the Licensed Deliverables in individual and commercial
+ * software must include, in the user documentation and internal
+ * comments to the code, the above Disclaimer and U.S. Government End
+ * Users Notice.
+ */
+
+//!
+//! subsetBatchStreamTest.cpp
+//! This file contains the unit test of SubsetBatchStream.h: k-means++ seeding is deterministic and spreads over
+//! clusters, selectDiverseImages returns distinct sorted images, and SubsetBatchStream replays exactly the images
+//! the selection scanned. The replay is checked against MNISTBatchStream, whose next() after reset(b) returns
+//! batch b + 1 of its files, and DatasetBatchStream, whose next() after reset(b) returns batch b. It needs neither
+//! TensorRT nor a GPU.
+//! It can be run with the following command line:
+//! Command: ./subset_batch_stream_test
+//!
+
+#include "BatchStream.h"
+#include "SubsetBatchStream.h"
+#include "calibrationDataset.h"
+#include "unitTest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace samplesCommon;
+
+namespace
+{
+
+const std::string kIMAGES = "subset_batch_stream_test-images-idx3-ubyte";
+const std::string kLABELS = "subset_batch_stream_test-labels-idx1-ubyte";
+const std::string kDATASET = "subset_batch_stream_test.dataset";
+constexpr int kSIDE = 28;
+constexpr int kIMAGE_SIZE = kSIDE * kSIDE;
+constexpr int kNB_IMAGES = 60;
+constexpr int kSTREAM_BATCH = 5;
+
+//! Returns the pixels of the images of the files. The first pixel of each image is its index in the files, and its
+//! label is the index plus 100, so that every image read back can be traced to its position.
+std::vector<uint8_t> makePixels()
+{
+    std::vector<uint8_t> pixels(kNB_IMAGES * kIMAGE_SIZE);
+    std::mt19937 generator(7);
+    for (int i = 0; i < kNB_IMAGES; ++i)
+    {
+        // Images differ in brightness and contrast, so that their features spread.
+        const int base = (i * 37) % 128;
+        std::uniform_int_distribution<int> noise(0, (i * 11) % 127 + 1);
+        for (int p = 1; p < kIMAGE_SIZE; ++p)
+        {
+            pixels[i * kIMAGE_SIZE + p] = static_cast<uint8_t>(base + noise(generator));
+        }
+        pixels[i * kIMAGE_SIZE] = static_cast<uint8_t>(i);
+    }
+    return pixels;
+}
+
+void writeBigEndian(std::ofstream& file, int value)
+{
+    const int swapped = swapEndianness(value);
+    file.write(reinterpret_cast<const char*>(&swapped), sizeof(swapped));
+}
+
+//! Writes the images as MNIST IDX files and as a float dataset file.
+void writeFiles()
+{
+    const std::vector<uint8_t> pixels = makePixels();
+    std::vector<float> labels(kNB_IMAGES);
+    for (int i = 0; i < kNB_IMAGES; ++i)
+    {
+        labels[i] = static_cast<float>(i + 100);
+    }
+
+    std::ofstream images(kIMAGES, std::ios::binary);
+    for (int value : {2051, kNB_IMAGES, kSIDE, kSIDE})
+    {
+        writeBigEndian(images, value);
+    }
+    images.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+
+    std::ofstream labelFile(kLABELS, std::ios::binary);
+    for (int value : {2049, kNB_IMAGES})
+    {
+        writeBigEndian(labelFile, value);
+    }
+    for (const float label : labels)
+    {
+        labelFile.put(static_cast<char>(label));
+    }
+
+    std::vector<float> normalized(pixels.size());
+    std::transform(pixels.begin(), pixels.end(), normalized.begin(), [](uint8_t v) { return v / 255.0F; });
+    const CalibrationDatasetWriter dataset(kDATASET, DatasetType::kFLOAT, 1, kSIDE, kSIDE, kNB_IMAGES, true);
+    dataset.writeImages(0, kNB_IMAGES, normalized.data(), labels.data());
+}
+
+void removeFiles()
+{
+    std::remove(kIMAGES.c_str());
+    std::remove(kLABELS.c_str());
+    std::remove(kDATASET.c_str());
+}
+
+MNISTBatchStream makeMNISTStream()
+{
+    return MNISTBatchStream(kSTREAM_BATCH, kNB_IMAGES / kSTREAM_BATCH, kIMAGES, kLABELS, {"./"});
+}
+
+DatasetBatchStream makeDatasetStream()
+{
+    return DatasetBatchStream(kSTREAM_BATCH, kNB_IMAGES / kSTREAM_BATCH, kDATASET, {"./"});
+}
+
+//! Returns the index in the files of the first image of the batches the stream returns, as the stream is read.
+template <typename TBatchStream>
+std::vector<int> readFirstImages(TBatchStream& stream)
+{
+    std::vector<int> firstImages;
+    while (stream.next())
+    {
+        firstImages.push_back(static_cast<int>(std::lround(stream.getBatch()[0] * 255.0F)));
+    }
+    return firstImages;
+}
+
+void testSeeding(samplesCommon::UnitTest& test)
+{
+    test.setCase("seeding");
+    // Four tight clusters of 50 points far apart, in 3 dimensions.
+    const int dim = 3;
+    std::vector<float> points;
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> jitter(-0.01F, 0.01F);
+    for (int p = 0; p < 200; ++p)
+    {
+        const int cluster = p % 4;
+        points.push_back(100.0F * (cluster & 1) + jitter(generator));
+        points.push_back(100.0F * (cluster >> 1) + jitter(generator));
+        points.push_back(jitter(generator));
+    }
+
+    const std::vector<int64_t> seeds = kMeansPlusPlusSeeds(points, dim, 4, 1);
+    UNIT_EXPECT(test, seeds.size() == 4);
+    // One point of every cluster.
+    std::set<int64_t> clusters;
+    for (const auto seed : seeds)
+    {
+        clusters.insert(seed % 4);
+    }
+    UNIT_EXPECT(test, clusters.size() == 4);
+
+    // The result only depends on the points, k and the seed, not on the number of threads.
+    const std::vector<int64_t> many = kMeansPlusPlusSeeds(points, dim, 40, 1, 5);
+    UNIT_EXPECT(test, kMeansPlusPlusSeeds(points, dim, 40, 4, 5) == many);
+    UNIT_EXPECT(test, kMeansPlusPlusSeeds(points, dim, 40, 1, 5) == many);
+    UNIT_EXPECT(test, std::set<int64_t>(many.begin(), many.end()).size() == many.size());
+    UNIT_EXPECT(test, kMeansPlusPlusSeeds(points, dim, 40, 1, 6) != many);
+
+    // k is clamped to the points, and seeding stops when every point duplicates a chosen one.
+    const std::vector<float> few(points.begin(), points.begin() + 5 * dim);
+    UNIT_EXPECT(test, kMeansPlusPlusSeeds(few, dim, 8, 2).size() == 5);
+    const std::vector<float> duplicates{1.0F, 1.0F, 1.0F, 2.0F, 2.0F, 2.0F, 1.0F, 1.0F, 1.0F, 2.0F, 2.0F, 2.0F};
+    const std::vector<int64_t> distinct = kMeansPlusPlusSeeds(duplicates, dim, 4, 1);
+    UNIT_EXPECT(test, distinct.size() == 2 && duplicates[distinct[0] * dim] != duplicates[distinct[1] * dim]);
+    UNIT_EXPECT(test, kMeansPlusPlusSeeds(points, dim, 0, 1).empty());
+}
+
+template <typename TBatchStream>
+void testSelection(samplesCommon::UnitTest& test, const TBatchStream& stream)
+{
+    const int nbPoolBatches = 8;
+    const int nbImages = 13;
+    const std::vector<int64_t> images = selectDiverseImages(stream, nbPoolBatches, nbImages, 4, 2);
+    UNIT_EXPECT(test, images.size() == nbImages);
+    UNIT_EXPECT(test, std::is_sorted(images.begin(), images.end()));
+    UNIT_EXPECT(test, std::set<int64_t>(images.begin(), images.end()).size() == images.size());
+    UNIT_EXPECT(test, images.front() >= 0 && images.back() < nbPoolBatches * kSTREAM_BATCH);
+    UNIT_EXPECT(test, selectDiverseImages(stream, nbPoolBatches, nbImages, 4, 3) == images);
+}
+
+//!
+//! \brief Checks that the images of a SubsetBatchStream are those of the list, given the index in the files of the
+//!        first image the wrapped stream returns after reset(0).
+//!
+template <typename TBatchStream>
+void testReplay(samplesCommon::UnitTest& test, const TBatchStream& stream, int firstImage)
+{
+    // The selection numbers images in the order the stream returns them from reset(0).
+    TBatchStream scan(stream);
+    scan.reset(0);
+    const std::vector<int> firstImages = readFirstImages(scan);
+    UNIT_EXPECT(test, !firstImages.empty() && firstImages[0] == firstImage);
+
+    const int batchSize = 4;
+    // Unsorted, crossing batches of the wrapped stream, and with an incomplete last batch.
+    const std::vector<int64_t> images{3, 4, 17, 0, 9, 9, 44, 22, 21, 36, 5};
+    SubsetBatchStream<TBatchStream> subset(stream, images, batchSize);
+    UNIT_EXPECT(test, subset.getNbBatches() == 2);
+    // Only NCHW dimensions carry the batch size.
+    const nvinfer1::Dims dims = subset.getDims();
+    UNIT_EXPECT(test, dims.nbDims == stream.getDims().nbDims && (dims.nbDims != 4 || dims.d[0] == batchSize));
+
+    for (int b = 0; b < subset.getNbBatches(); ++b)
+    {
+        UNIT_EXPECT(test, subset.next());
+        for (int i = 0; i < batchSize; ++i)
+        {
+            const int64_t expected = images[b * batchSize + i] + firstImage;
+            UNIT_EXPECT(test, std::lround(subset.getBatch()[i * kIMAGE_SIZE] * 255.0F) == expected);
+            UNIT_EXPECT(test, subset.getLabels()[i] == expected + 100);
+        }
+    }
+    UNIT_EXPECT(test, !subset.next());
+    UNIT_EXPECT(test, subset.getBatchesRead() == 2);
+
+    subset.reset(1);
+    UNIT_EXPECT(test, subset.next());
+    UNIT_EXPECT(test, std::lround(subset.getBatch()[0] * 255.0F) == images[batchSize] + firstImage);
+    subset.reset(0);
+    subset.skip(1);
+    UNIT_EXPECT(test, subset.next() && !subset.next());
+
+    // A selection replays the very images it scanned.
+    const std::vector<int64_t> selected = selectDiverseImages(stream, 8, 12, 4, 2);
+    SubsetBatchStream<TBatchStream> replay(stream, selected, batchSize);
+    bool same = true;
+    for (size_t i = 0; i < selected.size(); ++i)
+    {
+        if (i % batchSize == 0)
+        {
+            same &= replay.next();
+        }
+        const int64_t image = selected[i];
+        scan.reset(static_cast<int>(image / kSTREAM_BATCH));
+        scan.next();
+        const float* scanned = scan.getBatch() + (image % kSTREAM_BATCH) * kIMAGE_SIZE;
+        same &= std::equal(scanned, scanned + kIMAGE_SIZE, replay.getBatch() + (i % batchSize) * kIMAGE_SIZE);
+    }
+    UNIT_EXPECT(test, same);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    samplesCommon::UnitTest test("TensorRT.subset_batch_stream_test", argc, argv);
+    writeFiles();
+    testSeeding(test);
+
+    test.setCase("MNIST selection");
+    testSelection(test, makeMNISTStream());
+    test.setCase("MNIST replay");
+    // The baseline MNISTBatchStream returns batch b + 1 after reset(b), so image i of a selection is image
+    // i + kSTREAM_BATCH of the files.
+    testReplay(test, makeMNISTStream(), kSTREAM_BATCH);
+
+    test.setCase("dataset selection");
+    testSelection(test, makeDatasetStream());
+    test.setCase("dataset replay");
+    testReplay(test, makeDatasetStream(), 0);
+
+    removeFiles();
+    return test.report();
+}
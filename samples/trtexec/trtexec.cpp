@@ -70,108 +70,387 @@
 
 #include "buffers.h"
 #include "common.h"
+#include "latencyHistogram.h"
+#include "layerProfiler.h"
 #include "logger.h"
 #include "sampleOptions.h"
 #include "sampleEngines.h"
+#include "sampleInference.h"
+#include "sampleInputs.h"
+#include "sampleLoad.h"
+#include "sampleReporting.h"
+#include "sampleSweep.h"
+#include "sampleTrace.h"
 
 using namespace nvinfer1;
 using namespace sample;
 
-float percentile(float percentage, std::vector<float>& times)
+//!
+//! \brief The TrtInferenceWorker class runs inferences with its own execution context, stream and buffers.
+//!
+class TrtInferenceWorker : public IInferenceWorker
 {
-    int all = static_cast<int>(times.size());
-    int exclude = static_cast<int>((1 - percentage / 100) * all);
-    if (0 <= exclude && exclude <= all)
+public:
+    TrtInferenceWorker(ICudaEngine& engine, int batch, bool spin)
+        : mEngine(engine)
+        , mContext(engine.createExecutionContext())
+        , mBatch(batch)
     {
-        std::sort(times.begin(), times.end());
-        return times[all == exclude ? 0 : all - 1 - exclude];
+        CHECK(cudaStreamCreate(&mStream));
+        unsigned int cudaEventFlags = spin ? cudaEventDefault : cudaEventBlockingSync;
+        CHECK(cudaEventCreateWithFlags(&mStart, cudaEventFlags));
+        CHECK(cudaEventCreateWithFlags(&mEnd, cudaEventFlags));
     }
-    return std::numeric_limits<float>::infinity();
+
+    ~TrtInferenceWorker()
+    {
+        cudaStreamDestroy(mStream);
+        cudaEventDestroy(mStart);
+        cudaEventDestroy(mEnd);
+    }
+
+    //!
+    //! \brief Set the inference shapes, allocate the buffers and load the inputs
+    //!
+    //! \return boolean Return false if the shapes are incomplete or the inputs cannot be loaded
+    //!
+    bool setUp(const InferenceOptions& inference, IProfiler* profiler)
+    {
+        if (profiler)
+        {
+            mContext->setProfiler(profiler);
+        }
+
+        for (int b = 0; b < mEngine.getNbBindings(); ++b)
+        {
+            if (!mEngine.bindingIsInput(b))
+            {
+                continue;
+            }
+            auto dims = mContext->getBindingDimensions(b);
+            if (std::any_of(dims.d, dims.d + dims.nbDims, [](int d) { return d == -1; }))
+            {
+                auto shape = inference.shapes.find(mEngine.getBindingName(b));
+                if (shape == inference.shapes.end() || shape->second.nbDims != dims.nbDims)
+                {
+                    gLogError << "Missing dynamic shape of input " << mEngine.getBindingName(b) << " in inference"
+                              << std::endl;
+                    return false;
+                }
+                for (int d = 0; d < dims.nbDims; ++d)
+                {
+                    if (dims.d[d] == -1)
+                    {
+                        dims.d[d] = shape->second.d[d];
+                    }
+                }
+                if (!mContext->setBindingDimensions(b, dims))
+                {
+                    // Both common.h and sampleOptions.h print Dims; the latter uses the syntax of --shapes.
+                    sample::operator<<(gLogError << "Shape ", dims)
+                        << " of input " << mEngine.getBindingName(b) << " is outside of the optimization profile"
+                        << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        // Use an aliasing shared_ptr since we don't want engine to be deleted when mBuffers goes out of scope.
+        std::shared_ptr<ICudaEngine> emptyPtr{};
+        std::shared_ptr<ICudaEngine> aliasPtr(emptyPtr, &mEngine);
+        mBuffers.reset(new samplesCommon::BufferManager(aliasPtr, mBatch, mBatch ? nullptr : mContext.get()));
+        SAMPLE_TRACE_SPAN("Load inputs");
+        return mInputSets.load(mEngine, *mBuffers, inference.inputs, gLogError);
+    }
+
+    bool enqueue(int iteration) override
+    {
+        std::vector<void*>& buffers = mInputSets.getBindings(iteration);
+        cudaEventRecord(mStart, mStream);
+        const bool enqueued = mBatch ? mContext->enqueue(mBatch, &buffers[0], mStream, nullptr)
+                                     : mContext->enqueueV2(&buffers[0], mStream, nullptr);
+        cudaEventRecord(mEnd, mStream);
+        return enqueued;
+    }
+
+    bool synchronize(float& gpuTime) override
+    {
+        return cudaEventSynchronize(mEnd) == cudaSuccess && cudaEventElapsedTime(&gpuTime, mStart, mEnd) == cudaSuccess;
+    }
+
+    samplesCommon::BufferManager& getBuffers()
+    {
+        return *mBuffers;
+    }
+
+    int getNbInputSets() const
+    {
+        return mInputSets.size();
+    }
+
+private:
+    ICudaEngine& mEngine;
+    sample::unique_ptr<IExecutionContext> mContext;
+    int mBatch{0};
+    std::unique_ptr<samplesCommon::BufferManager> mBuffers;
+    InputSets mInputSets;
+    cudaStream_t mStream;
+    cudaEvent_t mStart;
+    cudaEvent_t mEnd;
+};
+
+bool hasDynamicInputs(const ICudaEngine& engine)
+{
+    for (int b = 0; b < engine.getNbBindings(); ++b)
+    {
+        const Dims dims = engine.getBindingDimensions(b);
+        if (engine.bindingIsInput(b) && std::any_of(dims.d, dims.d + dims.nbDims, [](int d) { return d == -1; }))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-bool doInference(ICudaEngine& engine, const InferenceOptions& inference, const ReportingOptions& reporting)
+//!
+//! \brief Write the timeline recorded since tracing was started, if it was requested
+//!
+void exportTrace(const std::string& fileName)
 {
-    IExecutionContext* context = engine.createExecutionContext();
+    if (fileName.empty())
+    {
+        return;
+    }
+#if defined(SAMPLES_DISABLE_TRACING)
+    gLogWarning << "Tracing was compiled out, " << fileName << " will only hold an empty timeline" << std::endl;
+#endif
+    Tracer& tracer = Tracer::instance();
+    tracer.stop();
+    if (!tracer.write(fileName))
+    {
+        gLogError << "Failed to write the trace to " << fileName << std::endl;
+    }
+    if (tracer.getDropped())
+    {
+        gLogWarning << tracer.getDropped() << " trace events were dropped" << std::endl;
+    }
+}
 
-    // Dump inferencing time per layer basis
-    SimpleProfiler profiler("Layer time");
-    if (reporting.profile)
+//!
+//! \brief Print the confidence interval of the latencies of a run, and warn if they were not stable
+//!
+//! \details With --untilStable, the monitor attached to the run already holds the report; otherwise the report is
+//!          computed from the traces, so that a run of fixed duration does no stability work while it measures.
+//!
+void reportStability(StabilityMonitor& monitor, const std::vector<std::vector<InferenceTrace>>& traces,
+    const samplesCommon::StabilityOptions& stability, const InferenceOptions& inference)
+{
+    const samplesCommon::StabilityReport report
+        = inference.untilStable > 0 ? monitor.getReport() : computeStability(traces, stability);
+    printStabilityReport(gLogInfo, report, stability.median, stability.confidence);
+    if (inference.untilStable > 0 && !report.stable)
+    {
+        gLogWarning << "The latency did not reach the requested precision of " << inference.untilStable
+                    << "% within " << inference.duration << "s, increase --duration" << std::endl;
+    }
+    if (report.drifting)
     {
-        context->setProfiler(&profiler);
+        gLogWarning << "The latency drifted by " << report.drift * 100
+                    << "% during the run, check for thermal throttling, clock changes or concurrent load" << std::endl;
     }
+}
 
-    for (int b = 0; b < engine.getNbBindings(); ++b)
+//!
+//! \brief Serve requests in an open loop at every rate of --loadRates, or at the recorded rate of --replayArrivals
+//!
+bool runLoadSweep(const std::vector<IInferenceWorker*>& workers, const RunOptions& run,
+    const InferenceOptions& inference, const samplesCommon::StabilityOptions& stability)
+{
+    ArrivalOptions arrivals;
+    if (!inference.replayArrivals.empty())
     {
-        if (!engine.bindingIsInput(b))
+        arrivals.process = ArrivalProcess::kREPLAY;
+        if (!readArrivals(inference.replayArrivals, arrivals.replay))
         {
-            continue;
+            gLogError << "Cannot read arrival times from " << inference.replayArrivals << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        parseArrivalProcess(inference.arrivals, arrivals.process);
+    }
+
+    const std::vector<float> rates = inference.loadRates.empty() ? std::vector<float>{0} : inference.loadRates;
+    std::vector<LoadSummary> summaries;
+    for (const float rate : rates)
+    {
+        // Every rate is a run of its own, with its own stability estimate.
+        StabilityMonitor monitor(stability, true);
+        RunOptions rateRun = run;
+        if (inference.untilStable > 0)
+        {
+            rateRun.listeners.push_back(&monitor);
+            rateRun.stop = monitor.getStop();
         }
-        auto dims = context->getBindingDimensions(b);
-        if (dims.d[0] == -1)
+        arrivals.rate = rate;
+        std::vector<std::vector<InferenceTrace>> traces;
+        LoadCounters counters;
+        if (!runLoad(workers, rateRun, generateArrivals(arrivals, run.warmup + run.duration), traces, counters))
         {
-            auto shape = inference.shapes.find(engine.getBindingName(b));
-            if (shape == inference.shapes.end())
-            {
-                gLogError << "Missing dynamic batch size in inference" << std::endl;
-                return false;
-            }
-            dims.d[0] = shape->second.d[0];
-            context->setBindingDimensions(b, dims);
+            return false;
         }
+        summaries.push_back(summarizeLoad(traces, counters));
+        if (rate > 0)
+        {
+            gLogInfo << "Arrival rate: " << rate << " qps"
+                     << (arrivals.process == ArrivalProcess::kREPLAY ? " replayed" : "") << std::endl;
+        }
+        printLoadReport(gLogInfo, summaries.back(), inference.batch);
+        reportStability(monitor, traces, stability, inference);
+    }
+    if (rates.size() > 1)
+    {
+        printLoadSweep(gLogInfo, rates, summaries);
     }
+    return true;
+}
 
-    // Use an aliasing shared_ptr since we don't want engine to be deleted when bufferManager goes out of scope.
-    std::shared_ptr<ICudaEngine> emptyPtr{};
-    std::shared_ptr<ICudaEngine> aliasPtr(emptyPtr, &engine);
-    samplesCommon::BufferManager bufferManager(aliasPtr, inference.batch, inference.batch ? nullptr : context);
-    std::vector<void*> buffers = bufferManager.getDeviceBindings();
+bool doInference(ICudaEngine& engine, const InferenceOptions& inference, const ReportingOptions& reporting)
+{
+    const int nbStreams = std::max(1, inference.streams);
+    if (nbStreams > 1 && hasDynamicInputs(engine))
+    {
+        // Every context would need an optimization profile of its own.
+        gLogError << "Multiple streams are not supported with dynamic shapes" << std::endl;
+        return false;
+    }
+
+    // Dump inferencing time per layer basis, for the first stream only since the profiler is not thread safe
+    samplesCommon::LayerProfiler profiler("Layer time");
+    ProfileExporter profileExporter(reporting.profile ? &profiler : nullptr);
+    IProfiler* streamProfiler = reporting.profile ? &profiler : nullptr;
+    if (!reporting.exportProfile.empty())
+    {
+        if (!profileExporter.open(reporting.exportProfile))
+        {
+            gLogError << "Cannot create " << reporting.exportProfile << std::endl;
+            return false;
+        }
+        streamProfiler = &profileExporter;
+    }
+    TimesExporter timesExporter;
+    if (!reporting.exportTimes.empty() && !timesExporter.open(reporting.exportTimes))
+    {
+        gLogError << "Cannot create " << reporting.exportTimes << std::endl;
+        return false;
+    }
 
-    cudaStream_t stream;
-    CHECK(cudaStreamCreate(&stream));
-    cudaEvent_t start, end;
-    unsigned int cudaEventFlags = inference.spin ? cudaEventDefault : cudaEventBlockingSync;
-    CHECK(cudaEventCreateWithFlags(&start, cudaEventFlags));
-    CHECK(cudaEventCreateWithFlags(&end, cudaEventFlags));
+    std::vector<std::unique_ptr<TrtInferenceWorker>> workers;
+    std::vector<IInferenceWorker*> workerPtrs;
+    for (int s = 0; s < nbStreams; ++s)
+    {
+        SAMPLE_TRACE_SPAN("Set up stream");
+        workers.emplace_back(new TrtInferenceWorker(engine, inference.batch, inference.spin));
+        if (!workers.back()->setUp(inference, s == 0 ? streamProfiler : nullptr))
+        {
+            return false;
+        }
+        workerPtrs.push_back(workers.back().get());
+    }
+    if (workers.front()->getNbInputSets() > 1)
+    {
+        gLogInfo << "Rotating " << workers.front()->getNbInputSets() << " input sets across iterations" << std::endl;
+    }
 
-    std::vector<float> times(reporting.avgs);
-    for (int j = 0; j < inference.iterations; j++)
+    RunOptions run;
+    run.warmup = static_cast<float>(inference.warmup);
+    run.duration = inference.duration * 1000.0F;
+    run.iterations = inference.iterations * reporting.avgs;
+    run.sleep = static_cast<float>(inference.sleep);
+    run.threads = inference.threads;
+    if (!reporting.exportTimes.empty())
+    {
+        run.listeners.push_back(&timesExporter);
+    }
+    run.recording = profileExporter.getRecording();
+    // The stability of the latencies is always reported; only --untilStable follows it during the run, to end it.
+    samplesCommon::StabilityOptions stability;
+    stability.median = !inference.stableMean;
+    stability.targetPrecision = inference.untilStable / 100;
+    StabilityMonitor monitor(stability, true);
+    const bool openLoop = !inference.loadRates.empty() || !inference.replayArrivals.empty();
+    if (!openLoop && inference.untilStable > 0)
+    {
+        run.listeners.push_back(&monitor);
+        run.stop = monitor.getStop();
+    }
+    std::vector<std::vector<InferenceTrace>> traces;
+    float walltime{0};
+    bool success{false};
     {
-        float totalGpu{0};  // GPU timer
-        float totalHost{0}; // Host timer
+        SAMPLE_TRACE_SPAN("Run inference");
+        success = openLoop ? runLoadSweep(workerPtrs, run, inference, stability)
+                           : runInference(workerPtrs, run, traces, walltime);
+    }
+    // Close the exports even after a failure, since they hold what completed.
+    if (!reporting.exportTimes.empty() && !timesExporter.close())
+    {
+        gLogError << "Failed to write the timing results to " << reporting.exportTimes << std::endl;
+    }
+    if (!reporting.exportProfile.empty() && !profileExporter.close())
+    {
+        gLogError << "Failed to write the layer profile to " << reporting.exportProfile << std::endl;
+    }
+    if (!success)
+    {
+        gLogError << "Inference failed" << std::endl;
+        return false;
+    }
 
-        for (int i = 0; i < reporting.avgs; i++)
+    if (!openLoop)
+    {
+        for (int s = 0; s < nbStreams; ++s)
         {
-            auto tStart = std::chrono::high_resolution_clock::now();
-            cudaEventRecord(start, stream);
-            if (inference.batch)
-            {
-                context->enqueue(inference.batch, &buffers[0], stream, nullptr);
-            }
-            else
+            const int nbWindows = static_cast<int>(traces[s].size()) / reporting.avgs;
+            for (int j = 0; j < nbWindows; j++)
             {
-                context->enqueueV2(&buffers[0], stream, nullptr);
+                float totalGpu{0};  // GPU timer
+                float totalHost{0}; // Host timer
+                samplesCommon::LatencyHistogram times;
+
+                for (int i = 0; i < reporting.avgs; i++)
+                {
+                    const InferenceTrace& trace = traces[s][j * reporting.avgs + i];
+                    totalHost += trace.latency();
+                    times.record(trace.gpuTime);
+                    totalGpu += trace.gpuTime;
+                }
+
+                totalGpu /= reporting.avgs;
+                totalHost /= reporting.avgs;
+                gLogVerbose << (nbStreams > 1 ? "Stream " + std::to_string(s) + ": " : "") << "Average over "
+                            << reporting.avgs << " runs is " << totalGpu << " ms (host walltime is " << totalHost
+                            << " ms, " << static_cast<int>(reporting.percentile) << "\% percentile time is "
+                            << times.percentile(reporting.percentile) << ")." << std::endl;
             }
-            cudaEventRecord(end, stream);
-            cudaEventSynchronize(end);
-
-            auto tEnd = std::chrono::high_resolution_clock::now();
-            totalHost += std::chrono::duration<float, std::milli>(tEnd - tStart).count();
-            float ms;
-            cudaEventElapsedTime(&ms, start, end);
-            times[i] = ms;
-            totalGpu += ms;
         }
-
-        totalGpu /= reporting.avgs;
-        totalHost /= reporting.avgs;
-        gLogInfo << "Average over " << reporting.avgs << " runs is " << totalGpu << " ms (host walltime is "
-                 << totalHost << " ms, " << static_cast<int>(reporting.percentile) << "\% percentile time is "
-                 << percentile(reporting.percentile, times) << ")." << std::endl;
+        printInferenceReport(gLogInfo, traces, walltime, inference.batch, reporting.percentile);
+        reportStability(monitor, traces, stability, inference);
     }
 
-    if (reporting.output)
+    samplesCommon::BufferManager& bufferManager = workers.front()->getBuffers();
+    if (reporting.output || !reporting.exportOutput.empty())
     {
+        SAMPLE_TRACE_SPAN("Copy outputs");
         bufferManager.copyOutputToHost();
+    }
+    if (!reporting.exportOutput.empty() && !bufferManager.dumpOutputsNpy(reporting.exportOutput))
+    {
+        gLogError << "Failed to export the output tensors to " << reporting.exportOutput << "*.npy" << std::endl;
+    }
+    if (reporting.output)
+    {
         int nbBindings = engine.getNbBindings();
         for (int i = 0; i < nbBindings; i++)
         {
@@ -187,13 +466,153 @@ bool doInference(ICudaEngine& engine, const InferenceOptions& inference, const R
     if (reporting.profile)
     {
         gLogInfo << profiler;
+        profiler.printHotspots(gLogInfo, 10);
+    }
+
+    return true;
+}
+
+//!
+//! \brief Measure the engine across the dynamic dimensions of its optimization profile, and report the shape of
+//!        highest throughput within --latencyBudget
+//!
+bool doShapeSweep(ICudaEngine& engine, const InferenceOptions& inference, const ReportingOptions& reporting)
+{
+    if (!hasDynamicInputs(engine))
+    {
+        gLogError << "Shape sweeps need an engine built with dynamic shapes" << std::endl;
+        return false;
+    }
+
+    // Every dynamic position is an axis, over the intersection of the ranges of the inputs dynamic there.
+    std::vector<SweepAxis> axes;
+    for (int b = 0; b < engine.getNbBindings(); ++b)
+    {
+        const Dims dims = engine.getBindingDimensions(b);
+        if (!engine.bindingIsInput(b))
+        {
+            continue;
+        }
+        const Dims min = engine.getProfileDimensions(b, 0, OptProfileSelector::kMIN);
+        const Dims max = engine.getProfileDimensions(b, 0, OptProfileSelector::kMAX);
+        for (int d = 0; d < dims.nbDims; ++d)
+        {
+            if (dims.d[d] != -1)
+            {
+                continue;
+            }
+            auto axis = std::find_if(axes.begin(), axes.end(), [d](const SweepAxis& a) { return a.position == d; });
+            if (axis == axes.end())
+            {
+                SweepAxis a;
+                a.position = d;
+                a.min = min.d[d];
+                a.max = max.d[d];
+                axis = axes.insert(std::upper_bound(axes.begin(), axes.end(), a,
+                                       [](const SweepAxis& x, const SweepAxis& y) { return x.position < y.position; }),
+                    a);
+            }
+            axis->min = std::max(axis->min, min.d[d]);
+            axis->max = std::min(axis->max, max.d[d]);
+            axis->inputs.push_back(engine.getBindingName(b));
+        }
+    }
+    for (const auto& a : axes)
+    {
+        if (a.min > a.max)
+        {
+            gLogError << "The inputs dynamic in dimension " << a.position << " have disjoint ranges" << std::endl;
+            return false;
+        }
     }
 
-    cudaStreamDestroy(stream);
-    cudaEventDestroy(start);
-    cudaEventDestroy(end);
-    context->destroy();
+    RunOptions run;
+    run.warmup = static_cast<float>(inference.warmup);
+    run.duration = inference.duration * 1000.0F;
+    run.iterations = inference.iterations;
+    run.sleep = static_cast<float>(inference.sleep);
+    samplesCommon::StabilityOptions stability;
+    stability.median = !inference.stableMean;
+    stability.targetPrecision = inference.untilStable / 100;
+
+    auto measure = [&](const std::vector<int>& values, SweepMeasurement& measurement) {
+        SAMPLE_TRACE_SPAN("Sweep point");
+        // The inference shapes, or the optimum of the profile, with the swept dimensions replaced
+        InferenceOptions point = inference;
+        int batch{1};
+        std::ostringstream shapes;
+        for (int b = 0; b < engine.getNbBindings(); ++b)
+        {
+            const std::string name = engine.getBindingName(b);
+            const Dims dims = engine.getBindingDimensions(b);
+            if (!engine.bindingIsInput(b) || std::none_of(dims.d, dims.d + dims.nbDims, [](int d) { return d == -1; }))
+            {
+                continue;
+            }
+            const auto given = inference.shapes.find(name);
+            Dims shape = given != inference.shapes.end() ? given->second
+                                                          : engine.getProfileDimensions(b, 0, OptProfileSelector::kOPT);
+            for (size_t a = 0; a < axes.size(); ++a)
+            {
+                if (std::find(axes[a].inputs.begin(), axes[a].inputs.end(), name) != axes[a].inputs.end())
+                {
+                    shape.d[axes[a].position] = values[a];
+                    batch = axes[a].position == 0 ? values[a] : batch;
+                }
+            }
+            point.shapes[name] = shape;
+            sample::operator<<(shapes << (shapes.tellp() > 0 ? ", " : "") << name << ":", shape);
+        }
 
+        TrtInferenceWorker worker(engine, 0, inference.spin);
+        if (!worker.setUp(point, nullptr))
+        {
+            return false;
+        }
+        StabilityMonitor monitor(stability, true);
+        RunOptions pointRun = run;
+        if (inference.untilStable > 0)
+        {
+            pointRun.listeners.push_back(&monitor);
+            pointRun.stop = monitor.getStop();
+        }
+        std::vector<std::vector<InferenceTrace>> traces;
+        float walltime{0};
+        if (!runInference(std::vector<IInferenceWorker*>{&worker}, pointRun, traces, walltime))
+        {
+            gLogError << "Inference failed with shapes " << shapes.str() << std::endl;
+            return false;
+        }
+        samplesCommon::LatencyHistogram latencies;
+        for (const auto& t : traces.front())
+        {
+            latencies.record(t.latency());
+        }
+        measurement.latency = latencies.summarize(walltime);
+        measurement.throughput = static_cast<float>(measurement.latency.throughput * batch);
+        gLogInfo << "Shapes " << shapes.str() << ": " << measurement.throughput << " samples/s, p99 latency "
+                 << measurement.latency.p99 << " ms" << std::endl;
+        return true;
+    };
+
+    SweepOptions options;
+    options.latencyBudget = inference.latencyBudget;
+    ShapeSweep sweep(axes, options);
+    if (!sweep.run(measure))
+    {
+        gLogError << "No shape of the sweep could be run" << std::endl;
+        return false;
+    }
+    sweep.print(gLogInfo);
+    if (!reporting.exportSweep.empty())
+    {
+        std::ofstream file(reporting.exportSweep);
+        sweep.exportJson(file);
+        if (!file)
+        {
+            gLogError << "Failed to write the shape sweep to " << reporting.exportSweep << std::endl;
+        }
+    }
     return true;
 }
 
@@ -233,8 +652,7 @@ int main(int argc, char** argv)
         {
             AllOptions::help(std::cout);
             std::cout << "Note: the following options are not fully supported in trtexec:"
-                         " dynamic shapes, multistream/threads, cuda graphs, json logs,"
-                         " and actual data IO" << std::endl;
+                         " dynamic shapes and cuda graphs" << std::endl;
             return gLogger.reportFail(sampleTest);
         }
     }
@@ -247,8 +665,7 @@ int main(int argc, char** argv)
     {
         AllOptions::help(std::cout);
         std::cout << "Note: the following options are not fully supported in trtexec:"
-                     " dynamic shapes, multistream/threads, cuda graphs, json logs,"
-                     " and actual data IO" << std::endl;
+                     " dynamic shapes and cuda graphs" << std::endl;
         return gLogger.reportPass(sampleTest);
     }
 
@@ -268,13 +685,21 @@ int main(int argc, char** argv)
         samplesCommon::loadLibrary(pluginPath);
     }
 
+    if (!options.reporting.exportTrace.empty())
+    {
+        Tracer::instance().start();
+        SAMPLE_TRACE_THREAD_NAME("Main");
+    }
+
     ICudaEngine* engine{nullptr};
     if (options.build.load)
     {
+        SAMPLE_TRACE_SPAN("Load engine");
         engine = loadEngine(options.build.engine, options.system.DLACore, gLogError);
     }
     else
     {
+        SAMPLE_TRACE_SPAN("Build engine");
         engine = modelToEngine(options.model, options.build, options.system, gLogError);
     }
     if (!engine)
@@ -284,6 +709,7 @@ int main(int argc, char** argv)
     }
     if (options.build.save)
     {
+        SAMPLE_TRACE_SPAN("Save engine");
         saveEngine(*engine, options.build.engine, gLogError);
     }
 
@@ -296,12 +722,20 @@ int main(int argc, char** argv)
                         "or alternatively run with your own application" << std::endl;
             return gLogger.reportFail(sampleTest);
         }
-        if (!doInference(*engine, options.inference, options.reporting))
+        bool success{false};
+        {
+            SAMPLE_TRACE_SPAN("Inference");
+            success = options.inference.sweepShapes ? doShapeSweep(*engine, options.inference, options.reporting)
+                                                    : doInference(*engine, options.inference, options.reporting);
+        }
+        if (!success)
         {
             gLogError << "Inference failure" << std::endl;
+            exportTrace(options.reporting.exportTrace);
             return gLogger.reportFail(sampleTest);
         }
     }
+    exportTrace(options.reporting.exportTrace);
     engine->destroy();
 
     return gLogger.reportPass(sampleTest);